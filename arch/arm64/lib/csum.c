@@ -4,6 +4,7 @@
 #include <linux/compiler.h>
 #include <linux/kasan-checks.h>
 #include <linux/kernel.h>
+#include <linux/string.h>
 
 #include <net/checksum.h>
 
@@ -129,6 +130,63 @@ unsigned int __no_sanitize_address do_csum(const unsigned char *buff, int len)
 	return sum >> 16;
 }
 
+/*
+ * Copy and checksum in a single pass, so that every byte is loaded once
+ * rather than once by memcpy() and again by csum_partial(). Unlike do_csum(),
+ * the words are summed relative to @src rather than to an aligned address,
+ * so there is no odd/even correction to make at the end.
+ */
+__wsum csum_partial_copy_nocheck(const void *src, void *dst, int len)
+{
+	u64 data, sum64 = 0;
+
+	while (len >= 64) {
+		__uint128_t tmp1, tmp2, tmp3, tmp4;
+
+		memcpy(&tmp1, src, 16);
+		memcpy(&tmp2, src + 16, 16);
+		memcpy(&tmp3, src + 32, 16);
+		memcpy(&tmp4, src + 48, 16);
+		memcpy(dst, &tmp1, 16);
+		memcpy(dst + 16, &tmp2, 16);
+		memcpy(dst + 32, &tmp3, 16);
+		memcpy(dst + 48, &tmp4, 16);
+
+		sum64 = accumulate(sum64, tmp1);
+		sum64 = accumulate(sum64, tmp1 >> 64);
+		sum64 = accumulate(sum64, tmp2);
+		sum64 = accumulate(sum64, tmp2 >> 64);
+		sum64 = accumulate(sum64, tmp3);
+		sum64 = accumulate(sum64, tmp3 >> 64);
+		sum64 = accumulate(sum64, tmp4);
+		sum64 = accumulate(sum64, tmp4 >> 64);
+
+		src += 64;
+		dst += 64;
+		len -= 64;
+	}
+	while (len >= 8) {
+		memcpy(&data, src, 8);
+		memcpy(dst, &data, 8);
+		sum64 = accumulate(sum64, data);
+
+		src += 8;
+		dst += 8;
+		len -= 8;
+	}
+	if (len > 0) {
+		/* Zero padding after the last byte does not change the sum. */
+		data = 0;
+		memcpy(&data, src, len);
+		memcpy(dst, &data, len);
+		sum64 = accumulate(sum64, data);
+	}
+
+	sum64 += (sum64 >> 32) | (sum64 << 32);
+	return (__force __wsum)(sum64 >> 32);
+}
+EXPORT_SYMBOL(csum_partial_copy_nocheck);
+
 __sum16 csum_ipv6_magic(const struct in6_addr *saddr,
 			const struct in6_addr *daddr,
 			__u32 len, __u8 proto, __wsum csum)
@@ -6236,27 +6236,25 @@ static inline void bfq_update_insert_stats(struct request_queue *q,
 
 static struct bfq_queue *bfq_init_rq(struct request *rq);
 
-static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
-			       blk_insert_t flags)
+/*
+ * Insert @rq into the scheduler with bfqd->lock held.  Returns the
+ * bfq_queue @rq ended up in, or NULL if @rq was merged into another
+ * request, in which case it's been added to @free.
+ */
+static struct bfq_queue *bfq_insert_request_locked(struct request_queue *q,
+						   struct request *rq,
+						   blk_insert_t flags,
+						   struct list_head *free,
+						   bool *idle_timer_disabled)
 {
-	struct request_queue *q = hctx->queue;
 	struct bfq_data *bfqd = q->elevator->elevator_data;
 	struct bfq_queue *bfqq;
-	bool idle_timer_disabled = false;
-	blk_opf_t cmd_flags;
-	LIST_HEAD(free);
 
-#ifdef CONFIG_BFQ_GROUP_IOSCHED
-	if (!cgroup_subsys_on_dfl(io_cgrp_subsys) && rq->bio)
-		bfqg_stats_update_legacy_io(q, rq);
-#endif
-	spin_lock_irq(&bfqd->lock);
+	lockdep_assert_held(&bfqd->lock);
+
 	bfqq = bfq_init_rq(rq);
-	if (blk_mq_sched_try_insert_merge(q, rq, &free)) {
-		spin_unlock_irq(&bfqd->lock);
-		blk_mq_free_requests(&free);
-		return;
-	}
+	if (blk_mq_sched_try_insert_merge(q, rq, free))
+		return NULL;
 
 	trace_block_rq_insert(rq);
 
@@ -6265,7 +6263,7 @@ static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 	} else if (!bfqq) {
 		list_add_tail(&rq->queuelist, &bfqd->dispatch);
 	} else {
-		idle_timer_disabled = __bfq_insert_request(bfqd, rq);
+		*idle_timer_disabled = __bfq_insert_request(bfqd, rq);
 		/*
 		 * Update bfqq, because, if a queue merge has occurred
 		 * in __bfq_insert_request, then rq has been
@@ -6280,6 +6278,32 @@ static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 		}
 	}
 
+	return bfqq;
+}
+
+static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
+			       blk_insert_t flags)
+{
+	struct request_queue *q = hctx->queue;
+	struct bfq_data *bfqd = q->elevator->elevator_data;
+	struct bfq_queue *bfqq;
+	bool idle_timer_disabled = false;
+	blk_opf_t cmd_flags;
+	LIST_HEAD(free);
+
+#ifdef CONFIG_BFQ_GROUP_IOSCHED
+	if (!cgroup_subsys_on_dfl(io_cgrp_subsys) && rq->bio)
+		bfqg_stats_update_legacy_io(q, rq);
+#endif
+	spin_lock_irq(&bfqd->lock);
+	bfqq = bfq_insert_request_locked(q, rq, flags, &free,
+					 &idle_timer_disabled);
+	if (!list_empty(&free)) {
+		spin_unlock_irq(&bfqd->lock);
+		blk_mq_free_requests(&free);
+		return;
+	}
+
 	/*
 	 * Cache cmd_flags before releasing scheduler lock, because rq
 	 * may disappear afterwards (for example, because of a request
@@ -6296,13 +6320,46 @@ static void bfq_insert_requests(struct blk_mq_hw_ctx *hctx,
 				struct list_head *list,
 				blk_insert_t flags)
 {
-	while (!list_empty(list)) {
-		struct request *rq;
+	struct request_queue *q = hctx->queue;
+	struct bfq_data *bfqd = q->elevator->elevator_data;
+	bool idle_timer_disabled;
+	struct request *rq;
+	LIST_HEAD(free);
+
+	/*
+	 * The debug insert stats are updated per request once bfqd->lock
+	 * has been dropped, so keep inserting one request at a time there.
+	 */
+	if (IS_ENABLED(CONFIG_BFQ_CGROUP_DEBUG) || list_is_singular(list)) {
+		while (!list_empty(list)) {
+			rq = list_first_entry(list, struct request, queuelist);
+			list_del_init(&rq->queuelist);
+			bfq_insert_request(hctx, rq, flags);
+		}
+		return;
+	}
 
+#ifdef CONFIG_BFQ_GROUP_IOSCHED
+	if (!cgroup_subsys_on_dfl(io_cgrp_subsys))
+		list_for_each_entry(rq, list, queuelist)
+			if (rq->bio)
+				bfqg_stats_update_legacy_io(q, rq);
+#endif
+	/*
+	 * Insert the whole batch in a single bfqd->lock section.  This
+	 * still runs in the context of the submitter, which bfq_init_rq()
+	 * relies on for the ioprio and pid it attaches to the bfq_queue.
+	 */
+	spin_lock_irq(&bfqd->lock);
+	while (!list_empty(list)) {
 		rq = list_first_entry(list, struct request, queuelist);
 		list_del_init(&rq->queuelist);
-		bfq_insert_request(hctx, rq, flags);
+		bfq_insert_request_locked(q, rq, flags, &free,
+					  &idle_timer_disabled);
 	}
+	spin_unlock_irq(&bfqd->lock);
+
+	blk_mq_free_requests(&free);
 }
 
 static void bfq_update_hw_tag(struct bfq_data *bfqd)
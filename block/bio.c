@@ -19,6 +19,8 @@
 #include <linux/sched/sysctl.h>
 #include <linux/blk-crypto.h>
 #include <linux/xarray.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/block.h>
 #include "blk.h"
@@ -35,6 +37,16 @@ struct bio_alloc_cache {
 	unsigned int		nr_irq;
 };
 
+/* bio alloc cache effectiveness across all bio_sets, see bio_cache_stats */
+struct bio_alloc_cache_stats {
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		puts;
+	unsigned long		overflows;
+};
+
+static DEFINE_PER_CPU(struct bio_alloc_cache_stats, bio_cache_stats);
+
 static struct biovec_slab {
 	int nr_vecs;
 	char *name;
@@ -441,6 +453,7 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 		if (READ_ONCE(cache->nr_irq) >= ALLOC_CACHE_THRESHOLD)
 			bio_alloc_irq_cache_splice(cache);
 		if (!cache->free_list) {
+			this_cpu_inc(bio_cache_stats.misses);
 			put_cpu();
 			return NULL;
 		}
@@ -448,6 +461,7 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 	bio = cache->free_list;
 	cache->free_list = bio->bi_next;
 	cache->nr--;
+	this_cpu_inc(bio_cache_stats.hits);
 	put_cpu();
 
 	bio_init(bio, bdev, nr_vecs ? bio->bi_inline_vecs : NULL, nr_vecs, opf);
@@ -763,11 +777,13 @@ static inline void bio_put_percpu_cache(struct bio *bio)
 
 	cache = per_cpu_ptr(bio->bi_pool->cache, get_cpu());
 	if (READ_ONCE(cache->nr_irq) + cache->nr > ALLOC_CACHE_MAX) {
+		this_cpu_inc(bio_cache_stats.overflows);
 		put_cpu();
 		bio_free(bio);
 		return;
 	}
 
+	this_cpu_inc(bio_cache_stats.puts);
 	bio_uninit(bio);
 
 	if ((bio->bi_opf & REQ_POLLED) && !WARN_ON_ONCE(in_interrupt())) {
@@ -1148,20 +1164,17 @@ void __bio_release_pages(struct bio *bio, bool mark_dirty)
 	struct folio_iter fi;
 
 	bio_for_each_folio_all(fi, bio) {
-		struct page *page;
 		size_t nr_pages;
 
-		if (mark_dirty) {
-			folio_lock(fi.folio);
-			folio_mark_dirty(fi.folio);
-			folio_unlock(fi.folio);
-		}
-		page = folio_page(fi.folio, fi.offset / PAGE_SIZE);
+		/*
+		 * Drop the pins of all pages of the folio the bio covers at
+		 * once, rather than taking one atomic per page.
+		 */
 		nr_pages = (fi.offset + fi.length - 1) / PAGE_SIZE -
 			   fi.offset / PAGE_SIZE + 1;
-		do {
-			bio_release_page(bio, page++);
-		} while (--nr_pages != 0);
+		unpin_user_page_range_dirty_lock(folio_page(fi.folio,
+							    fi.offset / PAGE_SIZE),
+						 nr_pages, mark_dirty);
 	}
 }
 EXPORT_SYMBOL_GPL(__bio_release_pages);
@@ -1240,7 +1253,7 @@ static int __bio_iov_iter_get_pages(struct bio *bio, struct iov_iter *iter)
 	struct bio_vec *bv = bio->bi_io_vec + bio->bi_vcnt;
 	struct page **pages = (struct page **)bv;
 	ssize_t size, left;
-	unsigned len, i = 0;
+	unsigned len, i = 0, nr = 1;
 	size_t offset;
 	int ret = 0;
 
@@ -1281,17 +1294,32 @@ static int __bio_iov_iter_get_pages(struct bio *bio, struct iov_iter *iter)
 		goto out;
 	}
 
-	for (left = size, i = 0; left > 0; left -= len, i++) {
+	for (left = size, i = 0; left > 0; left -= len, i += nr) {
 		struct page *page = pages[i];
 
 		len = min_t(size_t, PAGE_SIZE - offset, left);
+		nr = 1;
 		if (bio_op(bio) == REQ_OP_ZONE_APPEND) {
 			ret = bio_iov_add_zone_append_page(bio, page, len,
 					offset);
 			if (ret)
 				break;
-		} else
+		} else {
+			struct folio *folio = page_folio(page);
+
+			/*
+			 * Pages of a large folio usually come back in order:
+			 * add the whole run as one multi-page bvec instead of
+			 * merging it in page by page.
+			 */
+			while (len < left && len <= UINT_MAX - PAGE_SIZE &&
+			       pages[i + nr] == nth_page(page, nr) &&
+			       page_folio(pages[i + nr]) == folio) {
+				len += min_t(size_t, PAGE_SIZE, left - len);
+				nr++;
+			}
 			bio_iov_add_page(bio, page, len, offset);
+		}
 
 		offset = 0;
 	}
@@ -1581,6 +1609,9 @@ void bio_endio(struct bio *bio)
 
 	rq_qos_done_bio(bio);
 
+	if (bio_zone_write_plugging(bio))
+		blk_zone_write_plug_bio_endio(bio);
+
 	if (bio->bi_bdev && bio_flagged(bio, BIO_TRACE_COMPLETION)) {
 		trace_block_bio_complete(bdev_get_queue(bio->bi_bdev), bio);
 		bio_clear_flag(bio, BIO_TRACE_COMPLETION);
@@ -1808,3 +1839,34 @@ static int __init init_bio(void)
 	return 0;
 }
 subsys_initcall(init_bio);
+
+#ifdef CONFIG_DEBUG_FS
+static int bio_alloc_cache_show(struct seq_file *m, void *v)
+{
+	struct bio_alloc_cache_stats sum = { };
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct bio_alloc_cache_stats *st =
+			per_cpu_ptr(&bio_cache_stats, cpu);
+
+		sum.hits += READ_ONCE(st->hits);
+		sum.misses += READ_ONCE(st->misses);
+		sum.puts += READ_ONCE(st->puts);
+		sum.overflows += READ_ONCE(st->overflows);
+	}
+
+	seq_printf(m, "hits %lu\nmisses %lu\nputs %lu\noverflows %lu\n",
+		   sum.hits, sum.misses, sum.puts, sum.overflows);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bio_alloc_cache);
+
+static int __init bio_debugfs_init(void)
+{
+	debugfs_create_file("bio_alloc_cache", 0400, blk_debugfs_root, NULL,
+			    &bio_alloc_cache_fops);
+	return 0;
+}
+late_initcall(bio_debugfs_init);
+#endif
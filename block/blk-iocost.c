@@ -44,7 +44,12 @@
  * /sys/fs/cgroup/io.cost.model.
  *
  * If needed, tools/cgroup/iocost_coef_gen.py can be used to generate
- * device-specific coefficients.
+ * device-specific coefficients.  Alternatively, "ctrl=fit" makes the
+ * controller continuously re-estimate the coefficients from the service
+ * times of completed IOs.  Completion latencies at queue depth overstate
+ * how much device time an IO occupies, so only the relative costs - page
+ * vs. seq vs. rand, read vs. write - are learned and the overall scale is
+ * kept at what vrate is calibrated against.  See ioc_fit_cost_model().
  *
  * 2. Control Strategy
  *
@@ -312,6 +317,17 @@ enum {
 
 	/* if apart further than 16M, consider randio for linear model */
 	LCOEF_RANDIO_PAGES	= 4096,
+
+	/*
+	 * Cost model fitting: a class needs this many completions in a
+	 * period to produce an estimate, estimates are smoothed with a 1/8
+	 * ewma and the fitted coefficients are only applied once the
+	 * confidence, which ramps up over FIT_RAMP_PERIODS, is high enough.
+	 */
+	FIT_MIN_SAMPLES		= 64,
+	FIT_EWMA_SHIFT		= 3,
+	FIT_RAMP_PERIODS	= 8,
+	FIT_CONF_MIN_PCT	= 50,
 };
 
 enum ioc_running {
@@ -345,6 +361,30 @@ enum {
 	NR_COST_CTRL_PARAMS,
 };
 
+/* completion classes and running sums for cost model fitting */
+enum {
+	FIT_SEQ,
+	FIT_RAND,
+	NR_FIT_CLASSES,
+};
+
+enum {
+	FIT_NR,
+	FIT_PAGES,
+	FIT_NSEC,
+	FIT_PAGES_SQ,
+	FIT_PAGES_NSEC,
+	NR_FIT_SUMS,
+};
+
+/* fitted per-direction coefficients in nsecs */
+enum {
+	FIT_PAGE,
+	FIT_SEQIO,
+	FIT_RANDIO,
+	NR_FIT_COEFS,
+};
+
 /* builtin linear cost model coefficients */
 enum {
 	I_LCOEF_RBPS,
@@ -400,6 +440,11 @@ struct ioc_pcpu_stat {
 
 	local64_t			rq_wait_ns;
 	u64				last_rq_wait_ns;
+
+	/* cost model fitting, only updated w/ ctrl=fit */
+	u64				fit_cursor[2];
+	local64_t			fit[2][NR_FIT_CLASSES][NR_FIT_SUMS];
+	u64				last_fit[2][NR_FIT_CLASSES][NR_FIT_SUMS];
 };
 
 /* per device */
@@ -445,6 +490,13 @@ struct ioc {
 	int				autop_idx;
 	bool				user_qos_params:1;
 	bool				user_cost_model:1;
+	bool				fit_cost_model:1;
+
+	/* cost model fitting state, see ioc_fit_cost_model() */
+	u64				fit_nsec[2][NR_FIT_COEFS];
+	u32				fit_dev_pct[2];
+	u32				fit_conf_pct[2];
+	u32				fit_nr_periods[2];
 };
 
 struct iocg_pcpu_stat {
@@ -824,7 +876,8 @@ static int ioc_autop_idx(struct ioc *ioc, struct gendisk *disk)
 		return AUTOP_SSD_DFL;
 
 	/* if user is overriding anything, maintain what was there */
-	if (ioc->user_qos_params || ioc->user_cost_model)
+	if (ioc->user_qos_params || ioc->user_cost_model ||
+	    ioc->fit_cost_model)
 		return idx;
 
 	/* step up/down based on the vrate */
@@ -934,7 +987,7 @@ static bool ioc_refresh_params_disk(struct ioc *ioc, bool force,
 
 	if (!ioc->user_qos_params)
 		memcpy(ioc->params.qos, p->qos, sizeof(p->qos));
-	if (!ioc->user_cost_model)
+	if (!ioc->user_cost_model && !ioc->fit_cost_model)
 		memcpy(ioc->params.i_lcoefs, p->i_lcoefs, sizeof(p->i_lcoefs));
 
 	ioc_refresh_period_us(ioc);
@@ -953,6 +1006,245 @@ static bool ioc_refresh_params(struct ioc *ioc, bool force)
 	return ioc_refresh_params_disk(ioc, force, ioc->rqos.disk);
 }
 
+/*
+ * Convert between user facing bps/iops and per-page/per-IO nsecs.  @u
+ * points at either the read or the write triplet of i_lcoefs.
+ */
+static void i_lcoefs_to_fit_nsec(const u64 *u, u64 *c)
+{
+	u64 page = 0, v;
+
+	if (u[I_LCOEF_RBPS])
+		page = div64_u64((u64)IOC_PAGE_SIZE * NSEC_PER_SEC,
+				 u[I_LCOEF_RBPS]);
+	c[FIT_PAGE] = page;
+
+	v = u[I_LCOEF_RSEQIOPS] ? div64_u64(NSEC_PER_SEC, u[I_LCOEF_RSEQIOPS]) : 0;
+	c[FIT_SEQIO] = v > page ? v - page : 0;
+
+	v = u[I_LCOEF_RRANDIOPS] ? div64_u64(NSEC_PER_SEC, u[I_LCOEF_RRANDIOPS]) : 0;
+	c[FIT_RANDIO] = v > page ? v - page : 0;
+}
+
+static void fit_nsec_to_i_lcoefs(const u64 *c, u64 *u)
+{
+	u64 page = max_t(u64, c[FIT_PAGE], 1);
+
+	u[I_LCOEF_RBPS] = div64_u64((u64)IOC_PAGE_SIZE * NSEC_PER_SEC, page);
+	u[I_LCOEF_RSEQIOPS] = div64_u64(NSEC_PER_SEC, page + c[FIT_SEQIO]);
+	u[I_LCOEF_RRANDIOPS] = div64_u64(NSEC_PER_SEC, page + c[FIT_RANDIO]);
+}
+
+static void ioc_fit_reset(struct ioc *ioc)
+{
+	int cpu;
+
+	lockdep_assert_held(&ioc->lock);
+
+	for_each_possible_cpu(cpu) {
+		struct ioc_pcpu_stat *stat = per_cpu_ptr(ioc->pcpu_stat, cpu);
+		int rw, c, k;
+
+		for (rw = READ; rw <= WRITE; rw++)
+			for (c = 0; c < NR_FIT_CLASSES; c++)
+				for (k = 0; k < NR_FIT_SUMS; k++)
+					stat->last_fit[rw][c][k] =
+						local64_read(&stat->fit[rw][c][k]);
+	}
+
+	memset(ioc->fit_nsec, 0, sizeof(ioc->fit_nsec));
+	memset(ioc->fit_dev_pct, 0, sizeof(ioc->fit_dev_pct));
+	memset(ioc->fit_conf_pct, 0, sizeof(ioc->fit_conf_pct));
+	memset(ioc->fit_nr_periods, 0, sizeof(ioc->fit_nr_periods));
+}
+
+static void ioc_fit_collect(struct ioc *ioc,
+			    u64 sums[2][NR_FIT_CLASSES][NR_FIT_SUMS])
+{
+	int cpu, rw, c, k;
+
+	for_each_possible_cpu(cpu) {
+		struct ioc_pcpu_stat *stat = per_cpu_ptr(ioc->pcpu_stat, cpu);
+
+		for (rw = READ; rw <= WRITE; rw++) {
+			for (c = 0; c < NR_FIT_CLASSES; c++) {
+				for (k = 0; k < NR_FIT_SUMS; k++) {
+					u64 this = local64_read(&stat->fit[rw][c][k]);
+
+					sums[rw][c][k] += this - stat->last_fit[rw][c][k];
+					stat->last_fit[rw][c][k] = this;
+				}
+			}
+		}
+	}
+}
+
+/*
+ * Fit one direction of the linear model to a period's worth of
+ * completions.  The per-page cost is the least squares slope of service
+ * time over size pooled across the seq and rand classes, each class
+ * keeping its own intercept which becomes its base cost.  Returns a mask
+ * of the coefficients which could be estimated.
+ */
+static int ioc_fit_period(u64 sums[NR_FIT_CLASSES][NR_FIT_SUMS],
+			  const u64 *cur, u64 *raw)
+{
+	static const int base_coef[NR_FIT_CLASSES] = {
+		[FIT_SEQ]	= FIT_SEQIO,
+		[FIT_RAND]	= FIT_RANDIO,
+	};
+	s64 cov = 0;
+	u64 var = 0, nr = 0;
+	int c, mask = 0;
+
+	for (c = 0; c < NR_FIT_CLASSES; c++) {
+		u64 *s = sums[c];
+
+		if (!s[FIT_NR])
+			continue;
+		cov += (s64)(s[FIT_PAGES_NSEC] -
+			     mul_u64_u64_div_u64(s[FIT_PAGES], s[FIT_NSEC],
+						 s[FIT_NR]));
+		var += s[FIT_PAGES_SQ] -
+			mul_u64_u64_div_u64(s[FIT_PAGES], s[FIT_PAGES],
+					    s[FIT_NR]);
+		nr += s[FIT_NR];
+	}
+
+	/* need enough spread in IO sizes to tell per-page from per-IO cost */
+	if (nr >= FIT_MIN_SAMPLES && var >= nr) {
+		raw[FIT_PAGE] = cov > 0 ? div64_u64(cov, var) : 0;
+		mask |= 1 << FIT_PAGE;
+	} else {
+		raw[FIT_PAGE] = cur[FIT_PAGE];
+	}
+
+	for (c = 0; c < NR_FIT_CLASSES; c++) {
+		u64 *s = sums[c];
+		u64 page_nsec = raw[FIT_PAGE] * s[FIT_PAGES];
+
+		if (s[FIT_NR] < FIT_MIN_SAMPLES)
+			continue;
+		raw[base_coef[c]] = s[FIT_NSEC] > page_nsec ?
+			div64_u64(s[FIT_NSEC] - page_nsec, s[FIT_NR]) : 0;
+		mask |= 1 << base_coef[c];
+	}
+
+	return mask;
+}
+
+static u64 fit_mix_cost(u64 sums[NR_FIT_CLASSES][NR_FIT_SUMS], const u64 *c)
+{
+	return sums[FIT_SEQ][FIT_NR] * c[FIT_SEQIO] +
+		sums[FIT_RAND][FIT_NR] * c[FIT_RANDIO] +
+		(sums[FIT_SEQ][FIT_PAGES] + sums[FIT_RAND][FIT_PAGES]) *
+		c[FIT_PAGE];
+}
+
+/*
+ * Online cost model fitting for ctrl=fit.  Called from the period timer
+ * to fold the completions of the last period into smoothed per-direction
+ * estimates and, once they are trusted, into the model coefficients.
+ *
+ * The confidence of a direction is how closely the recent per-period
+ * estimates agree with the smoothed ones, ramped up over the first few
+ * periods which had enough samples.  It is published as rconf/wconf in
+ * io.cost.model.
+ *
+ * The fitted coefficients are rescaled so that the observed IO mix costs
+ * the same under the new model as under the current one.  The absolute
+ * device speed stays with the vrate feedback loop, which measures it
+ * directly against the QoS latency targets, while the fit corrects the
+ * relative costs that vrate can't see.
+ */
+static void ioc_fit_cost_model(struct ioc *ioc)
+{
+	u64 sums[2][NR_FIT_CLASSES][NR_FIT_SUMS] = { };
+	u64 cur[2][NR_FIT_COEFS];
+	u64 cur_cost = 0, fit_cost = 0;
+	bool apply[2] = { };
+	int rw, i;
+
+	lockdep_assert_held(&ioc->lock);
+
+	if (!ioc->fit_cost_model)
+		return;
+
+	ioc_fit_collect(ioc, sums);
+
+	for (rw = READ; rw <= WRITE; rw++) {
+		u64 *est = ioc->fit_nsec[rw];
+		u64 raw[NR_FIT_COEFS];
+		u32 dev_pct = 0;
+		int mask, nr_coefs = 0;
+
+		i_lcoefs_to_fit_nsec(&ioc->params.i_lcoefs[rw == READ ?
+					I_LCOEF_RBPS : I_LCOEF_WBPS], cur[rw]);
+
+		mask = ioc_fit_period(sums[rw], cur[rw], raw);
+		if (!mask)
+			continue;
+
+		for (i = 0; i < NR_FIT_COEFS; i++) {
+			if (!(mask & (1 << i)))
+				continue;
+			if (!est[i]) {
+				est[i] = raw[i];
+			} else {
+				dev_pct += min_t(u64, 100,
+					div64_u64(abs((s64)(raw[i] - est[i])) * 100,
+						  est[i]));
+				est[i] += div_s64((s64)(raw[i] - est[i]),
+						  1 << FIT_EWMA_SHIFT);
+			}
+			nr_coefs++;
+		}
+		dev_pct /= nr_coefs;
+
+		/* coefficients which haven't been seen yet keep their value */
+		for (i = 0; i < NR_FIT_COEFS; i++)
+			if (!est[i] && !(mask & (1 << i)))
+				est[i] = cur[rw][i];
+
+		/* be pessimistic while ramping up, then track the ewma */
+		if (ioc->fit_nr_periods[rw] < FIT_RAMP_PERIODS) {
+			ioc->fit_nr_periods[rw]++;
+			ioc->fit_dev_pct[rw] = max(ioc->fit_dev_pct[rw], dev_pct);
+		} else {
+			ioc->fit_dev_pct[rw] = (ioc->fit_dev_pct[rw] *
+				((1 << FIT_EWMA_SHIFT) - 1) + dev_pct) >>
+				FIT_EWMA_SHIFT;
+		}
+
+		ioc->fit_conf_pct[rw] = (100 -
+			min_t(u32, ioc->fit_dev_pct[rw], 100)) *
+			ioc->fit_nr_periods[rw] / FIT_RAMP_PERIODS;
+
+		if (ioc->fit_conf_pct[rw] >= FIT_CONF_MIN_PCT) {
+			apply[rw] = true;
+			cur_cost += fit_mix_cost(sums[rw], cur[rw]);
+			fit_cost += fit_mix_cost(sums[rw], est);
+		}
+	}
+
+	if (!fit_cost || !cur_cost)
+		return;
+
+	for (rw = READ; rw <= WRITE; rw++) {
+		u64 scaled[NR_FIT_COEFS];
+
+		if (!apply[rw])
+			continue;
+		for (i = 0; i < NR_FIT_COEFS; i++)
+			scaled[i] = mul_u64_u64_div_u64(ioc->fit_nsec[rw][i],
+							cur_cost, fit_cost);
+		fit_nsec_to_i_lcoefs(scaled, &ioc->params.i_lcoefs[rw == READ ?
+						I_LCOEF_RBPS : I_LCOEF_WBPS]);
+	}
+
+	ioc_refresh_lcoefs(ioc);
+}
+
 /*
  * When an iocg accumulates too much vtime or gets deactivated, we throw away
  * some vtime, which lowers the overall device utilization. As the exact amount
@@ -2429,6 +2721,7 @@ static void ioc_timer_fn(struct timer_list *timer)
 			      prev_busy_level, missed_ppm);
 
 	ioc_refresh_params(ioc, false);
+	ioc_fit_cost_model(ioc);
 
 	ioc_forgive_debts(ioc, usage_us_sum, nr_debtors, &now);
 
@@ -2794,11 +3087,37 @@ static void ioc_rqos_done_bio(struct rq_qos *rqos, struct bio *bio)
 		atomic64_add(bio->bi_iocost_cost, &iocg->done_vtime);
 }
 
+/*
+ * Record a completion for cost model fitting.  Like iocg->cursor, the
+ * seq/rand classification looks at the distance from the last IO, here
+ * the last completion in the same direction on this CPU.
+ */
+static void ioc_fit_account(struct ioc_pcpu_stat *ccs, struct request *rq,
+			    int rw, u64 now_ns)
+{
+	u64 sectors = blk_rq_stats_sectors(rq);
+	u64 pages = max_t(u64, sectors >> IOC_SECT_TO_PAGE_SHIFT, 1);
+	u64 nsec = now_ns - rq->io_start_time_ns;
+	u64 seek_pages;
+	local64_t *f;
+
+	seek_pages = abs((s64)(blk_rq_pos(rq) - ccs->fit_cursor[rw]));
+	seek_pages >>= IOC_SECT_TO_PAGE_SHIFT;
+	ccs->fit_cursor[rw] = blk_rq_pos(rq) + sectors;
+
+	f = ccs->fit[rw][seek_pages > LCOEF_RANDIO_PAGES ? FIT_RAND : FIT_SEQ];
+	local64_inc(&f[FIT_NR]);
+	local64_add(pages, &f[FIT_PAGES]);
+	local64_add(nsec, &f[FIT_NSEC]);
+	local64_add(pages * pages, &f[FIT_PAGES_SQ]);
+	local64_add(pages * nsec, &f[FIT_PAGES_NSEC]);
+}
+
 static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 {
 	struct ioc *ioc = rqos_to_ioc(rqos);
 	struct ioc_pcpu_stat *ccs;
-	u64 on_q_ns, rq_wait_ns, size_nsec;
+	u64 now_ns, on_q_ns, rq_wait_ns, size_nsec;
 	int pidx, rw;
 
 	if (!ioc->enabled || !rq->alloc_time_ns || !rq->start_time_ns)
@@ -2817,7 +3136,8 @@ static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 		return;
 	}
 
-	on_q_ns = ktime_get_ns() - rq->alloc_time_ns;
+	now_ns = ktime_get_ns();
+	on_q_ns = now_ns - rq->alloc_time_ns;
 	rq_wait_ns = rq->start_time_ns - rq->alloc_time_ns;
 	size_nsec = div64_u64(calc_size_vtime_cost(rq, ioc), VTIME_PER_NSEC);
 
@@ -2831,6 +3151,9 @@ static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 
 	local64_add(rq_wait_ns, &ccs->rq_wait_ns);
 
+	if (ioc->fit_cost_model && rq->io_start_time_ns)
+		ioc_fit_account(ccs, rq, rw, now_ns);
+
 	put_cpu_ptr(ccs);
 }
 
@@ -3363,10 +3686,15 @@ static u64 ioc_cost_model_prfill(struct seq_file *sf,
 	spin_lock_irq(&ioc->lock);
 	seq_printf(sf, "%s ctrl=%s model=linear "
 		   "rbps=%llu rseqiops=%llu rrandiops=%llu "
-		   "wbps=%llu wseqiops=%llu wrandiops=%llu\n",
-		   dname, ioc->user_cost_model ? "user" : "auto",
+		   "wbps=%llu wseqiops=%llu wrandiops=%llu",
+		   dname, ioc->fit_cost_model ? "fit" :
+		   ioc->user_cost_model ? "user" : "auto",
 		   u[I_LCOEF_RBPS], u[I_LCOEF_RSEQIOPS], u[I_LCOEF_RRANDIOPS],
 		   u[I_LCOEF_WBPS], u[I_LCOEF_WSEQIOPS], u[I_LCOEF_WRANDIOPS]);
+	if (ioc->fit_cost_model)
+		seq_printf(sf, " rconf=%u wconf=%u",
+			   ioc->fit_conf_pct[READ], ioc->fit_conf_pct[WRITE]);
+	seq_putc(sf, '\n');
 	spin_unlock_irq(&ioc->lock);
 	return 0;
 }
@@ -3403,7 +3731,7 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	struct request_queue *q;
 	struct ioc *ioc;
 	u64 u[NR_I_LCOEFS];
-	bool user;
+	bool user, fit;
 	char *body, *p;
 	int ret;
 
@@ -3434,6 +3762,7 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	spin_lock_irq(&ioc->lock);
 	memcpy(u, ioc->params.i_lcoefs, sizeof(u));
 	user = ioc->user_cost_model;
+	fit = ioc->fit_cost_model;
 
 	while ((p = strsep(&body, " \t\n"))) {
 		substring_t args[MAX_OPT_ARGS];
@@ -3447,12 +3776,18 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 		switch (match_token(p, cost_ctrl_tokens, args)) {
 		case COST_CTRL:
 			match_strlcpy(buf, &args[0], sizeof(buf));
-			if (!strcmp(buf, "auto"))
+			if (!strcmp(buf, "auto")) {
 				user = false;
-			else if (!strcmp(buf, "user"))
+				fit = false;
+			} else if (!strcmp(buf, "user")) {
 				user = true;
-			else
+				fit = false;
+			} else if (!strcmp(buf, "fit")) {
+				user = false;
+				fit = true;
+			} else {
 				goto einval;
+			}
 			continue;
 		case COST_MODEL:
 			match_strlcpy(buf, &args[0], sizeof(buf));
@@ -3467,14 +3802,24 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 		if (match_u64(&args[0], &v))
 			goto einval;
 		u[tok] = v;
-		user = true;
+		/* with ctrl=fit, explicit coefficients seed the fitting */
+		if (!fit)
+			user = true;
 	}
 
-	if (user) {
+	if (fit) {
+		memcpy(ioc->params.i_lcoefs, u, sizeof(u));
+		if (!ioc->fit_cost_model)
+			ioc_fit_reset(ioc);
+		ioc->user_cost_model = false;
+		ioc->fit_cost_model = true;
+	} else if (user) {
 		memcpy(ioc->params.i_lcoefs, u, sizeof(u));
 		ioc->user_cost_model = true;
+		ioc->fit_cost_model = false;
 	} else {
 		ioc->user_cost_model = false;
+		ioc->fit_cost_model = false;
 	}
 	ioc_refresh_params(ioc, true);
 	spin_unlock_irq(&ioc->lock);
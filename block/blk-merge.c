@@ -1000,6 +1000,34 @@ static enum bio_merge_status bio_attempt_back_merge(struct request *req,
 	return BIO_MERGE_OK;
 }
 
+/**
+ * blk_rq_back_merge_bio - append a bio to a request outside of submission
+ * @rq: request that has not been issued yet
+ * @bio: bio that was already split to the queue limits
+ *
+ * Used to build larger requests out of bios that were held back by the block
+ * layer, e.g. by zone write plugging. Returns false if @bio does not directly
+ * follow @rq or cannot be merged with it.
+ */
+bool blk_rq_back_merge_bio(struct request *rq, struct bio *bio)
+{
+	unsigned int nr_segs = 0, bytes = 0;
+	struct bvec_iter iter;
+	struct bio_vec bv;
+
+	if (!blk_rq_merge_ok(rq, bio) ||
+	    blk_try_merge(rq, bio) != ELEVATOR_BACK_MERGE)
+		return false;
+
+	if (bio_op(bio) != REQ_OP_WRITE_ZEROES) {
+		bio_for_each_bvec(bv, bio, iter)
+			bvec_split_segs(&rq->q->limits, &bv, &nr_segs, &bytes,
+					UINT_MAX, UINT_MAX);
+	}
+
+	return bio_attempt_back_merge(rq, bio, nr_segs) == BIO_MERGE_OK;
+}
+
 static enum bio_merge_status bio_attempt_front_merge(struct request *req,
 		struct bio *bio, unsigned int nr_segs)
 {
@@ -155,8 +155,17 @@ static ssize_t queue_state_write(void *data, const char __user *buf,
 	return count;
 }
 
+static int queue_plug_batch_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+
+	seq_printf(m, "%u\n", READ_ONCE(q->plug_batch) ?: BLK_MAX_REQUEST_COUNT);
+	return 0;
+}
+
 static const struct blk_mq_debugfs_attr blk_mq_debugfs_queue_attrs[] = {
 	{ "poll_stat", 0400, queue_poll_stat_show },
+	{ "plug_batch", 0400, queue_plug_batch_show },
 	{ "requeue_list", 0400, .seq_ops = &queue_requeue_list_seq_ops },
 	{ "pm_only", 0600, queue_pm_only_show, NULL },
 	{ "state", 0600, queue_state_show, queue_state_write },
@@ -598,6 +598,63 @@ void blk_mq_free_tags(struct blk_mq_tags *tags)
 	kfree(tags);
 }
 
+/*
+ * Tags shared by all hardware queues are handed out to CPUs on every node.
+ * On multi-node systems such tag maps are split into one contiguous slice
+ * of the (non-reserved) tag space per node with CPUs: the requests of a slice
+ * are allocated on that node by blk_mq_alloc_rqs(), and every CPU starts its
+ * tag search in the slice of its own node, see blk_mq_tag_seed_node_hints().
+ * Memory-only nodes get no slice, as no CPU would ever start searching there.
+ * Once a slice is exhausted the sbitmap search simply carries on into the
+ * slices of other nodes, so no tags are lost to the partitioning.
+ */
+bool blk_mq_tags_node_sliced(unsigned int hctx_idx)
+{
+	return hctx_idx == BLK_MQ_NO_HCTX_IDX && num_node_state(N_CPU) > 1;
+}
+
+/* Node whose slice @bit of a @depth deep tag map falls into. */
+int blk_mq_tag_slice_node(unsigned int bit, unsigned int depth)
+{
+	unsigned int idx = div_u64((u64)bit * num_node_state(N_CPU), depth);
+	int node;
+
+	for_each_node_state(node, N_CPU) {
+		if (!idx--)
+			return node;
+	}
+
+	return NUMA_NO_NODE;
+}
+
+/* First bit of the slice of @node in a @depth deep tag map. */
+static unsigned int blk_mq_tag_slice_start(int node, unsigned int depth)
+{
+	unsigned int idx = 0;
+	int n;
+
+	for_each_node_state(n, N_CPU) {
+		if (n == node)
+			return div_u64((u64)idx * depth, num_node_state(N_CPU));
+		idx++;
+	}
+
+	return 0;
+}
+
+void blk_mq_tag_seed_node_hints(struct blk_mq_tags *tags)
+{
+	struct sbitmap *sb = &tags->bitmap_tags.sb;
+	int cpu;
+
+	if (!sb->depth)
+		return;
+
+	for_each_possible_cpu(cpu)
+		*per_cpu_ptr(sb->alloc_hint, cpu) =
+			blk_mq_tag_slice_start(cpu_to_node(cpu), sb->depth);
+}
+
 int blk_mq_tag_update_depth(struct blk_mq_hw_ctx *hctx,
 			    struct blk_mq_tags **tagsptr, unsigned int tdepth,
 			    bool can_grow)
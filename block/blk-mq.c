@@ -695,6 +695,9 @@ static void blk_mq_finish_request(struct request *rq)
 		 */
 		rq->rq_flags &= ~RQF_USE_SCHED;
 	}
+
+	if (rq->rq_flags & RQF_ZONE_WRITE_PLUGGING)
+		blk_zone_write_plug_finish_request(rq);
 }
 
 static void __blk_mq_free_request(struct request *rq)
@@ -1234,6 +1237,34 @@ void blk_mq_complete_request(struct request *rq)
 }
 EXPORT_SYMBOL(blk_mq_complete_request);
 
+/**
+ * blk_mq_complete_request_batch - end I/O on a request, batching if possible
+ * @rq:		the request being processed
+ * @iob:	completion batch collected by the caller, may be %NULL
+ * @ioerror:	driver status for @rq, only error free requests are batched
+ * @complete:	driver callback used to end the batch
+ *
+ * Description:
+ *	Like blk_mq_complete_request(), but a request that would be completed
+ *	on the local CPU is added to @iob instead of running ->complete_rq
+ *	right away.  This lets interrupt driven drivers end everything they
+ *	reaped in one handler invocation with a single
+ *	blk_mq_end_request_batch() call, like the polled path already does.
+ *	Requests that need an IPI or softirq completion are still redirected.
+ *	The caller must run @iob->complete once it has dropped its queue
+ *	locks if @iob->req_list is not empty.
+ **/
+void blk_mq_complete_request_batch(struct request *rq,
+				   struct io_comp_batch *iob, int ioerror,
+				   void (*complete)(struct io_comp_batch *))
+{
+	if (blk_mq_complete_request_remote(rq))
+		return;
+	if (!blk_mq_add_to_batch(rq, iob, ioerror, complete))
+		rq->q->mq_ops->complete(rq);
+}
+EXPORT_SYMBOL_GPL(blk_mq_complete_request_batch);
+
 /**
  * blk_mq_start_request - Start processing a request
  * @rq: Pointer to request to be started
@@ -1270,15 +1301,96 @@ void blk_mq_start_request(struct request *rq)
 EXPORT_SYMBOL(blk_mq_start_request);
 
 /*
- * Allow 2x BLK_MAX_REQUEST_COUNT requests on plug queue for multiple
- * queues. This is important for md arrays to benefit from merging
- * requests.
+ * Adaptive plugging. When a completion latency target is configured for a
+ * queue, a blk-stat callback samples the mean completion latency every
+ * BLK_PLUG_ADAPT_WINDOW_MSECS and adjusts the number of requests a plug may
+ * hold for that queue: the batch is halved whenever the target is missed and
+ * grown gradually while latency stays well below it, up to
+ * BLK_PLUG_ADAPT_MAX_BATCH.
+ */
+#define BLK_PLUG_ADAPT_WINDOW_MSECS	100
+#define BLK_PLUG_ADAPT_MAX_BATCH	(BLK_MAX_REQUEST_COUNT * 2)
+
+static int blk_mq_plug_lat_bucket(const struct request *rq)
+{
+	if (req_op(rq) == REQ_OP_READ || req_op(rq) == REQ_OP_WRITE)
+		return 0;
+	return -1;
+}
+
+static void blk_mq_plug_lat_timer_fn(struct blk_stat_callback *cb)
+{
+	struct request_queue *q = cb->data;
+	const struct blk_rq_stat *stat = &cb->stat[0];
+	u64 target = READ_ONCE(q->plug_lat_target_nsec);
+	unsigned int batch = READ_ONCE(q->plug_batch);
+
+	if (!target)
+		return;
+
+	if (stat->nr_samples) {
+		if (stat->mean > target)
+			batch = max(batch / 2, 1U);
+		else if (stat->mean < target / 2)
+			batch = min(batch + batch / 4 + 1,
+				    (unsigned int)BLK_PLUG_ADAPT_MAX_BATCH);
+		WRITE_ONCE(q->plug_batch, batch);
+	}
+
+	blk_stat_activate_msecs(cb, BLK_PLUG_ADAPT_WINDOW_MSECS);
+}
+
+/**
+ * blk_mq_set_plug_lat_target - configure adaptive plug sizing for a queue
+ * @q: request queue
+ * @nsec: completion latency target in nanoseconds, 0 to disable
+ *
+ * Must be called with q->sysfs_lock held.
+ */
+int blk_mq_set_plug_lat_target(struct request_queue *q, u64 nsec)
+{
+	struct blk_stat_callback *cb = q->plug_cb;
+
+	lockdep_assert_held(&q->sysfs_lock);
+
+	if (!nsec) {
+		WRITE_ONCE(q->plug_lat_target_nsec, 0);
+		WRITE_ONCE(q->plug_batch, 0);
+		if (cb) {
+			blk_stat_remove_callback(q, cb);
+			blk_stat_free_callback(cb);
+			q->plug_cb = NULL;
+		}
+		return 0;
+	}
+
+	if (!cb) {
+		cb = blk_stat_alloc_callback(blk_mq_plug_lat_timer_fn,
+					     blk_mq_plug_lat_bucket, 1, q);
+		if (!cb)
+			return -ENOMEM;
+		q->plug_cb = cb;
+		WRITE_ONCE(q->plug_batch, BLK_MAX_REQUEST_COUNT);
+		blk_stat_add_callback(q, cb);
+	}
+
+	WRITE_ONCE(q->plug_lat_target_nsec, nsec);
+	blk_stat_activate_msecs(cb, BLK_PLUG_ADAPT_WINDOW_MSECS);
+	return 0;
+}
+
+/*
+ * Allow 2x the plug batch on plug queue for multiple queues. This is
+ * important for md arrays to benefit from merging requests.
  */
-static inline unsigned short blk_plug_max_rq_count(struct blk_plug *plug)
+static inline unsigned short blk_plug_max_rq_count(struct blk_plug *plug,
+						   struct request_queue *q)
 {
+	unsigned short batch = READ_ONCE(q->plug_batch) ?: BLK_MAX_REQUEST_COUNT;
+
 	if (plug->multiple_queues)
-		return BLK_MAX_REQUEST_COUNT * 2;
-	return BLK_MAX_REQUEST_COUNT;
+		return batch * 2;
+	return batch;
 }
 
 static void blk_add_rq_to_plug(struct blk_plug *plug, struct request *rq)
@@ -1287,7 +1399,7 @@ static void blk_add_rq_to_plug(struct blk_plug *plug, struct request *rq)
 
 	if (!plug->rq_count) {
 		trace_block_plug(rq->q);
-	} else if (plug->rq_count >= blk_plug_max_rq_count(plug) ||
+	} else if (plug->rq_count >= blk_plug_max_rq_count(plug, rq->q) ||
 		   (!blk_queue_nomerges(rq->q) &&
 		    blk_rq_bytes(last) >= BLK_PLUG_FLUSH_SIZE)) {
 		blk_mq_flush_plug_list(plug, false);
@@ -1549,6 +1661,19 @@ bool blk_mq_queue_inflight(struct request_queue *q)
 }
 EXPORT_SYMBOL_GPL(blk_mq_queue_inflight);
 
+/*
+ * Like blk_mq_queue_inflight(), but for all the queues sharing @set, e.g.
+ * the logical units behind one SCSI host.
+ */
+bool blk_mq_tagset_inflight(struct blk_mq_tag_set *set)
+{
+	bool busy = false;
+
+	blk_mq_tagset_busy_iter(set, blk_mq_rq_inflight, &busy);
+	return busy;
+}
+EXPORT_SYMBOL_GPL(blk_mq_tagset_inflight);
+
 static void blk_mq_rq_timed_out(struct request *req)
 {
 	req->rq_flags |= RQF_TIMED_OUT;
@@ -2986,6 +3111,19 @@ void blk_mq_submit_bio(struct bio *bio)
 	bio = blk_queue_bounce(bio, q);
 	bio_set_ioprio(bio);
 
+	/*
+	 * A bio released from a zone write plug has already been through the
+	 * preparation below and kept its queue usage reference while plugged.
+	 */
+	if (bio_zone_write_plugging(bio)) {
+		if (unlikely(bio_may_exceed_limits(bio, &q->limits))) {
+			bio = __bio_split_to_limits(bio, &q->limits, &nr_segs);
+			if (!bio)
+				goto fail;
+		}
+		goto new_request;
+	}
+
 	if (plug) {
 		rq = rq_list_peek(&plug->cached_rq);
 		if (rq && rq->q != q)
@@ -2999,6 +3137,8 @@ void blk_mq_submit_bio(struct bio *bio)
 		}
 		if (!bio_integrity_prep(bio))
 			return;
+		if (blk_zone_write_plug_bio(bio))
+			return;
 		if (blk_mq_attempt_bio_merge(q, bio, nr_segs))
 			return;
 		if (blk_mq_can_use_cached_rq(rq, plug, bio))
@@ -3014,8 +3154,14 @@ void blk_mq_submit_bio(struct bio *bio)
 		}
 		if (!bio_integrity_prep(bio))
 			goto fail;
+		if (blk_zone_write_plug_bio(bio)) {
+			/* the plug took its own queue reference */
+			blk_queue_exit(q);
+			return;
+		}
 	}
 
+new_request:
 	rq = blk_mq_get_new_requests(q, plug, bio, nr_segs);
 	if (unlikely(!rq)) {
 fail:
@@ -3038,6 +3184,9 @@ void blk_mq_submit_bio(struct bio *bio)
 		return;
 	}
 
+	if (bio_zone_write_plugging(bio))
+		blk_zone_write_plug_init_request(rq);
+
 	if (op_is_flush(bio->bi_opf) && blk_insert_flush(rq))
 		return;
 
@@ -3411,6 +3560,8 @@ static int blk_mq_alloc_rqs(struct blk_mq_tag_set *set,
 {
 	unsigned int i, j, entries_per_page, max_order = 4;
 	int node = blk_mq_get_hctx_node(set, hctx_idx);
+	bool sliced = blk_mq_tags_node_sliced(hctx_idx);
+	unsigned int reserved = tags->nr_reserved_tags;
 	size_t rq_size, left;
 
 	if (node == NUMA_NO_NODE)
@@ -3432,6 +3583,13 @@ static int blk_mq_alloc_rqs(struct blk_mq_tag_set *set,
 		int to_do;
 		void *p;
 
+		/* Back each node's slice of a shared tag map with local memory */
+		if (sliced && i >= reserved) {
+			node = blk_mq_tag_slice_node(i - reserved, depth - reserved);
+			if (node == NUMA_NO_NODE)
+				node = set->numa_node;
+		}
+
 		while (this_order && left < order_to_size(this_order - 1))
 			this_order--;
 
@@ -3827,6 +3985,9 @@ struct blk_mq_tags *blk_mq_alloc_map_and_rqs(struct blk_mq_tag_set *set,
 		return NULL;
 	}
 
+	if (blk_mq_tags_node_sliced(hctx_idx))
+		blk_mq_tag_seed_node_hints(tags);
+
 	return tags;
 }
 
@@ -4322,6 +4483,12 @@ void blk_mq_exit_queue(struct request_queue *q)
 {
 	struct blk_mq_tag_set *set = q->tag_set;
 
+	if (q->plug_cb) {
+		mutex_lock(&q->sysfs_lock);
+		blk_mq_set_plug_lat_target(q, 0);
+		mutex_unlock(&q->sysfs_lock);
+	}
+
 	/* Checks hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED. */
 	blk_mq_exit_hw_queues(q, set, set->nr_hw_queues);
 	/* May clear BLK_MQ_F_TAG_QUEUE_SHARED in hctx->flags. */
@@ -43,6 +43,7 @@ void blk_mq_submit_bio(struct bio *bio);
 int blk_mq_poll(struct request_queue *q, blk_qc_t cookie, struct io_comp_batch *iob,
 		unsigned int flags);
 void blk_mq_exit_queue(struct request_queue *q);
+int blk_mq_set_plug_lat_target(struct request_queue *q, u64 nsec);
 int blk_mq_update_nr_requests(struct request_queue *q, unsigned int nr);
 void blk_mq_wake_waiters(struct request_queue *q);
 bool blk_mq_dispatch_rq_list(struct blk_mq_hw_ctx *hctx, struct list_head *,
@@ -163,6 +164,9 @@ struct blk_mq_alloc_data {
 struct blk_mq_tags *blk_mq_init_tags(unsigned int nr_tags,
 		unsigned int reserved_tags, int node, int alloc_policy);
 void blk_mq_free_tags(struct blk_mq_tags *tags);
+bool blk_mq_tags_node_sliced(unsigned int hctx_idx);
+int blk_mq_tag_slice_node(unsigned int bit, unsigned int depth);
+void blk_mq_tag_seed_node_hints(struct blk_mq_tags *tags);
 int blk_mq_init_bitmaps(struct sbitmap_queue *bitmap_tags,
 		struct sbitmap_queue *breserved_tags, unsigned int queue_depth,
 		unsigned int reserved, int node, int alloc_policy);
@@ -528,6 +528,9 @@ QUEUE_RW_ENTRY(queue_io_timeout, "io_timeout");
 QUEUE_RO_ENTRY(queue_virt_boundary_mask, "virt_boundary_mask");
 QUEUE_RO_ENTRY(queue_dma_alignment, "dma_alignment");
 
+#ifdef CONFIG_BLK_DEV_THROTTLING
+QUEUE_RW_ENTRY(blk_throtl_batch, "throttle_batch");
+#endif
 #ifdef CONFIG_BLK_DEV_THROTTLING_LOW
 QUEUE_RW_ENTRY(blk_throtl_sample_time, "throttle_sample_time");
 #endif
@@ -543,6 +546,32 @@ QUEUE_RW_ENTRY(queue_iostats, "iostats");
 QUEUE_RW_ENTRY(queue_random, "add_random");
 QUEUE_RW_ENTRY(queue_stable_writes, "stable_writes");
 
+static ssize_t queue_plug_lat_show(struct request_queue *q, char *page)
+{
+	return sprintf(page, "%llu\n",
+		       div_u64(READ_ONCE(q->plug_lat_target_nsec), 1000));
+}
+
+static ssize_t queue_plug_lat_store(struct request_queue *q, const char *page,
+				    size_t count)
+{
+	unsigned long val;
+	ssize_t ret;
+	int err;
+
+	ret = queue_var_store(&val, page, count);
+	if (ret < 0)
+		return ret;
+
+	err = blk_mq_set_plug_lat_target(q, val * 1000ULL);
+	if (err)
+		return err;
+
+	return ret;
+}
+
+QUEUE_RW_ENTRY(queue_plug_lat, "plug_lat_usec");
+
 #ifdef CONFIG_BLK_WBT
 static ssize_t queue_var_store64(s64 *var, const char *page)
 {
@@ -651,6 +680,9 @@ static struct attribute *queue_attrs[] = {
 	&queue_fua_entry.attr,
 	&queue_dax_entry.attr,
 	&queue_poll_delay_entry.attr,
+#ifdef CONFIG_BLK_DEV_THROTTLING
+	&blk_throtl_batch_entry.attr,
+#endif
 #ifdef CONFIG_BLK_DEV_THROTTLING_LOW
 	&blk_throtl_sample_time_entry.attr,
 #endif
@@ -664,6 +696,7 @@ static struct attribute *blk_mq_queue_attrs[] = {
 	&elv_iosched_entry.attr,
 	&queue_rq_affinity_entry.attr,
 	&queue_io_timeout_entry.attr,
+	&queue_plug_lat_entry.attr,
 #ifdef CONFIG_BLK_WBT
 	&queue_wb_lat_entry.attr,
 #endif
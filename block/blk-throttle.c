@@ -21,6 +21,15 @@
 /* Total max dispatch from all groups in one round */
 #define THROTL_QUANTUM 32
 
+/*
+ * In batch mode a group dispatches up to throtl_data->dispatch_batch bios
+ * per round against a budget computed once per round, and dispatch times
+ * are aligned to a grid of throtl_slice / THROTL_BATCH_GRID_DIV so that
+ * groups becoming ready around the same time share a timer expiry.
+ */
+#define THROTL_BATCH_MAX 1024
+#define THROTL_BATCH_GRID_DIV 5
+
 /* Throttling is performed over a slice and after that slice is renewed */
 #define DFL_THROTL_SLICE_HD (HZ / 10)
 #define DFL_THROTL_SLICE_SSD (HZ / 50)
@@ -68,6 +77,9 @@ struct throtl_data
 
 	unsigned int throtl_slice;
 
+	/* max bios per group per dispatch round in batch mode, 0 if off */
+	unsigned int dispatch_batch;
+
 	/* Work for dispatching throttled bios */
 	struct work_struct dispatch_work;
 	unsigned int limit_index;
@@ -1023,6 +1035,12 @@ static void tg_update_disptime(struct throtl_grp *tg)
 	min_wait = min(read_wait, write_wait);
 	disptime = jiffies + min_wait;
 
+	/* let groups that are ready around the same time share an expiry */
+	if (tg->td->dispatch_batch && min_wait)
+		disptime = roundup(disptime,
+				   max(tg->td->throtl_slice /
+				       THROTL_BATCH_GRID_DIV, 1U));
+
 	/* Update dispatch time */
 	throtl_rb_erase(&tg->rb_node, tg->service_queue.parent_sq);
 	tg->disptime = disptime;
@@ -1085,14 +1103,105 @@ static void tg_dispatch_one_bio(struct throtl_grp *tg, bool rw)
 		blkg_put(tg_to_blkg(tg_to_put));
 }
 
+/*
+ * Calculate how many ios and bytes @tg may dispatch in direction @rw right
+ * now.  This is the same calculation tg_may_dispatch() does for a single
+ * bio, done once for the whole batch.  Must only be called while @tg has
+ * bios queued in @rw and thus an active slice.
+ */
+static void tg_dispatch_budget(struct throtl_grp *tg, bool rw,
+			       unsigned int *ios, u64 *bytes)
+{
+	u64 bps_limit = tg_bps_limit(tg, rw);
+	u32 iops_limit = tg_iops_limit(tg, rw);
+	unsigned long jiffy_elapsed, jiffy_elapsed_rnd;
+
+	*ios = UINT_MAX;
+	*bytes = U64_MAX;
+
+	if ((bps_limit == U64_MAX && iops_limit == UINT_MAX) ||
+	    tg->flags & THROTL_TG_CANCELING)
+		return;
+
+	if (time_before(tg->slice_end[rw], jiffies + tg->td->throtl_slice))
+		throtl_extend_slice(tg, rw, jiffies + tg->td->throtl_slice);
+
+	jiffy_elapsed = jiffies - tg->slice_start[rw];
+
+	if (iops_limit != UINT_MAX) {
+		int io_allowed;
+
+		jiffy_elapsed_rnd = roundup(jiffy_elapsed + 1,
+					    tg->td->throtl_slice);
+		io_allowed = calculate_io_allowed(iops_limit,
+						  jiffy_elapsed_rnd) +
+			     tg->carryover_ios[rw];
+		if (io_allowed > 0 && io_allowed > tg->io_disp[rw])
+			*ios = io_allowed - tg->io_disp[rw];
+		else
+			*ios = 0;
+	}
+
+	if (bps_limit != U64_MAX) {
+		long long bytes_allowed;
+
+		jiffy_elapsed_rnd = roundup(jiffy_elapsed ?: tg->td->throtl_slice,
+					    tg->td->throtl_slice);
+		bytes_allowed = calculate_bytes_allowed(bps_limit,
+							jiffy_elapsed_rnd) +
+				tg->carryover_bytes[rw];
+		if (bytes_allowed > 0 && bytes_allowed > tg->bytes_disp[rw])
+			*bytes = bytes_allowed - tg->bytes_disp[rw];
+		else
+			*bytes = 0;
+	}
+}
+
+static unsigned int throtl_dispatch_tg_batch(struct throtl_grp *tg, bool rw,
+					     unsigned int max_nr)
+{
+	struct throtl_service_queue *sq = &tg->service_queue;
+	unsigned int ios, nr = 0;
+	struct bio *bio;
+	u64 bytes;
+
+	if (!sq->nr_queued[rw])
+		return 0;
+
+	tg_dispatch_budget(tg, rw, &ios, &bytes);
+	max_nr = min(max_nr, ios);
+
+	while (nr < max_nr && (bio = throtl_peek_queued(&sq->queued[rw]))) {
+		if (bytes != U64_MAX && !bio_flagged(bio, BIO_BPS_THROTTLED)) {
+			unsigned int bio_size = throtl_bio_data_size(bio);
+
+			if (bio_size > bytes)
+				break;
+			bytes -= bio_size;
+		}
+		tg_dispatch_one_bio(tg, rw);
+		nr++;
+	}
+
+	return nr;
+}
+
 static int throtl_dispatch_tg(struct throtl_grp *tg)
 {
 	struct throtl_service_queue *sq = &tg->service_queue;
+	unsigned int batch = tg->td->dispatch_batch;
 	unsigned int nr_reads = 0, nr_writes = 0;
 	unsigned int max_nr_reads = THROTL_GRP_QUANTUM * 3 / 4;
 	unsigned int max_nr_writes = THROTL_GRP_QUANTUM - max_nr_reads;
 	struct bio *bio;
 
+	if (batch) {
+		max_nr_reads = max(batch * 3 / 4, 1U);
+		max_nr_writes = max(batch - max_nr_reads, 1U);
+		return throtl_dispatch_tg_batch(tg, READ, max_nr_reads) +
+		       throtl_dispatch_tg_batch(tg, WRITE, max_nr_writes);
+	}
+
 	/* Try to dispatch 75% READS and 25% WRITES */
 
 	while ((bio = throtl_peek_queued(&sq->queued[READ])) &&
@@ -1120,8 +1229,15 @@ static int throtl_dispatch_tg(struct throtl_grp *tg)
 
 static int throtl_select_dispatch(struct throtl_service_queue *parent_sq)
 {
+	unsigned int quantum = THROTL_QUANTUM;
 	unsigned int nr_disp = 0;
 
+	/* in batch mode, drop the queue lock every few full group batches */
+	if (sq_to_td(parent_sq)->dispatch_batch)
+		quantum = max_t(unsigned int, quantum,
+				sq_to_td(parent_sq)->dispatch_batch *
+				(THROTL_QUANTUM / THROTL_GRP_QUANTUM));
+
 	while (1) {
 		struct throtl_grp *tg;
 		struct throtl_service_queue *sq;
@@ -1144,7 +1260,7 @@ static int throtl_select_dispatch(struct throtl_service_queue *parent_sq)
 		else
 			throtl_dequeue_tg(tg);
 
-		if (nr_disp >= THROTL_QUANTUM)
+		if (nr_disp >= quantum)
 			break;
 	}
 
@@ -2453,6 +2569,31 @@ void blk_throtl_register(struct gendisk *disk)
 #endif
 }
 
+ssize_t blk_throtl_batch_show(struct request_queue *q, char *page)
+{
+	if (!q->td)
+		return -EINVAL;
+	return sprintf(page, "%u\n", q->td->dispatch_batch);
+}
+
+ssize_t blk_throtl_batch_store(struct request_queue *q, const char *page,
+			       size_t count)
+{
+	unsigned int v;
+
+	if (!q->td)
+		return -EINVAL;
+	if (kstrtouint(page, 10, &v))
+		return -EINVAL;
+	if (v > THROTL_BATCH_MAX)
+		return -EINVAL;
+
+	spin_lock_irq(&q->queue_lock);
+	q->td->dispatch_batch = v;
+	spin_unlock_irq(&q->queue_lock);
+	return count;
+}
+
 #ifdef CONFIG_BLK_DEV_THROTTLING_LOW
 ssize_t blk_throtl_sample_time_show(struct request_queue *q, char *page)
 {
@@ -28,6 +28,7 @@
 #include "blk-stat.h"
 #include "blk-wbt.h"
 #include "blk-rq-qos.h"
+#include "blk-cgroup.h"
 #include "elevator.h"
 
 #define CREATE_TRACE_POINTS
@@ -40,6 +41,13 @@ enum wbt_flags {
 	WBT_DISCARD		= 8,	/* discard */
 
 	WBT_NR_BITS		= 4,	/* number of bits */
+
+	/*
+	 * The bits above WBT_NR_BITS hold the index of the domain the
+	 * request was accounted to, 0 being the queue default domain.
+	 */
+	WBT_DOMAIN_SHIFT	= WBT_NR_BITS,
+	WBT_NR_DOMAINS		= 16,
 };
 
 enum {
@@ -61,21 +69,38 @@ enum {
 	WBT_STATE_OFF_MANUAL	= 4,	/* off manually by sysfs */
 };
 
-struct rq_wb {
+/*
+ * Depth and scaling state for one set of throttled writers. Every queue has
+ * a default domain; under CONFIG_BLK_CGROUP, cgroups with their own latency
+ * target get a domain of their own, so that they are scaled independently of
+ * writeback issued from other cgroups.
+ */
+struct wbt_domain {
 	/*
 	 * Settings that govern how we throttle
 	 */
 	unsigned int wb_background;		/* background writeback */
 	unsigned int wb_normal;			/* normal writeback */
 
-	short enable_state;			/* WBT_STATE_* */
-
 	/*
 	 * Number of consecutive periods where we don't have enough
 	 * information to make a firm scale up/down decision.
 	 */
 	unsigned int unknown_cnt;
 
+	unsigned long min_lat_nsec;
+	struct rq_wait rq_wait[WBT_NUM_RWQ];
+	struct rq_depth rq_depth;
+
+#ifdef CONFIG_BLK_CGROUP
+	int nr_grps;				/* cgroups using this domain */
+	struct blk_rq_stat __percpu *cpu_stat;	/* READ/WRITE completions */
+#endif
+};
+
+struct rq_wb {
+	short enable_state;			/* WBT_STATE_* */
+
 	u64 win_nsec;				/* default window size */
 	u64 cur_win_nsec;			/* current window size */
 
@@ -88,10 +113,13 @@ struct rq_wb {
 
 	unsigned long last_issue;		/* last non-throttled issue */
 	unsigned long last_comp;		/* last non-throttled comp */
-	unsigned long min_lat_nsec;
 	struct rq_qos rqos;
-	struct rq_wait rq_wait[WBT_NUM_RWQ];
-	struct rq_depth rq_depth;
+	struct wbt_domain dom;			/* default domain */
+
+#ifdef CONFIG_BLK_CGROUP
+	spinlock_t grp_lock;			/* protects grp_dom assignment */
+	struct wbt_domain *grp_dom[WBT_NR_DOMAINS];
+#endif
 };
 
 static inline struct rq_wb *RQWB(struct rq_qos *rqos)
@@ -170,31 +198,43 @@ static bool wb_recent_wait(struct rq_wb *rwb)
 	return time_before(jiffies, bdi->last_bdp_sleep + HZ);
 }
 
-static inline struct rq_wait *get_rq_wait(struct rq_wb *rwb,
+static inline struct wbt_domain *wbt_domain(struct rq_wb *rwb,
+					   enum wbt_flags wb_acct)
+{
+#ifdef CONFIG_BLK_CGROUP
+	unsigned int idx = wb_acct >> WBT_DOMAIN_SHIFT;
+
+	if (idx)
+		return rwb->grp_dom[idx];
+#endif
+	return &rwb->dom;
+}
+
+static inline struct rq_wait *get_rq_wait(struct wbt_domain *dom,
 					  enum wbt_flags wb_acct)
 {
 	if (wb_acct & WBT_KSWAPD)
-		return &rwb->rq_wait[WBT_RWQ_KSWAPD];
+		return &dom->rq_wait[WBT_RWQ_KSWAPD];
 	else if (wb_acct & WBT_DISCARD)
-		return &rwb->rq_wait[WBT_RWQ_DISCARD];
+		return &dom->rq_wait[WBT_RWQ_DISCARD];
 
-	return &rwb->rq_wait[WBT_RWQ_BG];
+	return &dom->rq_wait[WBT_RWQ_BG];
 }
 
-static void rwb_wake_all(struct rq_wb *rwb)
+static void rwb_wake_all(struct wbt_domain *dom)
 {
 	int i;
 
 	for (i = 0; i < WBT_NUM_RWQ; i++) {
-		struct rq_wait *rqw = &rwb->rq_wait[i];
+		struct rq_wait *rqw = &dom->rq_wait[i];
 
 		if (wq_has_sleeper(&rqw->wait))
 			wake_up_all(&rqw->wait);
 	}
 }
 
-static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
-			 enum wbt_flags wb_acct)
+static void wbt_rqw_done(struct rq_wb *rwb, struct wbt_domain *dom,
+			 struct rq_wait *rqw, enum wbt_flags wb_acct)
 {
 	int inflight, limit;
 
@@ -206,11 +246,11 @@ static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
 	 * wake people up.
 	 */
 	if (wb_acct & WBT_DISCARD)
-		limit = rwb->wb_background;
+		limit = dom->wb_background;
 	else if (rwb->wc && !wb_recent_wait(rwb))
 		limit = 0;
 	else
-		limit = rwb->wb_normal;
+		limit = dom->wb_normal;
 
 	/*
 	 * Don't wake anyone up if we are above the normal limit.
@@ -221,7 +261,7 @@ static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
 	if (wq_has_sleeper(&rqw->wait)) {
 		int diff = limit - inflight;
 
-		if (!inflight || diff >= rwb->wb_background / 2)
+		if (!inflight || diff >= dom->wb_background / 2)
 			wake_up_all(&rqw->wait);
 	}
 }
@@ -229,15 +269,45 @@ static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
 static void __wbt_done(struct rq_qos *rqos, enum wbt_flags wb_acct)
 {
 	struct rq_wb *rwb = RQWB(rqos);
-	struct rq_wait *rqw;
+	struct wbt_domain *dom;
 
 	if (!(wb_acct & WBT_TRACKED))
 		return;
 
-	rqw = get_rq_wait(rwb, wb_acct);
-	wbt_rqw_done(rwb, rqw, wb_acct);
+	dom = wbt_domain(rwb, wb_acct);
+	wbt_rqw_done(rwb, dom, get_rq_wait(dom, wb_acct), wb_acct);
 }
 
+#ifdef CONFIG_BLK_CGROUP
+/*
+ * The queue wide stats callback only sees the device as a whole. Requests
+ * accounted to a cgroup domain additionally feed that domain's own window.
+ */
+static void wbt_domain_account(struct rq_wb *rwb, struct request *rq)
+{
+	struct wbt_domain *dom;
+	struct blk_rq_stat *stat;
+	u64 now;
+
+	if (!(wbt_flags(rq) >> WBT_DOMAIN_SHIFT) || !rq->io_start_time_ns)
+		return;
+
+	now = ktime_get_ns();
+	if (now <= rq->io_start_time_ns)
+		return;
+
+	dom = wbt_domain(rwb, wbt_flags(rq));
+	stat = get_cpu_ptr(dom->cpu_stat);
+	blk_rq_stat_add(&stat[wbt_is_read(rq) ? READ : WRITE],
+			now - rq->io_start_time_ns);
+	put_cpu_ptr(dom->cpu_stat);
+}
+#else
+static inline void wbt_domain_account(struct rq_wb *rwb, struct request *rq)
+{
+}
+#endif
+
 /*
  * Called on completion of a request. Note that it's also called when
  * a request is merged, when the request gets freed.
@@ -246,6 +316,8 @@ static void wbt_done(struct rq_qos *rqos, struct request *rq)
 {
 	struct rq_wb *rwb = RQWB(rqos);
 
+	wbt_domain_account(rwb, rq);
+
 	if (!wbt_is_tracked(rq)) {
 		if (rwb->sync_cookie == rq) {
 			rwb->sync_issue = 0;
@@ -284,12 +356,12 @@ static u64 rwb_sync_issue_lat(struct rq_wb *rwb)
 	return now - issue;
 }
 
-static inline unsigned int wbt_inflight(struct rq_wb *rwb)
+static inline unsigned int wbt_inflight(struct wbt_domain *dom)
 {
 	unsigned int i, ret = 0;
 
 	for (i = 0; i < WBT_NUM_RWQ; i++)
-		ret += atomic_read(&rwb->rq_wait[i].inflight);
+		ret += atomic_read(&dom->rq_wait[i].inflight);
 
 	return ret;
 }
@@ -301,10 +373,11 @@ enum {
 	LAT_EXCEEDED,
 };
 
-static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
+static int latency_exceeded(struct rq_wb *rwb, struct wbt_domain *dom,
+			    struct blk_rq_stat *stat)
 {
 	struct backing_dev_info *bdi = rwb->rqos.disk->bdi;
-	struct rq_depth *rqd = &rwb->rq_depth;
+	struct rq_depth *rqd = &dom->rq_depth;
 	u64 thislat;
 
 	/*
@@ -315,10 +388,12 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 	 * to complete after being issued. If this time exceeds our
 	 * monitoring window AND we didn't see any other completions in that
 	 * window, then count that sync IO as a violation of the latency.
+	 * The sync cookie isn't tied to a domain, only the default domain
+	 * looks at it.
 	 */
-	thislat = rwb_sync_issue_lat(rwb);
+	thislat = dom == &rwb->dom ? rwb_sync_issue_lat(rwb) : 0;
 	if (thislat > rwb->cur_win_nsec ||
-	    (thislat > rwb->min_lat_nsec && !stat[READ].nr_samples)) {
+	    (thislat > dom->min_lat_nsec && !stat[READ].nr_samples)) {
 		trace_wbt_lat(bdi, thislat);
 		return LAT_EXCEEDED;
 	}
@@ -334,7 +409,7 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 		 * just writes as well.
 		 */
 		if (stat[WRITE].nr_samples || wb_recent_wait(rwb) ||
-		    wbt_inflight(rwb))
+		    wbt_inflight(dom))
 			return LAT_UNKNOWN_WRITES;
 		return LAT_UNKNOWN;
 	}
@@ -342,7 +417,7 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 	/*
 	 * If the 'min' latency exceeds our target, step down.
 	 */
-	if (stat[READ].min > rwb->min_lat_nsec) {
+	if (stat[READ].min > dom->min_lat_nsec) {
 		trace_wbt_lat(bdi, stat[READ].min);
 		trace_wbt_stat(bdi, stat);
 		return LAT_EXCEEDED;
@@ -354,50 +429,52 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 	return LAT_OK;
 }
 
-static void rwb_trace_step(struct rq_wb *rwb, const char *msg)
+static void rwb_trace_step(struct rq_wb *rwb, struct wbt_domain *dom,
+			   const char *msg)
 {
 	struct backing_dev_info *bdi = rwb->rqos.disk->bdi;
-	struct rq_depth *rqd = &rwb->rq_depth;
+	struct rq_depth *rqd = &dom->rq_depth;
 
 	trace_wbt_step(bdi, msg, rqd->scale_step, rwb->cur_win_nsec,
-			rwb->wb_background, rwb->wb_normal, rqd->max_depth);
+			dom->wb_background, dom->wb_normal, rqd->max_depth);
 }
 
-static void calc_wb_limits(struct rq_wb *rwb)
+static void calc_wb_limits(struct wbt_domain *dom)
 {
-	if (rwb->min_lat_nsec == 0) {
-		rwb->wb_normal = rwb->wb_background = 0;
-	} else if (rwb->rq_depth.max_depth <= 2) {
-		rwb->wb_normal = rwb->rq_depth.max_depth;
-		rwb->wb_background = 1;
+	if (dom->min_lat_nsec == 0) {
+		dom->wb_normal = dom->wb_background = 0;
+	} else if (dom->rq_depth.max_depth <= 2) {
+		dom->wb_normal = dom->rq_depth.max_depth;
+		dom->wb_background = 1;
 	} else {
-		rwb->wb_normal = (rwb->rq_depth.max_depth + 1) / 2;
-		rwb->wb_background = (rwb->rq_depth.max_depth + 3) / 4;
+		dom->wb_normal = (dom->rq_depth.max_depth + 1) / 2;
+		dom->wb_background = (dom->rq_depth.max_depth + 3) / 4;
 	}
 }
 
-static void scale_up(struct rq_wb *rwb)
+static void scale_up(struct rq_wb *rwb, struct wbt_domain *dom)
 {
-	if (!rq_depth_scale_up(&rwb->rq_depth))
+	if (!rq_depth_scale_up(&dom->rq_depth))
 		return;
-	calc_wb_limits(rwb);
-	rwb->unknown_cnt = 0;
-	rwb_wake_all(rwb);
-	rwb_trace_step(rwb, tracepoint_string("scale up"));
+	calc_wb_limits(dom);
+	dom->unknown_cnt = 0;
+	rwb_wake_all(dom);
+	rwb_trace_step(rwb, dom, tracepoint_string("scale up"));
 }
 
-static void scale_down(struct rq_wb *rwb, bool hard_throttle)
+static void scale_down(struct rq_wb *rwb, struct wbt_domain *dom,
+		       bool hard_throttle)
 {
-	if (!rq_depth_scale_down(&rwb->rq_depth, hard_throttle))
+	if (!rq_depth_scale_down(&dom->rq_depth, hard_throttle))
 		return;
-	calc_wb_limits(rwb);
-	rwb->unknown_cnt = 0;
-	rwb_trace_step(rwb, tracepoint_string("scale down"));
+	calc_wb_limits(dom);
+	dom->unknown_cnt = 0;
+	rwb_trace_step(rwb, dom, tracepoint_string("scale down"));
 }
 
 static void rwb_arm_timer(struct rq_wb *rwb)
 {
-	struct rq_depth *rqd = &rwb->rq_depth;
+	struct rq_depth *rqd = &rwb->dom.rq_depth;
 
 	if (rqd->scale_step > 0) {
 		/*
@@ -419,31 +496,22 @@ static void rwb_arm_timer(struct rq_wb *rwb)
 	blk_stat_activate_nsecs(rwb->cb, rwb->cur_win_nsec);
 }
 
-static void wb_timer_fn(struct blk_stat_callback *cb)
+/*
+ * If we exceeded the latency target, step down. If we did not,
+ * step one level up. If we don't know enough to say either exceeded
+ * or ok, then don't do anything.
+ */
+static void wbt_domain_step(struct rq_wb *rwb, struct wbt_domain *dom,
+			    int status)
 {
-	struct rq_wb *rwb = cb->data;
-	struct rq_depth *rqd = &rwb->rq_depth;
-	unsigned int inflight = wbt_inflight(rwb);
-	int status;
-
-	if (!rwb->rqos.disk)
-		return;
-
-	status = latency_exceeded(rwb, cb->stat);
-
-	trace_wbt_timer(rwb->rqos.disk->bdi, status, rqd->scale_step, inflight);
+	struct rq_depth *rqd = &dom->rq_depth;
 
-	/*
-	 * If we exceeded the latency target, step down. If we did not,
-	 * step one level up. If we don't know enough to say either exceeded
-	 * or ok, then don't do anything.
-	 */
 	switch (status) {
 	case LAT_EXCEEDED:
-		scale_down(rwb, true);
+		scale_down(rwb, dom, true);
 		break;
 	case LAT_OK:
-		scale_up(rwb);
+		scale_up(rwb, dom);
 		break;
 	case LAT_UNKNOWN_WRITES:
 		/*
@@ -451,10 +519,10 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 		 * read/write sample, but we do have writes going on.
 		 * Allow step to go negative, to increase write perf.
 		 */
-		scale_up(rwb);
+		scale_up(rwb, dom);
 		break;
 	case LAT_UNKNOWN:
-		if (++rwb->unknown_cnt < RWB_UNKNOWN_BUMP)
+		if (++dom->unknown_cnt < RWB_UNKNOWN_BUMP)
 			break;
 		/*
 		 * We get here when previously scaled reduced depth, and we
@@ -462,33 +530,349 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 		 * case, slowly return to center state (step == 0).
 		 */
 		if (rqd->scale_step > 0)
-			scale_up(rwb);
+			scale_up(rwb, dom);
 		else if (rqd->scale_step < 0)
-			scale_down(rwb, false);
+			scale_down(rwb, dom, false);
 		break;
 	default:
 		break;
 	}
+}
+
+#ifdef CONFIG_BLK_CGROUP
+static void wbt_domain_collect(struct wbt_domain *dom,
+			       struct blk_rq_stat *stat)
+{
+	int cpu, i;
+
+	blk_rq_stat_init(&stat[READ]);
+	blk_rq_stat_init(&stat[WRITE]);
+
+	for_each_online_cpu(cpu) {
+		struct blk_rq_stat *cpu_stat = per_cpu_ptr(dom->cpu_stat, cpu);
+
+		for (i = 0; i < 2; i++) {
+			blk_rq_stat_sum(&stat[i], &cpu_stat[i]);
+			blk_rq_stat_init(&cpu_stat[i]);
+		}
+	}
+}
+
+/*
+ * Evaluate the cgroup domains for the window that just ended. A domain that
+ * missed its target steps down every domain whose target is at least as
+ * loose, including the default one, while domains with tighter targets are
+ * left to make their own decision. This keeps background writeback from a
+ * relaxed cgroup from shrinking the depth of a latency sensitive one.
+ *
+ * Returns true if any cgroup domain still needs the timer.
+ */
+static bool wbt_grp_timer(struct rq_wb *rwb, int *status)
+{
+	int grp_status[WBT_NR_DOMAINS] = { };
+	struct blk_rq_stat stat[2];
+	u64 miss_lat = U64_MAX;
+	bool active = false;
+	int i;
+
+	if (*status == LAT_EXCEEDED)
+		miss_lat = rwb->dom.min_lat_nsec;
+
+	for (i = 1; i < WBT_NR_DOMAINS; i++) {
+		struct wbt_domain *dom = rwb->grp_dom[i];
+
+		if (!dom || !READ_ONCE(dom->nr_grps))
+			continue;
+
+		wbt_domain_collect(dom, stat);
+		grp_status[i] = latency_exceeded(rwb, dom, stat);
+		if (grp_status[i] == LAT_EXCEEDED)
+			miss_lat = min_t(u64, miss_lat, dom->min_lat_nsec);
+	}
+
+	for (i = 1; i < WBT_NR_DOMAINS; i++) {
+		struct wbt_domain *dom = rwb->grp_dom[i];
+
+		if (!grp_status[i])
+			continue;
+
+		if (miss_lat <= dom->min_lat_nsec)
+			grp_status[i] = LAT_EXCEEDED;
+		wbt_domain_step(rwb, dom, grp_status[i]);
+		if (dom->rq_depth.scale_step || wbt_inflight(dom))
+			active = true;
+	}
+
+	if (miss_lat <= rwb->dom.min_lat_nsec)
+		*status = LAT_EXCEEDED;
+
+	return active;
+}
+#else
+static inline bool wbt_grp_timer(struct rq_wb *rwb, int *status)
+{
+	return false;
+}
+#endif
+
+static void wb_timer_fn(struct blk_stat_callback *cb)
+{
+	struct rq_wb *rwb = cb->data;
+	struct rq_depth *rqd = &rwb->dom.rq_depth;
+	unsigned int inflight = wbt_inflight(&rwb->dom);
+	bool grp_active;
+	int status;
+
+	if (!rwb->rqos.disk)
+		return;
+
+	status = latency_exceeded(rwb, &rwb->dom, cb->stat);
+
+	trace_wbt_timer(rwb->rqos.disk->bdi, status, rqd->scale_step, inflight);
+
+	grp_active = wbt_grp_timer(rwb, &status);
+	wbt_domain_step(rwb, &rwb->dom, status);
 
 	/*
 	 * Re-arm timer, if we have IO in flight
 	 */
-	if (rqd->scale_step || inflight)
+	if (rqd->scale_step || inflight || grp_active)
 		rwb_arm_timer(rwb);
 }
 
-static void wbt_update_limits(struct rq_wb *rwb)
+static void wbt_domain_update_limits(struct wbt_domain *dom)
 {
-	struct rq_depth *rqd = &rwb->rq_depth;
+	struct rq_depth *rqd = &dom->rq_depth;
 
 	rqd->scale_step = 0;
 	rqd->scaled_max = false;
 
 	rq_depth_calc_max_depth(rqd);
-	calc_wb_limits(rwb);
+	calc_wb_limits(dom);
+
+	rwb_wake_all(dom);
+}
+
+static void wbt_update_limits(struct rq_wb *rwb)
+{
+	wbt_domain_update_limits(&rwb->dom);
+}
+
+#ifdef CONFIG_BLK_CGROUP
+static struct blkcg_policy blkcg_policy_wbt;
+
+struct wbt_grp {
+	struct blkg_policy_data pd;
+	u64 min_lat_nsec;		/* configured target, 0 if none */
+	unsigned int idx;		/* domain index, 0 if none */
+};
+
+static inline struct wbt_grp *pd_to_wg(struct blkg_policy_data *pd)
+{
+	return pd ? container_of(pd, struct wbt_grp, pd) : NULL;
+}
+
+static inline struct wbt_grp *blkg_to_wg(struct blkcg_gq *blkg)
+{
+	return pd_to_wg(blkg_to_pd(blkg, &blkcg_policy_wbt));
+}
+
+/*
+ * Writes are accounted to the domain of the nearest ancestor with a latency
+ * target of its own, or to the default domain if there is none.
+ */
+static enum wbt_flags wbt_bio_domain(struct rq_wb *rwb, struct bio *bio)
+{
+	struct blkcg_gq *blkg;
+
+	for (blkg = bio->bi_blkg; blkg; blkg = blkg->parent) {
+		struct wbt_grp *wg = blkg_to_wg(blkg);
+		unsigned int idx;
+
+		if (!wg)
+			break;
+		idx = READ_ONCE(wg->idx);
+		if (idx)
+			return idx << WBT_DOMAIN_SHIFT;
+	}
+	return 0;
+}
+
+static struct wbt_domain *wbt_alloc_domain(struct rq_wb *rwb)
+{
+	struct wbt_domain *dom;
+	int i;
+
+	dom = kzalloc_node(sizeof(*dom), GFP_KERNEL, rwb->rqos.disk->node_id);
+	if (!dom)
+		return NULL;
+
+	dom->cpu_stat = __alloc_percpu(2 * sizeof(struct blk_rq_stat),
+				       __alignof__(struct blk_rq_stat));
+	if (!dom->cpu_stat) {
+		kfree(dom);
+		return NULL;
+	}
+
+	for (i = 0; i < WBT_NUM_RWQ; i++)
+		rq_wait_init(&dom->rq_wait[i]);
+	dom->rq_depth.default_depth = RWB_DEF_DEPTH;
+	return dom;
+}
+
+static void wbt_free_domain(struct wbt_domain *dom)
+{
+	if (!dom)
+		return;
+	free_percpu(dom->cpu_stat);
+	kfree(dom);
+}
+
+static void wbt_domain_reset(struct rq_wb *rwb, struct wbt_domain *dom,
+			     u64 min_lat_nsec)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct blk_rq_stat *stat = per_cpu_ptr(dom->cpu_stat, cpu);
+
+		blk_rq_stat_init(&stat[READ]);
+		blk_rq_stat_init(&stat[WRITE]);
+	}
+
+	dom->min_lat_nsec = min_lat_nsec;
+	dom->unknown_cnt = 0;
+	dom->rq_depth.queue_depth = rwb->dom.rq_depth.queue_depth;
+	wbt_domain_update_limits(dom);
+}
+
+/*
+ * A released domain keeps its limits until it has drained, writers that
+ * are still waiting on it get through as its inflight count drops. It can
+ * only be handed to another cgroup once nothing references it anymore.
+ */
+static bool wbt_domain_idle(struct wbt_domain *dom)
+{
+	int i;
+
+	if (dom->nr_grps || wbt_inflight(dom))
+		return false;
+	for (i = 0; i < WBT_NUM_RWQ; i++)
+		if (wq_has_sleeper(&dom->rq_wait[i].wait))
+			return false;
+	return true;
+}
+
+static void __wbt_grp_release(struct rq_wb *rwb, struct wbt_grp *wg)
+{
+	struct wbt_domain *dom;
+
+	lockdep_assert_held(&rwb->grp_lock);
+
+	if (!wg->idx)
+		return;
+
+	dom = rwb->grp_dom[wg->idx];
+	WRITE_ONCE(dom->nr_grps, 0);
+	WRITE_ONCE(wg->idx, 0);
+	rwb_wake_all(dom);
+}
+
+/*
+ * Give @wg a domain of its own with a target of @min_lat_nsec, or drop its
+ * domain if @min_lat_nsec is 0. @spare is used if no allocated domain is
+ * free, and is consumed in that case.
+ */
+static int wbt_grp_set_lat(struct rq_wb *rwb, struct wbt_grp *wg,
+			   u64 min_lat_nsec, struct wbt_domain **spare)
+{
+	struct wbt_domain *dom;
+	int i, free_idx = 0;
+
+	spin_lock(&rwb->grp_lock);
+
+	if (wg->idx && min_lat_nsec) {
+		dom = rwb->grp_dom[wg->idx];
+		wbt_domain_reset(rwb, dom, min_lat_nsec);
+		wg->min_lat_nsec = min_lat_nsec;
+		goto out;
+	}
+
+	__wbt_grp_release(rwb, wg);
+	wg->min_lat_nsec = min_lat_nsec;
+	if (!min_lat_nsec)
+		goto out;
+
+	for (i = 1; i < WBT_NR_DOMAINS; i++) {
+		dom = rwb->grp_dom[i];
+		if (dom && wbt_domain_idle(dom))
+			break;
+		if (!dom && !free_idx)
+			free_idx = i;
+	}
+
+	if (i == WBT_NR_DOMAINS) {
+		if (!free_idx || !*spare) {
+			wg->min_lat_nsec = 0;
+			spin_unlock(&rwb->grp_lock);
+			return free_idx ? -ENOMEM : -ENOSPC;
+		}
+		i = free_idx;
+		rwb->grp_dom[i] = *spare;
+		*spare = NULL;
+	}
+
+	dom = rwb->grp_dom[i];
+	wbt_domain_reset(rwb, dom, min_lat_nsec);
+	dom->nr_grps = 1;
+	/* pairs with the dependent grp_dom[] load in wbt_domain() */
+	smp_wmb();
+	WRITE_ONCE(wg->idx, i);
+out:
+	spin_unlock(&rwb->grp_lock);
+	return 0;
+}
+
+static void wbt_grp_depth_changed(struct rq_wb *rwb, unsigned int depth)
+{
+	int i;
+
+	spin_lock(&rwb->grp_lock);
+	for (i = 1; i < WBT_NR_DOMAINS; i++) {
+		struct wbt_domain *dom = rwb->grp_dom[i];
+
+		if (!dom)
+			continue;
+		dom->rq_depth.queue_depth = depth;
+		wbt_domain_update_limits(dom);
+	}
+	spin_unlock(&rwb->grp_lock);
+}
+
+static void wbt_grp_exit(struct rq_wb *rwb)
+{
+	int i;
+
+	blkcg_deactivate_policy(rwb->rqos.disk, &blkcg_policy_wbt);
+	for (i = 1; i < WBT_NR_DOMAINS; i++)
+		wbt_free_domain(rwb->grp_dom[i]);
+}
+#else
+static inline enum wbt_flags wbt_bio_domain(struct rq_wb *rwb,
+					    struct bio *bio)
+{
+	return 0;
+}
+
+static inline void wbt_grp_depth_changed(struct rq_wb *rwb,
+					 unsigned int depth)
+{
+}
 
-	rwb_wake_all(rwb);
+static inline void wbt_grp_exit(struct rq_wb *rwb)
+{
 }
+#endif /* CONFIG_BLK_CGROUP */
 
 bool wbt_disabled(struct request_queue *q)
 {
@@ -502,7 +886,7 @@ u64 wbt_get_min_lat(struct request_queue *q)
 	struct rq_qos *rqos = wbt_rq_qos(q);
 	if (!rqos)
 		return 0;
-	return RQWB(rqos)->min_lat_nsec;
+	return RQWB(rqos)->dom.min_lat_nsec;
 }
 
 void wbt_set_min_lat(struct request_queue *q, u64 val)
@@ -511,7 +895,7 @@ void wbt_set_min_lat(struct request_queue *q, u64 val)
 	if (!rqos)
 		return;
 
-	RQWB(rqos)->min_lat_nsec = val;
+	RQWB(rqos)->dom.min_lat_nsec = val;
 	if (val)
 		RQWB(rqos)->enable_state = WBT_STATE_ON_MANUAL;
 	else
@@ -531,12 +915,13 @@ static bool close_io(struct rq_wb *rwb)
 
 #define REQ_HIPRIO	(REQ_SYNC | REQ_META | REQ_PRIO)
 
-static inline unsigned int get_limit(struct rq_wb *rwb, blk_opf_t opf)
+static inline unsigned int get_limit(struct rq_wb *rwb, struct wbt_domain *dom,
+				     blk_opf_t opf)
 {
 	unsigned int limit;
 
 	if ((opf & REQ_OP_MASK) == REQ_OP_DISCARD)
-		return rwb->wb_background;
+		return dom->wb_background;
 
 	/*
 	 * At this point we know it's a buffered write. If this is
@@ -547,21 +932,22 @@ static inline unsigned int get_limit(struct rq_wb *rwb, blk_opf_t opf)
 	 * IO for a bit.
 	 */
 	if ((opf & REQ_HIPRIO) || wb_recent_wait(rwb) || current_is_kswapd())
-		limit = rwb->rq_depth.max_depth;
+		limit = dom->rq_depth.max_depth;
 	else if ((opf & REQ_BACKGROUND) || close_io(rwb)) {
 		/*
 		 * If less than 100ms since we completed unrelated IO,
 		 * limit us to half the depth for background writeback.
 		 */
-		limit = rwb->wb_background;
+		limit = dom->wb_background;
 	} else
-		limit = rwb->wb_normal;
+		limit = dom->wb_normal;
 
 	return limit;
 }
 
 struct wbt_wait_data {
 	struct rq_wb *rwb;
+	struct wbt_domain *dom;
 	enum wbt_flags wb_acct;
 	blk_opf_t opf;
 };
@@ -569,13 +955,13 @@ struct wbt_wait_data {
 static bool wbt_inflight_cb(struct rq_wait *rqw, void *private_data)
 {
 	struct wbt_wait_data *data = private_data;
-	return rq_wait_inc_below(rqw, get_limit(data->rwb, data->opf));
+	return rq_wait_inc_below(rqw, get_limit(data->rwb, data->dom, data->opf));
 }
 
 static void wbt_cleanup_cb(struct rq_wait *rqw, void *private_data)
 {
 	struct wbt_wait_data *data = private_data;
-	wbt_rqw_done(data->rwb, rqw, data->wb_acct);
+	wbt_rqw_done(data->rwb, data->dom, rqw, data->wb_acct);
 }
 
 /*
@@ -585,9 +971,11 @@ static void wbt_cleanup_cb(struct rq_wait *rqw, void *private_data)
 static void __wbt_wait(struct rq_wb *rwb, enum wbt_flags wb_acct,
 		       blk_opf_t opf)
 {
-	struct rq_wait *rqw = get_rq_wait(rwb, wb_acct);
+	struct wbt_domain *dom = wbt_domain(rwb, wb_acct);
+	struct rq_wait *rqw = get_rq_wait(dom, wb_acct);
 	struct wbt_wait_data data = {
 		.rwb = rwb,
+		.dom = dom,
 		.wb_acct = wb_acct,
 		.opf = opf,
 	};
@@ -628,8 +1016,10 @@ static enum wbt_flags bio_to_wbt_flags(struct rq_wb *rwb, struct bio *bio)
 		if (bio_op(bio) == REQ_OP_DISCARD)
 			flags |= WBT_DISCARD;
 		flags |= WBT_TRACKED;
+	} else {
+		return 0;
 	}
-	return flags;
+	return flags | wbt_bio_domain(rwb, bio);
 }
 
 static void wbt_cleanup(struct rq_qos *rqos, struct bio *bio)
@@ -763,8 +1153,12 @@ static int wbt_data_dir(const struct request *rq)
 
 static void wbt_queue_depth_changed(struct rq_qos *rqos)
 {
-	RQWB(rqos)->rq_depth.queue_depth = blk_queue_depth(rqos->disk->queue);
-	wbt_update_limits(RQWB(rqos));
+	struct rq_wb *rwb = RQWB(rqos);
+	unsigned int depth = blk_queue_depth(rqos->disk->queue);
+
+	rwb->dom.rq_depth.queue_depth = depth;
+	wbt_update_limits(rwb);
+	wbt_grp_depth_changed(rwb, depth);
 }
 
 static void wbt_exit(struct rq_qos *rqos)
@@ -773,6 +1167,7 @@ static void wbt_exit(struct rq_qos *rqos)
 
 	blk_stat_remove_callback(rqos->disk->queue, rwb->cb);
 	blk_stat_free_callback(rwb->cb);
+	wbt_grp_exit(rwb);
 	kfree(rwb);
 }
 
@@ -828,7 +1223,7 @@ static int wbt_inflight_show(void *data, struct seq_file *m)
 
 	for (i = 0; i < WBT_NUM_RWQ; i++)
 		seq_printf(m, "%d: inflight %d\n", i,
-			   atomic_read(&rwb->rq_wait[i].inflight));
+			   atomic_read(&rwb->dom.rq_wait[i].inflight));
 	return 0;
 }
 
@@ -837,7 +1232,7 @@ static int wbt_min_lat_nsec_show(void *data, struct seq_file *m)
 	struct rq_qos *rqos = data;
 	struct rq_wb *rwb = RQWB(rqos);
 
-	seq_printf(m, "%lu\n", rwb->min_lat_nsec);
+	seq_printf(m, "%lu\n", rwb->dom.min_lat_nsec);
 	return 0;
 }
 
@@ -846,7 +1241,7 @@ static int wbt_unknown_cnt_show(void *data, struct seq_file *m)
 	struct rq_qos *rqos = data;
 	struct rq_wb *rwb = RQWB(rqos);
 
-	seq_printf(m, "%u\n", rwb->unknown_cnt);
+	seq_printf(m, "%u\n", rwb->dom.unknown_cnt);
 	return 0;
 }
 
@@ -855,7 +1250,7 @@ static int wbt_normal_show(void *data, struct seq_file *m)
 	struct rq_qos *rqos = data;
 	struct rq_wb *rwb = RQWB(rqos);
 
-	seq_printf(m, "%u\n", rwb->wb_normal);
+	seq_printf(m, "%u\n", rwb->dom.wb_normal);
 	return 0;
 }
 
@@ -864,7 +1259,7 @@ static int wbt_background_show(void *data, struct seq_file *m)
 	struct rq_qos *rqos = data;
 	struct rq_wb *rwb = RQWB(rqos);
 
-	seq_printf(m, "%u\n", rwb->wb_background);
+	seq_printf(m, "%u\n", rwb->dom.wb_background);
 	return 0;
 }
 
@@ -913,15 +1308,18 @@ int wbt_init(struct gendisk *disk)
 	}
 
 	for (i = 0; i < WBT_NUM_RWQ; i++)
-		rq_wait_init(&rwb->rq_wait[i]);
+		rq_wait_init(&rwb->dom.rq_wait[i]);
 
 	rwb->last_comp = rwb->last_issue = jiffies;
 	rwb->win_nsec = RWB_WINDOW_NSEC;
 	rwb->enable_state = WBT_STATE_ON_DEFAULT;
 	rwb->wc = test_bit(QUEUE_FLAG_WC, &q->queue_flags);
-	rwb->rq_depth.default_depth = RWB_DEF_DEPTH;
-	rwb->min_lat_nsec = wbt_default_latency_nsec(q);
-	rwb->rq_depth.queue_depth = blk_queue_depth(q);
+	rwb->dom.rq_depth.default_depth = RWB_DEF_DEPTH;
+	rwb->dom.min_lat_nsec = wbt_default_latency_nsec(q);
+	rwb->dom.rq_depth.queue_depth = blk_queue_depth(q);
+#ifdef CONFIG_BLK_CGROUP
+	spin_lock_init(&rwb->grp_lock);
+#endif
 	wbt_update_limits(rwb);
 
 	/*
@@ -943,3 +1341,159 @@ int wbt_init(struct gendisk *disk)
 	return ret;
 
 }
+
+#ifdef CONFIG_BLK_CGROUP
+static ssize_t wbt_grp_set_limit(struct kernfs_open_file *of, char *buf,
+				 size_t nbytes, loff_t off)
+{
+	struct blkcg *blkcg = css_to_blkcg(of_css(of));
+	struct wbt_domain *spare = NULL;
+	struct blkg_conf_ctx ctx;
+	struct rq_qos *rqos;
+	char *p, *tok;
+	u64 lat_val = 0;
+	int ret;
+
+	blkg_conf_init(&ctx, buf);
+
+	ret = blkg_conf_open_bdev(&ctx);
+	if (ret)
+		goto out;
+
+	/* cgroup domains hang off the queue's wbt instance */
+	lockdep_assert_held(&ctx.bdev->bd_queue->rq_qos_mutex);
+	rqos = wbt_rq_qos(ctx.bdev->bd_queue);
+	if (!rqos) {
+		ret = -EOPNOTSUPP;
+		goto out;
+	}
+
+	ret = blkcg_activate_policy(ctx.bdev->bd_disk, &blkcg_policy_wbt);
+	if (ret)
+		goto out;
+
+	ret = blkg_conf_prep(blkcg, &blkcg_policy_wbt, &ctx);
+	if (ret)
+		goto out;
+
+	p = ctx.body;
+
+	ret = -EINVAL;
+	while ((tok = strsep(&p, " "))) {
+		char key[16];
+		char val[21];	/* 18446744073709551616 */
+
+		if (sscanf(tok, "%15[^=]=%20s", key, val) != 2)
+			goto out;
+
+		if (!strcmp(key, "target")) {
+			u64 v;
+
+			if (!strcmp(val, "max"))
+				lat_val = 0;
+			else if (sscanf(val, "%llu", &v) == 1 && v)
+				lat_val = v * NSEC_PER_USEC;
+			else
+				goto out;
+		} else {
+			goto out;
+		}
+	}
+
+	/*
+	 * Domains are allocated on demand and stay around until the queue
+	 * goes away, so that completions never look at freed memory.
+	 */
+	if (lat_val) {
+		spare = wbt_alloc_domain(RQWB(rqos));
+		if (!spare) {
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+	ret = wbt_grp_set_lat(RQWB(rqos), blkg_to_wg(ctx.blkg), lat_val,
+			      &spare);
+	wbt_free_domain(spare);
+out:
+	blkg_conf_exit(&ctx);
+	return ret ?: nbytes;
+}
+
+static u64 wbt_grp_prfill_limit(struct seq_file *sf,
+				struct blkg_policy_data *pd, int off)
+{
+	struct wbt_grp *wg = pd_to_wg(pd);
+	const char *dname = blkg_dev_name(pd->blkg);
+
+	if (!dname || !wg->min_lat_nsec)
+		return 0;
+	seq_printf(sf, "%s target=%llu\n",
+		   dname, div_u64(wg->min_lat_nsec, NSEC_PER_USEC));
+	return 0;
+}
+
+static int wbt_grp_print_limit(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)),
+			  wbt_grp_prfill_limit,
+			  &blkcg_policy_wbt, seq_cft(sf)->private, false);
+	return 0;
+}
+
+static struct blkg_policy_data *wbt_grp_pd_alloc(struct gendisk *disk,
+		struct blkcg *blkcg, gfp_t gfp)
+{
+	struct wbt_grp *wg;
+
+	wg = kzalloc_node(sizeof(*wg), gfp, disk->node_id);
+	if (!wg)
+		return NULL;
+	return &wg->pd;
+}
+
+static void wbt_grp_pd_offline(struct blkg_policy_data *pd)
+{
+	struct wbt_grp *wg = pd_to_wg(pd);
+	struct rq_qos *rqos = wbt_rq_qos(pd->blkg->q);
+
+	if (!rqos) {
+		wg->idx = 0;
+		wg->min_lat_nsec = 0;
+		return;
+	}
+
+	spin_lock(&RQWB(rqos)->grp_lock);
+	__wbt_grp_release(RQWB(rqos), wg);
+	wg->min_lat_nsec = 0;
+	spin_unlock(&RQWB(rqos)->grp_lock);
+}
+
+static void wbt_grp_pd_free(struct blkg_policy_data *pd)
+{
+	kfree(pd_to_wg(pd));
+}
+
+static struct cftype wbt_grp_files[] = {
+	{
+		.name = "wbt.latency",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = wbt_grp_print_limit,
+		.write = wbt_grp_set_limit,
+	},
+	{}
+};
+
+static struct blkcg_policy blkcg_policy_wbt = {
+	.dfl_cftypes	= wbt_grp_files,
+	.pd_alloc_fn	= wbt_grp_pd_alloc,
+	.pd_offline_fn	= wbt_grp_pd_offline,
+	.pd_free_fn	= wbt_grp_pd_free,
+};
+
+static int __init wbt_grp_init(void)
+{
+	return blkcg_policy_register(&blkcg_policy_wbt);
+}
+module_init(wbt_grp_init);
+#endif /* CONFIG_BLK_CGROUP */
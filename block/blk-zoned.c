@@ -17,8 +17,31 @@
 #include <linux/mm.h>
 #include <linux/vmalloc.h>
 #include <linux/sched/mm.h>
+#include <linux/workqueue.h>
 
 #include "blk.h"
+#include "blk-mq.h"
+
+/*
+ * Per-zone write plug. Writes to a sequential zone must reach the device in
+ * order, so only one write request per zone is let through at a time and the
+ * following bios are held in the plug until it completes. Bios that directly
+ * follow the request when it is allocated are merged into it, which keeps
+ * requests large. Zones are plugged independently, so many zones can be
+ * written concurrently at high queue depth regardless of the I/O scheduler.
+ *
+ * A plugged bio keeps the queue usage reference it got at submission, so that
+ * freezing the queue waits for all plugs to drain.
+ */
+struct blk_zone_wplug {
+	spinlock_t		lock;
+	unsigned int		flags;
+	struct bio_list		bio_list;
+	struct work_struct	bio_work;
+};
+
+/* A write to the zone is in flight */
+#define BLK_ZONE_WPLUG_PLUGGED		(1U << 0)
 
 #define ZONE_COND_NAME(name) [BLK_ZONE_COND_##name] = #name
 static const char *const zone_cond_name[] = {
@@ -98,6 +121,153 @@ void __blk_req_zone_write_unlock(struct request *rq)
 }
 EXPORT_SYMBOL_GPL(__blk_req_zone_write_unlock);
 
+static inline struct blk_zone_wplug *disk_zone_wplug(struct gendisk *disk,
+						     sector_t sector)
+{
+	return &disk->zone_wplugs[disk_zone_no(disk, sector)];
+}
+
+/**
+ * blk_zone_write_plug_bio - order a write to a sequential zone
+ * @bio: bio being submitted, already split to the queue limits
+ *
+ * Returns true if @bio was added to the write plug of its zone, in which case
+ * it is submitted again once the writes ahead of it have completed. Returns
+ * false if the caller should go on with @bio, which then owns the plug if it
+ * is a write to a sequential zone.
+ */
+bool blk_zone_write_plug_bio(struct bio *bio)
+{
+	struct gendisk *disk = bio->bi_bdev->bd_disk;
+	struct blk_zone_wplug *zwplug;
+	unsigned long flags;
+
+	if (!disk->zone_wplugs || !op_needs_zoned_write_locking(bio_op(bio)) ||
+	    !bio_sectors(bio) || !bio_zone_is_seq(bio))
+		return false;
+
+	/*
+	 * Once a write is ordered behind others it must not fail with -EAGAIN,
+	 * or the writes queued after it would reach the device first.
+	 */
+	bio->bi_opf &= ~REQ_NOWAIT;
+
+	zwplug = disk_zone_wplug(disk, bio->bi_iter.bi_sector);
+	spin_lock_irqsave(&zwplug->lock, flags);
+	if (zwplug->flags & BLK_ZONE_WPLUG_PLUGGED) {
+		percpu_ref_get(&disk->queue->q_usage_counter);
+		bio_list_add(&zwplug->bio_list, bio);
+		spin_unlock_irqrestore(&zwplug->lock, flags);
+		return true;
+	}
+	zwplug->flags |= BLK_ZONE_WPLUG_PLUGGED;
+	spin_unlock_irqrestore(&zwplug->lock, flags);
+
+	bio_set_flag(bio, BIO_ZONE_WRITE_PLUGGING);
+	return false;
+}
+
+/*
+ * Called with the request owning the plug of its zone, before it is queued.
+ * Hand the plug over to the request and pull in the plugged bios that can be
+ * merged with it.
+ */
+void blk_zone_write_plug_init_request(struct request *rq)
+{
+	struct blk_zone_wplug *zwplug = disk_zone_wplug(rq->q->disk,
+							blk_rq_pos(rq));
+	unsigned long flags;
+	struct bio *bio;
+
+	bio_clear_flag(rq->bio, BIO_ZONE_WRITE_PLUGGING);
+	rq->rq_flags |= RQF_ZONE_WRITE_PLUGGING;
+
+	spin_lock_irqsave(&zwplug->lock, flags);
+	while ((bio = bio_list_peek(&zwplug->bio_list))) {
+		if (!blk_rq_back_merge_bio(rq, bio))
+			break;
+		bio_list_pop(&zwplug->bio_list);
+		/* the request holds the queue reference for the merged bio */
+		blk_queue_exit(rq->q);
+	}
+	spin_unlock_irqrestore(&zwplug->lock, flags);
+}
+
+static void disk_zone_wplug_unplug(struct gendisk *disk,
+				   struct blk_zone_wplug *zwplug)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&zwplug->lock, flags);
+	if (bio_list_empty(&zwplug->bio_list))
+		zwplug->flags &= ~BLK_ZONE_WPLUG_PLUGGED;
+	else
+		queue_work(disk->zone_wplugs_wq, &zwplug->bio_work);
+	spin_unlock_irqrestore(&zwplug->lock, flags);
+}
+
+/*
+ * The bio owning the plug completed without having been turned into a request
+ * of its own, e.g. because it was merged or failed early.
+ */
+void blk_zone_write_plug_bio_endio(struct bio *bio)
+{
+	struct gendisk *disk = bio->bi_bdev->bd_disk;
+
+	bio_clear_flag(bio, BIO_ZONE_WRITE_PLUGGING);
+	disk_zone_wplug_unplug(disk,
+			       disk_zone_wplug(disk, bio->bi_iter.bi_sector));
+}
+
+void blk_zone_write_plug_finish_request(struct request *rq)
+{
+	struct gendisk *disk = rq->q->disk;
+
+	rq->rq_flags &= ~RQF_ZONE_WRITE_PLUGGING;
+	disk_zone_wplug_unplug(disk, disk_zone_wplug(disk, blk_rq_pos(rq)));
+}
+
+static void disk_zone_wplug_bio_work(struct work_struct *work)
+{
+	struct blk_zone_wplug *zwplug =
+		container_of(work, struct blk_zone_wplug, bio_work);
+	unsigned long flags;
+	struct bio *bio;
+
+	spin_lock_irqsave(&zwplug->lock, flags);
+	bio = bio_list_pop(&zwplug->bio_list);
+	if (!bio)
+		zwplug->flags &= ~BLK_ZONE_WPLUG_PLUGGED;
+	spin_unlock_irqrestore(&zwplug->lock, flags);
+
+	if (bio) {
+		bio_set_flag(bio, BIO_ZONE_WRITE_PLUGGING);
+		/*
+		 * The bio was already accounted and issue-stamped when it was
+		 * first submitted, so go straight to blk-mq rather than through
+		 * submit_bio_noacct_nocheck().
+		 */
+		blk_mq_submit_bio(bio);
+	}
+}
+
+static struct blk_zone_wplug *disk_alloc_zone_wplugs(unsigned int nr_zones)
+{
+	struct blk_zone_wplug *zwplugs;
+	unsigned int i;
+
+	zwplugs = kvcalloc(nr_zones, sizeof(*zwplugs), GFP_KERNEL);
+	if (!zwplugs)
+		return NULL;
+
+	for (i = 0; i < nr_zones; i++) {
+		spin_lock_init(&zwplugs[i].lock);
+		bio_list_init(&zwplugs[i].bio_list);
+		INIT_WORK(&zwplugs[i].bio_work, disk_zone_wplug_bio_work);
+	}
+	return zwplugs;
+}
+
 /**
  * bdev_nr_zones - Get number of zones
  * @bdev:	Target device
@@ -435,12 +605,21 @@ void disk_free_zone_bitmaps(struct gendisk *disk)
 	disk->conv_zones_bitmap = NULL;
 	kfree(disk->seq_zones_wlock);
 	disk->seq_zones_wlock = NULL;
+
+	/* Plugged writes hold the queue usage counter, all plugs are idle */
+	if (disk->zone_wplugs_wq) {
+		destroy_workqueue(disk->zone_wplugs_wq);
+		disk->zone_wplugs_wq = NULL;
+	}
+	kvfree(disk->zone_wplugs);
+	disk->zone_wplugs = NULL;
 }
 
 struct blk_revalidate_zone_args {
 	struct gendisk	*disk;
 	unsigned long	*conv_zones_bitmap;
 	unsigned long	*seq_zones_wlock;
+	struct blk_zone_wplug *zone_wplugs;
 	unsigned int	nr_zones;
 	sector_t	sector;
 };
@@ -591,6 +770,24 @@ int blk_revalidate_disk_zones(struct gendisk *disk,
 		ret = -ENODEV;
 	}
 
+	/*
+	 * Only sequential zones need write plugs, but index them by zone number
+	 * to keep the lookup trivial.
+	 */
+	if (ret > 0 && args.seq_zones_wlock) {
+		noio_flag = memalloc_noio_save();
+		if (!disk->zone_wplugs_wq)
+			disk->zone_wplugs_wq =
+				alloc_workqueue("%s_zwplugs",
+						WQ_MEM_RECLAIM | WQ_HIGHPRI, 0,
+						disk->disk_name);
+		if (disk->zone_wplugs_wq)
+			args.zone_wplugs = disk_alloc_zone_wplugs(args.nr_zones);
+		memalloc_noio_restore(noio_flag);
+		if (!args.zone_wplugs)
+			ret = -ENOMEM;
+	}
+
 	/*
 	 * Install the new bitmaps and update nr_zones only once the queue is
 	 * stopped and all I/Os are completed (i.e. a scheduler is not
@@ -601,6 +798,9 @@ int blk_revalidate_disk_zones(struct gendisk *disk,
 		disk->nr_zones = args.nr_zones;
 		swap(disk->seq_zones_wlock, args.seq_zones_wlock);
 		swap(disk->conv_zones_bitmap, args.conv_zones_bitmap);
+		if (disk->zone_wplugs_wq)
+			flush_workqueue(disk->zone_wplugs_wq);
+		swap(disk->zone_wplugs, args.zone_wplugs);
 		if (update_driver_data)
 			update_driver_data(disk);
 		ret = 0;
@@ -612,6 +812,7 @@ int blk_revalidate_disk_zones(struct gendisk *disk,
 
 	kfree(args.seq_zones_wlock);
 	kfree(args.conv_zones_bitmap);
+	kvfree(args.zone_wplugs);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(blk_revalidate_disk_zones);
@@ -327,6 +327,7 @@ bool blk_attempt_req_merge(struct request_queue *q, struct request *rq,
 unsigned int blk_recalc_rq_segments(struct request *rq);
 void blk_rq_set_mixed_merge(struct request *rq);
 bool blk_rq_merge_ok(struct request *rq, struct bio *bio);
+bool blk_rq_back_merge_bio(struct request *rq, struct bio *bio);
 enum elv_merge blk_try_merge(struct request *rq, struct bio *bio);
 
 void blk_set_default_limits(struct queue_limits *lim);
@@ -365,6 +366,12 @@ static inline void ioc_clear_queue(struct request_queue *q)
 }
 #endif /* CONFIG_BLK_ICQ */
 
+#ifdef CONFIG_BLK_DEV_THROTTLING
+extern ssize_t blk_throtl_batch_show(struct request_queue *q, char *page);
+extern ssize_t blk_throtl_batch_store(struct request_queue *q,
+	const char *page, size_t count);
+#endif
+
 #ifdef CONFIG_BLK_DEV_THROTTLING_LOW
 extern ssize_t blk_throtl_sample_time_show(struct request_queue *q, char *page);
 extern ssize_t blk_throtl_sample_time_store(struct request_queue *q,
@@ -400,9 +407,38 @@ int blkdev_report_zones_ioctl(struct block_device *bdev, unsigned int cmd,
 		unsigned long arg);
 int blkdev_zone_mgmt_ioctl(struct block_device *bdev, blk_mode_t mode,
 		unsigned int cmd, unsigned long arg);
+bool blk_zone_write_plug_bio(struct bio *bio);
+void blk_zone_write_plug_init_request(struct request *rq);
+void blk_zone_write_plug_bio_endio(struct bio *bio);
+void blk_zone_write_plug_finish_request(struct request *rq);
+
+static inline bool disk_has_zone_wplugs(struct gendisk *disk)
+{
+	return disk && disk->zone_wplugs;
+}
+
+static inline bool bio_zone_write_plugging(struct bio *bio)
+{
+	return bio_flagged(bio, BIO_ZONE_WRITE_PLUGGING);
+}
 #else /* CONFIG_BLK_DEV_ZONED */
 static inline void disk_free_zone_bitmaps(struct gendisk *disk) {}
 static inline void disk_clear_zone_settings(struct gendisk *disk) {}
+static inline bool blk_zone_write_plug_bio(struct bio *bio)
+{
+	return false;
+}
+static inline void blk_zone_write_plug_init_request(struct request *rq) {}
+static inline void blk_zone_write_plug_bio_endio(struct bio *bio) {}
+static inline void blk_zone_write_plug_finish_request(struct request *rq) {}
+static inline bool disk_has_zone_wplugs(struct gendisk *disk)
+{
+	return false;
+}
+static inline bool bio_zone_write_plugging(struct bio *bio)
+{
+	return false;
+}
 static inline int blkdev_report_zones_ioctl(struct block_device *bdev,
 		unsigned int cmd, unsigned long arg)
 {
@@ -86,8 +86,16 @@ EXPORT_SYMBOL(elv_bio_merge_ok);
 static inline bool elv_support_features(struct request_queue *q,
 		const struct elevator_type *e)
 {
-	return (q->required_elevator_features & e->elevator_features) ==
-		q->required_elevator_features;
+	unsigned int required = q->required_elevator_features;
+
+	/*
+	 * Zone write plugging already orders writes to sequential zones
+	 * before they reach the scheduler.
+	 */
+	if (disk_has_zone_wplugs(q->disk))
+		required &= ~ELEVATOR_F_ZBD_SEQ_WRITE;
+
+	return (required & e->elevator_features) == required;
 }
 
 /**
@@ -604,10 +612,11 @@ static struct elevator_type *elevator_get_by_features(struct request_queue *q)
 }
 
 /*
- * For a device queue that has no required features, use the default elevator
- * settings. Otherwise, use the first elevator available matching the required
- * features. If no suitable elevator is find or if the chosen elevator
- * initialization fails, fall back to the "none" elevator (no elevator).
+ * For a device queue that has no required features, or whose required
+ * features are covered by zone write plugging, use the default elevator
+ * settings. Otherwise, use the first elevator available matching the
+ * required features. If no suitable elevator is found or if the chosen
+ * elevator initialization fails, fall back to the "none" elevator.
  */
 void elevator_init_mq(struct request_queue *q)
 {
@@ -622,7 +631,7 @@ void elevator_init_mq(struct request_queue *q)
 	if (unlikely(q->elevator))
 		return;
 
-	if (!q->required_elevator_features)
+	if (!q->required_elevator_features || disk_has_zone_wplugs(q->disk))
 		e = elevator_get_default(q);
 	else
 		e = elevator_get_by_features(q);
@@ -199,7 +199,13 @@ static ssize_t __blkdev_direct_IO(struct kiocb *iocb, struct iov_iter *iter,
 	if (is_read && user_backed_iter(iter))
 		dio->flags |= DIO_SHOULD_DIRTY;
 
-	blk_start_plug(&plug);
+	/*
+	 * This dio is split into at least one bio per BIO_MAX_VECS pages,
+	 * let the plug allocate requests for all of them in one go.
+	 */
+	blk_start_plug_nr_ios(&plug, min_t(size_t, BLK_MAX_REQUEST_COUNT,
+			DIV_ROUND_UP(iov_iter_count(iter),
+				     BIO_MAX_VECS * PAGE_SIZE)));
 
 	for (;;) {
 		bio->bi_iter.bi_sector = pos >> SECTOR_SHIFT;
@@ -313,8 +319,12 @@ static ssize_t __blkdev_direct_IO_async(struct kiocb *iocb,
 	if (blkdev_dio_unaligned(bdev, pos, iter))
 		return -EINVAL;
 
-	if (iocb->ki_flags & IOCB_ALLOC_CACHE)
-		opf |= REQ_ALLOC_CACHE;
+	/*
+	 * Single bio dios always come back through bio_put(), which can
+	 * return them to the per-cpu cache from any context, so let plain
+	 * aio use the cache as well and not only io_uring.
+	 */
+	opf |= REQ_ALLOC_CACHE;
 	bio = bio_alloc_bioset(bdev, nr_pages, opf, GFP_KERNEL,
 			       &blkdev_dio_pool);
 	dio = container_of(bio, struct blkdev_dio, bio);
@@ -79,6 +79,18 @@ struct dd_per_prio {
 	struct io_stats_per_prio stats;
 };
 
+/*
+ * Per hardware queue staging list used when sharded insertion is enabled.
+ * Requests are queued here under the hctx-local lock by dd_insert_requests()
+ * and moved onto the shared sort and FIFO lists in bulk by the next dispatch,
+ * so that submitters on different hardware queues do not serialize on
+ * deadline_data.lock.
+ */
+struct dd_hctx_data {
+	spinlock_t lock;
+	struct list_head staged;
+} ____cacheline_aligned_in_smp;
+
 struct deadline_data {
 	/*
 	 * run time data
@@ -91,6 +103,9 @@ struct deadline_data {
 	unsigned int batching;		/* number of sequential requests made */
 	unsigned int starved;		/* times reads have starved writes */
 
+	/* Set once a request has been staged, cleared by dd_collect_staged(). */
+	int staged;
+
 	/*
 	 * settings that change how the i/o scheduler behaves
 	 */
@@ -100,6 +115,7 @@ struct deadline_data {
 	int front_merges;
 	u32 async_depth;
 	int prio_aging_expire;
+	int sharded_insert;
 
 	spinlock_t lock;
 	spinlock_t zone_lock;
@@ -585,6 +601,58 @@ static struct request *dd_dispatch_prio_aged_requests(struct deadline_data *dd,
 	return NULL;
 }
 
+static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
+			      blk_insert_t flags, struct list_head *free);
+
+/*
+ * Move the requests staged on every hardware queue onto @list. The hardware
+ * queues are only walked if dd->staged says that something was staged since
+ * the last walk, and their staged lists are checked without taking their lock
+ * first so that idle hardware queues cost one cache line read.
+ */
+static void dd_collect_staged(struct request_queue *q, struct list_head *list)
+{
+	struct deadline_data *dd = q->elevator->elevator_data;
+	struct blk_mq_hw_ctx *hctx;
+	unsigned long i;
+
+	/*
+	 * Pairs with the smp_store_release() in dd_insert_requests(): a
+	 * request staged before the flag was set is seen by the walk below,
+	 * one staged after it was cleared sets the flag again.
+	 */
+	if (!READ_ONCE(dd->staged) || !xchg(&dd->staged, 0))
+		return;
+
+	queue_for_each_hw_ctx(q, hctx, i) {
+		struct dd_hctx_data *dhd = hctx->sched_data;
+
+		if (!dhd || list_empty_careful(&dhd->staged))
+			continue;
+
+		spin_lock(&dhd->lock);
+		list_splice_tail_init(&dhd->staged, list);
+		spin_unlock(&dhd->lock);
+	}
+}
+
+/* Insert requests collected by dd_collect_staged(). */
+static void dd_insert_staged(struct blk_mq_hw_ctx *hctx, struct list_head *list,
+			     struct list_head *free)
+{
+	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
+
+	lockdep_assert_held(&dd->lock);
+
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		dd_insert_request(hctx, rq, 0, free);
+	}
+}
+
 /*
  * Called from blk_mq_run_hw_queue() -> __blk_mq_sched_dispatch_requests().
  *
@@ -599,8 +667,15 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 	const unsigned long now = jiffies;
 	struct request *rq;
 	enum dd_prio prio;
+	LIST_HEAD(staged);
+	LIST_HEAD(free);
+
+	dd_collect_staged(hctx->queue, &staged);
 
 	spin_lock(&dd->lock);
+	if (!list_empty(&staged))
+		dd_insert_staged(hctx, &staged, &free);
+
 	rq = dd_dispatch_prio_aged_requests(dd, now);
 	if (rq)
 		goto unlock;
@@ -618,6 +693,8 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 unlock:
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&free);
+
 	return rq;
 }
 
@@ -655,10 +732,29 @@ static void dd_depth_updated(struct blk_mq_hw_ctx *hctx)
 /* Called by blk_mq_init_hctx() and blk_mq_init_sched(). */
 static int dd_init_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
 {
+	struct dd_hctx_data *dhd;
+
+	dhd = kmalloc_node(sizeof(*dhd), GFP_KERNEL, hctx->numa_node);
+	if (!dhd)
+		return -ENOMEM;
+
+	spin_lock_init(&dhd->lock);
+	INIT_LIST_HEAD(&dhd->staged);
+	hctx->sched_data = dhd;
+
 	dd_depth_updated(hctx);
 	return 0;
 }
 
+static void dd_exit_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
+{
+	struct dd_hctx_data *dhd = hctx->sched_data;
+
+	WARN_ON_ONCE(!list_empty(&dhd->staged));
+	kfree(dhd);
+	hctx->sched_data = NULL;
+}
+
 static void dd_exit_sched(struct elevator_queue *e)
 {
 	struct deadline_data *dd = e->elevator_data;
@@ -866,8 +962,24 @@ static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
+	struct dd_hctx_data *dhd = hctx->sched_data;
 	LIST_HEAD(free);
 
+	/*
+	 * In sharded mode, stage tail insertions on this hardware queue and
+	 * let the next dispatch sort them in. Head insertions (requeues) and
+	 * zoned devices, which depend on the per-zone write order established
+	 * at insertion time, always take the shared lock.
+	 */
+	if (READ_ONCE(dd->sharded_insert) && !(flags & BLK_MQ_INSERT_AT_HEAD) &&
+	    !blk_queue_is_zoned(q)) {
+		spin_lock(&dhd->lock);
+		list_splice_tail_init(list, &dhd->staged);
+		smp_store_release(&dd->staged, 1);
+		spin_unlock(&dhd->lock);
+		return;
+	}
+
 	spin_lock(&dd->lock);
 	while (!list_empty(list)) {
 		struct request *rq;
@@ -957,6 +1069,9 @@ static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	enum dd_prio prio;
 
+	if (READ_ONCE(dd->staged))
+		return true;
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++)
 		if (dd_has_work_for_prio(&dd->per_prio[prio]))
 			return true;
@@ -982,6 +1097,7 @@ SHOW_INT(deadline_writes_starved_show, dd->writes_starved);
 SHOW_INT(deadline_front_merges_show, dd->front_merges);
 SHOW_INT(deadline_async_depth_show, dd->async_depth);
 SHOW_INT(deadline_fifo_batch_show, dd->fifo_batch);
+SHOW_INT(deadline_sharded_insert_show, dd->sharded_insert);
 #undef SHOW_INT
 #undef SHOW_JIFFIES
 
@@ -1012,6 +1128,7 @@ STORE_INT(deadline_writes_starved_store, &dd->writes_starved, INT_MIN, INT_MAX);
 STORE_INT(deadline_front_merges_store, &dd->front_merges, 0, 1);
 STORE_INT(deadline_async_depth_store, &dd->async_depth, 1, INT_MAX);
 STORE_INT(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX);
+STORE_INT(deadline_sharded_insert_store, &dd->sharded_insert, 0, 1);
 #undef STORE_FUNCTION
 #undef STORE_INT
 #undef STORE_JIFFIES
@@ -1027,6 +1144,7 @@ static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(async_depth),
 	DD_ATTR(fifo_batch),
 	DD_ATTR(prio_aging_expire),
+	DD_ATTR(sharded_insert),
 	__ATTR_NULL
 };
 
@@ -1258,6 +1376,7 @@ static struct elevator_type mq_deadline = {
 		.init_sched		= dd_init_sched,
 		.exit_sched		= dd_exit_sched,
 		.init_hctx		= dd_init_hctx,
+		.exit_hctx		= dd_exit_hctx,
 	},
 
 #ifdef CONFIG_BLK_DEBUG_FS
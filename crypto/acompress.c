@@ -71,6 +71,8 @@ static int crypto_acomp_init_tfm(struct crypto_tfm *tfm)
 
 	acomp->compress = alg->compress;
 	acomp->decompress = alg->decompress;
+	acomp->compress_batch = alg->compress_batch;
+	acomp->decompress_batch = alg->decompress_batch;
 	acomp->dst_free = alg->dst_free;
 	acomp->reqsize = alg->reqsize;
 
@@ -23,6 +23,12 @@
 
 #define CRYPTO_ENGINE_MAX_QLEN 10
 
+/*
+ * Requests moved off the queue per lock hold by engines with retry support,
+ * which can have many requests in flight in the hardware.
+ */
+#define CRYPTO_ENGINE_BATCH 16
+
 /* Temporary algorithm flag used to indicate an updated driver. */
 #define CRYPTO_ALG_ENGINE 0x200
 
@@ -73,11 +79,14 @@ static void crypto_finalize_request(struct crypto_engine *engine,
 static void crypto_pump_requests(struct crypto_engine *engine,
 				 bool in_kthread)
 {
-	struct crypto_async_request *async_req, *backlog;
+	struct crypto_async_request *backlog[CRYPTO_ENGINE_BATCH];
+	struct crypto_async_request *reqs[CRYPTO_ENGINE_BATCH];
 	struct crypto_engine_alg *alg;
 	struct crypto_engine_op *op;
 	unsigned long flags;
 	bool was_busy = false;
+	bool requeued = false;
+	unsigned int i, nr;
 	int ret;
 
 	spin_lock_irqsave(&engine->queue_lock, flags);
@@ -118,10 +127,21 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 	}
 
 start_request:
-	/* Get the fist request from the engine queue to handle */
-	backlog = crypto_get_backlog(&engine->queue);
-	async_req = crypto_dequeue_request(&engine->queue);
-	if (!async_req)
+	/*
+	 * Get the first requests from the engine queue to handle: only one
+	 * unless the hardware can take several, in which case take a batch
+	 * so that the queue lock is not bounced for every request.
+	 */
+	nr = 0;
+	do {
+		backlog[nr] = crypto_get_backlog(&engine->queue);
+		reqs[nr] = crypto_dequeue_request(&engine->queue);
+		if (!reqs[nr])
+			break;
+		nr++;
+	} while (engine->retry_support && nr < CRYPTO_ENGINE_BATCH);
+
+	if (!nr)
 		goto out;
 
 	/*
@@ -130,7 +150,7 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 	 * We'll need it on completion (crypto_finalize_request).
 	 */
 	if (!engine->retry_support)
-		engine->cur_req = async_req;
+		engine->cur_req = reqs[0];
 
 	if (engine->busy)
 		was_busy = true;
@@ -144,56 +164,70 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 		ret = engine->prepare_crypt_hardware(engine);
 		if (ret) {
 			dev_err(engine->dev, "failed to prepare crypt hardware\n");
-			goto req_err_1;
+			for (i = 0; i < nr; i++)
+				crypto_request_complete(reqs[i], ret);
+			goto complete_backlog;
 		}
 	}
 
-	if (async_req->tfm->__crt_alg->cra_flags & CRYPTO_ALG_ENGINE) {
-		alg = container_of(async_req->tfm->__crt_alg,
-				   struct crypto_engine_alg, base);
-		op = &alg->op;
-	} else {
-		dev_err(engine->dev, "failed to do request\n");
-		ret = -EINVAL;
-		goto req_err_1;
+	for (i = 0; i < nr; i++) {
+		struct crypto_async_request *async_req = reqs[i];
+
+		if (async_req->tfm->__crt_alg->cra_flags & CRYPTO_ALG_ENGINE) {
+			alg = container_of(async_req->tfm->__crt_alg,
+					   struct crypto_engine_alg, base);
+			op = &alg->op;
+		} else {
+			dev_err(engine->dev, "failed to do request\n");
+			crypto_request_complete(async_req, -EINVAL);
+			continue;
+		}
+
+		ret = op->do_one_request(engine, async_req);
+
+		/* Request unsuccessfully executed by hardware */
+		if (ret < 0) {
+			/*
+			 * If hardware queue is full (-ENOSPC), requeue request
+			 * regardless of backlog flag.
+			 * Otherwise, unprepare and complete the request.
+			 */
+			if (!engine->retry_support ||
+			    (ret != -ENOSPC)) {
+				dev_err(engine->dev,
+					"Failed to do one request from queue: %d\n",
+					ret);
+				crypto_request_complete(async_req, ret);
+				continue;
+			}
+			break;
+		}
 	}
 
-	ret = op->do_one_request(engine, async_req);
+	requeued = i < nr;
+	if (requeued) {
+		unsigned int done = i;
 
-	/* Request unsuccessfully executed by hardware */
-	if (ret < 0) {
-		/*
-		 * If hardware queue is full (-ENOSPC), requeue request
-		 * regardless of backlog flag.
-		 * Otherwise, unprepare and complete the request.
-		 */
-		if (!engine->retry_support ||
-		    (ret != -ENOSPC)) {
-			dev_err(engine->dev,
-				"Failed to do one request from queue: %d\n",
-				ret);
-			goto req_err_1;
-		}
 		spin_lock_irqsave(&engine->queue_lock, flags);
 		/*
-		 * If hardware was unable to execute request, enqueue it
-		 * back in front of crypto-engine queue, to keep the order
-		 * of requests.
+		 * If hardware was unable to execute request, enqueue it and
+		 * the rest of the batch back in front of crypto-engine queue,
+		 * to keep the order of requests.
 		 */
-		crypto_enqueue_request_head(&engine->queue, async_req);
+		for (i = nr; i-- > done;)
+			crypto_enqueue_request_head(&engine->queue, reqs[i]);
 
 		kthread_queue_work(engine->kworker, &engine->pump_requests);
-		goto out;
+		spin_unlock_irqrestore(&engine->queue_lock, flags);
 	}
 
-	goto retry;
-
-req_err_1:
-	crypto_request_complete(async_req, ret);
+complete_backlog:
+	for (i = 0; i < nr; i++)
+		if (backlog[i])
+			crypto_request_complete(backlog[i], -EINPROGRESS);
 
-retry:
-	if (backlog)
-		crypto_request_complete(backlog, -EINPROGRESS);
+	if (requeued)
+		goto batch;
 
 	/* If retry mechanism is supported, send new requests to engine */
 	if (engine->retry_support) {
@@ -205,6 +239,7 @@ static void crypto_pump_requests(struct crypto_engine *engine,
 out:
 	spin_unlock_irqrestore(&engine->queue_lock, flags);
 
+batch:
 	/*
 	 * Batch requests is possible only if
 	 * hardware can enqueue multiple requests
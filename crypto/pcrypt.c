@@ -30,7 +30,7 @@ struct pcrypt_instance_ctx {
 
 struct pcrypt_aead_ctx {
 	struct crypto_aead *child;
-	unsigned int cb_cpu;
+	unsigned int cb_cpu[];		/* indexed by submitting node */
 };
 
 static inline struct pcrypt_instance_ctx *pcrypt_tfm_ictx(
@@ -114,7 +114,8 @@ static int pcrypt_aead_encrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psenc, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ictx->psenc, padata,
+				 &ctx->cb_cpu[numa_node_id()]);
 	if (!err)
 		return -EINPROGRESS;
 	if (err == -EBUSY)
@@ -163,7 +164,8 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psdec, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ictx->psdec, padata,
+				 &ctx->cb_cpu[numa_node_id()]);
 	if (!err)
 		return -EINPROGRESS;
 	if (err == -EBUSY)
@@ -174,18 +176,31 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 
 static int pcrypt_aead_init_tfm(struct crypto_aead *tfm)
 {
-	int cpu, cpu_index;
 	struct aead_instance *inst = aead_alg_instance(tfm);
 	struct pcrypt_instance_ctx *ictx = aead_instance_ctx(inst);
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(tfm);
 	struct crypto_aead *cipher;
-
-	cpu_index = (unsigned int)atomic_inc_return(&ictx->tfm_count) %
-		    cpumask_weight(cpu_online_mask);
-
-	ctx->cb_cpu = cpumask_first(cpu_online_mask);
-	for (cpu = 0; cpu < cpu_index; cpu++)
-		ctx->cb_cpu = cpumask_next(ctx->cb_cpu, cpu_online_mask);
+	unsigned int cpu_index, nr_local;
+	int node;
+
+	/*
+	 * Give the tfm one serialization callback CPU per node and let each
+	 * request use the one of the node it is submitted from, so that the
+	 * completion runs where the submitter and its flow state are, no
+	 * matter which CPU allocated the tfm.  Requests submitted from one
+	 * node still share a callback CPU and complete in order.  Within a
+	 * node the tfms are spread round-robin over its CPUs.
+	 */
+	cpu_index = (unsigned int)atomic_inc_return(&ictx->tfm_count);
+	for_each_node(node) {
+		nr_local = cpumask_weight_and(cpumask_of_node(node),
+					      cpu_online_mask);
+		if (!nr_local)
+			nr_local = num_online_cpus();
+
+		ctx->cb_cpu[node] = cpumask_local_spread(cpu_index % nr_local,
+							 node);
+	}
 
 	cipher = crypto_spawn_aead(&ictx->spawn);
 
@@ -272,7 +287,8 @@ static int pcrypt_create_aead(struct crypto_template *tmpl, struct rtattr **tb,
 	inst->alg.ivsize = crypto_aead_alg_ivsize(alg);
 	inst->alg.maxauthsize = crypto_aead_alg_maxauthsize(alg);
 
-	inst->alg.base.cra_ctxsize = sizeof(struct pcrypt_aead_ctx);
+	inst->alg.base.cra_ctxsize = struct_size_t(struct pcrypt_aead_ctx,
+						   cb_cpu, nr_node_ids);
 
 	inst->alg.init = pcrypt_aead_init_tfm;
 	inst->alg.exit = pcrypt_aead_exit_tfm;
@@ -110,16 +110,14 @@ static int crypto_scomp_init_tfm(struct crypto_tfm *tfm)
 	return ret;
 }
 
-static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
-{
-	struct crypto_acomp *tfm = crypto_acomp_reqtfm(req);
-	void **tfm_ctx = acomp_tfm_ctx(tfm);
-	struct crypto_scomp *scomp = *tfm_ctx;
-	void **ctx = acomp_request_ctx(req);
-	struct scomp_scratch *scratch;
-	unsigned int dlen;
-	int ret;
+/*
+ * Maximum number of batched requests handled under one hold of the per-CPU
+ * scratch lock, to bound the time spent with preemption disabled.
+ */
+#define SCOMP_BATCH_LOCK_MAX	16
 
+static int scomp_acomp_check(struct acomp_req *req)
+{
 	if (!req->src || !req->slen || req->slen > SCOMP_SCRATCH_SIZE)
 		return -EINVAL;
 
@@ -129,10 +127,19 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 	if (!req->dlen || req->dlen > SCOMP_SCRATCH_SIZE)
 		req->dlen = SCOMP_SCRATCH_SIZE;
 
-	dlen = req->dlen;
+	return 0;
+}
 
-	scratch = raw_cpu_ptr(&scomp_scratch);
-	spin_lock(&scratch->lock);
+/* Called with scratch->lock held, after scomp_acomp_check(). */
+static int __scomp_acomp_comp_decomp(struct acomp_req *req, int dir,
+				     struct scomp_scratch *scratch)
+{
+	struct crypto_acomp *tfm = crypto_acomp_reqtfm(req);
+	void **tfm_ctx = acomp_tfm_ctx(tfm);
+	struct crypto_scomp *scomp = *tfm_ctx;
+	void **ctx = acomp_request_ctx(req);
+	unsigned int dlen = req->dlen;
+	int ret;
 
 	scatterwalk_map_and_copy(scratch->src, req->src, 0, req->slen, 0);
 	if (dir)
@@ -141,25 +148,72 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 	else
 		ret = crypto_scomp_decompress(scomp, scratch->src, req->slen,
 					      scratch->dst, &req->dlen, *ctx);
-	if (!ret) {
-		if (!req->dst) {
-			req->dst = sgl_alloc(req->dlen, GFP_ATOMIC, NULL);
-			if (!req->dst) {
-				ret = -ENOMEM;
-				goto out;
-			}
-		} else if (req->dlen > dlen) {
-			ret = -ENOSPC;
-			goto out;
-		}
-		scatterwalk_map_and_copy(scratch->dst, req->dst, 0, req->dlen,
-					 1);
+	if (ret)
+		return ret;
+
+	if (!req->dst) {
+		req->dst = sgl_alloc(req->dlen, GFP_ATOMIC, NULL);
+		if (!req->dst)
+			return -ENOMEM;
+	} else if (req->dlen > dlen) {
+		return -ENOSPC;
 	}
-out:
+	scatterwalk_map_and_copy(scratch->dst, req->dst, 0, req->dlen, 1);
+
+	return 0;
+}
+
+static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
+{
+	struct scomp_scratch *scratch;
+	int ret;
+
+	ret = scomp_acomp_check(req);
+	if (ret)
+		return ret;
+
+	scratch = raw_cpu_ptr(&scomp_scratch);
+	spin_lock(&scratch->lock);
+	ret = __scomp_acomp_comp_decomp(req, dir, scratch);
 	spin_unlock(&scratch->lock);
+
 	return ret;
 }
 
+/*
+ * Run a batch through the scratch buffers, taking the per-CPU scratch lock
+ * once per SCOMP_BATCH_LOCK_MAX requests rather than once per request.
+ */
+static void scomp_acomp_comp_decomp_batch(struct acomp_req *reqs[],
+					  int errs[], unsigned int nr, int dir)
+{
+	struct scomp_scratch *scratch = NULL;
+	unsigned int i, held = 0;
+
+	for (i = 0; i < nr; i++) {
+		errs[i] = scomp_acomp_check(reqs[i]);
+		if (errs[i])
+			continue;
+
+		if (scratch && held == SCOMP_BATCH_LOCK_MAX) {
+			spin_unlock(&scratch->lock);
+			scratch = NULL;
+		}
+
+		if (!scratch) {
+			scratch = raw_cpu_ptr(&scomp_scratch);
+			spin_lock(&scratch->lock);
+			held = 0;
+		}
+
+		errs[i] = __scomp_acomp_comp_decomp(reqs[i], dir, scratch);
+		held++;
+	}
+
+	if (scratch)
+		spin_unlock(&scratch->lock);
+}
+
 static int scomp_acomp_compress(struct acomp_req *req)
 {
 	return scomp_acomp_comp_decomp(req, 1);
@@ -170,6 +224,18 @@ static int scomp_acomp_decompress(struct acomp_req *req)
 	return scomp_acomp_comp_decomp(req, 0);
 }
 
+static void scomp_acomp_compress_batch(struct acomp_req *reqs[], int errs[],
+				       unsigned int nr)
+{
+	scomp_acomp_comp_decomp_batch(reqs, errs, nr, 1);
+}
+
+static void scomp_acomp_decompress_batch(struct acomp_req *reqs[], int errs[],
+					 unsigned int nr)
+{
+	scomp_acomp_comp_decomp_batch(reqs, errs, nr, 0);
+}
+
 static void crypto_exit_scomp_ops_async(struct crypto_tfm *tfm)
 {
 	struct crypto_scomp **ctx = crypto_tfm_ctx(tfm);
@@ -203,6 +269,8 @@ int crypto_init_scomp_ops_async(struct crypto_tfm *tfm)
 
 	crt->compress = scomp_acomp_compress;
 	crt->decompress = scomp_acomp_decompress;
+	crt->compress_batch = scomp_acomp_compress_batch;
+	crt->decompress_batch = scomp_acomp_decompress_batch;
 	crt->dst_free = sgl_free;
 	crt->reqsize = sizeof(void *);
 
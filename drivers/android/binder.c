@@ -56,9 +56,11 @@
 #include <linux/rbtree.h>
 #include <linux/sched/signal.h>
 #include <linux/sched/mm.h>
+#include <linux/sched/topology.h>
 #include <linux/seq_file.h>
 #include <linux/string.h>
 #include <linux/uaccess.h>
+#include <linux/percpu.h>
 #include <linux/pid_namespace.h>
 #include <linux/security.h>
 #include <linux/spinlock.h>
@@ -115,6 +117,9 @@ static uint32_t binder_debug_mask = BINDER_DEBUG_USER_ERROR |
 	BINDER_DEBUG_FAILED_TRANSACTION | BINDER_DEBUG_DEAD_TRANSACTION;
 module_param_named(debug_mask, binder_debug_mask, uint, 0644);
 
+static bool binder_cluster_wakeup;
+module_param_named(cluster_wakeup, binder_cluster_wakeup, bool, 0644);
+
 char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, 0444);
 
@@ -198,6 +203,40 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	atomic_inc(&binder_stats.obj_created[type]);
 }
 
+int binder_context_init_latency(struct binder_context *context)
+{
+	context->latency = alloc_percpu(struct binder_latency_stats);
+	return context->latency ? 0 : -ENOMEM;
+}
+
+void binder_context_free_latency(struct binder_context *context)
+{
+	free_percpu(context->latency);
+	context->latency = NULL;
+}
+
+/**
+ * binder_latency_account() - add a sample to a context latency histogram
+ * @context:	binder context the transaction belongs to
+ * @reply:	account to the reply histogram instead of the queue one
+ * @start:	start of the interval, ending now
+ */
+static void binder_latency_account(struct binder_context *context,
+				   bool reply, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket = 0;
+
+	if (!context->latency)
+		return;
+	if (us > 0)
+		bucket = min_t(int, ilog2(us) + 1, BINDER_LATENCY_BUCKETS - 1);
+	if (reply)
+		this_cpu_inc(context->latency->reply[bucket]);
+	else
+		this_cpu_inc(context->latency->queue[bucket]);
+}
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int debug_id_done;
@@ -602,19 +641,40 @@ static void binder_wakeup_poll_threads_ilocked(struct binder_proc *proc,
  * signal. Therefore, callers *should* always wake up the thread this function
  * returns.
  *
+ * If @proc has cluster_wakeup enabled, the first of the most recently
+ * parked threads that went to sleep on a CPU sharing a cache domain with
+ * the current CPU is preferred, so that a caller on a big core doesn't
+ * hand its work to a thread parked on a little core. The search is
+ * bounded to keep the cost under the inner lock constant.
+ *
  * Return:	If there's a thread currently waiting for process work,
  *		returns that thread. Otherwise returns NULL.
  */
 static struct binder_thread *
 binder_select_thread_ilocked(struct binder_proc *proc)
 {
-	struct binder_thread *thread;
+	struct binder_thread *thread, *iter;
+	int cpu, scanned = 0;
 
 	assert_spin_locked(&proc->inner_lock);
 	thread = list_first_entry_or_null(&proc->waiting_threads,
 					  struct binder_thread,
 					  waiting_thread_node);
 
+	if (thread && proc->cluster_wakeup) {
+		cpu = smp_processor_id();
+		list_for_each_entry(iter, &proc->waiting_threads,
+				    waiting_thread_node) {
+			if (cpus_share_cache(cpu, iter->wait_cpu)) {
+				thread = iter;
+				break;
+			}
+			if (++scanned == BINDER_SELECT_THREAD_SCAN_MAX)
+				break;
+		}
+		trace_binder_select_thread(proc, thread, cpu);
+	}
+
 	if (thread)
 		list_del_init(&thread->waiting_thread_node);
 
@@ -2769,13 +2829,16 @@ static int binder_proc_transaction(struct binder_transaction *t,
 	bool frozen = false;
 
 	BUG_ON(!node);
+	t->enqueue_time = ktime_get();
 	binder_node_lock(node);
 	if (oneway) {
 		BUG_ON(thread);
-		if (node->has_async_transaction)
+		if (node->has_async_transaction) {
 			pending_async = true;
-		else
+			node->async_queued++;
+		} else {
 			node->has_async_transaction = true;
+		}
 	}
 
 	binder_inner_proc_lock(proc);
@@ -2843,6 +2906,179 @@ static int binder_proc_transaction(struct binder_transaction *t,
 	return 0;
 }
 
+/**
+ * binder_txn_plug_fail() - undo a plugged transaction that can't be delivered
+ * @thread:	sending thread owning the plug
+ * @t:		transaction that failed
+ * @tcomplete:	TRANSACTION_COMPLETE work queued for @t
+ * @error:	error to report to the sender
+ *
+ * Mirrors the dead-target error path of binder_transaction() for a
+ * transaction whose delivery was deferred by the plug. Only the first
+ * failure is reported, as subsequent ones hit the same target.
+ */
+static void binder_txn_plug_fail(struct binder_thread *thread,
+				 struct binder_transaction *t,
+				 struct binder_work *tcomplete,
+				 uint32_t error)
+{
+	struct binder_proc *proc = thread->proc;
+	struct binder_proc *target_proc = thread->txn_plug->proc;
+
+	binder_txn_error("%d:%d dead process or thread\n",
+		thread->pid, proc->pid);
+	binder_dequeue_work(proc, tcomplete);
+	binder_free_txn_fixups(t);
+	trace_binder_transaction_failed_buffer_release(t->buffer);
+	binder_release_entire_buffer(target_proc, NULL, t->buffer, true);
+	t->buffer->transaction = NULL;
+	binder_alloc_free_buf(&target_proc->alloc, t->buffer);
+	kfree(tcomplete);
+	binder_stats_deleted(BINDER_STAT_TRANSACTION_COMPLETE);
+	if (trace_binder_txn_latency_free_enabled())
+		binder_txn_latency_free(t);
+
+	if (thread->return_error.cmd == BR_OK) {
+		binder_inner_proc_lock(proc);
+		binder_set_extended_error(&thread->ee, t->debug_id, error, 0);
+		binder_inner_proc_unlock(proc);
+		thread->return_error.cmd = error;
+		binder_enqueue_thread_work(thread, &thread->return_error.work);
+	}
+	kfree(t);
+	binder_stats_deleted(BINDER_STAT_TRANSACTION);
+}
+
+/**
+ * binder_txn_plug_flush() - deliver all transactions held in the plug
+ * @thread:	sending thread owning the plug
+ *
+ * The common case, a live and unfrozen target, is handled with a single
+ * acquisition of the node and proc locks: the first transaction goes to
+ * a waiting thread (or the proc todo list) unless the node already has
+ * an async transaction in flight, and the rest are appended to
+ * @node->async_todo. At most one thread is woken up. Frozen or dead
+ * targets fall back to binder_proc_transaction() so that the
+ * TF_UPDATE_TXN and pending-frozen semantics are preserved.
+ */
+static void binder_txn_plug_flush(struct binder_thread *thread)
+{
+	struct binder_txn_plug *plug = thread->txn_plug;
+	struct binder_thread *target_thread = NULL;
+	struct binder_proc *target_proc;
+	struct binder_node *node;
+	bool pending_async;
+	ktime_t now;
+	int i;
+
+	if (!plug || !plug->count)
+		return;
+
+	node = plug->node;
+	target_proc = plug->proc;
+
+	now = ktime_get();
+	for (i = 0; i < plug->count; i++)
+		plug->txns[i]->enqueue_time = now;
+
+	binder_node_lock(node);
+	binder_inner_proc_lock(target_proc);
+	if (target_proc->is_frozen || target_proc->is_dead) {
+		binder_inner_proc_unlock(target_proc);
+		binder_node_unlock(node);
+		goto slow_path;
+	}
+
+	pending_async = node->has_async_transaction;
+	node->has_async_transaction = true;
+	node->async_queued += pending_async ? plug->count : plug->count - 1;
+	if (!pending_async)
+		target_thread = binder_select_thread_ilocked(target_proc);
+
+	for (i = 0; i < plug->count; i++) {
+		struct binder_work *w = &plug->txns[i]->work;
+
+		if (i || pending_async)
+			binder_enqueue_work_ilocked(w, &node->async_todo);
+		else if (target_thread)
+			binder_enqueue_thread_work_ilocked(target_thread, w);
+		else
+			binder_enqueue_work_ilocked(w, &target_proc->todo);
+	}
+
+	if (!pending_async)
+		binder_wakeup_thread_ilocked(target_proc, target_thread, false);
+
+	target_proc->outstanding_txns += plug->count;
+	binder_inner_proc_unlock(target_proc);
+	binder_node_unlock(node);
+
+	binder_debug(BINDER_DEBUG_TRANSACTION,
+		     "%d:%d flushed %d oneway transactions to node %d\n",
+		     thread->proc->pid, thread->pid, plug->count,
+		     node->debug_id);
+	goto out;
+
+slow_path:
+	for (i = 0; i < plug->count; i++) {
+		uint32_t ret;
+
+		ret = binder_proc_transaction(plug->txns[i], target_proc, NULL);
+		if (ret == BR_TRANSACTION_PENDING_FROZEN) {
+			binder_inner_proc_lock(thread->proc);
+			plug->tcomplete[i]->type = BINDER_WORK_TRANSACTION_PENDING;
+			binder_inner_proc_unlock(thread->proc);
+		} else if (ret) {
+			binder_txn_plug_fail(thread, plug->txns[i],
+					     plug->tcomplete[i], ret);
+		}
+	}
+
+out:
+	plug->count = 0;
+	plug->node = NULL;
+	plug->proc = NULL;
+	binder_proc_dec_tmpref(target_proc);
+	binder_dec_node_tmpref(node);
+}
+
+/**
+ * binder_txn_plug_add() - defer delivery of a oneway transaction
+ * @thread:	sending thread
+ * @t:		fully built oneway transaction
+ * @tcomplete:	TRANSACTION_COMPLETE work already queued to @thread
+ * @node:	target node of @t
+ * @proc:	process owning @node
+ *
+ * Adds @t to the plug of @thread, which must be set, flushing the plug
+ * first if it targets another node or is full. The plug takes its own
+ * tmprefs on @node and @proc, so the caller drops its refs as usual.
+ */
+static void binder_txn_plug_add(struct binder_thread *thread,
+				struct binder_transaction *t,
+				struct binder_work *tcomplete,
+				struct binder_node *node,
+				struct binder_proc *proc)
+{
+	struct binder_txn_plug *plug = thread->txn_plug;
+
+	if (plug->count &&
+	    (plug->node != node || plug->count == BINDER_TXN_PLUG_MAX))
+		binder_txn_plug_flush(thread);
+
+	if (!plug->count) {
+		binder_inc_node_tmpref(node);
+		binder_inner_proc_lock(proc);
+		proc->tmp_ref++;
+		binder_inner_proc_unlock(proc);
+		plug->node = node;
+		plug->proc = proc;
+	}
+	plug->txns[plug->count] = t;
+	plug->tcomplete[plug->count] = tcomplete;
+	plug->count++;
+}
+
 /**
  * binder_get_node_refs_for_txn() - Get required refs on node for txn
  * @node:         struct binder_node for which to get refs
@@ -2953,6 +3189,10 @@ static void binder_transaction(struct binder_proc *proc,
 	binder_set_extended_error(&thread->ee, t_debug_id, BR_OK, 0);
 	binder_inner_proc_unlock(proc);
 
+	/* Keep plugged oneway work ordered before replies and calls */
+	if (reply || !(tr->flags & TF_ONE_WAY))
+		binder_txn_plug_flush(thread);
+
 	if (reply) {
 		binder_inner_proc_lock(proc);
 		in_reply_to = thread->transaction_stack;
@@ -3525,6 +3765,8 @@ static void binder_transaction(struct binder_proc *proc,
 				return_error_line = __LINE__;
 				goto err_bad_offset;
 			}
+			trace_binder_transaction_sg_copy(t, sg_buf_offset,
+							 bp->length);
 			ret = binder_defer_copy(&sgc_head, sg_buf_offset,
 				(const void __user *)(uintptr_t)bp->buffer,
 				bp->length);
@@ -3613,10 +3855,13 @@ static void binder_transaction(struct binder_proc *proc,
 		}
 		BUG_ON(t->buffer->async_transaction != 0);
 		binder_pop_transaction_ilocked(target_thread, in_reply_to);
+		t->enqueue_time = ktime_get();
 		binder_enqueue_thread_work_ilocked(target_thread, &t->work);
 		target_proc->outstanding_txns++;
 		binder_inner_proc_unlock(target_proc);
 		wake_up_interruptible_sync(&target_thread->wait);
+		binder_latency_account(proc->context, true,
+				       in_reply_to->start_time);
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
 		BUG_ON(t->buffer->async_transaction != 0);
@@ -3644,6 +3889,12 @@ static void binder_transaction(struct binder_proc *proc,
 	} else {
 		BUG_ON(target_node == NULL);
 		BUG_ON(t->buffer->async_transaction != 1);
+		if (thread->txn_plug) {
+			binder_enqueue_thread_work(thread, tcomplete);
+			binder_txn_plug_add(thread, t, tcomplete,
+					    target_node, target_proc);
+			goto out_plugged;
+		}
 		return_error = binder_proc_transaction(t, target_proc, NULL);
 		/*
 		 * Let the caller know when async transaction reaches a frozen
@@ -3657,6 +3908,7 @@ static void binder_transaction(struct binder_proc *proc,
 		    return_error != BR_TRANSACTION_PENDING_FROZEN)
 			goto err_dead_proc_or_thread;
 	}
+out_plugged:
 	if (target_thread)
 		binder_thread_dec_tmpref(target_thread);
 	binder_proc_dec_tmpref(target_proc);
@@ -3808,7 +4060,7 @@ binder_free_buf(struct binder_proc *proc,
 	binder_alloc_free_buf(&proc->alloc, buffer);
 }
 
-static int binder_thread_write(struct binder_proc *proc,
+static int __binder_thread_write(struct binder_proc *proc,
 			struct binder_thread *thread,
 			binder_uintptr_t binder_buffer, size_t size,
 			binder_size_t *consumed)
@@ -3831,6 +4083,8 @@ static int binder_thread_write(struct binder_proc *proc,
 			atomic_inc(&proc->stats.bc[_IOC_NR(cmd)]);
 			atomic_inc(&thread->stats.bc[_IOC_NR(cmd)]);
 		}
+		if (cmd != BC_TRANSACTION && cmd != BC_TRANSACTION_SG)
+			binder_txn_plug_flush(thread);
 		switch (cmd) {
 		case BC_INCREFS:
 		case BC_ACQUIRE:
@@ -4255,6 +4509,29 @@ static int binder_thread_write(struct binder_proc *proc,
 	return 0;
 }
 
+/*
+ * Oneway transactions to the same node that appear back-to-back in the
+ * write buffer are batched through a plug and delivered together, either
+ * when a different command or target is seen or when the buffer has been
+ * fully consumed.
+ */
+static int binder_thread_write(struct binder_proc *proc,
+			struct binder_thread *thread,
+			binder_uintptr_t binder_buffer, size_t size,
+			binder_size_t *consumed)
+{
+	struct binder_txn_plug plug = { .count = 0 };
+	int ret;
+
+	thread->txn_plug = &plug;
+	ret = __binder_thread_write(proc, thread, binder_buffer, size,
+				    consumed);
+	binder_txn_plug_flush(thread);
+	thread->txn_plug = NULL;
+
+	return ret;
+}
+
 static void binder_stat_br(struct binder_proc *proc,
 			   struct binder_thread *thread, uint32_t cmd)
 {
@@ -4309,9 +4586,11 @@ static int binder_wait_for_work(struct binder_thread *thread,
 		prepare_to_wait(&thread->wait, &wait, TASK_INTERRUPTIBLE|TASK_FREEZABLE);
 		if (binder_has_work_ilocked(thread, do_proc_work))
 			break;
-		if (do_proc_work)
+		if (do_proc_work) {
+			thread->wait_cpu = smp_processor_id();
 			list_add(&thread->waiting_thread_node,
 				 &proc->waiting_threads);
+		}
 		binder_inner_proc_unlock(proc);
 		schedule();
 		binder_inner_proc_lock(proc);
@@ -4469,6 +4748,8 @@ static int binder_thread_read(struct binder_proc *proc,
 		case BINDER_WORK_TRANSACTION: {
 			binder_inner_proc_unlock(proc);
 			t = container_of(w, struct binder_transaction, work);
+			binder_latency_account(proc->context, false,
+					       t->enqueue_time);
 		} break;
 		case BINDER_WORK_RETURN_ERROR: {
 			struct binder_error *e = container_of(
@@ -4923,6 +5204,7 @@ static void binder_free_proc(struct binder_proc *proc)
 			__func__, proc->outstanding_txns);
 	device = container_of(proc->context, struct binder_device, context);
 	if (refcount_dec_and_test(&device->ref)) {
+		binder_context_free_latency(proc->context);
 		kfree(proc->context->name);
 		kfree(device);
 	}
@@ -5641,6 +5923,7 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	INIT_LIST_HEAD(&proc->todo);
 	init_waitqueue_head(&proc->freeze_wait);
 	proc->default_priority = task_nice(current);
+	proc->cluster_wakeup = READ_ONCE(binder_cluster_wakeup);
 	/* binderfs stashes devices in i_private */
 	if (is_binderfs_device(nodp)) {
 		binder_dev = nodp->i_private;
@@ -6091,11 +6374,12 @@ static void print_binder_node_nilocked(struct seq_file *m,
 	hlist_for_each_entry(ref, &node->refs, node_entry)
 		count++;
 
-	seq_printf(m, "  node %d: u%016llx c%016llx hs %d hw %d ls %d lw %d is %d iw %d tr %d",
+	seq_printf(m, "  node %d: u%016llx c%016llx hs %d hw %d ls %d lw %d is %d iw %d tr %d aq %u",
 		   node->debug_id, (u64)node->ptr, (u64)node->cookie,
 		   node->has_strong_ref, node->has_weak_ref,
 		   node->local_strong_refs, node->local_weak_refs,
-		   node->internal_strong_refs, count, node->tmp_refs);
+		   node->internal_strong_refs, count, node->tmp_refs,
+		   node->async_queued);
 	if (count) {
 		seq_puts(m, " proc");
 		hlist_for_each_entry(ref, &node->refs, node_entry)
@@ -6338,6 +6622,7 @@ static void print_binder_proc_stats(struct seq_file *m,
 	seq_printf(m, "  buffers: %d\n", count);
 
 	binder_alloc_print_pages(m, &proc->alloc);
+	binder_alloc_print_buffer_cache(m, &proc->alloc);
 
 	count = 0;
 	binder_inner_proc_lock(proc);
@@ -6419,6 +6704,59 @@ static int transactions_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static void print_binder_latency(struct seq_file *m,
+				 struct binder_context *context)
+{
+	unsigned long queue[BINDER_LATENCY_BUCKETS] = { 0 };
+	unsigned long reply[BINDER_LATENCY_BUCKETS] = { 0 };
+	int cpu, i;
+
+	if (!context->latency)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct binder_latency_stats *stats =
+			per_cpu_ptr(context->latency, cpu);
+
+		for (i = 0; i < BINDER_LATENCY_BUCKETS; i++) {
+			queue[i] += READ_ONCE(stats->queue[i]);
+			reply[i] += READ_ONCE(stats->reply[i]);
+		}
+	}
+
+	seq_printf(m, "context %s\n", context->name);
+	for (i = 0; i < BINDER_LATENCY_BUCKETS; i++) {
+		if (!queue[i] && !reply[i])
+			continue;
+		if (i == BINDER_LATENCY_BUCKETS - 1)
+			seq_printf(m, "  >=%luus: queue %lu reply %lu\n",
+				   1UL << (i - 1), queue[i], reply[i]);
+		else
+			seq_printf(m, "  <%luus: queue %lu reply %lu\n",
+				   1UL << i, queue[i], reply[i]);
+	}
+}
+
+static int latency_show(struct seq_file *m, void *unused)
+{
+	struct binder_proc *proc, *itr;
+
+	seq_puts(m, "binder latency:\n");
+	mutex_lock(&binder_procs_lock);
+	hlist_for_each_entry(proc, &binder_procs, proc_node) {
+		/* Print each context once, at its first proc */
+		hlist_for_each_entry(itr, &binder_procs, proc_node) {
+			if (itr == proc || itr->context == proc->context)
+				break;
+		}
+		if (itr == proc)
+			print_binder_latency(m, proc->context);
+	}
+	mutex_unlock(&binder_procs_lock);
+
+	return 0;
+}
+
 static int proc_show(struct seq_file *m, void *unused)
 {
 	struct binder_proc *itr;
@@ -6498,6 +6836,7 @@ DEFINE_SHOW_ATTRIBUTE(state);
 DEFINE_SHOW_ATTRIBUTE(stats);
 DEFINE_SHOW_ATTRIBUTE(transactions);
 DEFINE_SHOW_ATTRIBUTE(transaction_log);
+DEFINE_SHOW_ATTRIBUTE(latency);
 
 const struct binder_debugfs_entry binder_debugfs_entries[] = {
 	{
@@ -6530,6 +6869,12 @@ const struct binder_debugfs_entry binder_debugfs_entries[] = {
 		.fops = &transaction_log_fops,
 		.data = &binder_transaction_log_failed,
 	},
+	{
+		.name = "latency",
+		.mode = 0444,
+		.fops = &latency_fops,
+		.data = NULL,
+	},
 	{} /* terminator */
 };
 
@@ -6551,8 +6896,15 @@ static int __init init_binder_device(const char *name)
 	binder_device->context.name = name;
 	mutex_init(&binder_device->context.context_mgr_node_lock);
 
+	ret = binder_context_init_latency(&binder_device->context);
+	if (ret) {
+		kfree(binder_device);
+		return ret;
+	}
+
 	ret = misc_register(&binder_device->miscdev);
 	if (ret < 0) {
+		binder_context_free_latency(&binder_device->context);
 		kfree(binder_device);
 		return ret;
 	}
@@ -6620,6 +6972,7 @@ static int __init binder_init(void)
 	hlist_for_each_entry_safe(device, tmp, &binder_devices, hlist) {
 		misc_deregister(&device->miscdev);
 		hlist_del(&device->hlist);
+		binder_context_free_latency(&device->context);
 		kfree(device);
 	}
 
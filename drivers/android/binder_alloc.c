@@ -41,6 +41,22 @@ static uint32_t binder_alloc_debug_mask = BINDER_DEBUG_USER_ERROR;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+/*
+ * Number of buffer pages kept resident per process: the shrinker does
+ * not reclaim below prefault_low_pages, and after a transaction had to
+ * fault in pages a worker refills free buffer space up to
+ * prefault_high_pages. Sampled when a process opens binder.
+ */
+static unsigned int binder_alloc_prefault_low;
+module_param_named(prefault_low_pages, binder_alloc_prefault_low,
+		   uint, 0644);
+static unsigned int binder_alloc_prefault_high;
+module_param_named(prefault_high_pages, binder_alloc_prefault_high,
+		   uint, 0644);
+
+/* Pages populated by one run of the prefault worker */
+#define BINDER_PREFAULT_BATCH	16
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -266,6 +282,7 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 
 		if (index + 1 > alloc->pages_high)
 			alloc->pages_high = index + 1;
+		alloc->pages_resident++;
 
 		trace_binder_alloc_page_end(alloc, index);
 	}
@@ -273,6 +290,8 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 		mmap_write_unlock(mm);
 		mmput_async(mm);
 	}
+	if (need_mm && alloc->pages_resident < alloc->prefault_high)
+		queue_work(system_unbound_wq, &alloc->prefault_work);
 	return 0;
 
 free_range:
@@ -365,6 +384,80 @@ static bool debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 	return false;
 }
 
+/**
+ * binder_alloc_cache_class() - size class for a buffer of @size bytes
+ * @alloc:	binder_alloc for this proc
+ * @size:	padded buffer size
+ *
+ * Return:	index into @alloc->cache, or -1 if @size is not cacheable
+ */
+static int binder_alloc_cache_class(struct binder_alloc *alloc, size_t size)
+{
+	if (alloc->cache_disabled || size > BINDER_ALLOC_CACHE_MAX_SIZE)
+		return -1;
+	return max_t(int, fls_long(size - 1), BINDER_ALLOC_CACHE_MIN_SHIFT) -
+		BINDER_ALLOC_CACHE_MIN_SHIFT;
+}
+
+static size_t binder_alloc_cache_size(int class)
+{
+	return 1UL << (class + BINDER_ALLOC_CACHE_MIN_SHIFT);
+}
+
+static struct binder_buffer *
+binder_alloc_cache_get_locked(struct binder_alloc *alloc, int class)
+{
+	if (!alloc->cache_count[class]) {
+		alloc->cache_misses++;
+		return NULL;
+	}
+	alloc->cache_hits++;
+	return alloc->cache[class][--alloc->cache_count[class]];
+}
+
+/*
+ * Park a freed buffer of exactly one size class in the cache. The buffer
+ * is neither in @free_buffers nor in @allocated_buffers and stays marked
+ * as not free, so neighbours never merge with it and the pages it covers
+ * stay resident until the cache is drained.
+ */
+static bool binder_alloc_cache_put_locked(struct binder_alloc *alloc,
+					  struct binder_buffer *buffer,
+					  size_t buffer_size)
+{
+	int class = binder_alloc_cache_class(alloc, buffer_size);
+
+	if (class < 0 || buffer_size != binder_alloc_cache_size(class) ||
+	    alloc->cache_count[class] == BINDER_ALLOC_CACHE_DEPTH)
+		return false;
+
+	buffer->async_transaction = 0;
+	buffer->target_node = NULL;
+	alloc->cache[class][alloc->cache_count[class]++] = buffer;
+	return true;
+}
+
+static void binder_free_buf_merge_locked(struct binder_alloc *alloc,
+					 struct binder_buffer *buffer,
+					 size_t buffer_size);
+
+/* Return all cached buffers to the best-fit allocator */
+static int binder_alloc_cache_drain_locked(struct binder_alloc *alloc)
+{
+	struct binder_buffer *buffer;
+	int class, count = 0;
+
+	for (class = 0; class < BINDER_ALLOC_CACHE_CLASSES; class++) {
+		while (alloc->cache_count[class]) {
+			buffer = alloc->cache[class][--alloc->cache_count[class]];
+			binder_free_buf_merge_locked(alloc, buffer,
+					binder_alloc_buffer_size(alloc, buffer));
+			count++;
+		}
+	}
+	return count;
+}
+
 static struct binder_buffer *binder_alloc_new_buf_locked(
 				struct binder_alloc *alloc,
 				size_t data_size,
@@ -373,13 +466,14 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 				int is_async,
 				int pid)
 {
-	struct rb_node *n = alloc->free_buffers.rb_node;
+	struct rb_node *n;
 	struct binder_buffer *buffer;
 	size_t buffer_size;
 	struct rb_node *best_fit = NULL;
 	void __user *has_page_addr;
 	void __user *end_page_addr;
 	size_t size, data_offsets_size;
+	int class;
 	int ret;
 
 	/* Check binder_alloc is fully initialized */
@@ -410,6 +504,10 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	/* Pad 0-size buffers so they get assigned unique addresses */
 	size = max(size, sizeof(void *));
 
+	class = binder_alloc_cache_class(alloc, size);
+	if (class >= 0)
+		size = binder_alloc_cache_size(class);
+
 	if (is_async && alloc->free_async_space < size) {
 		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
 			     "%d: binder_alloc_buf size %zd failed, no async space left\n",
@@ -417,6 +515,18 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		return ERR_PTR(-ENOSPC);
 	}
 
+	if (class >= 0) {
+		buffer = binder_alloc_cache_get_locked(alloc, class);
+		if (buffer) {
+			binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				     "%d: binder_alloc_buf size %zd got cached %pK\n",
+				      alloc->pid, size, buffer);
+			goto buffer_ready;
+		}
+	}
+
+retry:
+	n = alloc->free_buffers.rb_node;
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -432,6 +542,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			break;
 		}
 	}
+	if (best_fit == NULL && binder_alloc_cache_drain_locked(alloc))
+		goto retry;
 	if (best_fit == NULL) {
 		size_t allocated_buffers = 0;
 		size_t largest_alloc_size = 0;
@@ -506,6 +618,7 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	rb_erase(best_fit, &alloc->free_buffers);
 	buffer->free = 0;
+buffer_ready:
 	buffer->allow_user_free = 0;
 	binder_insert_allocated_buffer_locked(alloc, buffer);
 	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
@@ -662,12 +775,26 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 			      alloc->pid, size, alloc->free_async_space);
 	}
 
+	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
+	if (binder_alloc_cache_put_locked(alloc, buffer, buffer_size))
+		return;
+
+	binder_free_buf_merge_locked(alloc, buffer, buffer_size);
+}
+
+/*
+ * Return a buffer that is in neither rb tree to the free tree, merging
+ * it with free neighbours and releasing the pages it no longer shares.
+ */
+static void binder_free_buf_merge_locked(struct binder_alloc *alloc,
+					 struct binder_buffer *buffer,
+					 size_t buffer_size)
+{
 	binder_update_page_range(alloc, 0,
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data),
 		(void __user *)(((uintptr_t)
 			  buffer->user_data + buffer_size) & PAGE_MASK));
 
-	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
 	buffer->free = 1;
 	if (!list_is_last(&buffer->entry, &alloc->buffers)) {
 		struct binder_buffer *next = binder_buffer_next(buffer);
@@ -718,6 +845,91 @@ void binder_alloc_free_buf(struct binder_alloc *alloc,
 	mutex_unlock(&alloc->mutex);
 }
 
+/**
+ * binder_alloc_prefault_work() - populate pages of free buffers
+ * @work: &binder_alloc.prefault_work
+ *
+ * Allocates and maps pages that lie entirely inside free buffers until
+ * @alloc->prefault_high pages are resident, and puts them on the binder
+ * LRU as if they had been released by a freed buffer. The next
+ * transactions landing there then only need to take the pages off the
+ * LRU instead of allocating and inserting them. At most
+ * BINDER_PREFAULT_BATCH pages are populated per run to bound the
+ * @alloc->mutex hold time; the work requeues itself if more are needed.
+ */
+static void binder_alloc_prefault_work(struct work_struct *work)
+{
+	struct binder_alloc *alloc =
+		container_of(work, struct binder_alloc, prefault_work);
+	struct binder_buffer *buffer;
+	struct vm_area_struct *vma;
+	struct mm_struct *mm;
+	int populated = 0;
+	bool more = false;
+
+	mutex_lock(&alloc->mutex);
+	mm = alloc->mm;
+	if (!mmget_not_zero(mm))
+		goto out_unlock;
+	mmap_write_lock(mm);
+	vma = alloc->vma;
+	if (!vma)
+		goto out_mmput;
+
+	list_for_each_entry(buffer, &alloc->buffers, entry) {
+		void __user *page_addr, *end;
+
+		if (!buffer->free)
+			continue;
+
+		page_addr = (void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data);
+		end = (void __user *)(((uintptr_t)buffer->user_data +
+			binder_alloc_buffer_size(alloc, buffer)) & PAGE_MASK);
+		for (; page_addr < end; page_addr += PAGE_SIZE) {
+			size_t index = (page_addr - alloc->buffer) / PAGE_SIZE;
+			struct binder_lru_page *page = &alloc->pages[index];
+			struct page *page_ptr;
+
+			if (alloc->pages_resident >= alloc->prefault_high)
+				goto out_mmput;
+			if (populated == BINDER_PREFAULT_BATCH) {
+				more = true;
+				goto out_mmput;
+			}
+			if (page->page_ptr)
+				continue;
+
+			page_ptr = alloc_page(GFP_KERNEL | __GFP_HIGHMEM |
+					      __GFP_ZERO | __GFP_NOWARN);
+			if (!page_ptr)
+				goto out_mmput;
+			if (vm_insert_page(vma, (uintptr_t)page_addr, page_ptr)) {
+				__free_page(page_ptr);
+				goto out_mmput;
+			}
+			page->page_ptr = page_ptr;
+			page->alloc = alloc;
+			INIT_LIST_HEAD(&page->lru);
+			list_lru_add(&binder_alloc_lru, &page->lru);
+			if (index + 1 > alloc->pages_high)
+				alloc->pages_high = index + 1;
+			alloc->pages_resident++;
+			populated++;
+		}
+	}
+
+out_mmput:
+	mmap_write_unlock(mm);
+	mmput_async(mm);
+out_unlock:
+	mutex_unlock(&alloc->mutex);
+
+	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+			   "%d: prefaulted %d pages\n", alloc->pid, populated);
+	if (more)
+		queue_work(system_unbound_wq, &alloc->prefault_work);
+}
+
 /**
  * binder_alloc_mmap_handler() - map virtual address space for proc
  * @alloc:	alloc structure for this proc
@@ -781,6 +993,9 @@ int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 	/* Signal binder_alloc is fully initialized */
 	binder_alloc_set_vma(alloc, vma);
 
+	if (alloc->prefault_high)
+		queue_work(system_unbound_wq, &alloc->prefault_work);
+
 	return 0;
 
 err_alloc_buf_struct_failed:
@@ -808,9 +1023,12 @@ void binder_alloc_deferred_release(struct binder_alloc *alloc)
 	struct binder_buffer *buffer;
 
 	buffers = 0;
+	cancel_work_sync(&alloc->prefault_work);
 	mutex_lock(&alloc->mutex);
 	BUG_ON(alloc->vma);
 
+	binder_alloc_cache_drain_locked(alloc);
+
 	while ((n = rb_first(&alloc->allocated_buffers))) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 
@@ -930,6 +1148,46 @@ void binder_alloc_print_pages(struct seq_file *m,
 	mutex_unlock(&alloc->mutex);
 	seq_printf(m, "  pages: %d:%d:%d\n", active, lru, free);
 	seq_printf(m, "  pages high watermark: %zu\n", alloc->pages_high);
+	if (alloc->prefault_high)
+		seq_printf(m, "  pages prefault: %zu-%zu\n",
+			   alloc->prefault_low, alloc->prefault_high);
+}
+
+/**
+ * binder_alloc_print_buffer_cache() - print small buffer cache statistics
+ * @m:     seq_file for output via seq_printf()
+ * @alloc: binder_alloc for this proc
+ */
+void binder_alloc_print_buffer_cache(struct seq_file *m,
+				     struct binder_alloc *alloc)
+{
+	u64 hits, misses;
+	int class, cached = 0;
+
+	mutex_lock(&alloc->mutex);
+	hits = alloc->cache_hits;
+	misses = alloc->cache_misses;
+	for (class = 0; class < BINDER_ALLOC_CACHE_CLASSES; class++)
+		cached += alloc->cache_count[class];
+	mutex_unlock(&alloc->mutex);
+	seq_printf(m, "  buffer cache: hits %llu misses %llu cached %d\n",
+		   hits, misses, cached);
+}
+
+/**
+ * binder_alloc_disable_buffer_cache() - stop caching small buffers
+ * @alloc: binder_alloc for this proc
+ *
+ * Drains the small buffer cache so that all free space is again tracked
+ * by @alloc->free_buffers, and makes every later allocation use the
+ * best-fit allocator with exact sizes.
+ */
+void binder_alloc_disable_buffer_cache(struct binder_alloc *alloc)
+{
+	mutex_lock(&alloc->mutex);
+	alloc->cache_disabled = true;
+	binder_alloc_cache_drain_locked(alloc);
+	mutex_unlock(&alloc->mutex);
 }
 
 /**
@@ -995,6 +1253,12 @@ enum lru_status binder_alloc_free_page(struct list_head *item,
 	if (!page->page_ptr)
 		goto err_page_already_freed;
 
+	/* Keep the low watermark of pages resident, try others first */
+	if (alloc->pages_resident <= alloc->prefault_low) {
+		mutex_unlock(&alloc->mutex);
+		return LRU_ROTATE;
+	}
+
 	index = page - alloc->pages;
 	page_addr = (uintptr_t)alloc->buffer + index * PAGE_SIZE;
 
@@ -1024,6 +1288,7 @@ enum lru_status binder_alloc_free_page(struct list_head *item,
 
 	__free_page(page->page_ptr);
 	page->page_ptr = NULL;
+	alloc->pages_resident--;
 
 	trace_binder_unmap_kernel_end(alloc, index);
 
@@ -1075,6 +1340,10 @@ void binder_alloc_init(struct binder_alloc *alloc)
 	mmgrab(alloc->mm);
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	INIT_WORK(&alloc->prefault_work, binder_alloc_prefault_work);
+	alloc->prefault_low = READ_ONCE(binder_alloc_prefault_low);
+	alloc->prefault_high = max_t(size_t, alloc->prefault_low,
+				     READ_ONCE(binder_alloc_prefault_high));
 }
 
 int binder_alloc_shrinker_init(void)
@@ -13,11 +13,23 @@
 #include <linux/vmalloc.h>
 #include <linux/slab.h>
 #include <linux/list_lru.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/android/binder.h>
 
 extern struct list_lru binder_alloc_lru;
 struct binder_transaction;
 
+/*
+ * Small buffers are rounded up to a power-of-two size class between
+ * 1 << BINDER_ALLOC_CACHE_MIN_SHIFT and BINDER_ALLOC_CACHE_MAX_SIZE so
+ * that freed ones can be handed out again as-is.
+ */
+#define BINDER_ALLOC_CACHE_MIN_SHIFT	7
+#define BINDER_ALLOC_CACHE_CLASSES	4
+#define BINDER_ALLOC_CACHE_DEPTH	8
+#define BINDER_ALLOC_CACHE_MAX_SIZE \
+	(1UL << (BINDER_ALLOC_CACHE_MIN_SHIFT + BINDER_ALLOC_CACHE_CLASSES - 1))
+
 /**
  * struct binder_buffer - buffer used for binder transactions
  * @entry:              entry alloc->buffers
@@ -91,6 +103,18 @@ struct binder_lru_page {
  * @pages_high:         high watermark of offset in @pages
  * @oneway_spam_detected: %true if oneway spam detection fired, clear that
  * flag once the async buffer has returned to a healthy state
+ * @cache:              recently freed small buffers, indexed by size class,
+ *                      kept out of @free_buffers for reuse without a
+ *                      best-fit search
+ * @cache_count:        number of buffers held in each class of @cache
+ * @cache_disabled:     %true if small buffers must not be cached
+ * @cache_hits:         allocations served from @cache
+ * @cache_misses:       cacheable allocations that fell back to best-fit
+ * @pages_resident:     number of entries in @pages backed by a page
+ * @prefault_low:       the shrinker leaves at least this many pages resident
+ * @prefault_high:      @prefault_work populates free space up to this many
+ *                      resident pages
+ * @prefault_work:      populates pages of free buffers ahead of use
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -111,6 +135,16 @@ struct binder_alloc {
 	int pid;
 	size_t pages_high;
 	bool oneway_spam_detected;
+	struct binder_buffer *cache[BINDER_ALLOC_CACHE_CLASSES]
+				   [BINDER_ALLOC_CACHE_DEPTH];
+	int cache_count[BINDER_ALLOC_CACHE_CLASSES];
+	bool cache_disabled;
+	u64 cache_hits;
+	u64 cache_misses;
+	size_t pages_resident;
+	size_t prefault_low;
+	size_t prefault_high;
+	struct work_struct prefault_work;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
@@ -144,6 +178,9 @@ extern void binder_alloc_print_allocated(struct seq_file *m,
 					 struct binder_alloc *alloc);
 void binder_alloc_print_pages(struct seq_file *m,
 			      struct binder_alloc *alloc);
+void binder_alloc_print_buffer_cache(struct seq_file *m,
+				     struct binder_alloc *alloc);
+void binder_alloc_disable_buffer_cache(struct binder_alloc *alloc);
 
 /**
  * binder_alloc_get_free_async_space() - get free space available for async
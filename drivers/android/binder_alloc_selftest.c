@@ -290,6 +290,8 @@ void binder_selftest_alloc(struct binder_alloc *alloc)
 	if (!binder_selftest_run || !alloc->vma)
 		goto done;
 	pr_info("STARTED\n");
+	/* The page layout checks below rely on exact-size allocations */
+	binder_alloc_disable_buffer_cache(alloc);
 	binder_selftest_alloc_offset(alloc, end_offset, 0);
 	binder_selftest_run = false;
 	if (binder_selftest_failures > 0)
@@ -15,13 +15,33 @@
 #include <uapi/linux/android/binderfs.h>
 #include "binder_alloc.h"
 
+#define BINDER_LATENCY_BUCKETS 24
+
+/**
+ * struct binder_latency_stats - latency histograms for a binder context
+ * @queue:  transactions by time from enqueue to dequeue by a reader
+ * @reply:  transactions by time from start of the transaction to reply
+ *
+ * Bucket 0 counts latencies below 1us and bucket n latencies in
+ * [2^(n-1), 2^n) us, with the last bucket being open-ended. Kept per
+ * CPU and updated without locks.
+ */
+struct binder_latency_stats {
+	unsigned long queue[BINDER_LATENCY_BUCKETS];
+	unsigned long reply[BINDER_LATENCY_BUCKETS];
+};
+
 struct binder_context {
 	struct binder_node *binder_context_mgr_node;
 	struct mutex context_mgr_node_lock;
 	kuid_t binder_context_mgr_uid;
 	const char *name;
+	struct binder_latency_stats __percpu *latency;
 };
 
+int binder_context_init_latency(struct binder_context *context);
+void binder_context_free_latency(struct binder_context *context);
+
 /**
  * struct binder_device - information about a binder device node
  * @hlist:          list of binder devices (only used for devices requested via
@@ -224,6 +244,9 @@ struct binder_error {
  *                        (invariant after initialized)
  * @async_todo:           list of async work items
  *                        (protected by @proc->inner_lock)
+ * @async_queued:         async transactions that had to wait on
+ *                        @async_todo behind one already in progress
+ *                        (protected by @lock)
  *
  * Bookkeeping structure for binder nodes.
  */
@@ -263,6 +286,7 @@ struct binder_node {
 	};
 	bool has_async_transaction;
 	struct list_head async_todo;
+	unsigned int async_queued;
 };
 
 struct binder_ref_death {
@@ -396,6 +420,9 @@ struct binder_ref {
  * @binderfs_entry:       process-specific binderfs log file
  * @oneway_spam_detection_enabled: process enabled oneway spam detection
  *                        or not
+ * @cluster_wakeup:       prefer waiting threads that last ran on a CPU
+ *                        sharing a cache domain with the waker
+ *                        (protected by @inner_lock)
  *
  * Bookkeeping structure for binder processes
  */
@@ -433,6 +460,7 @@ struct binder_proc {
 	spinlock_t outer_lock;
 	struct dentry *binderfs_entry;
 	bool oneway_spam_detection_enabled;
+	bool cluster_wakeup;
 };
 
 /**
@@ -470,6 +498,12 @@ struct binder_proc {
  * @is_dead:              thread is dead and awaiting free
  *                        when outstanding transactions are cleaned up
  *                        (protected by @proc->inner_lock)
+ * @wait_cpu:             CPU the thread last started waiting for proc
+ *                        work on
+ *                        (protected by @proc->inner_lock)
+ * @txn_plug:             batch of oneway transactions collected while
+ *                        processing the current write buffer
+ *                        (only accessed by this thread)
  *
  * Bookkeeping structure for binder threads.
  */
@@ -490,6 +524,37 @@ struct binder_thread {
 	struct binder_stats stats;
 	atomic_t tmp_ref;
 	bool is_dead;
+	int wait_cpu;
+	struct binder_txn_plug *txn_plug;
+};
+
+#define BINDER_TXN_PLUG_MAX 16
+
+/* Waiting threads inspected by a cluster-aware thread selection */
+#define BINDER_SELECT_THREAD_SCAN_MAX 8
+
+/**
+ * struct binder_txn_plug - oneway transactions awaiting delivery
+ * @node:       target node of every transaction in the plug
+ *              (tmpref held while @count is non-zero)
+ * @proc:       process owning @node
+ *              (tmpref held while @count is non-zero)
+ * @count:      number of entries in @txns and @tcomplete
+ * @txns:       transactions not yet queued to @proc
+ * @tcomplete:  TRANSACTION_COMPLETE work queued to the sender for
+ *              the matching entry in @txns
+ *
+ * Consecutive oneway transactions to the same node found in one write
+ * buffer are collected here and handed to the target under a single
+ * acquisition of the node and proc locks, with at most one wakeup.
+ * Lives on the stack of binder_thread_write().
+ */
+struct binder_txn_plug {
+	struct binder_node *node;
+	struct binder_proc *proc;
+	int count;
+	struct binder_transaction *txns[BINDER_TXN_PLUG_MAX];
+	struct binder_work *tcomplete[BINDER_TXN_PLUG_MAX];
 };
 
 /**
@@ -531,6 +596,7 @@ struct binder_transaction {
 	long    saved_priority;
 	kuid_t  sender_euid;
 	ktime_t start_time;
+	ktime_t enqueue_time;
 	struct list_head fd_fixups;
 	binder_uintptr_t security_ctx;
 	/**
@@ -95,6 +95,29 @@ TRACE_EVENT(binder_wait_for_work,
 		  __entry->thread_todo)
 );
 
+TRACE_EVENT(binder_select_thread,
+	TP_PROTO(struct binder_proc *proc, struct binder_thread *thread,
+		 int cpu),
+	TP_ARGS(proc, thread, cpu),
+	TP_STRUCT__entry(
+		__field(int, proc)
+		__field(int, thread)
+		__field(int, cpu)
+		__field(int, wait_cpu)
+		__field(bool, shared)
+	),
+	TP_fast_assign(
+		__entry->proc = proc->pid;
+		__entry->thread = thread->pid;
+		__entry->cpu = cpu;
+		__entry->wait_cpu = thread->wait_cpu;
+		__entry->shared = cpus_share_cache(cpu, thread->wait_cpu);
+	),
+	TP_printk("proc=%d thread=%d cpu=%d wait_cpu=%d shared=%d",
+		  __entry->proc, __entry->thread, __entry->cpu,
+		  __entry->wait_cpu, __entry->shared)
+);
+
 TRACE_EVENT(binder_txn_latency_free,
 	TP_PROTO(struct binder_transaction *t,
 		 int from_proc, int from_thread,
@@ -243,6 +266,24 @@ TRACE_EVENT(binder_transaction_ref_to_ref,
 		  __entry->dest_ref_debug_id, __entry->dest_ref_desc)
 );
 
+TRACE_EVENT(binder_transaction_sg_copy,
+	TP_PROTO(struct binder_transaction *t, size_t offset, size_t length),
+	TP_ARGS(t, offset, length),
+
+	TP_STRUCT__entry(
+		__field(int, debug_id)
+		__field(size_t, offset)
+		__field(size_t, length)
+	),
+	TP_fast_assign(
+		__entry->debug_id = t->debug_id;
+		__entry->offset = offset;
+		__entry->length = length;
+	),
+	TP_printk("transaction=%d offset=%zu length=%zu",
+		  __entry->debug_id, __entry->offset, __entry->length)
+);
+
 TRACE_EVENT(binder_transaction_fd_send,
 	TP_PROTO(struct binder_transaction *t, int fd, size_t offset),
 	TP_ARGS(t, fd, offset),
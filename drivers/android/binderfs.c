@@ -173,6 +173,8 @@ static int binderfs_binder_device_create(struct inode *ref_inode,
 	device->miscdev.name = name;
 	device->miscdev.minor = minor;
 	mutex_init(&device->context.context_mgr_node_lock);
+	if (binder_context_init_latency(&device->context))
+		goto err;
 
 	req->major = MAJOR(binderfs_dev);
 	req->minor = minor;
@@ -209,6 +211,8 @@ static int binderfs_binder_device_create(struct inode *ref_inode,
 	return 0;
 
 err:
+	if (device)
+		binder_context_free_latency(&device->context);
 	kfree(name);
 	kfree(device);
 	mutex_lock(&binderfs_minors_mutex);
@@ -271,6 +275,7 @@ static void binderfs_evict_inode(struct inode *inode)
 	mutex_unlock(&binderfs_minors_mutex);
 
 	if (refcount_dec_and_test(&device->ref)) {
+		binder_context_free_latency(&device->context);
 		kfree(device->context.name);
 		kfree(device);
 	}
@@ -63,8 +63,6 @@ struct loop_device {
 	int			lo_state;
 	spinlock_t              lo_work_lock;
 	struct workqueue_struct *workqueue;
-	struct work_struct      rootcg_work;
-	struct list_head        rootcg_cmd_list;
 	struct list_head        idle_worker_list;
 	struct rb_root          worker_tree;
 	struct timer_list       timer;
@@ -89,6 +87,16 @@ struct loop_cmd {
 	struct cgroup_subsys_state *memcg_css;
 };
 
+/*
+ * Commands issued from the root cgroup are run by a worker per hardware
+ * queue, so that several submitting CPUs can keep the backing file busy.
+ */
+struct loop_hctx {
+	struct work_struct	rootcg_work;
+	struct list_head	rootcg_cmd_list;
+	struct loop_device	*lo;
+};
+
 #define LOOP_IDLE_WORKER_TIMEOUT (60 * HZ)
 #define LOOP_DEFAULT_HW_Q_DEPTH 128
 
@@ -826,14 +834,16 @@ static inline int queue_on_root_worker(struct cgroup_subsys_state *css)
 }
 #endif
 
-static void loop_queue_work(struct loop_device *lo, struct loop_cmd *cmd)
+/* Must be called with lo->lo_work_lock held */
+static void __loop_queue_work(struct loop_device *lo, struct loop_hctx *lh,
+		struct loop_cmd *cmd)
 {
 	struct rb_node **node, *parent = NULL;
 	struct loop_worker *cur_worker, *worker = NULL;
 	struct work_struct *work;
 	struct list_head *cmd_list;
 
-	spin_lock_irq(&lo->lo_work_lock);
+	lockdep_assert_held(&lo->lo_work_lock);
 
 	if (queue_on_root_worker(cmd->blkcg_css))
 		goto queue_work;
@@ -888,11 +898,19 @@ static void loop_queue_work(struct loop_device *lo, struct loop_cmd *cmd)
 		work = &worker->work;
 		cmd_list = &worker->cmd_list;
 	} else {
-		work = &lo->rootcg_work;
-		cmd_list = &lo->rootcg_cmd_list;
+		work = &lh->rootcg_work;
+		cmd_list = &lh->rootcg_cmd_list;
 	}
 	list_add_tail(&cmd->list_entry, cmd_list);
-	queue_work(lo->workqueue, work);
+	/* the workqueue is unbound, this just keeps the worker near us */
+	queue_work_on(raw_smp_processor_id(), lo->workqueue, work);
+}
+
+static void loop_queue_work(struct loop_device *lo, struct loop_hctx *lh,
+		struct loop_cmd *cmd)
+{
+	spin_lock_irq(&lo->lo_work_lock);
+	__loop_queue_work(lo, lh, cmd);
 	spin_unlock_irq(&lo->lo_work_lock);
 }
 
@@ -1836,20 +1854,27 @@ static const struct kernel_param_ops loop_hw_qdepth_param_ops = {
 device_param_cb(hw_queue_depth, &loop_hw_qdepth_param_ops, &hw_queue_depth, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: " __stringify(LOOP_DEFAULT_HW_Q_DEPTH));
 
+static unsigned int nr_hw_queues = 1;
+
+static int loop_set_nr_hw_queues(const char *s, const struct kernel_param *p)
+{
+	return param_set_uint_minmax(s, p, 1, nr_cpu_ids);
+}
+
+static const struct kernel_param_ops loop_nr_hw_queues_param_ops = {
+	.set	= loop_set_nr_hw_queues,
+	.get	= param_get_uint,
+};
+
+device_param_cb(nr_hw_queues, &loop_nr_hw_queues_param_ops, &nr_hw_queues, 0444);
+MODULE_PARM_DESC(nr_hw_queues, "Number of hardware queues per device. Default: 1");
+
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
-static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
-		const struct blk_mq_queue_data *bd)
+static void loop_prep_cmd(struct loop_device *lo, struct request *rq)
 {
-	struct request *rq = bd->rq;
 	struct loop_cmd *cmd = blk_mq_rq_to_pdu(rq);
-	struct loop_device *lo = rq->q->queuedata;
-
-	blk_mq_start_request(rq);
-
-	if (lo->lo_state != Lo_bound)
-		return BLK_STS_IOERR;
 
 	switch (req_op(rq)) {
 	case REQ_OP_FLUSH:
@@ -1877,11 +1902,64 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 #endif
 	}
 #endif
-	loop_queue_work(lo, cmd);
+}
+
+static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
+		const struct blk_mq_queue_data *bd)
+{
+	struct request *rq = bd->rq;
+	struct loop_device *lo = rq->q->queuedata;
+
+	blk_mq_start_request(rq);
+
+	if (lo->lo_state != Lo_bound)
+		return BLK_STS_IOERR;
+
+	loop_prep_cmd(lo, rq);
+	loop_queue_work(lo, hctx->driver_data, blk_mq_rq_to_pdu(rq));
 
 	return BLK_STS_OK;
 }
 
+/*
+ * Hand a whole plug list over to the workers under a single acquisition of
+ * lo_work_lock, so that a burst of requests wakes each worker once and gets
+ * submitted to the backing file back to back.
+ */
+static void loop_queue_rqs(struct request **rqlist)
+{
+	struct request *rq, *next, *requeue_list = NULL;
+	struct request *submit_list = NULL, **tail = &submit_list;
+	struct loop_device *lo = NULL;
+
+	while ((rq = rq_list_pop(rqlist))) {
+		lo = rq->q->queuedata;
+		if (lo->lo_state != Lo_bound) {
+			/* let ->queue_rq fail it */
+			rq_list_add(&requeue_list, rq);
+			continue;
+		}
+		blk_mq_start_request(rq);
+		loop_prep_cmd(lo, rq);
+		rq->rq_next = NULL;
+		*tail = rq;
+		tail = &rq->rq_next;
+	}
+
+	if (submit_list) {
+		spin_lock_irq(&lo->lo_work_lock);
+		for (rq = submit_list; rq; rq = next) {
+			/* rq may complete as soon as it has been queued */
+			next = rq->rq_next;
+			__loop_queue_work(lo, rq->mq_hctx->driver_data,
+					  blk_mq_rq_to_pdu(rq));
+		}
+		spin_unlock_irq(&lo->lo_work_lock);
+	}
+
+	*rqlist = requeue_list;
+}
+
 static void loop_handle_cmd(struct loop_cmd *cmd)
 {
 	struct cgroup_subsys_state *cmd_blkcg_css = cmd->blkcg_css;
@@ -1936,8 +2014,11 @@ static void loop_process_work(struct loop_worker *worker,
 {
 	int orig_flags = current->flags;
 	struct loop_cmd *cmd;
+	struct blk_plug plug;
 
 	current->flags |= PF_LOCAL_THROTTLE | PF_MEMALLOC_NOIO;
+	/* batch the backing device I/O of all queued commands */
+	blk_start_plug(&plug);
 	spin_lock_irq(&lo->lo_work_lock);
 	while (!list_empty(cmd_list)) {
 		cmd = container_of(
@@ -1962,6 +2043,7 @@ static void loop_process_work(struct loop_worker *worker,
 		loop_set_timer(lo);
 	}
 	spin_unlock_irq(&lo->lo_work_lock);
+	blk_finish_plug(&plug);
 	current->flags = orig_flags;
 }
 
@@ -1974,14 +2056,38 @@ static void loop_workfn(struct work_struct *work)
 
 static void loop_rootcg_workfn(struct work_struct *work)
 {
-	struct loop_device *lo =
-		container_of(work, struct loop_device, rootcg_work);
-	loop_process_work(NULL, &lo->rootcg_cmd_list, lo);
+	struct loop_hctx *lh =
+		container_of(work, struct loop_hctx, rootcg_work);
+	loop_process_work(NULL, &lh->rootcg_cmd_list, lh->lo);
+}
+
+static int loop_init_hctx(struct blk_mq_hw_ctx *hctx, void *data,
+		unsigned int hctx_idx)
+{
+	struct loop_hctx *lh;
+
+	lh = kzalloc_node(sizeof(*lh), GFP_KERNEL, hctx->numa_node);
+	if (!lh)
+		return -ENOMEM;
+	INIT_WORK(&lh->rootcg_work, loop_rootcg_workfn);
+	INIT_LIST_HEAD(&lh->rootcg_cmd_list);
+	lh->lo = data;
+	hctx->driver_data = lh;
+	return 0;
+}
+
+static void loop_exit_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
+{
+	kfree(hctx->driver_data);
+	hctx->driver_data = NULL;
 }
 
 static const struct blk_mq_ops loop_mq_ops = {
 	.queue_rq       = loop_queue_rq,
+	.queue_rqs	= loop_queue_rqs,
 	.complete	= lo_complete_rq,
+	.init_hctx	= loop_init_hctx,
+	.exit_hctx	= loop_exit_hctx,
 };
 
 static int loop_add(int i)
@@ -2017,7 +2123,7 @@ static int loop_add(int i)
 	i = err;
 
 	lo->tag_set.ops = &loop_mq_ops;
-	lo->tag_set.nr_hw_queues = 1;
+	lo->tag_set.nr_hw_queues = nr_hw_queues;
 	lo->tag_set.queue_depth = hw_queue_depth;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
@@ -2070,8 +2176,6 @@ static int loop_add(int i)
 	lo->lo_number		= i;
 	spin_lock_init(&lo->lo_lock);
 	spin_lock_init(&lo->lo_work_lock);
-	INIT_WORK(&lo->rootcg_work, loop_rootcg_workfn);
-	INIT_LIST_HEAD(&lo->rootcg_cmd_list);
 	disk->major		= LOOP_MAJOR;
 	disk->first_minor	= i << part_shift;
 	disk->minors		= 1 << part_shift;
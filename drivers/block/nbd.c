@@ -163,6 +163,7 @@ static struct dentry *nbd_dbg_dir;
 static unsigned int nbds_max = 16;
 static int max_part = 16;
 static int part_shift;
+static bool zerocopy_send;
 
 static int nbd_dev_dbg_init(struct nbd_device *nbd);
 static void nbd_dev_dbg_close(struct nbd_device *nbd);
@@ -665,48 +666,65 @@ static int nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd, int index)
 		struct bio *next = bio->bi_next;
 		struct bvec_iter iter;
 		struct bio_vec bvec;
+		int flags = next ? MSG_MORE : 0;
+		unsigned int nr_bvec = 0;
 
-		bio_for_each_segment(bvec, bio, iter) {
-			bool is_last = !next && bio_iter_last(bvec, iter);
-			int flags = is_last ? 0 : MSG_MORE;
-
-			dev_dbg(nbd_to_dev(nbd), "request %p: sending %d bytes data\n",
-				req, bvec.bv_len);
-			iov_iter_bvec(&from, ITER_SOURCE, &bvec, 1, bvec.bv_len);
-			if (skip) {
-				if (skip >= iov_iter_count(&from)) {
-					skip -= iov_iter_count(&from);
-					continue;
+		/*
+		 * Push the whole bio down in a single sendmsg() instead of one
+		 * call per segment, and let the socket reference the pages
+		 * directly when asked to and every page is safe to splice.
+		 */
+		bio_for_each_bvec(bvec, bio, iter)
+			nr_bvec++;
+		if (zerocopy_send) {
+			flags |= MSG_SPLICE_PAGES;
+			/* A multi-page bvec can span pages of different kinds */
+			bio_for_each_segment(bvec, bio, iter) {
+				if (!sendpage_ok(bvec.bv_page)) {
+					flags &= ~MSG_SPLICE_PAGES;
+					break;
 				}
-				iov_iter_advance(&from, skip);
-				skip = 0;
 			}
-			result = sock_xmit(nbd, index, 1, &from, flags, &sent);
-			if (result < 0) {
-				if (was_interrupted(result)) {
-					/* We've already sent the header, we
-					 * have no choice but to set pending and
-					 * return BUSY.
-					 */
-					nsock->pending = req;
-					nsock->sent = sent;
-					set_bit(NBD_CMD_REQUEUED, &cmd->flags);
-					return BLK_STS_RESOURCE;
-				}
-				dev_err(disk_to_dev(nbd->disk),
-					"Send data failed (result %d)\n",
-					result);
-				return -EAGAIN;
+		}
+
+		if (skip >= bio->bi_iter.bi_size) {
+			skip -= bio->bi_iter.bi_size;
+			bio = next;
+			continue;
+		}
+
+		dev_dbg(nbd_to_dev(nbd), "request %p: sending %u bytes data\n",
+			req, bio->bi_iter.bi_size);
+		iov_iter_bvec(&from, ITER_SOURCE,
+			      __bvec_iter_bvec(bio->bi_io_vec, bio->bi_iter),
+			      nr_bvec, bio->bi_iter.bi_size);
+		from.iov_offset = bio->bi_iter.bi_bvec_done;
+		if (skip) {
+			iov_iter_advance(&from, skip);
+			skip = 0;
+		}
+		result = sock_xmit(nbd, index, 1, &from, flags, &sent);
+		if (result < 0) {
+			if (was_interrupted(result)) {
+				/* We've already sent the header, we
+				 * have no choice but to set pending and
+				 * return BUSY.
+				 */
+				nsock->pending = req;
+				nsock->sent = sent;
+				set_bit(NBD_CMD_REQUEUED, &cmd->flags);
+				return BLK_STS_RESOURCE;
 			}
-			/*
-			 * The completion might already have come in,
-			 * so break for the last one instead of letting
-			 * the iterator do it. This prevents use-after-free
-			 * of the bio.
-			 */
-			if (is_last)
-				break;
+			dev_err(disk_to_dev(nbd->disk),
+				"Send data failed (result %d)\n",
+				result);
+			return -EAGAIN;
 		}
+		/*
+		 * The completion might already have come in once the last
+		 * bio is out, so only use the next pointer sampled above.
+		 * This prevents use-after-free of the bio.
+		 */
 		bio = next;
 	}
 out:
@@ -2634,3 +2652,5 @@ module_param(nbds_max, int, 0444);
 MODULE_PARM_DESC(nbds_max, "number of network block devices to initialize (default: 16)");
 module_param(max_part, int, 0444);
 MODULE_PARM_DESC(max_part, "number of partitions per device (default: 16)");
+module_param(zerocopy_send, bool, 0644);
+MODULE_PARM_DESC(zerocopy_send, "let the socket reference write payload pages instead of copying them (default: false)");
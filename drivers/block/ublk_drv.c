@@ -32,6 +32,8 @@
 #include <linux/miscdevice.h>
 #include <linux/falloc.h>
 #include <linux/uio.h>
+#include <linux/splice.h>
+#include <linux/pipe_fs_i.h>
 #include <linux/ioprio.h>
 #include <linux/sched/mm.h>
 #include <linux/uaccess.h>
@@ -1852,10 +1854,9 @@ static inline bool ublk_check_ubuf_dir(const struct request *req,
 	return false;
 }
 
-static struct request *ublk_check_and_get_req(struct kiocb *iocb,
-		struct iov_iter *iter, size_t *off, int dir)
+static struct request *ublk_check_and_get_req_pos(struct ublk_device *ub,
+		loff_t pos, size_t *off, int dir)
 {
-	struct ublk_device *ub = iocb->ki_filp->private_data;
 	struct ublk_queue *ubq;
 	struct request *req;
 	size_t buf_off;
@@ -1864,15 +1865,12 @@ static struct request *ublk_check_and_get_req(struct kiocb *iocb,
 	if (!ub)
 		return ERR_PTR(-EACCES);
 
-	if (!user_backed_iter(iter))
-		return ERR_PTR(-EACCES);
-
 	if (ub->dev_info.state == UBLK_S_DEV_DEAD)
 		return ERR_PTR(-EACCES);
 
-	tag = ublk_pos_to_tag(iocb->ki_pos);
-	q_id = ublk_pos_to_hwq(iocb->ki_pos);
-	buf_off = ublk_pos_to_buf_off(iocb->ki_pos);
+	tag = ublk_pos_to_tag(pos);
+	q_id = ublk_pos_to_hwq(pos);
+	buf_off = ublk_pos_to_buf_off(pos);
 
 	if (q_id >= ub->dev_info.nr_hw_queues)
 		return ERR_PTR(-EINVAL);
@@ -1901,6 +1899,16 @@ static struct request *ublk_check_and_get_req(struct kiocb *iocb,
 	return ERR_PTR(-EACCES);
 }
 
+static struct request *ublk_check_and_get_req(struct kiocb *iocb,
+		struct iov_iter *iter, size_t *off, int dir)
+{
+	if (!user_backed_iter(iter))
+		return ERR_PTR(-EACCES);
+
+	return ublk_check_and_get_req_pos(iocb->ki_filp->private_data,
+					  iocb->ki_pos, off, dir);
+}
+
 static ssize_t ublk_ch_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct ublk_queue *ubq;
@@ -1937,6 +1945,100 @@ static ssize_t ublk_ch_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	return ret;
 }
 
+static void ublk_pipe_buf_release(struct pipe_inode_info *pipe,
+		struct pipe_buffer *buf)
+{
+	struct request *req = (struct request *)buf->private;
+
+	put_page(buf->page);
+	ublk_put_req_ref(req->mq_hctx->driver_data, req);
+}
+
+static bool ublk_pipe_buf_get(struct pipe_inode_info *pipe,
+		struct pipe_buffer *buf)
+{
+	struct request *req = (struct request *)buf->private;
+
+	if (!ublk_get_req_ref(req->mq_hctx->driver_data, req))
+		return false;
+	if (!try_get_page(buf->page)) {
+		ublk_put_req_ref(req->mq_hctx->driver_data, req);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Every pipe buffer holds a reference on the request it points into, so the
+ * request is not completed, and its pages are not handed back to the issuer,
+ * before the last buffer referencing them has been released.
+ */
+static const struct pipe_buf_operations ublk_pipe_buf_ops = {
+	.release	= ublk_pipe_buf_release,
+	.get		= ublk_pipe_buf_get,
+};
+
+/*
+ * Zero copy for UBLK_F_USER_COPY: splice the pages of a WRITE request into
+ * a pipe by reference, so the server can forward them to a socket (e.g. with
+ * IORING_OP_SPLICE) without bouncing them through its own buffer.
+ *
+ * The pipe buffers pin the request, see ublk_pipe_buf_ops: committing the io
+ * command while the data still sits in a pipe only defers the completion
+ * until the pipe has been drained.
+ */
+static ssize_t ublk_ch_splice_read(struct file *in, loff_t *ppos,
+		struct pipe_inode_info *pipe, size_t len, unsigned int flags)
+{
+	struct req_iterator rq_iter;
+	struct ublk_queue *ubq;
+	struct request *req;
+	struct bio_vec bv;
+	size_t buf_off;
+	ssize_t ret = 0;
+	size_t done = 0;
+
+	req = ublk_check_and_get_req_pos(in->private_data, *ppos, &buf_off,
+					 ITER_DEST);
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+	ubq = req->mq_hctx->driver_data;
+
+	rq_for_each_segment(bv, req, rq_iter) {
+		struct pipe_buffer buf = {
+			.ops		= &ublk_pipe_buf_ops,
+			.private	= (unsigned long)req,
+		};
+
+		if (buf_off >= bv.bv_len) {
+			buf_off -= bv.bv_len;
+			continue;
+		}
+
+		buf.page = bv.bv_page;
+		buf.offset = bv.bv_offset + buf_off;
+		buf.len = min_t(size_t, bv.bv_len - buf_off, len - done);
+		buf_off = 0;
+
+		/* can't fail, we hold a reference from the lookup */
+		ublk_get_req_ref(ubq, req);
+		get_page(buf.page);
+		ret = add_to_pipe(pipe, &buf);
+		if (ret < 0)
+			break;
+		done += ret;
+		if (done == len)
+			break;
+	}
+
+	ublk_put_req_ref(ubq, req);
+
+	if (!done)
+		return ret;
+	*ppos += done;
+	return done;
+}
+
 static const struct file_operations ublk_ch_fops = {
 	.owner = THIS_MODULE,
 	.open = ublk_ch_open,
@@ -1944,6 +2046,7 @@ static const struct file_operations ublk_ch_fops = {
 	.llseek = no_llseek,
 	.read_iter = ublk_ch_read_iter,
 	.write_iter = ublk_ch_write_iter,
+	.splice_read = ublk_ch_splice_read,
 	.uring_cmd = ublk_ch_uring_cmd,
 	.mmap = ublk_ch_mmap,
 };
@@ -645,6 +645,55 @@ static ssize_t size_show(struct device *dev, struct device_attribute *attr,
 }
 static DEVICE_ATTR_RW(size);
 
+struct cxl_region_pmus {
+	char *buf;
+	int len;
+};
+
+static int emit_region_pmu(struct device *dev, void *data)
+{
+	struct cxl_region_pmus *ctx = data;
+
+	if (dev->type != &cxl_pmu_type)
+		return 0;
+
+	ctx->len += sysfs_emit_at(ctx->buf, ctx->len, "%s%s",
+				  ctx->len ? " " : "", dev_name(dev));
+	return 0;
+}
+
+/*
+ * List the CPMU instances of the memdevs backing the region, in target
+ * position order, so that the per-device counters can be aggregated into
+ * region level bandwidth and latency figures.
+ */
+static ssize_t pmus_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct cxl_region *cxlr = to_cxl_region(dev);
+	struct cxl_region_params *p = &cxlr->params;
+	struct cxl_region_pmus ctx = { .buf = buf };
+	int i, rc;
+
+	rc = down_read_interruptible(&cxl_region_rwsem);
+	if (rc)
+		return rc;
+	for (i = 0; i < p->interleave_ways; i++) {
+		struct cxl_endpoint_decoder *cxled = p->targets[i];
+		struct cxl_memdev *cxlmd;
+
+		if (!cxled)
+			continue;
+		cxlmd = cxled_to_memdev(cxled);
+		device_for_each_child(cxlmd->dev.parent, &ctx, emit_region_pmu);
+	}
+	ctx.len += sysfs_emit_at(buf, ctx.len, "\n");
+	up_read(&cxl_region_rwsem);
+
+	return ctx.len;
+}
+static DEVICE_ATTR_RO(pmus);
+
 static struct attribute *cxl_region_attrs[] = {
 	&dev_attr_uuid.attr,
 	&dev_attr_commit.attr,
@@ -653,6 +702,7 @@ static struct attribute *cxl_region_attrs[] = {
 	&dev_attr_resource.attr,
 	&dev_attr_size.attr,
 	&dev_attr_mode.attr,
+	&dev_attr_pmus.attr,
 	NULL,
 };
 
@@ -439,6 +439,60 @@ static long dma_buf_import_sync_file(struct dma_buf *dmabuf,
 }
 #endif
 
+static int dma_buf_sync_flags_to_dir(u64 flags, enum dma_data_direction *direction)
+{
+	if (flags & ~DMA_BUF_SYNC_VALID_FLAGS_MASK)
+		return -EINVAL;
+
+	switch (flags & DMA_BUF_SYNC_RW) {
+	case DMA_BUF_SYNC_READ:
+		*direction = DMA_FROM_DEVICE;
+		break;
+	case DMA_BUF_SYNC_WRITE:
+		*direction = DMA_TO_DEVICE;
+		break;
+	case DMA_BUF_SYNC_RW:
+		*direction = DMA_BIDIRECTIONAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static long dma_buf_sync_partial(struct dma_buf *dmabuf, const void __user *user_data)
+{
+	struct dma_buf_sync_partial sync;
+	enum dma_data_direction direction;
+	int ret;
+
+	if (copy_from_user(&sync, user_data, sizeof(sync)))
+		return -EFAULT;
+
+	ret = dma_buf_sync_flags_to_dir(sync.flags, &direction);
+	if (ret)
+		return ret;
+
+	/* The exporter callbacks take 32-bit offsets and lengths */
+	if (!sync.len || sync.offset > UINT_MAX || sync.len > UINT_MAX ||
+	    sync.offset + sync.len > dmabuf->size)
+		return -EINVAL;
+
+	if (!dmabuf->ops->begin_cpu_access_partial ||
+	    !dmabuf->ops->end_cpu_access_partial) {
+		if (sync.flags & DMA_BUF_SYNC_END)
+			return dma_buf_end_cpu_access(dmabuf, direction);
+		return dma_buf_begin_cpu_access(dmabuf, direction);
+	}
+
+	if (sync.flags & DMA_BUF_SYNC_END)
+		return dma_buf_end_cpu_access_partial(dmabuf, direction,
+						      sync.offset, sync.len);
+	return dma_buf_begin_cpu_access_partial(dmabuf, direction,
+						sync.offset, sync.len);
+}
+
 static long dma_buf_ioctl(struct file *file,
 			  unsigned int cmd, unsigned long arg)
 {
@@ -454,22 +508,9 @@ static long dma_buf_ioctl(struct file *file,
 		if (copy_from_user(&sync, (void __user *) arg, sizeof(sync)))
 			return -EFAULT;
 
-		if (sync.flags & ~DMA_BUF_SYNC_VALID_FLAGS_MASK)
-			return -EINVAL;
-
-		switch (sync.flags & DMA_BUF_SYNC_RW) {
-		case DMA_BUF_SYNC_READ:
-			direction = DMA_FROM_DEVICE;
-			break;
-		case DMA_BUF_SYNC_WRITE:
-			direction = DMA_TO_DEVICE;
-			break;
-		case DMA_BUF_SYNC_RW:
-			direction = DMA_BIDIRECTIONAL;
-			break;
-		default:
-			return -EINVAL;
-		}
+		ret = dma_buf_sync_flags_to_dir(sync.flags, &direction);
+		if (ret)
+			return ret;
 
 		if (sync.flags & DMA_BUF_SYNC_END)
 			ret = dma_buf_end_cpu_access(dmabuf, direction);
@@ -478,6 +519,9 @@ static long dma_buf_ioctl(struct file *file,
 
 		return ret;
 
+	case DMA_BUF_IOCTL_SYNC_PARTIAL:
+		return dma_buf_sync_partial(dmabuf, (const void __user *)arg);
+
 	case DMA_BUF_SET_NAME_A:
 	case DMA_BUF_SET_NAME_B:
 		return dma_buf_set_name(dmabuf, (const char __user *)arg);
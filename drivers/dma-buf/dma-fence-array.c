@@ -103,10 +103,42 @@ static bool dma_fence_array_enable_signaling(struct dma_fence *fence)
 static bool dma_fence_array_signaled(struct dma_fence *fence)
 {
 	struct dma_fence_array *array = to_dma_fence_array(fence);
+	struct dma_fence *f;
+	unsigned int i;
 
-	if (atomic_read(&array->num_pending) > 0)
+	if (atomic_read(&array->num_pending) <= 0)
+		goto signaled;
+
+	/* Once signaling is enabled the callbacks keep num_pending up to date */
+	if (test_bit(DMA_FENCE_FLAG_ENABLE_SIGNAL_BIT, &fence->flags))
+		return false;
+
+	if (array->signal_on_any) {
+		for (i = 0; i < array->num_fences; ++i) {
+			f = array->fences[i];
+			if (dma_fence_is_signaled(f)) {
+				dma_fence_array_set_pending_error(array, f->error);
+				goto signaled;
+			}
+		}
 		return false;
+	}
+
+	/*
+	 * Otherwise poll the fences. A fence never goes back to unsignaled, so
+	 * remember the first one still pending and resume from there next
+	 * time rather than rescanning the whole array.
+	 */
+	for (i = READ_ONCE(array->num_signaled); i < array->num_fences; ++i) {
+		f = array->fences[i];
+		if (!dma_fence_is_signaled(f)) {
+			WRITE_ONCE(array->num_signaled, i);
+			return false;
+		}
+		dma_fence_array_set_pending_error(array, f->error);
+	}
 
+signaled:
 	dma_fence_array_clear_pending_error(array);
 	return true;
 }
@@ -186,6 +218,7 @@ struct dma_fence_array *dma_fence_array_create(int num_fences,
 	array->num_fences = num_fences;
 	atomic_set(&array->num_pending, signal_on_any ? 1 : num_fences);
 	array->fences = fences;
+	array->signal_on_any = signal_on_any;
 
 	array->base.error = PENDING_ERROR;
 
@@ -161,17 +161,48 @@ static bool dma_fence_chain_enable_signaling(struct dma_fence *fence)
 	return false;
 }
 
+/*
+ * Remember which contained fence stopped the last dma_fence_chain_signaled()
+ * walk, so that polling an unsignaled chain only has to recheck that fence
+ * instead of walking the chain again.
+ */
+static void dma_fence_chain_set_pending(struct dma_fence_chain *head,
+					struct dma_fence *f)
+{
+	struct dma_fence *old;
+
+	old = unrcu_pointer(xchg(&head->pending,
+				 RCU_INITIALIZER(dma_fence_get(f))));
+	dma_fence_put(old);
+}
+
 static bool dma_fence_chain_signaled(struct dma_fence *fence)
 {
+	struct dma_fence_chain *head = to_dma_fence_chain(fence);
+	struct dma_fence *pending;
+
+	rcu_read_lock();
+	pending = dma_fence_get_rcu_safe(&head->pending);
+	rcu_read_unlock();
+	if (pending) {
+		bool signaled = dma_fence_is_signaled(pending);
+
+		dma_fence_put(pending);
+		if (!signaled)
+			return false;
+	}
+
 	dma_fence_chain_for_each(fence, fence) {
 		struct dma_fence *f = dma_fence_chain_contained(fence);
 
 		if (!dma_fence_is_signaled(f)) {
+			dma_fence_chain_set_pending(head, f);
 			dma_fence_put(fence);
 			return false;
 		}
 	}
 
+	dma_fence_chain_set_pending(head, NULL);
 	return true;
 }
 
@@ -202,6 +233,7 @@ static void dma_fence_chain_release(struct dma_fence *fence)
 	}
 	dma_fence_put(prev);
 
+	dma_fence_put(rcu_dereference_protected(chain->pending, true));
 	dma_fence_put(chain->fence);
 	dma_fence_free(fence);
 }
@@ -250,6 +282,7 @@ void dma_fence_chain_init(struct dma_fence_chain *chain,
 	rcu_assign_pointer(chain->prev, prev);
 	chain->fence = fence;
 	chain->prev_seqno = 0;
+	RCU_INIT_POINTER(chain->pending, NULL);
 
 	/* Try to reuse the context of the previous chain node. */
 	if (prev_chain && __dma_fence_is_later(seqno, prev->seqno, prev->ops)) {
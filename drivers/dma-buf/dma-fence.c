@@ -479,6 +479,62 @@ int dma_fence_signal(struct dma_fence *fence)
 }
 EXPORT_SYMBOL(dma_fence_signal);
 
+/**
+ * dma_fence_signal_range - signal a run of fences on one timeline
+ * @fences: fences to signal, all from the same context and sharing one lock
+ * @count: number of entries in @fences
+ * @seqno: sequence number up to which fences should be signaled
+ *
+ * Signal completion of every fence in @fences whose sequence number is not
+ * later than @seqno. Drivers retiring a batch of work on one timeline can use
+ * this instead of calling dma_fence_signal() on each fence, which takes the
+ * shared &dma_fence.lock once per fence. All fences are signaled under a
+ * single acquisition of the lock and get the same timestamp.
+ *
+ * Fences not sharing the lock or context of the first fence are skipped with
+ * a warning.
+ *
+ * Returns the number of fences signaled by this call.
+ */
+unsigned int dma_fence_signal_range(struct dma_fence **fences,
+				    unsigned int count, u64 seqno)
+{
+	unsigned int i, signaled = 0;
+	unsigned long flags;
+	ktime_t timestamp;
+	spinlock_t *lock;
+	bool tmp;
+
+	if (!count)
+		return 0;
+
+	lock = fences[0]->lock;
+
+	tmp = dma_fence_begin_signalling();
+
+	spin_lock_irqsave(lock, flags);
+	timestamp = ktime_get();
+	for (i = 0; i < count; i++) {
+		struct dma_fence *fence = fences[i];
+
+		if (WARN_ON(fence->lock != lock ||
+			    fence->context != fences[0]->context))
+			continue;
+
+		if (__dma_fence_is_later(fence->seqno, seqno, fence->ops))
+			continue;
+
+		if (!dma_fence_signal_timestamp_locked(fence, timestamp))
+			signaled++;
+	}
+	spin_unlock_irqrestore(lock, flags);
+
+	dma_fence_end_signalling(tmp);
+
+	return signaled;
+}
+EXPORT_SYMBOL(dma_fence_signal_range);
+
 /**
  * dma_fence_wait_timeout - sleep until the fence gets signaled
  * or until timeout elapses
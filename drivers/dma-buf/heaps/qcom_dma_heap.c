@@ -30,9 +30,12 @@ static int qcom_dma_heap_probe(struct platform_device *pdev)
 	int i;
 	struct platform_data *heaps;
 
-	qcom_system_heap_create("qcom,system", NULL, false);
+	qcom_system_heap_create("qcom,system", NULL, false, false);
 #ifdef CONFIG_QCOM_DMABUF_HEAPS_SYSTEM_UNCACHED
-	qcom_system_heap_create("qcom,system-uncached", NULL, true);
+	qcom_system_heap_create("qcom,system-uncached", NULL, true, false);
+#endif
+#ifdef CONFIG_QCOM_DMABUF_HEAPS_SYSTEM_HUGE
+	qcom_system_heap_create("qcom,system-huge", NULL, false, true);
 #endif
 	qcom_secure_system_heap_create("qcom,secure-pixel", NULL,
 				       QCOM_DMA_HEAP_FLAG_CP_PIXEL);
@@ -16,6 +16,7 @@
  */
 
 #include <linux/list.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/spinlock.h>
@@ -27,11 +28,8 @@
 static LIST_HEAD(pool_list);
 static DEFINE_MUTEX(pool_list_lock);
 
-void dynamic_page_pool_add(struct dynamic_page_pool *pool, struct page *page)
+static void __dynamic_page_pool_put(struct dynamic_page_pool *pool, struct page *page)
 {
-	unsigned long flags;
-
-	spin_lock_irqsave(&pool->lock, flags);
 	if (PageHighMem(page)) {
 		list_add_tail(&page->lru, &pool->high_items);
 		pool->high_count++;
@@ -39,14 +37,9 @@ void dynamic_page_pool_add(struct dynamic_page_pool *pool, struct page *page)
 		list_add_tail(&page->lru, &pool->low_items);
 		pool->low_count++;
 	}
-
-	atomic_inc(&pool->count);
-	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
-			    1 << pool->order);
-	spin_unlock_irqrestore(&pool->lock, flags);
 }
 
-struct page *dynamic_page_pool_remove(struct dynamic_page_pool *pool, bool high)
+static struct page *__dynamic_page_pool_take(struct dynamic_page_pool *pool, bool high)
 {
 	struct page *page;
 
@@ -60,18 +53,188 @@ struct page *dynamic_page_pool_remove(struct dynamic_page_pool *pool, bool high)
 		pool->low_count--;
 	}
 
-	atomic_dec(&pool->count);
 	list_del(&page->lru);
+	return page;
+}
+
+void dynamic_page_pool_add(struct dynamic_page_pool *pool, struct page *page)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	__dynamic_page_pool_put(pool, page);
+
+	atomic_inc(&pool->count);
+	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+			    1 << pool->order);
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+
+/*
+ * Add a list of pages to the pool under a single acquisition of the pool
+ * lock. The list is left empty.
+ */
+void dynamic_page_pool_add_list(struct dynamic_page_pool *pool, struct list_head *pages)
+{
+	struct page *page, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	list_for_each_entry_safe(page, tmp, pages, lru) {
+		list_del(&page->lru);
+		__dynamic_page_pool_put(pool, page);
+
+		atomic_inc(&pool->count);
+		mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+				    1 << pool->order);
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+
+struct page *dynamic_page_pool_remove(struct dynamic_page_pool *pool, bool high)
+{
+	struct page *page = __dynamic_page_pool_take(pool, high);
+
+	atomic_dec(&pool->count);
 	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
 			    -(1 << pool->order));
 	return page;
 }
 
+/*
+ * Pages held in a per-CPU front cache are still accounted to the pool (in
+ * pool->count and NR_KERNEL_MISC_RECLAIMABLE), they are just not on the pool
+ * lists. Moving pages between a front cache and the lists therefore only
+ * touches the high/low counts.
+ *
+ * Front cache locks nest outside of pool->lock and are taken with interrupts
+ * disabled so that the local cache cannot change under us.
+ */
+static void dynamic_page_pool_pcp_refill(struct dynamic_page_pool *pool,
+					 struct dynamic_page_pool_pcp *pcp)
+{
+	struct page *page;
+	int nr = 0;
+
+	spin_lock(&pool->lock);
+	while (pcp->count < pool->pcp_batch) {
+		if (pool->high_count)
+			page = __dynamic_page_pool_take(pool, true);
+		else if (pool->low_count)
+			page = __dynamic_page_pool_take(pool, false);
+		else
+			break;
+
+		pcp->pages[pcp->count++] = page;
+		nr++;
+	}
+	spin_unlock(&pool->lock);
+
+	atomic_add(nr, &pool->pcp_count);
+}
+
+/* Move the @nr oldest pages of a front cache back onto the pool lists. */
+static void dynamic_page_pool_pcp_drain(struct dynamic_page_pool *pool,
+					struct dynamic_page_pool_pcp *pcp, int nr)
+{
+	int i;
+
+	nr = min(nr, pcp->count);
+	if (!nr)
+		return;
+
+	spin_lock(&pool->lock);
+	for (i = 0; i < nr; i++)
+		__dynamic_page_pool_put(pool, pcp->pages[i]);
+	spin_unlock(&pool->lock);
+
+	pcp->count -= nr;
+	memmove(pcp->pages, pcp->pages + nr, pcp->count * sizeof(pcp->pages[0]));
+	atomic_sub(nr, &pool->pcp_count);
+}
+
+/* Flush every CPU's front cache back onto the pool lists. */
+void dynamic_page_pool_drain_pcp(struct dynamic_page_pool *pool)
+{
+	struct dynamic_page_pool_pcp *pcp;
+	unsigned long flags;
+	int cpu;
+
+	if (!pool->pcp || !atomic_read(&pool->pcp_count))
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+
+		spin_lock_irqsave(&pcp->lock, flags);
+		dynamic_page_pool_pcp_drain(pool, pcp, pcp->count);
+		spin_unlock_irqrestore(&pcp->lock, flags);
+	}
+}
+
+struct page *dynamic_page_pool_alloc(struct dynamic_page_pool *pool)
+{
+	struct dynamic_page_pool_pcp *pcp;
+	struct page *page = NULL;
+	unsigned long flags;
+
+	if (!pool->pcp) {
+		spin_lock_irqsave(&pool->lock, flags);
+		if (pool->high_count)
+			page = dynamic_page_pool_remove(pool, true);
+		else if (pool->low_count)
+			page = dynamic_page_pool_remove(pool, false);
+		spin_unlock_irqrestore(&pool->lock, flags);
+
+		return page;
+	}
+
+	local_irq_save(flags);
+	pcp = this_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (!pcp->count)
+		dynamic_page_pool_pcp_refill(pool, pcp);
+	if (pcp->count) {
+		page = pcp->pages[--pcp->count];
+		atomic_dec(&pool->pcp_count);
+	}
+	spin_unlock(&pcp->lock);
+	local_irq_restore(flags);
+
+	if (page) {
+		atomic_dec(&pool->count);
+		mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+				    -(1 << pool->order));
+	}
+
+	return page;
+}
+
 void dynamic_page_pool_free(struct dynamic_page_pool *pool, struct page *page)
 {
+	struct dynamic_page_pool_pcp *pcp;
+	unsigned long flags;
+
 	BUG_ON(pool->order != compound_order(page));
 
-	dynamic_page_pool_add(pool, page);
+	if (!pool->pcp) {
+		dynamic_page_pool_add(pool, page);
+		return;
+	}
+
+	atomic_inc(&pool->count);
+	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+			    1 << pool->order);
+
+	local_irq_save(flags);
+	pcp = this_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count >= pool->pcp_high)
+		dynamic_page_pool_pcp_drain(pool, pcp, pool->pcp_batch);
+	pcp->pages[pcp->count++] = page;
+	atomic_inc(&pool->pcp_count);
+	spin_unlock(&pcp->lock);
+	local_irq_restore(flags);
 }
 
 int dynamic_page_pool_total(struct dynamic_page_pool *pool, bool high)
@@ -79,7 +242,7 @@ int dynamic_page_pool_total(struct dynamic_page_pool *pool, bool high)
 	int count = pool->low_count;
 
 	if (high)
-		count += pool->high_count;
+		count += pool->high_count + atomic_read(&pool->pcp_count);
 
 	return count << pool->order;
 }
@@ -96,6 +259,10 @@ struct dynamic_page_pool *dynamic_page_pool_create(gfp_t gfp_mask, unsigned int
 	INIT_LIST_HEAD(&pool->high_items);
 	pool->gfp_mask = gfp_mask | __GFP_COMP;
 	pool->order = order;
+	pool->pcp = NULL;
+	pool->pcp_high = 0;
+	pool->pcp_batch = 0;
+	atomic_set(&pool->pcp_count, 0);
 	spin_lock_init(&pool->lock);
 
 	mutex_lock(&pool_list_lock);
@@ -105,6 +272,25 @@ struct dynamic_page_pool *dynamic_page_pool_create(gfp_t gfp_mask, unsigned int
 	return pool;
 }
 
+static void dynamic_page_pool_init_pcp(struct dynamic_page_pool *pool)
+{
+	int cpu;
+
+	pool->pcp_high = min_t(unsigned long, DYNAMIC_POOL_PCP_MAX,
+			       DYNAMIC_POOL_PCP_BYTES / (PAGE_SIZE << pool->order));
+	pool->pcp_batch = pool->pcp_high / 2;
+	if (!pool->pcp_batch)
+		return;
+
+	/* The front caches are an optimisation; run without them on failure. */
+	pool->pcp = alloc_percpu(struct dynamic_page_pool_pcp);
+	if (!pool->pcp)
+		return;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(pool->pcp, cpu)->lock);
+}
+
 void dynamic_page_pool_destroy(struct dynamic_page_pool *pool)
 {
 	struct page *page, *tmp;
@@ -118,6 +304,8 @@ void dynamic_page_pool_destroy(struct dynamic_page_pool *pool)
 	list_del(&pool->list);
 	mutex_unlock(&pool_list_lock);
 
+	dynamic_page_pool_drain_pcp(pool);
+
 	/* Free any remaining pages in the pool */
 	spin_lock_irqsave(&pool->lock, flags);
 	while (true) {
@@ -146,6 +334,7 @@ void dynamic_page_pool_destroy(struct dynamic_page_pool *pool)
 		__free_pages(page, pool->order);
 	}
 
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
 
@@ -166,6 +355,8 @@ static int dynamic_page_pool_do_shrink(struct dynamic_page_pool *pool, gfp_t gfp
 	if (nr_to_scan == 0)
 		return dynamic_page_pool_total(pool, high);
 
+	dynamic_page_pool_drain_pcp(pool);
+
 	while (freed < nr_to_scan) {
 		unsigned long flags;
 
@@ -295,6 +486,14 @@ struct dynamic_page_pool **dynamic_page_pool_create_pools(int vmid,
 			ret = -ENOMEM;
 			goto free_pool_arr;
 		}
+
+		/*
+		 * Pools with a prerelease callback hold pages assigned to
+		 * other VMs, which are taken directly off the pool lists by
+		 * their heap, so only plain pools get front caches.
+		 */
+		if (!callback)
+			dynamic_page_pool_init_pcp(pool_list[i]);
 	}
 
 	return pool_list;
@@ -22,6 +22,7 @@
 #include <linux/mm_types.h>
 #include <linux/mutex.h>
 #include <linux/shrinker.h>
+#include <linux/sizes.h>
 #include <linux/types.h>
 
 #define HIGH_ORDER_GFP  (((GFP_HIGHUSER | __GFP_ZERO | __GFP_NOWARN \
@@ -47,6 +48,27 @@ enum dynamic_pool_callback_ret {
 	DYNAMIC_POOL_FAILURE,
 };
 
+/*
+ * Per-CPU front caches hold at most DYNAMIC_POOL_PCP_BYTES worth of pages per
+ * order, capped at DYNAMIC_POOL_PCP_MAX entries. Orders whose pages are larger
+ * than that (e.g. 2MB) bypass the front cache and go straight to the pool.
+ */
+#define DYNAMIC_POOL_PCP_MAX	32
+#define DYNAMIC_POOL_PCP_BYTES	SZ_1M
+
+/**
+ * struct dynamic_page_pool_pcp - per-CPU front cache of a pool
+ * @lock:	lock protecting this cache, only contended while it is drained
+ *		from another CPU
+ * @count:	number of pages in @pages
+ * @pages:	cached pages, most recently freed last
+ */
+struct dynamic_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct page *pages[DYNAMIC_POOL_PCP_MAX];
+};
+
 struct dynamic_page_pool;
 
 typedef enum dynamic_pool_callback_ret (*prerelease_callback)(struct dynamic_page_pool *pool,
@@ -71,6 +93,11 @@ typedef enum dynamic_pool_callback_ret (*prerelease_callback)(struct dynamic_pag
  * @vmid:			the vmid used for this pool
  * @prerelease_callback:	preprocessing function called before pages are
  *				released to buddy
+ * @pcp:			per-CPU front caches, NULL if not used for this pool
+ * @pcp_high:			maximum number of pages held in each front cache
+ * @pcp_batch:			number of pages moved between a front cache and
+ *				the pool lists at a time
+ * @pcp_count:			total number of pages held in the front caches
  *
  * Allows you to keep a pool of pre allocated pages to use
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -91,6 +118,10 @@ struct dynamic_page_pool {
 	struct list_head list;
 	int vmid;
 	prerelease_callback prerelease_callback;
+	struct dynamic_page_pool_pcp __percpu *pcp;
+	int pcp_high;
+	int pcp_batch;
+	atomic_t pcp_count;
 };
 
 struct dynamic_page_pool **dynamic_page_pool_create_pools(int vmid,
@@ -107,5 +138,7 @@ int dynamic_page_pool_total(struct dynamic_page_pool *pool, bool high);
 
 struct page *dynamic_page_pool_remove(struct dynamic_page_pool *pool, bool high);
 void dynamic_page_pool_add(struct dynamic_page_pool *pool, struct page *page);
+void dynamic_page_pool_add_list(struct dynamic_page_pool *pool, struct list_head *pages);
+void dynamic_page_pool_drain_pcp(struct dynamic_page_pool *pool);
 
 #endif /* _DYN_PAGE_POOL_H */
@@ -214,6 +214,56 @@ void qcom_sg_unmap_dma_buf(struct dma_buf_attachment *attachment,
 	mutex_unlock(&buffer->lock);
 }
 
+static int sgl_sync_range(struct device *dev, struct scatterlist *sgl,
+			  unsigned int nents, unsigned long offset,
+			  unsigned long length,
+			  enum dma_data_direction dir, bool for_cpu);
+
+/*
+ * A CPU access session that may write to the buffer marks the range it
+ * covers as CPU-dirty. When the session is ended without a range, only the
+ * accumulated dirty range is cleaned for the device instead of the whole
+ * buffer, so partial updates to large buffers stay cheap even for clients
+ * that end access with a plain DMA_BUF_IOCTL_SYNC. Read-only sessions still
+ * maintain the whole buffer. Must be called with buffer->lock held.
+ */
+static void qcom_sg_mark_cpu_dirty(struct qcom_sg_buffer *buffer,
+				   enum dma_data_direction dir,
+				   unsigned long offset, unsigned long len)
+{
+	if (dir == DMA_FROM_DEVICE)
+		return;
+
+	if (buffer->cpu_dirty_end <= buffer->cpu_dirty_start) {
+		buffer->cpu_dirty_start = offset;
+		buffer->cpu_dirty_end = offset + len;
+	} else {
+		buffer->cpu_dirty_start = min(buffer->cpu_dirty_start, offset);
+		buffer->cpu_dirty_end = max(buffer->cpu_dirty_end, offset + len);
+	}
+}
+
+static void qcom_sg_clear_cpu_dirty(struct qcom_sg_buffer *buffer)
+{
+	buffer->cpu_dirty_start = 0;
+	buffer->cpu_dirty_end = 0;
+}
+
+/*
+ * Clean [offset, offset + len) for one attachment. Ranged maintenance needs
+ * the attachment to be mapped as a single DMA segment; otherwise fall back
+ * to maintaining the whole table.
+ */
+static void qcom_sg_sync_range_for_device(struct dma_heap_attachment *a,
+					  unsigned long offset, unsigned long len,
+					  enum dma_data_direction dir)
+{
+	if (a->table->nents != 1 ||
+	    sgl_sync_range(a->dev, a->table->sgl, a->table->orig_nents,
+			   offset, len, dir, false))
+		dma_sync_sgtable_for_device(a->dev, a->table, dir);
+}
+
 int qcom_sg_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 				     enum dma_data_direction direction)
 {
@@ -240,6 +290,7 @@ int qcom_sg_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 		dma_sync_sgtable_for_cpu(a->dev, a->table, direction);
 	}
 
+	qcom_sg_mark_cpu_dirty(buffer, direction, 0, buffer->len);
 	mutex_unlock(&buffer->lock);
 
 	return 0;
@@ -262,6 +313,23 @@ int qcom_sg_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 		return 0;
 	}
 
+	if (direction != DMA_FROM_DEVICE &&
+	    buffer->cpu_dirty_end > buffer->cpu_dirty_start &&
+	    buffer->cpu_dirty_end - buffer->cpu_dirty_start < buffer->len) {
+		unsigned long offset = buffer->cpu_dirty_start;
+		unsigned long len = buffer->cpu_dirty_end - offset;
+
+		if (buffer->vmap_cnt)
+			flush_kernel_vmap_range(buffer->vaddr + offset, len);
+
+		list_for_each_entry(a, &buffer->attachments, list) {
+			if (!a->mapped)
+				continue;
+			qcom_sg_sync_range_for_device(a, offset, len, direction);
+		}
+		goto out;
+	}
+
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
@@ -270,6 +338,8 @@ int qcom_sg_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 			continue;
 		dma_sync_sgtable_for_device(a->dev, a->table, direction);
 	}
+out:
+	qcom_sg_clear_cpu_dirty(buffer);
 	mutex_unlock(&buffer->lock);
 
 	return 0;
@@ -364,6 +434,8 @@ int qcom_sg_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 		ret = sgl_sync_range(a->dev, a->table->sgl, a->table->orig_nents,
 				     offset, len, dir, true);
 	}
+
+	qcom_sg_mark_cpu_dirty(buffer, dir, offset, len);
 	mutex_unlock(&buffer->lock);
 
 	return ret;
@@ -399,6 +471,11 @@ int qcom_sg_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
 		ret = sgl_sync_range(a->dev, a->table->sgl, a->table->orig_nents,
 				     offset, len, direction, false);
 	}
+
+	/* The range just cleaned no longer needs maintenance at full end */
+	if (!ret && offset <= buffer->cpu_dirty_start &&
+	    offset + len >= buffer->cpu_dirty_end)
+		qcom_sg_clear_cpu_dirty(buffer);
 	mutex_unlock(&buffer->lock);
 
 	return ret;
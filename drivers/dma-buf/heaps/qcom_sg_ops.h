@@ -30,6 +30,9 @@ struct qcom_sg_buffer {
 	bool uncached;
 	struct mem_buf_vmperm *vmperm;
 	void (*free)(struct qcom_sg_buffer *buffer);
+	/* Range CPU writes are pending cleaning in, empty if end <= start */
+	unsigned long cpu_dirty_start;
+	unsigned long cpu_dirty_end;
 };
 
 struct dma_heap_attachment {
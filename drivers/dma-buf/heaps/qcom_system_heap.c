@@ -60,6 +60,16 @@
 #include "qcom_system_heap.h"
 #include "../../../mm/internal.h"
 
+/*
+ * Allocation flags for the largest order pool of a huge heap. Unlike
+ * HIGH_ORDER_GFP this allows direct reclaim so that, combined with
+ * __GFP_NORETRY, the allocator performs a single round of light (async)
+ * compaction before giving up on a costly order.
+ */
+#define HUGE_ORDER_GFP  ((GFP_HIGHUSER | __GFP_ZERO | __GFP_NOWARN \
+				| __GFP_NORETRY | __GFP_NOMEMALLOC \
+				| __GFP_DIRECT_RECLAIM) & ~__GFP_KSWAPD_RECLAIM)
+
 #if IS_ENABLED(CONFIG_QCOM_DMABUF_HEAPS_PAGE_POOL_REFILL)
 #define DYNAMIC_POOL_FILL_MARK (100 * SZ_1M)
 #define DYNAMIC_POOL_LOW_MARK_PERCENT 40UL
@@ -67,6 +77,7 @@
 
 #define DYNAMIC_POOL_REFILL_DEFER_WINDOW_MS 10
 #define DYNAMIC_POOL_KTHREAD_NICE_VAL 10
+#define DYNAMIC_POOL_REFILL_BATCH 8
 
 static int get_dynamic_pool_fillmark(struct dynamic_page_pool *pool)
 {
@@ -211,21 +222,49 @@ static bool dynamic_pool_refill_ok(struct dynamic_page_pool *pool)
 	return true;
 }
 
-static void dynamic_page_pool_refill(struct dynamic_page_pool *pool)
+/*
+ * The refill thread normally reclaims as hard as needed to reach the fill
+ * mark. For the huge-order pool of a huge heap, keep __GFP_NORETRY and let
+ * kswapd/kcompactd do the heavy lifting in the background, so that refilling
+ * does not churn the page cache just to assemble 2MB pages.
+ */
+static gfp_t system_heap_refill_gfp(struct qcom_system_heap *sys_heap,
+				    struct dynamic_page_pool *pool)
 {
-	struct page *page;
-	gfp_t gfp_refill = (pool->gfp_mask | __GFP_RECLAIM) & ~__GFP_NORETRY;
+	if (sys_heap->huge && pool->order == orders[0])
+		return pool->gfp_mask | __GFP_RECLAIM;
+
+	return (pool->gfp_mask | __GFP_RECLAIM) & ~__GFP_NORETRY;
+}
+
+static void dynamic_page_pool_refill(struct dynamic_page_pool *pool, gfp_t gfp_refill)
+{
+	struct page *page = NULL;
 
 	/* skip refilling order 0 pools */
 	if (!pool->order)
 		return;
 
 	while (!dynamic_pool_fillmark_reached(pool) && dynamic_pool_refill_ok(pool)) {
-		page = alloc_pages(gfp_refill, pool->order);
-		if (!page)
+		LIST_HEAD(pages);
+		int nr = min(DYNAMIC_POOL_REFILL_BATCH, get_dynamic_pool_fillmark(pool) -
+			     atomic_read(&pool->count));
+
+		/* Hand pages over in batches to limit pool lock round trips */
+		while (nr-- > 0) {
+			page = alloc_pages(gfp_refill, pool->order);
+			if (!page)
+				break;
+
+			list_add_tail(&page->lru, &pages);
+		}
+
+		if (list_empty(&pages))
 			break;
 
-		dynamic_page_pool_add(pool, page);
+		dynamic_page_pool_add_list(pool, &pages);
+		if (!page)
+			break;
 	}
 }
 
@@ -236,13 +275,16 @@ static bool dynamic_pool_needs_refill(struct dynamic_page_pool *pool)
 
 static int system_heap_refill_worker(void *data)
 {
-	struct dynamic_page_pool **pool_list = data;
+	struct qcom_system_heap *sys_heap = data;
+	struct dynamic_page_pool **pool_list = sys_heap->pool_list;
 	int i;
 
 	for (;;) {
 		for (i = 0; i < NUM_ORDERS; i++) {
 			if (dynamic_pool_count_below_lowmark(pool_list[i]))
-				dynamic_page_pool_refill(pool_list[i]);
+				dynamic_page_pool_refill(pool_list[i],
+							 system_heap_refill_gfp(sys_heap,
+										pool_list[i]));
 		}
 
 		set_current_state(TASK_INTERRUPTIBLE);
@@ -265,7 +307,7 @@ static int system_heap_create_refill_worker(struct qcom_system_heap *sys_heap, c
 	int ret;
 	int i;
 
-	refill_worker = kthread_run(system_heap_refill_worker, sys_heap->pool_list,
+	refill_worker = kthread_run(system_heap_refill_worker, sys_heap,
 				    "%s-pool-refill-thread", name);
 	if (IS_ERR(refill_worker)) {
 		pr_err("%s: failed to create %s-pool-refill-thread: %ld\n",
@@ -384,20 +426,12 @@ struct page *qcom_sys_heap_alloc_largest_available(struct dynamic_page_pool **po
 	int i;
 
 	for (i = 0; i < NUM_ORDERS; i++) {
-		unsigned long flags;
-
 		if (size <  (PAGE_SIZE << orders[i]))
 			continue;
 		if (max_order < orders[i])
 			continue;
 
-		spin_lock_irqsave(&pools[i]->lock, flags);
-		if (pools[i]->high_count)
-			page = dynamic_page_pool_remove(pools[i], true);
-		else if (pools[i]->low_count)
-			page = dynamic_page_pool_remove(pools[i], false);
-		spin_unlock_irqrestore(&pools[i]->lock, flags);
-
+		page = dynamic_page_pool_alloc(pools[i]);
 		if (!page)
 			page = alloc_pages(pools[i]->gfp_mask, pools[i]->order);
 		if (!page)
@@ -422,8 +456,9 @@ int system_qcom_sg_buffer_alloc(struct dma_heap *heap,
 	struct sg_table *table;
 	struct scatterlist *sg;
 	struct list_head pages;
+	struct list_head order_pages[NUM_ORDERS];
 	struct page *page, *tmp_page;
-	int i, ret = -ENOMEM;
+	int i, j, ret = -ENOMEM;
 
 	sys_heap = dma_heap_get_drvdata(heap);
 
@@ -435,6 +470,8 @@ int system_qcom_sg_buffer_alloc(struct dma_heap *heap,
 	buffer->free = qcom_system_heap_free;
 
 	INIT_LIST_HEAD(&pages);
+	for (j = 0; j < NUM_ORDERS; j++)
+		INIT_LIST_HEAD(&order_pages[j]);
 	i = 0;
 	while (size_remaining > 0) {
 		/*
@@ -451,12 +488,31 @@ int system_qcom_sg_buffer_alloc(struct dma_heap *heap,
 		if (!page)
 			goto free_mem;
 
-		list_add_tail(&page->lru, &pages);
+		for (j = 0; j < NUM_ORDERS; j++) {
+			if (compound_order(page) == orders[j])
+				break;
+		}
+
+		list_add_tail(&page->lru, &order_pages[j]);
 		size_remaining -= page_size(page);
-		max_order = compound_order(page);
+		/*
+		 * A huge heap keeps trying the largest order for every chunk
+		 * instead of settling for the order that last succeeded.
+		 */
+		if (!sys_heap->huge)
+			max_order = compound_order(page);
 		i++;
 	}
 
+	/*
+	 * Lay the pages out largest order first. Since each order is naturally
+	 * aligned and the IOVA range of a mapping is size aligned, this keeps
+	 * every high order chunk at an IOVA aligned to its size, which lets
+	 * the IOMMU page table code use block mappings for it.
+	 */
+	for (j = 0; j < NUM_ORDERS; j++)
+		list_splice_tail_init(&order_pages[j], &pages);
+
 	table = &buffer->sg_table;
 	if (sg_alloc_table(table, i, GFP_KERNEL))
 		goto free_mem;
@@ -482,6 +538,8 @@ int system_qcom_sg_buffer_alloc(struct dma_heap *heap,
 	return 0;
 
 free_mem:
+	for (j = 0; j < NUM_ORDERS; j++)
+		list_splice_tail_init(&order_pages[j], &pages);
 	list_for_each_entry_safe(page, tmp_page, &pages, lru) {
 		/* Unpin the memory first if it was borrowed from movable zone */
 		if (is_zone_movable_page(page))
@@ -544,7 +602,8 @@ static const struct dma_heap_ops system_heap_ops = {
 	.allocate = system_heap_allocate,
 };
 
-void qcom_system_heap_create(const char *name, const char *system_alias, bool uncached)
+void qcom_system_heap_create(const char *name, const char *system_alias, bool uncached,
+			     bool huge)
 {
 	struct dma_heap_export_info exp_info;
 	struct dma_heap *heap;
@@ -566,6 +625,7 @@ void qcom_system_heap_create(const char *name, const char *system_alias, bool un
 	exp_info.priv = sys_heap;
 
 	sys_heap->uncached = uncached;
+	sys_heap->huge = huge;
 
 	sys_heap->pool_list = dynamic_page_pool_create_pools(0, NULL);
 	if (IS_ERR(sys_heap->pool_list)) {
@@ -573,6 +633,9 @@ void qcom_system_heap_create(const char *name, const char *system_alias, bool un
 		goto free_heap;
 	}
 
+	if (huge)
+		sys_heap->pool_list[0]->gfp_mask = HUGE_ORDER_GFP | __GFP_COMP;
+
 	ret = system_heap_create_refill_worker(sys_heap, name);
 	if (ret)
 		goto free_pools;
@@ -15,11 +15,13 @@
 
 struct qcom_system_heap {
 	int uncached;
+	bool huge;
 	struct dynamic_page_pool **pool_list;
 };
 
 #ifdef CONFIG_QCOM_DMABUF_HEAPS_SYSTEM
-void qcom_system_heap_create(const char *name, const char *system_alias, bool uncached);
+void qcom_system_heap_create(const char *name, const char *system_alias, bool uncached,
+			     bool huge);
 void qcom_system_heap_free(struct qcom_sg_buffer *buffer);
 struct page *qcom_sys_heap_alloc_largest_available(struct dynamic_page_pool **pools,
 						   unsigned long size,
@@ -35,7 +37,7 @@ bool dynamic_pool_zone_watermark_ok_safe(struct zone *z, unsigned int order,
 					unsigned long mark, int highest_zoneidx);
 #else
 static inline void qcom_system_heap_create(const char *name, const char *system_alias,
-					   bool uncached)
+					   bool uncached, bool huge)
 {
 
 }
@@ -147,6 +147,59 @@ static int test_signaling(void *arg)
 	return err;
 }
 
+static int test_signal_range(void *arg)
+{
+	struct dma_fence *fences[4] = {};
+	struct mock_fence *f;
+	spinlock_t lock;
+	u64 context;
+	int err = -EINVAL;
+	int i;
+
+	spin_lock_init(&lock);
+	context = dma_fence_context_alloc(1);
+	for (i = 0; i < ARRAY_SIZE(fences); i++) {
+		f = kmem_cache_alloc(slab_fences, GFP_KERNEL);
+		if (!f) {
+			err = -ENOMEM;
+			goto err_free;
+		}
+
+		dma_fence_init(&f->base, &mock_ops, &lock, context, i + 1);
+		fences[i] = &f->base;
+	}
+
+	if (dma_fence_signal_range(fences, ARRAY_SIZE(fences), 2) != 2) {
+		pr_err("Fence range did not signal the first two fences\n");
+		goto err_free;
+	}
+
+	if (!dma_fence_is_signaled(fences[1]) || dma_fence_is_signaled(fences[2])) {
+		pr_err("Fence range signaled past the requested seqno\n");
+		goto err_free;
+	}
+
+	if (fences[0]->timestamp != fences[1]->timestamp) {
+		pr_err("Fence range did not share one timestamp\n");
+		goto err_free;
+	}
+
+	if (dma_fence_signal_range(fences, ARRAY_SIZE(fences), 4) != 2) {
+		pr_err("Fence range resignaled already signaled fences\n");
+		goto err_free;
+	}
+
+	err = 0;
+err_free:
+	for (i = 0; i < ARRAY_SIZE(fences); i++) {
+		if (fences[i]) {
+			dma_fence_signal(fences[i]);
+			dma_fence_put(fences[i]);
+		}
+	}
+	return err;
+}
+
 struct simple_cb {
 	struct dma_fence_cb cb;
 	bool seen;
@@ -564,6 +617,7 @@ int dma_fence(void)
 	static const struct subtest tests[] = {
 		SUBTEST(sanitycheck),
 		SUBTEST(test_signaling),
+		SUBTEST(test_signal_range),
 		SUBTEST(test_add_callback),
 		SUBTEST(test_late_add_callback),
 		SUBTEST(test_rm_callback),
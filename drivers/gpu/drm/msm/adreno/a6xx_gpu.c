@@ -212,18 +212,20 @@ static void a6xx_submit(struct msm_gpu *gpu, struct msm_gem_submit *submit)
 			OUT_RING(ring, upper_32_bits(submit->cmd[i].iova));
 			OUT_RING(ring, submit->cmd[i].size);
 			ibs++;
+
+			/*
+			 * Periodically update shadow-wptr if needed, so that we
+			 * can see partial progress of submits with large # of
+			 * cmds.. otherwise we could needlessly stall waiting for
+			 * ringbuffer state, simply due to looking at a shadow
+			 * rptr value that has not been updated.  Only count
+			 * IBs actually emitted, skipped cmds don't advance the
+			 * ring.
+			 */
+			if ((ibs % 32) == 0)
+				update_shadow_rptr(gpu, ring);
 			break;
 		}
-
-		/*
-		 * Periodically update shadow-wptr if needed, so that we
-		 * can see partial progress of submits with large # of
-		 * cmds.. otherwise we could needlessly stall waiting for
-		 * ringbuffer state, simply due to looking at a shadow
-		 * rptr value that has not been updated
-		 */
-		if ((ibs % 32) == 0)
-			update_shadow_rptr(gpu, ring);
 	}
 
 	get_stats_counter(ring, REG_A6XX_RBBM_PERFCTR_CP(0),
@@ -246,8 +248,13 @@ static void a6xx_submit(struct msm_gpu *gpu, struct msm_gem_submit *submit)
 	OUT_RING(ring, upper_32_bits(rbmemptr(ring, fence)));
 	OUT_RING(ring, submit->seqno);
 
-	trace_msm_gpu_submit_flush(submit,
-		gpu_read64(gpu, REG_A6XX_CP_ALWAYS_ON_COUNTER));
+	/*
+	 * The always-on counter read is a pair of MMIO reads on every
+	 * submit, don't pay for it unless someone is tracing.
+	 */
+	if (trace_msm_gpu_submit_flush_enabled())
+		trace_msm_gpu_submit_flush(submit,
+			gpu_read64(gpu, REG_A6XX_CP_ALWAYS_ON_COUNTER));
 
 	a6xx_flush(gpu, ring);
 }
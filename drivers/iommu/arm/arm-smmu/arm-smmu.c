@@ -321,12 +321,49 @@ static void arm_smmu_tlb_inv_walk_s1(unsigned long iova, size_t size,
 	}
 }
 
+/*
+ * Unmapped stage-1 leaf entries are only accumulated in the gather here and
+ * invalidated from .iotlb_sync: a contiguous run is then either one loop of
+ * TLBIVALs or, once it exceeds ARM_SMMU_INV_RANGE_MAX_PAGES, a single
+ * TLBIASID. iommu_iotlb_gather_add_page() syncs early if the next page is
+ * disjoint from, or of a different size than, what has been gathered.
+ */
+#define ARM_SMMU_INV_RANGE_MAX_PAGES	64
+
 static void arm_smmu_tlb_add_page_s1(struct iommu_iotlb_gather *gather,
 				     unsigned long iova, size_t granule,
 				     void *cookie)
 {
-	arm_smmu_tlb_inv_range_s1(iova, granule, granule, cookie,
-				  ARM_SMMU_CB_S1_TLBIVAL);
+	struct arm_smmu_domain *smmu_domain = cookie;
+
+	if (!gather) {
+		arm_smmu_tlb_inv_range_s1(iova, granule, granule, cookie,
+					  ARM_SMMU_CB_S1_TLBIVAL);
+		return;
+	}
+
+	iommu_iotlb_gather_add_page(&smmu_domain->domain, gather, iova, granule);
+}
+
+static void arm_smmu_tlb_inv_gather_s1(struct arm_smmu_domain *smmu_domain,
+				       struct iommu_iotlb_gather *gather)
+{
+	size_t size;
+
+	if (gather->end < gather->start || !gather->pgsize) {
+		arm_smmu_tlb_sync_context(smmu_domain);
+		return;
+	}
+
+	size = gather->end - gather->start + 1;
+	if (size / gather->pgsize > ARM_SMMU_INV_RANGE_MAX_PAGES) {
+		arm_smmu_tlb_inv_context_s1(smmu_domain);
+		return;
+	}
+
+	arm_smmu_tlb_inv_range_s1(gather->start, size, gather->pgsize,
+				  smmu_domain, ARM_SMMU_CB_S1_TLBIVAL);
+	arm_smmu_tlb_sync_context(smmu_domain);
 }
 
 static void arm_smmu_tlb_inv_walk_s2(unsigned long iova, size_t size,
@@ -1241,8 +1278,10 @@ static void arm_smmu_iotlb_sync(struct iommu_domain *domain,
 		return;
 
 	arm_smmu_rpm_get(smmu);
-	if (smmu->version == ARM_SMMU_V2 ||
-	    smmu_domain->stage == ARM_SMMU_DOMAIN_S1)
+	if (smmu_domain->flush_ops == &arm_smmu_s1_tlb_ops)
+		arm_smmu_tlb_inv_gather_s1(smmu_domain, gather);
+	else if (smmu->version == ARM_SMMU_V2 ||
+		 smmu_domain->stage == ARM_SMMU_DOMAIN_S1)
 		arm_smmu_tlb_sync_context(smmu_domain);
 	else
 		arm_smmu_tlb_sync_global(smmu);
@@ -324,7 +324,10 @@ enum data_mode {
 };
 
 struct dm_buffer {
-	/* protected by the locks in dm_buffer_cache */
+	/*
+	 * Protected by the locks in dm_buffer_cache, but also walked
+	 * locklessly under RCU by cache_get().
+	 */
 	struct rb_node node;
 
 	/* immutable, so don't need protecting */
@@ -355,6 +358,7 @@ struct dm_buffer {
 	struct list_head write_list;
 	struct dm_bufio_client *c;
 	void (*end_io)(struct dm_buffer *b, blk_status_t bs);
+	struct rcu_head rcu;
 #ifdef CONFIG_DM_DEBUG_BLOCK_STACK_TRACING
 #define MAX_STACK 10
 	unsigned int stack_len;
@@ -612,10 +616,79 @@ static void __cache_inc_buffer(struct dm_buffer *b)
 	WRITE_ONCE(b->last_accessed, jiffies);
 }
 
+/*
+ * Upper bound on the nodes visited by a lockless lookup. Buffers are
+ * recycled for other blocks without waiting for a grace period, so a
+ * lockless walk may follow stale links; bounding it guarantees termination,
+ * and a false miss just falls back to the locked lookup.
+ */
+#define CACHE_GET_RCU_MAX_DEPTH	(2 * BITS_PER_LONG)
+
+static struct dm_buffer *__cache_get_rcu(const struct rb_root *root, sector_t block)
+{
+	struct rb_node *n = READ_ONCE(root->rb_node);
+	unsigned int depth = 0;
+	struct dm_buffer *b;
+	sector_t b_block;
+
+	while (n && depth++ < CACHE_GET_RCU_MAX_DEPTH) {
+		b = container_of(n, struct dm_buffer, node);
+		b_block = READ_ONCE(b->block);
+
+		if (b_block == block)
+			return b;
+
+		n = block < b_block ? READ_ONCE(n->rb_left) : READ_ONCE(n->rb_right);
+	}
+
+	return NULL;
+}
+
+static void cache_put_and_wake(struct dm_bufio_client *c, struct dm_buffer *b);
+
+/*
+ * Lockless fast path for buffers somebody else already holds, which covers
+ * the hot metadata blocks (btree roots, top hash tree levels) that many CPUs
+ * look up at once. A buffer with a zero hold count may be evicted under the
+ * tree lock at any time, so only an elevated hold count can be taken without
+ * it. The buffer found may have been recycled meanwhile, so recheck it once
+ * it is pinned.
+ */
+static struct dm_buffer *cache_get_rcu(struct dm_buffer_cache *bc, sector_t block)
+{
+	struct dm_buffer *b;
+
+	rcu_read_lock();
+	b = __cache_get_rcu(&bc->trees[cache_index(block, bc->num_locks)].root, block);
+	if (!b || RB_EMPTY_NODE(&b->node) ||
+	    !atomic_inc_not_zero(&b->hold_count)) {
+		rcu_read_unlock();
+		return NULL;
+	}
+	rcu_read_unlock();
+
+	/* The reference keeps b from being freed or recycled from here on. */
+	if (likely(READ_ONCE(b->block) == block &&
+		   &b->c->cache == bc && !RB_EMPTY_NODE(&b->node))) {
+		lru_reference(&b->lru);
+		WRITE_ONCE(b->last_accessed, jiffies);
+		return b;
+	}
+
+	/* We may be dropping the last reference, so wake any allocator. */
+	cache_put_and_wake(b->c, b);
+
+	return NULL;
+}
+
 static struct dm_buffer *cache_get(struct dm_buffer_cache *bc, sector_t block)
 {
 	struct dm_buffer *b;
 
+	b = cache_get_rcu(bc, block);
+	if (b)
+		return b;
+
 	cache_read_lock(bc, block);
 	b = __cache_get(&bc->trees[cache_index(block, bc->num_locks)].root, block);
 	if (b) {
@@ -692,6 +765,7 @@ static struct dm_buffer *__cache_evict(struct dm_buffer_cache *bc, int list_mode
 	b = le_to_buffer(le);
 	/* __evict_pred will have locked the appropriate tree. */
 	rb_erase(&b->node, &bc->trees[cache_index(b->block, bc->num_locks)].root);
+	RB_CLEAR_NODE(&b->node);
 
 	return b;
 }
@@ -842,7 +916,7 @@ static bool __cache_insert(struct rb_root *root, struct dm_buffer *b)
 			&found->node.rb_left : &found->node.rb_right;
 	}
 
-	rb_link_node(&b->node, parent, new);
+	rb_link_node_rcu(&b->node, parent, new);
 	rb_insert_color(&b->node, root);
 
 	return true;
@@ -856,7 +930,8 @@ static bool cache_insert(struct dm_buffer_cache *bc, struct dm_buffer *b)
 		return false;
 
 	cache_write_lock(bc, b->block);
-	BUG_ON(atomic_read(&b->hold_count) != 1);
+	/* lockless lookups may hold a transient extra reference */
+	BUG_ON(!atomic_read(&b->hold_count));
 	r = __cache_insert(&bc->trees[cache_index(b->block, bc->num_locks)].root, b);
 	if (r)
 		lru_insert(&bc->lru[b->list_mode], &b->lru);
@@ -870,6 +945,12 @@ static bool cache_insert(struct dm_buffer_cache *bc, struct dm_buffer *b)
 /*
  * Removes buffer from cache, ownership of the buffer passes back to the caller.
  * Fails if the hold_count is not one (ie. the caller holds the only reference).
+ * The hold_count is dropped to zero atomically so that lockless lookups can no
+ * longer take a reference.  A lockless lookup that has just pinned the buffer,
+ * even one about to drop it again because the buffer turned out to be stale,
+ * makes this fail exactly like any other holder would.  Callers treat that as
+ * a buffer still in use and leave it cached; it's reconsidered on its next
+ * release or eviction.
  *
  * Not threadsafe.
  */
@@ -879,11 +960,12 @@ static bool cache_remove(struct dm_buffer_cache *bc, struct dm_buffer *b)
 
 	cache_write_lock(bc, b->block);
 
-	if (atomic_read(&b->hold_count) != 1) {
+	if (atomic_cmpxchg(&b->hold_count, 1, 0) != 1) {
 		r = false;
 	} else {
 		r = true;
 		rb_erase(&b->node, &bc->trees[cache_index(b->block, bc->num_locks)].root);
+		RB_CLEAR_NODE(&b->node);
 		lru_remove(&bc->lru[b->list_mode], &b->lru);
 	}
 
@@ -940,6 +1022,7 @@ static void __remove_range(struct dm_buffer_cache *bc,
 
 		if (pred(b, NULL) == ER_EVICT) {
 			rb_erase(&b->node, root);
+			RB_CLEAR_NODE(&b->node);
 			lru_remove(&bc->lru[b->list_mode], &b->lru);
 			release(b);
 		}
@@ -1234,6 +1317,8 @@ static struct dm_buffer *alloc_buffer(struct dm_bufio_client *c, gfp_t gfp_mask)
 		return NULL;
 
 	b->c = c;
+	RB_CLEAR_NODE(&b->node);
+	atomic_set(&b->hold_count, 0);
 
 	b->data = alloc_buffer_data(c, gfp_mask, &b->data_mode);
 	if (!b->data) {
@@ -1248,8 +1333,16 @@ static struct dm_buffer *alloc_buffer(struct dm_bufio_client *c, gfp_t gfp_mask)
 	return b;
 }
 
+static void free_buffer_rcu(struct rcu_head *rcu)
+{
+	struct dm_buffer *b = container_of(rcu, struct dm_buffer, rcu);
+
+	kmem_cache_free(b->c->slab_buffer, b);
+}
+
 /*
- * Free buffer and its data.
+ * Free buffer and its data.  The buffer itself may still be looked at by
+ * lockless lookups, so it is freed after a grace period.
  */
 static void free_buffer(struct dm_buffer *b)
 {
@@ -1257,7 +1350,7 @@ static void free_buffer(struct dm_buffer *b)
 
 	adjust_total_allocated(b, true);
 	free_buffer_data(c, b->data, b->data_mode);
-	kmem_cache_free(c->slab_buffer, b);
+	call_rcu(&b->rcu, free_buffer_rcu);
 }
 
 /*
@@ -1784,9 +1877,8 @@ static struct dm_buffer *__bufio_new(struct dm_bufio_client *c, sector_t block,
 	__check_watermark(c, write_list);
 
 	b = new_b;
-	atomic_set(&b->hold_count, 1);
 	WRITE_ONCE(b->last_accessed, jiffies);
-	b->block = block;
+	WRITE_ONCE(b->block, block);
 	b->read_error = 0;
 	b->write_error = 0;
 	b->list_mode = LIST_CLEAN;
@@ -1798,6 +1890,12 @@ static struct dm_buffer *__bufio_new(struct dm_bufio_client *c, sector_t block,
 		*need_submit = 1;
 	}
 
+	/*
+	 * Publish the new identity before the hold count, a lockless lookup
+	 * that pins a recycled buffer must see the new block number.
+	 */
+	atomic_set_release(&b->hold_count, 1);
+
 	/*
 	 * We mustn't insert into the cache until the B_READING state
 	 * is set.  Otherwise another thread could get it and use
@@ -2552,6 +2650,8 @@ struct dm_bufio_client *dm_bufio_client_create(struct block_device *bdev, unsign
 		free_buffer(b);
 	}
 	kmem_cache_destroy(c->slab_cache);
+	/* wait for free_buffer_rcu() */
+	rcu_barrier();
 	kmem_cache_destroy(c->slab_buffer);
 	dm_io_client_destroy(c->dm_io);
 bad_dm_io:
@@ -2603,6 +2703,8 @@ void dm_bufio_client_destroy(struct dm_bufio_client *c)
 
 	cache_destroy(&c->cache);
 	kmem_cache_destroy(c->slab_cache);
+	/* wait for free_buffer_rcu() */
+	rcu_barrier();
 	kmem_cache_destroy(c->slab_buffer);
 	dm_io_client_destroy(c->dm_io);
 	mutex_destroy(&c->lock);
@@ -45,6 +45,7 @@ struct entry {
 	bool allocated:1;
 	bool sentinel:1;
 	bool pending_work:1;
+	bool hashed:1;
 
 	dm_oblock_t oblock;
 };
@@ -617,8 +618,11 @@ static struct entry *h_next(struct smq_hash_table *ht, struct entry *e)
 
 static void __h_insert(struct smq_hash_table *ht, unsigned int bucket, struct entry *e)
 {
+	/* pairs with the barriers in h_lookup_lockless() */
+	smp_wmb();
+	e->hashed = true;
 	e->hash_next = ht->buckets[bucket];
-	ht->buckets[bucket] = to_index(ht->es, e);
+	WRITE_ONCE(ht->buckets[bucket], to_index(ht->es, e));
 }
 
 static void h_insert(struct smq_hash_table *ht, struct entry *e)
@@ -684,8 +688,45 @@ static void h_remove(struct smq_hash_table *ht, struct entry *e)
 	 * iterate the bucket to remove an item.
 	 */
 	e = __h_lookup(ht, h, e->oblock, &prev);
-	if (e)
+	if (e) {
 		__h_unlink(ht, h, e, prev);
+		e->hashed = false;
+	}
+}
+
+/*
+ * Bound on the entries a lockless lookup walks.  Entries are recycled under
+ * the lock while we walk, so a walk may be diverted to another chain; the
+ * bound guarantees termination and a miss just means taking the lock.
+ */
+#define SMQ_LOCKLESS_MAX_CHAIN 16u
+
+/*
+ * Lockless lookup of @oblock.  Only valid while the caller prevents the
+ * mapping of @oblock itself from changing (the target holds the shared bio
+ * prison lock on the block), so any entry found hashed for @oblock is the
+ * live mapping.  The oblock is read again after the hashed flag, so an entry
+ * recycled for another block since we reached it is rejected.
+ */
+static struct entry *h_lookup_lockless(struct smq_hash_table *ht, dm_oblock_t oblock)
+{
+	unsigned int h = hash_64(from_oblock(oblock), ht->hash_bits);
+	unsigned int i, idx = READ_ONCE(ht->buckets[h]);
+	struct entry *e;
+
+	for (i = 0; idx != INDEXER_NULL && i < SMQ_LOCKLESS_MAX_CHAIN; i++) {
+		e = __get_entry(ht->es, idx);
+		if (data_race(e->oblock == oblock)) {
+			smp_rmb();
+			if (!data_race(e->hashed))
+				return NULL;
+			smp_rmb();
+			return data_race(e->oblock == oblock) ? e : NULL;
+		}
+		idx = data_race(e->hash_next);
+	}
+
+	return NULL;
 }
 
 /*----------------------------------------------------------------*/
@@ -794,6 +835,11 @@ static struct entry *get_entry(struct entry_alloc *ea, unsigned int index)
 #define HOTSPOT_UPDATE_PERIOD (HZ)
 #define CACHE_UPDATE_PERIOD (60ul * HZ)
 
+struct smq_pcpu_stats {
+	unsigned long hits;
+	unsigned long misses;
+};
+
 struct smq_policy {
 	struct dm_cache_policy policy;
 
@@ -830,6 +876,14 @@ struct smq_policy {
 	struct stats hotspot_stats;
 	struct stats cache_stats;
 
+	/*
+	 * Hits taken on the lockless lookup path are counted per cpu and
+	 * folded into cache_stats under the lock.
+	 */
+	struct smq_pcpu_stats __percpu *pcpu_stats;
+	unsigned long folded_hits;
+	unsigned long folded_misses;
+
 	/*
 	 * Keeps track of time, incremented by the core.  We use this to
 	 * avoid attributing multiple hits within the same tick.
@@ -1363,6 +1417,7 @@ static void smq_destroy(struct dm_cache_policy *p)
 	struct smq_policy *mq = to_smq_policy(p);
 
 	btracker_destroy(mq->bg_work);
+	free_percpu(mq->pcpu_stats);
 	h_exit(&mq->hotspot_table);
 	h_exit(&mq->table);
 	free_bitset(mq->hotspot_hit_bits);
@@ -1408,6 +1463,59 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 	}
 }
 
+/*
+ * The common hit is on a block that has already been requeued in this
+ * period (its cache_hit_bits bit is set), which only has to bump the level
+ * statistics.  Serve those without the policy lock, counting the hit per
+ * cpu; anything else falls through to __lookup().
+ */
+static bool smq_lookup_hit_lockless(struct smq_policy *mq, dm_oblock_t oblock,
+				    dm_cblock_t *cblock)
+{
+	struct smq_pcpu_stats *stats;
+	struct entry *e;
+	dm_cblock_t cb;
+
+	e = h_lookup_lockless(&mq->table, oblock);
+	if (!e)
+		return false;
+
+	cb = infer_cblock(mq, e);
+	if (!test_bit(from_cblock(cb), mq->cache_hit_bits))
+		return false;
+
+	stats = get_cpu_ptr(mq->pcpu_stats);
+	if (data_race(e->level) >= mq->cache_stats.hit_threshold)
+		stats->hits++;
+	else
+		stats->misses++;
+	put_cpu_ptr(mq->pcpu_stats);
+
+	*cblock = cb;
+	return true;
+}
+
+/*
+ * Called with the lock held, before the cache statistics are consumed.
+ */
+static void smq_fold_pcpu_stats(struct smq_policy *mq)
+{
+	unsigned long hits = 0, misses = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct smq_pcpu_stats *stats = per_cpu_ptr(mq->pcpu_stats, cpu);
+
+		hits += READ_ONCE(stats->hits);
+		misses += READ_ONCE(stats->misses);
+	}
+
+	mq->cache_stats.hits += hits - mq->folded_hits;
+	mq->cache_stats.misses += misses - mq->folded_misses;
+	mq->folded_hits = hits;
+	mq->folded_misses = misses;
+}
+
 static int smq_lookup(struct dm_cache_policy *p, dm_oblock_t oblock, dm_cblock_t *cblock,
 		      int data_dir, bool fast_copy,
 		      bool *background_work)
@@ -1416,6 +1524,11 @@ static int smq_lookup(struct dm_cache_policy *p, dm_oblock_t oblock, dm_cblock_t
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
+	if (smq_lookup_hit_lockless(mq, oblock, cblock)) {
+		*background_work = false;
+		return 0;
+	}
+
 	spin_lock_irqsave(&mq->lock, flags);
 	r = __lookup(mq, oblock, cblock,
 		     data_dir, fast_copy,
@@ -1435,6 +1548,9 @@ static int smq_lookup_with_work(struct dm_cache_policy *p,
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
+	if (smq_lookup_hit_lockless(mq, oblock, cblock))
+		return 0;
+
 	spin_lock_irqsave(&mq->lock, flags);
 	r = __lookup(mq, oblock, cblock, data_dir, fast_copy, work, &background_queued);
 	spin_unlock_irqrestore(&mq->lock, flags);
@@ -1450,6 +1566,7 @@ static int smq_get_background_work(struct dm_cache_policy *p, bool idle,
 	struct smq_policy *mq = to_smq_policy(p);
 
 	spin_lock_irqsave(&mq->lock, flags);
+	smq_fold_pcpu_stats(mq);
 	r = btracker_issue(mq->bg_work, result);
 	if (r == -ENODATA) {
 		if (!clean_target_met(mq, idle)) {
@@ -1630,6 +1747,7 @@ static void smq_tick(struct dm_cache_policy *p, bool can_block)
 	unsigned long flags;
 
 	spin_lock_irqsave(&mq->lock, flags);
+	smq_fold_pcpu_stats(mq);
 	mq->tick++;
 	update_sentinels(mq);
 	end_hotspot_period(mq);
@@ -1816,11 +1934,17 @@ __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_
 	if (!mq->bg_work)
 		goto bad_btracker;
 
+	mq->pcpu_stats = alloc_percpu(struct smq_pcpu_stats);
+	if (!mq->pcpu_stats)
+		goto bad_pcpu_stats;
+
 	mq->migrations_allowed = migrations_allowed;
 	mq->cleaner = cleaner;
 
 	return &mq->policy;
 
+bad_pcpu_stats:
+	btracker_destroy(mq->bg_work);
 bad_btracker:
 	h_exit(&mq->hotspot_table);
 bad_alloc_hotspot_table:
@@ -87,6 +87,7 @@ struct dm_crypt_io {
 	struct bvec_iter saved_bi_iter;
 
 	struct rb_node rb_node;
+	struct list_head write_list;
 } CRYPTO_MINALIGN_ATTR;
 
 struct dm_crypt_request {
@@ -145,6 +146,20 @@ enum cipher_flags {
 	CRYPT_MODE_INTEGRITY_AEAD,	/* Use authenticated mode for cipher */
 	CRYPT_IV_LARGE_SECTORS,		/* Calculate IV from sector_size, not 512B sectors */
 	CRYPT_ENCRYPT_PREPROCESS,	/* Must preprocess data for encryption (elephant) */
+	CRYPT_CONVERT_BATCH,		/* Synchronous cipher, convert a bio in one pass */
+};
+
+/*
+ * Encrypted writes are sorted and submitted by one thread per NUMA node, so
+ * that the submission cost scales with the nodes doing the encryption.
+ */
+struct crypt_write_shard {
+	struct crypt_config *cc;
+	spinlock_t lock;
+	struct task_struct *thread;
+	struct rb_root tree;
+	struct list_head fifo;
+	unsigned int nr_queued;
 };
 
 /*
@@ -159,9 +174,9 @@ struct crypt_config {
 	struct workqueue_struct *io_queue;
 	struct workqueue_struct *crypt_queue;
 
-	spinlock_t write_thread_lock;
-	struct task_struct *write_thread;
-	struct rb_root write_tree;
+	struct crypt_write_shard *write_shards;
+	int write_fallback_node;
+	unsigned int write_reorder_depth;
 
 	char *cipher_string;
 	char *cipher_auth;
@@ -1558,6 +1573,44 @@ static void crypt_free_req(struct crypt_config *cc, void *req, struct bio *base_
 		crypt_free_req_skcipher(cc, req, base_bio);
 }
 
+/*
+ * Batched conversion for synchronous skciphers without integrity or IV
+ * post-processing: every sector of the bio goes through one request that
+ * is set up once, and no per-sector pending accounting is needed since
+ * the cipher never completes asynchronously.
+ */
+static blk_status_t crypt_convert_batch_skcipher(struct crypt_config *cc,
+						 struct convert_context *ctx,
+						 bool atomic)
+{
+	unsigned int sector_step = cc->sector_size >> SECTOR_SHIFT;
+	struct skcipher_request *req;
+	int r;
+
+	r = crypt_alloc_req_skcipher(cc, ctx);
+	if (r) {
+		complete(&ctx->restart);
+		return BLK_STS_DEV_RESOURCE;
+	}
+	req = ctx->r.req;
+
+	while (ctx->iter_in.bi_size && ctx->iter_out.bi_size) {
+		if (cc->tfms_count > 1)
+			skcipher_request_set_tfm(req,
+				cc->cipher_tfm.tfms[ctx->cc_sector & (cc->tfms_count - 1)]);
+
+		r = crypt_convert_block_skcipher(cc, ctx, req, 0);
+		if (unlikely(r))
+			return BLK_STS_IOERR;
+
+		ctx->cc_sector += sector_step;
+		if (!atomic)
+			cond_resched();
+	}
+
+	return 0;
+}
+
 /*
  * Encrypt / decrypt data from one bio to another one (can be the same one)
  */
@@ -1576,6 +1629,9 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 	if (reset_pending)
 		atomic_set(&ctx->cc_pending, 1);
 
+	if (test_bit(CRYPT_CONVERT_BATCH, &cc->cipher_flags))
+		return crypt_convert_batch_skcipher(cc, ctx, atomic);
+
 	while (ctx->iter_in.bi_size && ctx->iter_out.bi_size) {
 
 		r = crypt_alloc_req(cc, ctx);
@@ -1944,24 +2000,70 @@ static void kcryptd_io_write(struct dm_crypt_io *io)
 
 #define crypt_io_from_node(node) rb_entry((node), struct dm_crypt_io, rb_node)
 
+static void crypt_write_tree_insert(struct rb_root *root, struct dm_crypt_io *io)
+{
+	struct rb_node **rbp = &root->rb_node, *parent = NULL;
+	sector_t sector = io->sector;
+
+	while (*rbp) {
+		parent = *rbp;
+		if (sector < crypt_io_from_node(parent)->sector)
+			rbp = &(*rbp)->rb_left;
+		else
+			rbp = &(*rbp)->rb_right;
+	}
+	rb_link_node(&io->rb_node, parent, rbp);
+	rb_insert_color(&io->rb_node, root);
+}
+
+/*
+ * Detach the next batch of writes from the shard. Without a reorder depth
+ * everything queued so far is sorted as one batch; otherwise only the
+ * write_reorder_depth oldest writes are, which bounds how long any write can
+ * be overtaken by later ones.
+ */
+static void crypt_write_shard_pop(struct crypt_write_shard *shard,
+				  struct rb_root *write_tree)
+{
+	unsigned int depth = shard->cc->write_reorder_depth;
+	struct dm_crypt_io *io;
+
+	if (!depth || shard->nr_queued <= depth) {
+		*write_tree = shard->tree;
+		shard->tree = RB_ROOT;
+		INIT_LIST_HEAD(&shard->fifo);
+		shard->nr_queued = 0;
+		return;
+	}
+
+	*write_tree = RB_ROOT;
+	while (depth--) {
+		io = list_first_entry(&shard->fifo, struct dm_crypt_io, write_list);
+		list_del(&io->write_list);
+		rb_erase(&io->rb_node, &shard->tree);
+		crypt_write_tree_insert(write_tree, io);
+		shard->nr_queued--;
+	}
+}
+
 static int dmcrypt_write(void *data)
 {
-	struct crypt_config *cc = data;
+	struct crypt_write_shard *shard = data;
 	struct dm_crypt_io *io;
 
 	while (1) {
 		struct rb_root write_tree;
 		struct blk_plug plug;
 
-		spin_lock_irq(&cc->write_thread_lock);
+		spin_lock_irq(&shard->lock);
 continue_locked:
 
-		if (!RB_EMPTY_ROOT(&cc->write_tree))
+		if (!RB_EMPTY_ROOT(&shard->tree))
 			goto pop_from_list;
 
 		set_current_state(TASK_INTERRUPTIBLE);
 
-		spin_unlock_irq(&cc->write_thread_lock);
+		spin_unlock_irq(&shard->lock);
 
 		if (unlikely(kthread_should_stop())) {
 			set_current_state(TASK_RUNNING);
@@ -1971,13 +2073,12 @@ static int dmcrypt_write(void *data)
 		schedule();
 
 		set_current_state(TASK_RUNNING);
-		spin_lock_irq(&cc->write_thread_lock);
+		spin_lock_irq(&shard->lock);
 		goto continue_locked;
 
 pop_from_list:
-		write_tree = cc->write_tree;
-		cc->write_tree = RB_ROOT;
-		spin_unlock_irq(&cc->write_thread_lock);
+		crypt_write_shard_pop(shard, &write_tree);
+		spin_unlock_irq(&shard->lock);
 
 		BUG_ON(rb_parent(write_tree.rb_node));
 
@@ -2001,9 +2102,8 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 {
 	struct bio *clone = io->ctx.bio_out;
 	struct crypt_config *cc = io->cc;
+	struct crypt_write_shard *shard;
 	unsigned long flags;
-	sector_t sector;
-	struct rb_node **rbp, *parent;
 
 	if (unlikely(io->error)) {
 		crypt_free_buffer_pages(cc, clone);
@@ -2023,22 +2123,17 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 		return;
 	}
 
-	spin_lock_irqsave(&cc->write_thread_lock, flags);
-	if (RB_EMPTY_ROOT(&cc->write_tree))
-		wake_up_process(cc->write_thread);
-	rbp = &cc->write_tree.rb_node;
-	parent = NULL;
-	sector = io->sector;
-	while (*rbp) {
-		parent = *rbp;
-		if (sector < crypt_io_from_node(parent)->sector)
-			rbp = &(*rbp)->rb_left;
-		else
-			rbp = &(*rbp)->rb_right;
-	}
-	rb_link_node(&io->rb_node, parent, rbp);
-	rb_insert_color(&io->rb_node, &cc->write_tree);
-	spin_unlock_irqrestore(&cc->write_thread_lock, flags);
+	shard = &cc->write_shards[numa_node_id()];
+	if (unlikely(!shard->thread))
+		shard = &cc->write_shards[cc->write_fallback_node];
+
+	spin_lock_irqsave(&shard->lock, flags);
+	if (RB_EMPTY_ROOT(&shard->tree))
+		wake_up_process(shard->thread);
+	crypt_write_tree_insert(&shard->tree, io);
+	list_add_tail(&io->write_list, &shard->fifo);
+	shard->nr_queued++;
+	spin_unlock_irqrestore(&shard->lock, flags);
 }
 
 static bool kcryptd_crypt_write_inline(struct crypt_config *cc,
@@ -2765,8 +2860,14 @@ static void crypt_dtr(struct dm_target *ti)
 	if (!cc)
 		return;
 
-	if (cc->write_thread)
-		kthread_stop(cc->write_thread);
+	if (cc->write_shards) {
+		int node;
+
+		for_each_node(node)
+			if (cc->write_shards[node].thread)
+				kthread_stop(cc->write_shards[node].thread);
+		kfree(cc->write_shards);
+	}
 
 	if (cc->io_queue)
 		destroy_workqueue(cc->io_queue);
@@ -3137,7 +3238,7 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 	struct crypt_config *cc = ti->private;
 	struct dm_arg_set as;
 	static const struct dm_arg _args[] = {
-		{0, 8, "Invalid number of feature args"},
+		{0, 9, "Invalid number of feature args"},
 	};
 	unsigned int opt_params, val;
 	const char *opt_string, *sval;
@@ -3202,6 +3303,8 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 			cc->sector_shift = __ffs(cc->sector_size) - SECTOR_SHIFT;
 		} else if (!strcasecmp(opt_string, "iv_large_sectors"))
 			set_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags);
+		else if (sscanf(opt_string, "write_reorder_depth:%u%c", &val, &dummy) == 1)
+			cc->write_reorder_depth = val;
 		else {
 			ti->error = "Invalid feature arguments";
 			return -EINVAL;
@@ -3229,6 +3332,38 @@ static int crypt_report_zones(struct dm_target *ti,
  * Construct an encryption mapping:
  * <cipher> [<key>|:<key_size>:<user|logon>:<key_description>] <iv_offset> <dev_path> <start>
  */
+static int crypt_ctr_write_shards(struct crypt_config *cc, const char *devname)
+{
+	struct task_struct *thread;
+	int node;
+
+	cc->write_shards = kcalloc(nr_node_ids, sizeof(*cc->write_shards), GFP_KERNEL);
+	if (!cc->write_shards)
+		return -ENOMEM;
+
+	cc->write_fallback_node = first_online_node;
+	for_each_online_node(node) {
+		struct crypt_write_shard *shard = &cc->write_shards[node];
+		const struct cpumask *mask = cpumask_of_node(node);
+
+		shard->cc = cc;
+		spin_lock_init(&shard->lock);
+		shard->tree = RB_ROOT;
+		INIT_LIST_HEAD(&shard->fifo);
+
+		thread = kthread_create_on_node(dmcrypt_write, shard, node,
+						"dmcrypt_write/%s/%d", devname, node);
+		if (IS_ERR(thread))
+			return PTR_ERR(thread);
+		if (!cpumask_empty(mask))
+			set_cpus_allowed_ptr(thread, mask);
+		shard->thread = thread;
+		wake_up_process(thread);
+	}
+
+	return 0;
+}
+
 static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 {
 	struct crypt_config *cc;
@@ -3401,6 +3536,11 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		cc->tag_pool_max_sectors <<= cc->sector_shift;
 	}
 
+	if (!crypt_integrity_aead(cc) && !cc->on_disk_tag_size &&
+	    !(cc->iv_gen_ops && cc->iv_gen_ops->post) &&
+	    !(crypto_skcipher_alg(any_tfm(cc))->base.cra_flags & CRYPTO_ALG_ASYNC))
+		set_bit(CRYPT_CONVERT_BATCH, &cc->cipher_flags);
+
 	ret = -ENOMEM;
 	cc->io_queue = alloc_workqueue("kcryptd_io/%s", WQ_MEM_RECLAIM, 1, devname);
 	if (!cc->io_queue) {
@@ -3420,13 +3560,8 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		goto bad;
 	}
 
-	spin_lock_init(&cc->write_thread_lock);
-	cc->write_tree = RB_ROOT;
-
-	cc->write_thread = kthread_run(dmcrypt_write, cc, "dmcrypt_write/%s", devname);
-	if (IS_ERR(cc->write_thread)) {
-		ret = PTR_ERR(cc->write_thread);
-		cc->write_thread = NULL;
+	ret = crypt_ctr_write_shards(cc, devname);
+	if (ret) {
 		ti->error = "Couldn't spawn write thread";
 		goto bad;
 	}
@@ -3555,6 +3690,7 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		num_feature_args += test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
 		num_feature_args += cc->sector_size != (1 << SECTOR_SHIFT);
 		num_feature_args += test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags);
+		num_feature_args += !!cc->write_reorder_depth;
 		if (cc->on_disk_tag_size)
 			num_feature_args++;
 		if (num_feature_args) {
@@ -3575,6 +3711,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 				DMEMIT(" sector_size:%d", cc->sector_size);
 			if (test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags))
 				DMEMIT(" iv_large_sectors");
+			if (cc->write_reorder_depth)
+				DMEMIT(" write_reorder_depth:%u", cc->write_reorder_depth);
 		}
 		break;
 
@@ -3596,6 +3734,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 			       cc->on_disk_tag_size, cc->cipher_auth);
 		if (cc->sector_size != (1 << SECTOR_SHIFT))
 			DMEMIT(",sector_size=%d", cc->sector_size);
+		if (cc->write_reorder_depth)
+			DMEMIT(",write_reorder_depth=%u", cc->write_reorder_depth);
 		if (cc->cipher_string)
 			DMEMIT(",cipher_string=%s", cc->cipher_string);
 
@@ -3709,7 +3849,7 @@ static void crypt_io_hints(struct dm_target *ti, struct queue_limits *limits)
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 24, 0},
+	.version = {1, 25, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
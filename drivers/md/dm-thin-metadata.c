@@ -13,6 +13,7 @@
 
 #include <linux/list.h>
 #include <linux/device-mapper.h>
+#include <linux/seqlock.h>
 #include <linux/workqueue.h>
 
 /*
@@ -228,6 +229,25 @@ struct dm_pool_metadata {
 	__u8 metadata_space_map_root[SPACE_MAP_ROOT_SIZE];
 };
 
+/*
+ * Each open thin device keeps a small direct-mapped cache of the
+ * mappings it has recently looked up, so that repeat lookups of
+ * provisioned blocks neither walk the btree nor take the root_lock.
+ *
+ * Entries are only filled while the root_lock is held for read and are
+ * invalidated while it is held for write, so a fill can never race with
+ * the change that makes it stale.  Readers go lockless under cache_seq;
+ * cache_lock only serialises concurrent fillers.
+ */
+#define THIN_MAPPING_CACHE_SIZE 64
+
+struct thin_mapping_cache_entry {
+	dm_block_t virt_block;
+	dm_block_t data_block;
+	uint32_t time;
+	bool valid;
+};
+
 struct dm_thin_device {
 	struct list_head list;
 	struct dm_pool_metadata *pmd;
@@ -240,6 +260,10 @@ struct dm_thin_device {
 	uint64_t transaction_id;
 	uint32_t creation_time;
 	uint32_t snapshotted_time;
+
+	spinlock_t cache_lock;
+	seqcount_spinlock_t cache_seq;
+	struct thin_mapping_cache_entry cache[THIN_MAPPING_CACHE_SIZE];
 };
 
 /*
@@ -1090,6 +1114,9 @@ static int __open_device(struct dm_pool_metadata *pmd,
 	(*td)->transaction_id = le64_to_cpu(details_le.transaction_id);
 	(*td)->creation_time = le32_to_cpu(details_le.creation_time);
 	(*td)->snapshotted_time = le32_to_cpu(details_le.snapshotted_time);
+	spin_lock_init(&(*td)->cache_lock);
+	seqcount_spinlock_init(&(*td)->cache_seq, &(*td)->cache_lock);
+	memset((*td)->cache, 0, sizeof((*td)->cache));
 
 	list_add(&(*td)->list, &pmd->thin_devices);
 
@@ -1543,6 +1570,84 @@ static void unpack_lookup_result(struct dm_thin_device *td, __le64 value,
 	result->shared = __snapshotted_since(td, exception_time);
 }
 
+static struct thin_mapping_cache_entry *
+__cache_slot(struct dm_thin_device *td, dm_block_t block)
+{
+	return &td->cache[block & (THIN_MAPPING_CACHE_SIZE - 1)];
+}
+
+static bool cache_lookup(struct dm_thin_device *td, dm_block_t block,
+			 struct dm_thin_lookup_result *result)
+{
+	struct thin_mapping_cache_entry *e = __cache_slot(td, block);
+	unsigned int seq;
+	bool hit;
+	dm_block_t data_block;
+	uint32_t time;
+
+	do {
+		seq = read_seqcount_begin(&td->cache_seq);
+		hit = e->valid && e->virt_block == block;
+		data_block = e->data_block;
+		time = e->time;
+	} while (read_seqcount_retry(&td->cache_seq, seq));
+
+	if (!hit)
+		return false;
+
+	result->block = data_block;
+	result->shared = READ_ONCE(td->snapshotted_time) > time;
+	return true;
+}
+
+/*
+ * Must be called with the root_lock held for read.
+ */
+static void cache_fill(struct dm_thin_device *td, dm_block_t block, __le64 value)
+{
+	struct thin_mapping_cache_entry *e = __cache_slot(td, block);
+	dm_block_t data_block;
+	uint32_t time;
+
+	unpack_block_time(le64_to_cpu(value), &data_block, &time);
+
+	spin_lock(&td->cache_lock);
+	write_seqcount_begin(&td->cache_seq);
+	e->virt_block = block;
+	e->data_block = data_block;
+	e->time = time;
+	e->valid = true;
+	write_seqcount_end(&td->cache_seq);
+	spin_unlock(&td->cache_lock);
+}
+
+/*
+ * The following must be called with the root_lock held for write.
+ */
+static void __cache_invalidate_block(struct dm_thin_device *td, dm_block_t block)
+{
+	struct thin_mapping_cache_entry *e = __cache_slot(td, block);
+
+	spin_lock(&td->cache_lock);
+	write_seqcount_begin(&td->cache_seq);
+	if (e->virt_block == block)
+		e->valid = false;
+	write_seqcount_end(&td->cache_seq);
+	spin_unlock(&td->cache_lock);
+}
+
+static void __cache_invalidate(struct dm_thin_device *td)
+{
+	unsigned int i;
+
+	spin_lock(&td->cache_lock);
+	write_seqcount_begin(&td->cache_seq);
+	for (i = 0; i < THIN_MAPPING_CACHE_SIZE; i++)
+		td->cache[i].valid = false;
+	write_seqcount_end(&td->cache_seq);
+	spin_unlock(&td->cache_lock);
+}
+
 static int __find_block(struct dm_thin_device *td, dm_block_t block,
 			int can_issue_io, struct dm_thin_lookup_result *result)
 {
@@ -1558,8 +1663,10 @@ static int __find_block(struct dm_thin_device *td, dm_block_t block,
 		info = &pmd->nb_info;
 
 	r = dm_btree_lookup(info, pmd->root, keys, &value);
-	if (!r)
+	if (!r) {
 		unpack_lookup_result(td, value, result);
+		cache_fill(td, block, value);
+	}
 
 	return r;
 }
@@ -1570,6 +1677,14 @@ int dm_thin_find_block(struct dm_thin_device *td, dm_block_t block,
 	int r;
 	struct dm_pool_metadata *pmd = td->pmd;
 
+	/*
+	 * A cached mapping is only ever dropped with the root_lock held
+	 * for write, so a hit here is as good as a btree walk that
+	 * completed just before the writer got in.
+	 */
+	if (likely(!pmd->fail_io) && cache_lookup(td, block, result))
+		return 0;
+
 	down_read(&pmd->root_lock);
 	if (pmd->fail_io) {
 		up_read(&pmd->root_lock);
@@ -1673,6 +1788,7 @@ static int __insert(struct dm_thin_device *td, dm_block_t block,
 	value = cpu_to_le64(pack_block_time(data_block, pmd->time));
 	__dm_bless_for_disk(&value);
 
+	__cache_invalidate_block(td, block);
 	r = dm_btree_insert_notify(&pmd->info, pmd->root, keys, &value,
 				   &pmd->root, &inserted);
 	if (r)
@@ -1707,6 +1823,8 @@ static int __remove_range(struct dm_thin_device *td, dm_block_t begin, dm_block_
 	__le64 value;
 	dm_block_t mapping_root;
 
+	__cache_invalidate(td);
+
 	/*
 	 * Find the mapping tree
 	 */
@@ -1890,8 +2008,10 @@ static void __set_abort_with_changes_flags(struct dm_pool_metadata *pmd)
 {
 	struct dm_thin_device *td;
 
-	list_for_each_entry(td, &pmd->thin_devices, list)
+	list_for_each_entry(td, &pmd->thin_devices, list) {
 		td->aborted_with_changes = td->changed;
+		__cache_invalidate(td);
+	}
 }
 
 int dm_pool_abort_metadata(struct dm_pool_metadata *pmd)
@@ -38,8 +38,9 @@
 #define DM_VERITY_OPT_IGN_ZEROES	"ignore_zero_blocks"
 #define DM_VERITY_OPT_AT_MOST_ONCE	"check_at_most_once"
 #define DM_VERITY_OPT_TASKLET_VERIFY	"try_verify_in_tasklet"
+#define DM_VERITY_OPT_ADAPTIVE_PREFETCH	"adaptive_prefetch"
 
-#define DM_VERITY_OPTS_MAX		(4 + DM_VERITY_OPTS_FEC + \
+#define DM_VERITY_OPTS_MAX		(5 + DM_VERITY_OPTS_FEC + \
 					 DM_VERITY_ROOT_HASH_VERIFICATION_OPTS)
 
 static unsigned int dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
@@ -53,6 +54,7 @@ struct dm_verity_prefetch_work {
 	struct dm_verity *v;
 	sector_t block;
 	unsigned int n_blocks;
+	unsigned int cluster;
 };
 
 /*
@@ -179,12 +181,42 @@ static int verity_hash_final(struct dm_verity *v, struct ahash_request *req,
 	return r;
 }
 
+/*
+ * Synchronous hashing through shash, avoiding the scatterlist and completion
+ * setup that the ahash interface costs for every block.
+ */
+static int verity_shash(struct dm_verity *v, const u8 *data, size_t len,
+			u8 *digest)
+{
+	SHASH_DESC_ON_STACK(desc, v->shash_tfm);
+	int r;
+
+	desc->tfm = v->shash_tfm;
+
+	if (v->initial_hashstate) {
+		r = crypto_shash_import(desc, v->initial_hashstate) ?:
+		    crypto_shash_finup(desc, data, len, digest);
+	} else if (unlikely(v->salt_size && !v->version)) {
+		r = crypto_shash_init(desc) ?:
+		    crypto_shash_update(desc, data, len) ?:
+		    crypto_shash_finup(desc, v->salt, v->salt_size, digest);
+	} else {
+		r = crypto_shash_digest(desc, data, len, digest);
+	}
+
+	shash_desc_zero(desc);
+	return r;
+}
+
 int verity_hash(struct dm_verity *v, struct ahash_request *req,
 		const u8 *data, size_t len, u8 *digest, bool may_sleep)
 {
 	int r;
 	struct crypto_wait wait;
 
+	if (v->shash_tfm)
+		return verity_shash(v, data, len, digest);
+
 	r = verity_hash_init(v, req, &wait, may_sleep);
 	if (unlikely(r < 0))
 		goto out;
@@ -307,6 +339,14 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 			 */
 			return -EAGAIN;
 		}
+	} else if (v->adaptive_prefetch && !level) {
+		data = dm_bufio_get(v->bufio, hash_block, &buf);
+		if (data) {
+			atomic64_inc(&v->prefetch_hits);
+		} else {
+			atomic64_inc(&v->prefetch_misses);
+			data = dm_bufio_read(v->bufio, hash_block, &buf);
+		}
 	} else
 		data = dm_bufio_read(v->bufio, hash_block, &buf);
 
@@ -444,6 +484,51 @@ static int verity_for_io_block(struct dm_verity *v, struct dm_verity_io *io,
 	return 0;
 }
 
+/*
+ * Calculates the digest for the given bio through shash, see verity_shash()
+ */
+static int verity_shash_io_block(struct dm_verity *v, struct dm_verity_io *io,
+				 struct bvec_iter *iter, u8 *digest)
+{
+	SHASH_DESC_ON_STACK(desc, v->shash_tfm);
+	unsigned int todo = 1 << v->data_dev_block_bits;
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	int r;
+
+	desc->tfm = v->shash_tfm;
+
+	if (v->initial_hashstate)
+		r = crypto_shash_import(desc, v->initial_hashstate);
+	else
+		r = crypto_shash_init(desc);
+
+	while (likely(!r) && todo) {
+		struct bio_vec bv = bio_iter_iovec(bio, *iter);
+		unsigned int len = min(bv.bv_len, todo);
+		u8 *page;
+
+		page = bvec_kmap_local(&bv);
+		r = crypto_shash_update(desc, page, len);
+		kunmap_local(page);
+
+		bio_advance_iter(bio, iter, len);
+		todo -= len;
+	}
+
+	if (likely(!r)) {
+		if (unlikely(v->salt_size && !v->version))
+			r = crypto_shash_finup(desc, v->salt, v->salt_size,
+					       digest);
+		else
+			r = crypto_shash_final(desc, digest);
+	}
+
+	shash_desc_zero(desc);
+	if (unlikely(r < 0))
+		DMERR("%s crypto op failed: %d", __func__, r);
+	return r;
+}
+
 /*
  * Calls function process for 1 << v->data_dev_block_bits bytes in the bio_vec
  * starting from iter.
@@ -558,6 +643,40 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
 }
 
+/*
+ * Hash the data block at iter into the real digest and the block after it
+ * into next_digest in a single sha256_finup_2x() pass. Only done if each
+ * block sits within one page; returns false, with iter untouched, otherwise.
+ */
+static bool verity_hash_2x(struct dm_verity *v, struct dm_verity_io *io,
+			   struct bvec_iter *iter, u8 *next_digest)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	unsigned int block_size = 1 << v->data_dev_block_bits;
+	struct bvec_iter next = *iter;
+	struct bio_vec bv1, bv2;
+	u8 *data1, *data2;
+
+	bv1 = bio_iter_iovec(bio, *iter);
+	if (bv1.bv_len < block_size)
+		return false;
+
+	bio_advance_iter(bio, &next, block_size);
+	bv2 = bio_iter_iovec(bio, next);
+	if (bv2.bv_len < block_size)
+		return false;
+
+	data1 = bvec_kmap_local(&bv1);
+	data2 = bvec_kmap_local(&bv2);
+	sha256_finup_2x(v->sha256_2x_state, data1, data2, block_size,
+			verity_io_real_digest(v, io), next_digest);
+	kunmap_local(data2);
+	kunmap_local(data1);
+
+	*iter = next;
+	return true;
+}
+
 /*
  * Verify one "dm_verity_io" structure.
  */
@@ -570,6 +689,8 @@ static int verity_verify_io(struct dm_verity_io *io)
 	struct bvec_iter *iter;
 	struct crypto_wait wait;
 	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	u8 next_digest[SHA256_DIGEST_SIZE];
+	bool have_next_digest = false;
 	unsigned int b;
 
 	if (static_branch_unlikely(&use_tasklet_enabled) && io->in_tasklet) {
@@ -586,6 +707,9 @@ static int verity_verify_io(struct dm_verity_io *io)
 		int r;
 		sector_t cur_block = io->block + b;
 		struct ahash_request *req = verity_io_hash_req(v, io);
+		bool prehashed = have_next_digest;
+
+		have_next_digest = false;
 
 		if (v->validated_blocks && bio->bi_status == BLK_STS_OK &&
 		    likely(test_bit(cur_block, v->validated_blocks))) {
@@ -612,19 +736,37 @@ static int verity_verify_io(struct dm_verity_io *io)
 			continue;
 		}
 
-		r = verity_hash_init(v, req, &wait, !io->in_tasklet);
-		if (unlikely(r < 0))
-			return r;
-
 		start = *iter;
-		r = verity_for_io_block(v, io, iter, &wait);
-		if (unlikely(r < 0))
-			return r;
+		if (prehashed) {
+			/* Hashed together with the previous block. */
+			memcpy(verity_io_real_digest(v, io), next_digest,
+			       v->digest_size);
+			verity_bv_skip_block(v, io, iter);
+		} else if (v->sha256_2x_state && b + 1 < io->n_blocks &&
+			   !(v->validated_blocks &&
+			     test_bit(cur_block + 1, v->validated_blocks)) &&
+			   verity_hash_2x(v, io, iter, next_digest)) {
+			have_next_digest = true;
+		} else if (v->shash_tfm) {
+			r = verity_shash_io_block(v, io, iter,
+						  verity_io_real_digest(v, io));
+			if (unlikely(r < 0))
+				return r;
+		} else {
+			r = verity_hash_init(v, req, &wait, !io->in_tasklet);
+			if (unlikely(r < 0))
+				return r;
 
-		r = verity_hash_final(v, req, verity_io_real_digest(v, io),
-					&wait);
-		if (unlikely(r < 0))
-			return r;
+			r = verity_for_io_block(v, io, iter, &wait);
+			if (unlikely(r < 0))
+				return r;
+
+			r = verity_hash_final(v, req,
+					      verity_io_real_digest(v, io),
+					      &wait);
+			if (unlikely(r < 0))
+				return r;
+		}
 
 		if (likely(memcmp(verity_io_real_digest(v, io),
 				  verity_io_want_digest(v, io), v->digest_size) == 0)) {
@@ -737,9 +879,8 @@ static void verity_prefetch_io(struct work_struct *work)
 		verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i, &hash_block_end, NULL);
 
 		if (!i) {
-			unsigned int cluster = READ_ONCE(dm_verity_prefetch_cluster);
+			unsigned int cluster = pw->cluster;
 
-			cluster >>= v->data_dev_block_bits;
 			if (unlikely(!cluster))
 				goto no_prefetch_cluster;
 
@@ -759,12 +900,53 @@ static void verity_prefetch_io(struct work_struct *work)
 	kfree(pw);
 }
 
+/*
+ * Size the level 0 prefetch cluster like file readahead: a reader continuing
+ * where one of the tracked streams stopped gets its window doubled up to the
+ * prefetch_cluster limit, anything else is treated as random and only the
+ * hash blocks it needs are read.
+ */
+static unsigned int verity_stream_cluster(struct dm_verity *v, sector_t block,
+					  unsigned int n_blocks,
+					  unsigned int max_cluster)
+{
+	struct dm_verity_stream *s;
+	unsigned int cluster, i;
+
+	spin_lock(&v->stream_lock);
+	for (i = 0; i < DM_VERITY_PREFETCH_STREAMS; i++) {
+		s = &v->streams[i];
+		if (s->next_block == block && block)
+			goto found;
+	}
+
+	s = &v->streams[v->stream_victim];
+	v->stream_victim = (v->stream_victim + 1) % DM_VERITY_PREFETCH_STREAMS;
+	s->cluster = 0;
+	s->next_block = block + n_blocks;
+	spin_unlock(&v->stream_lock);
+	return 0;
+
+found:
+	s->cluster = s->cluster ? min(s->cluster << 1, max_cluster) : min(2U, max_cluster);
+	s->next_block = block + n_blocks;
+	cluster = s->cluster;
+	spin_unlock(&v->stream_lock);
+
+	return cluster;
+}
+
 static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 {
 	sector_t block = io->block;
 	unsigned int n_blocks = io->n_blocks;
+	unsigned int cluster = READ_ONCE(dm_verity_prefetch_cluster);
 	struct dm_verity_prefetch_work *pw;
 
+	cluster >>= v->data_dev_block_bits;
+	if (v->adaptive_prefetch && cluster)
+		cluster = verity_stream_cluster(v, block, n_blocks, cluster);
+
 	if (v->validated_blocks) {
 		while (n_blocks && test_bit(block, v->validated_blocks)) {
 			block++;
@@ -787,6 +969,7 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 	pw->v = v;
 	pw->block = block;
 	pw->n_blocks = n_blocks;
+	pw->cluster = cluster;
 	queue_work(v->verify_wq, &pw->work);
 }
 
@@ -850,6 +1033,10 @@ static void verity_status(struct dm_target *ti, status_type_t type,
 	switch (type) {
 	case STATUSTYPE_INFO:
 		DMEMIT("%c", v->hash_failed ? 'C' : 'V');
+		if (v->adaptive_prefetch)
+			DMEMIT(" %llu %llu",
+			       (unsigned long long)atomic64_read(&v->prefetch_hits),
+			       (unsigned long long)atomic64_read(&v->prefetch_misses));
 		break;
 	case STATUSTYPE_TABLE:
 		DMEMIT("%u %s %s %u %u %llu %llu %s ",
@@ -880,6 +1067,8 @@ static void verity_status(struct dm_target *ti, status_type_t type,
 			args++;
 		if (v->use_tasklet)
 			args++;
+		if (v->adaptive_prefetch)
+			args++;
 		if (v->signature_key_desc)
 			args += DM_VERITY_ROOT_HASH_VERIFICATION_OPTS;
 		if (!args)
@@ -907,6 +1096,8 @@ static void verity_status(struct dm_target *ti, status_type_t type,
 			DMEMIT(" " DM_VERITY_OPT_AT_MOST_ONCE);
 		if (v->use_tasklet)
 			DMEMIT(" " DM_VERITY_OPT_TASKLET_VERIFY);
+		if (v->adaptive_prefetch)
+			DMEMIT(" " DM_VERITY_OPT_ADAPTIVE_PREFETCH);
 		sz = verity_fec_status_table(v, sz, result, maxlen);
 		if (v->signature_key_desc)
 			DMEMIT(" " DM_VERITY_ROOT_HASH_VERIFICATION_OPT_SIG_KEY
@@ -934,6 +1125,7 @@ static void verity_status(struct dm_target *ti, status_type_t type,
 
 		DMEMIT(",ignore_zero_blocks=%c", v->zero_digest ? 'y' : 'n');
 		DMEMIT(",check_at_most_once=%c", v->validated_blocks ? 'y' : 'n');
+		DMEMIT(",adaptive_prefetch=%c", v->adaptive_prefetch ? 'y' : 'n');
 		if (v->signature_key_desc)
 			DMEMIT(",root_hash_sig_key_desc=%s", v->signature_key_desc);
 
@@ -1004,11 +1196,16 @@ static void verity_dtr(struct dm_target *ti)
 	if (v->bufio)
 		dm_bufio_client_destroy(v->bufio);
 
+	kfree(v->streams);
 	kvfree(v->validated_blocks);
 	kfree(v->salt);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
 
+	kfree(v->initial_hashstate);
+	kfree(v->sha256_2x_state);
+	if (v->shash_tfm)
+		crypto_free_shash(v->shash_tfm);
 	if (v->tfm)
 		crypto_free_ahash(v->tfm);
 
@@ -1053,6 +1250,85 @@ static int verity_alloc_most_once(struct dm_verity *v)
 	return 0;
 }
 
+/*
+ * If the selected ahash implementation is just a synchronous shash, hash
+ * through the shash interface directly and precompute the salted state.
+ */
+static int verity_setup_shash(struct dm_verity *v)
+{
+	struct crypto_shash *shash;
+	int r;
+
+	shash = crypto_alloc_shash(v->alg_name, 0, 0);
+	if (IS_ERR(shash))
+		return 0;
+
+	if (strcmp(crypto_shash_driver_name(shash),
+		   crypto_ahash_driver_name(v->tfm))) {
+		crypto_free_shash(shash);
+		return 0;
+	}
+	v->shash_tfm = shash;
+
+	/*
+	 * The generic sha256 can hash two data blocks at once through the
+	 * library; its salt handling is only easy for a salt prefix.
+	 */
+	if (!strcmp(crypto_shash_driver_name(shash), "sha256-generic") &&
+	    (!v->salt_size || v->version >= 1)) {
+		v->sha256_2x_state = kmalloc(sizeof(*v->sha256_2x_state),
+					     GFP_KERNEL);
+		if (!v->sha256_2x_state)
+			return -ENOMEM;
+
+		sha256_init(v->sha256_2x_state);
+		if (v->salt_size)
+			sha256_update(v->sha256_2x_state, v->salt,
+				      v->salt_size);
+	}
+
+	if (v->salt_size && v->version >= 1) {
+		SHASH_DESC_ON_STACK(desc, shash);
+
+		v->initial_hashstate = kmalloc(crypto_shash_statesize(shash),
+					       GFP_KERNEL);
+		if (!v->initial_hashstate)
+			return -ENOMEM;
+
+		desc->tfm = shash;
+		r = crypto_shash_init(desc) ?:
+		    crypto_shash_update(desc, v->salt, v->salt_size) ?:
+		    crypto_shash_export(desc, v->initial_hashstate);
+		shash_desc_zero(desc);
+		if (r)
+			return r;
+	}
+
+	return 0;
+}
+
+static int verity_alloc_streams(struct dm_verity *v)
+{
+	struct dm_target *ti = v->ti;
+
+	if (v->streams)
+		return 0;
+
+	v->streams = kcalloc(DM_VERITY_PREFETCH_STREAMS, sizeof(*v->streams),
+			     GFP_KERNEL);
+	if (!v->streams) {
+		ti->error = "Cannot allocate prefetch streams";
+		return -ENOMEM;
+	}
+
+	spin_lock_init(&v->stream_lock);
+	atomic64_set(&v->prefetch_hits, 0);
+	atomic64_set(&v->prefetch_misses, 0);
+	v->adaptive_prefetch = true;
+
+	return 0;
+}
+
 static int verity_alloc_zero_digest(struct dm_verity *v)
 {
 	int r = -ENOMEM;
@@ -1163,6 +1439,14 @@ static int verity_parse_opt_args(struct dm_arg_set *as, struct dm_verity *v,
 			static_branch_inc(&use_tasklet_enabled);
 			continue;
 
+		} else if (!strcasecmp(arg_name, DM_VERITY_OPT_ADAPTIVE_PREFETCH)) {
+			if (only_modifier_opts)
+				continue;
+			r = verity_alloc_streams(v);
+			if (r)
+				return r;
+			continue;
+
 		} else if (verity_is_fec_opt_arg(arg_name)) {
 			if (only_modifier_opts)
 				continue;
@@ -1386,6 +1670,12 @@ static int verity_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		}
 	}
 
+	r = verity_setup_shash(v);
+	if (r) {
+		ti->error = "Cannot set up synchronous hash";
+		goto bad;
+	}
+
 	argv += 10;
 	argc -= 10;
 
@@ -1560,7 +1850,7 @@ int dm_verity_get_root_digest(struct dm_target *ti, u8 **root_digest, unsigned i
 static struct target_type verity_target = {
 	.name		= "verity",
 	.features	= DM_TARGET_IMMUTABLE,
-	.version	= {1, 9, 0},
+	.version	= {1, 10, 0},
 	.module		= THIS_MODULE,
 	.ctr		= verity_ctr,
 	.dtr		= verity_dtr,
@@ -16,6 +16,7 @@
 #include <linux/device-mapper.h>
 #include <linux/interrupt.h>
 #include <crypto/hash.h>
+#include <crypto/sha2.h>
 
 #define DM_VERITY_MAX_LEVELS		63
 
@@ -33,6 +34,14 @@ enum verity_block_type {
 
 struct dm_verity_fec;
 
+#define DM_VERITY_PREFETCH_STREAMS	8
+
+/* A sequential reader detected by adaptive prefetch */
+struct dm_verity_stream {
+	sector_t next_block;	/* data block expected next */
+	unsigned int cluster;	/* hash blocks to read ahead, 0 if random */
+};
+
 struct dm_verity {
 	struct dm_dev *data_dev;
 	struct dm_dev *hash_dev;
@@ -40,6 +49,10 @@ struct dm_verity {
 	struct dm_bufio_client *bufio;
 	char *alg_name;
 	struct crypto_ahash *tfm;
+	struct crypto_shash *shash_tfm;	/* set if the hash is synchronous */
+	u8 *initial_hashstate;	/* shash state after hashing the salt */
+	/* set if data blocks can be hashed in pairs with sha256_finup_2x() */
+	struct sha256_state *sha256_2x_state;
 	u8 *root_digest;	/* digest of the root block */
 	u8 *salt;		/* salt: its size is salt_size */
 	u8 *zero_digest;	/* digest for a zero block */
@@ -55,6 +68,7 @@ struct dm_verity {
 	unsigned char version;
 	bool hash_failed:1;	/* set if hash of any block failed */
 	bool use_tasklet:1;	/* try to verify in tasklet before work-queue */
+	bool adaptive_prefetch:1; /* size prefetch by detected streams */
 	unsigned int digest_size;	/* digest size for the current hash algorithm */
 	unsigned int ahash_reqsize;/* the size of temporary space for crypto */
 	enum verity_mode mode;	/* mode for handling verification errors */
@@ -72,6 +86,13 @@ struct dm_verity {
 
 	struct dm_io_client *io;
 	mempool_t recheck_pool;
+
+	/* adaptive prefetch state, protected by stream_lock */
+	spinlock_t stream_lock;
+	struct dm_verity_stream *streams;
+	unsigned int stream_victim;
+	atomic64_t prefetch_hits;	/* level 0 hash block found cached */
+	atomic64_t prefetch_misses;	/* level 0 hash block read from disk */
 };
 
 struct dm_verity_io {
@@ -106,6 +106,8 @@ struct wc_entry {
 #endif
 #define WC_MODE_SORT_FREELIST(wc)		(!WC_MODE_PMEM(wc))
 
+#define WC_SEQ_STREAMS		4
+
 struct dm_writecache {
 	struct mutex lock;
 	struct list_head lru;
@@ -174,6 +176,7 @@ struct dm_writecache {
 	bool cleaner_set:1;
 	bool metadata_only:1;
 	bool pause_set:1;
+	bool sequential_threshold_set:1;
 
 	unsigned int high_wm_percent_value;
 	unsigned int low_wm_percent_value;
@@ -181,6 +184,14 @@ struct dm_writecache {
 	unsigned int max_age_value;
 	unsigned int pause_value;
 
+	/* write streams tracked for sequential bypass, protected by lock */
+	unsigned int sequential_threshold;
+	unsigned int seq_victim;
+	struct {
+		sector_t next_sector;
+		sector_t run_sectors;
+	} seq_streams[WC_SEQ_STREAMS];
+
 	unsigned int writeback_all;
 	struct workqueue_struct *writeback_wq;
 	struct work_struct writeback_work;
@@ -1433,9 +1444,39 @@ static void writecache_bio_copy_ssd(struct dm_writecache *wc, struct bio *bio,
 	}
 }
 
+/*
+ * Streaming writes gain nothing from the cache and push hot data out of it,
+ * so once a stream has written sequential_threshold blocks in a row, send the
+ * blocks that are not cached already straight to the origin.
+ */
+static bool writecache_sequential_bypass(struct dm_writecache *wc, struct bio *bio)
+{
+	sector_t sector = bio->bi_iter.bi_sector;
+	unsigned int i;
+
+	for (i = 0; i < WC_SEQ_STREAMS; i++) {
+		if (wc->seq_streams[i].next_sector == sector && sector)
+			goto found;
+	}
+
+	i = wc->seq_victim;
+	wc->seq_victim = (wc->seq_victim + 1) % WC_SEQ_STREAMS;
+	wc->seq_streams[i].run_sectors = 0;
+found:
+	wc->seq_streams[i].run_sectors += bio_sectors(bio);
+	wc->seq_streams[i].next_sector = bio_end_sector(bio);
+
+	return (wc->seq_streams[i].run_sectors >> (wc->block_size_bits - SECTOR_SHIFT)) >=
+		wc->sequential_threshold;
+}
+
 static enum wc_map_op writecache_map_write(struct dm_writecache *wc, struct bio *bio)
 {
 	struct wc_entry *e;
+	bool bypass = false;
+
+	if (wc->sequential_threshold)
+		bypass = writecache_sequential_bypass(wc, bio);
 
 	do {
 		bool found_entry = false;
@@ -1460,7 +1501,7 @@ static enum wc_map_op writecache_map_write(struct dm_writecache *wc, struct bio
 			}
 			found_entry = true;
 		} else {
-			if (unlikely(wc->cleaner) ||
+			if (unlikely(wc->cleaner) || bypass ||
 			    (wc->metadata_only && !(bio->bi_opf & REQ_META)))
 				goto direct_write;
 		}
@@ -2241,7 +2282,7 @@ static int writecache_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	struct wc_memory_superblock s;
 
 	static struct dm_arg _args[] = {
-		{0, 18, "Invalid number of feature args"},
+		{0, 20, "Invalid number of feature args"},
 	};
 
 	as.argc = argc;
@@ -2490,6 +2531,11 @@ static int writecache_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 			wc->pause = msecs_to_jiffies(pause_msecs);
 			wc->pause_set = true;
 			wc->pause_value = pause_msecs;
+		} else if (!strcasecmp(string, "sequential_threshold") && opt_params >= 1) {
+			string = dm_shift_arg(&as), opt_params--;
+			if (sscanf(string, "%u%c", &wc->sequential_threshold, &dummy) != 1)
+				goto invalid_optional;
+			wc->sequential_threshold_set = true;
 		} else {
 invalid_optional:
 			r = -EINVAL;
@@ -2727,6 +2773,8 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 			extra_args++;
 		if (wc->pause_set)
 			extra_args += 2;
+		if (wc->sequential_threshold_set)
+			extra_args += 2;
 
 		DMEMIT("%u", extra_args);
 		if (wc->start_sector_set)
@@ -2751,6 +2799,8 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 			DMEMIT(" metadata_only");
 		if (wc->pause_set)
 			DMEMIT(" pause_writeback %u", wc->pause_value);
+		if (wc->sequential_threshold_set)
+			DMEMIT(" sequential_threshold %u", wc->sequential_threshold);
 		break;
 	case STATUSTYPE_IMA:
 		*result = '\0';
@@ -2760,7 +2810,7 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 
 static struct target_type writecache_target = {
 	.name			= "writecache",
-	.version		= {1, 6, 0},
+	.version		= {1, 7, 0},
 	.module			= THIS_MODULE,
 	.ctr			= writecache_ctr,
 	.dtr			= writecache_dtr,
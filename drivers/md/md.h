@@ -119,6 +119,10 @@ struct md_rdev {
 					   * for reporting to userspace and storing
 					   * in superblock.
 					   */
+	unsigned long	read_latency_ns;  /* moving average of read completion
+					   * latency, kept by raid1/raid10 when
+					   * latency_read_balance is set
+					   */
 
 	struct serial_in_rdev *serial;  /* used for raid1 io serialization */
 
@@ -23,6 +23,50 @@
 #define BIO_SPECIAL(bio) ((unsigned long)bio <= 2)
 #define MAX_PLUG_BIO 32
 
+/*
+ * With latency_read_balance set, read_balance() sends each read to the
+ * mirror with the smallest expected service time, i.e. its average read
+ * latency times the number of requests that would be ahead of this one.
+ * Mirrors whose estimates are within 1/8 of each other are treated as
+ * equal and the usual head-position/sequential preference decides.
+ */
+static bool latency_read_balance;
+module_param(latency_read_balance, bool, 0644);
+MODULE_PARM_DESC(latency_read_balance, "Balance reads by measured per-device latency");
+
+#define READ_LATENCY_EWMA_SHIFT	3
+
+static inline u64 read_start_time(void)
+{
+	return READ_ONCE(latency_read_balance) ? ktime_get_ns() : 0;
+}
+
+static inline void rdev_update_read_latency(struct md_rdev *rdev, u64 start_ns)
+{
+	unsigned long old = READ_ONCE(rdev->read_latency_ns);
+	unsigned long sample = min_t(u64, ktime_get_ns() - start_ns, LONG_MAX);
+
+	/* racing updates just lose a sample, which an average can afford */
+	WRITE_ONCE(rdev->read_latency_ns, old - (old >> READ_LATENCY_EWMA_SHIFT) +
+		   (sample >> READ_LATENCY_EWMA_SHIFT));
+}
+
+static inline u64 rdev_read_cost(struct md_rdev *rdev)
+{
+	return (u64)(atomic_read(&rdev->nr_pending) + 1) *
+		READ_ONCE(rdev->read_latency_ns);
+}
+
+static inline bool read_cost_better(u64 cost, sector_t dist,
+				    u64 best_cost, sector_t best_dist)
+{
+	if (cost + (cost >> 3) < best_cost)
+		return true;
+	if (best_cost + (best_cost >> 3) < cost)
+		return false;
+	return dist < best_dist;
+}
+
 /* for managing resync I/O pages */
 struct resync_pages {
 	void		*raid_bio;
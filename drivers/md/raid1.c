@@ -395,6 +395,8 @@ static void raid1_end_read_request(struct bio *bio)
 	}
 
 	if (uptodate) {
+		if (r1_bio->read_start_ns)
+			rdev_update_read_latency(rdev, r1_bio->read_start_ns);
 		raid_end_bio_io(r1_bio);
 		rdev_dec_pending(rdev, conf->mddev);
 	} else {
@@ -600,11 +602,13 @@ static int read_balance(struct r1conf *conf, struct r1bio *r1_bio, int *max_sect
 	const sector_t this_sector = r1_bio->sector;
 	int sectors;
 	int best_good_sectors;
-	int best_disk, best_dist_disk, best_pending_disk;
+	int best_disk, best_dist_disk, best_pending_disk, best_cost_disk;
 	int has_nonrot_disk;
 	int disk;
-	sector_t best_dist;
+	sector_t best_dist, best_cost_dist;
 	unsigned int min_pending;
+	u64 min_cost;
+	bool by_latency = READ_ONCE(latency_read_balance);
 	struct md_rdev *rdev;
 	int choose_first;
 	int choose_next_idle;
@@ -622,6 +626,9 @@ static int read_balance(struct r1conf *conf, struct r1bio *r1_bio, int *max_sect
 	best_dist = MaxSector;
 	best_pending_disk = -1;
 	min_pending = UINT_MAX;
+	best_cost_disk = -1;
+	best_cost_dist = MaxSector;
+	min_cost = U64_MAX;
 	best_good_sectors = 0;
 	has_nonrot_disk = 0;
 	choose_next_idle = 0;
@@ -714,6 +721,24 @@ static int read_balance(struct r1conf *conf, struct r1bio *r1_bio, int *max_sect
 			best_disk = disk;
 			break;
 		}
+		if (by_latency) {
+			u64 cost = rdev_read_cost(rdev);
+
+			/* a sequential continuation counts as no seek at all */
+			if (conf->mirrors[disk].next_seq_sect == this_sector)
+				dist = 0;
+			if (best_cost_disk < 0 ||
+			    read_cost_better(cost, dist, min_cost, best_cost_dist)) {
+				min_cost = cost;
+				best_cost_dist = dist;
+				best_cost_disk = disk;
+			}
+			if (dist < best_dist) {
+				best_dist = dist;
+				best_dist_disk = disk;
+			}
+			continue;
+		}
 		/* Don't change to another disk for sequential reads */
 		if (conf->mirrors[disk].next_seq_sect == this_sector
 		    || dist == 0) {
@@ -766,7 +791,9 @@ static int read_balance(struct r1conf *conf, struct r1bio *r1_bio, int *max_sect
 	 * mixed ratation/non-rotational disks depending on workload.
 	 */
 	if (best_disk == -1) {
-		if (has_nonrot_disk || min_pending == 0)
+		if (best_cost_disk >= 0)
+			best_disk = best_cost_disk;
+		else if (has_nonrot_disk || min_pending == 0)
 			best_disk = best_pending_disk;
 		else
 			best_disk = best_dist_disk;
@@ -1325,6 +1352,7 @@ static void raid1_read_request(struct mddev *mddev, struct bio *bio,
 	    test_bit(R1BIO_FailFast, &r1_bio->state))
 	        read_bio->bi_opf |= MD_FAILFAST;
 	read_bio->bi_private = r1_bio;
+	r1_bio->read_start_ns = read_start_time();
 
 	if (mddev->gendisk)
 	        trace_block_bio_remap(read_bio, disk_devt(mddev->gendisk),
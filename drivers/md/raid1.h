@@ -175,6 +175,12 @@ struct r1bio {
 	 */
 	struct bio		*behind_master_bio;
 
+	/*
+	 * when the read to read_disk was issued, or 0 if its latency
+	 * isn't being sampled
+	 */
+	u64			read_start_ns;
+
 	/*
 	 * if the IO is in WRITE direction, then multiple bios are used.
 	 * We choose the number when they are allocated.
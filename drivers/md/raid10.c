@@ -389,6 +389,8 @@ static void raid10_end_read_request(struct bio *bio)
 	update_head_pos(slot, r10_bio);
 
 	if (uptodate) {
+		if (r10_bio->read_start_ns)
+			rdev_update_read_latency(rdev, r10_bio->read_start_ns);
 		/*
 		 * Set R10BIO_Uptodate in our master bio, so that
 		 * we will return a good error code to the higher
@@ -736,10 +738,14 @@ static struct md_rdev *read_balance(struct r10conf *conf,
 	int best_good_sectors;
 	sector_t new_distance, best_dist;
 	struct md_rdev *best_dist_rdev, *best_pending_rdev, *rdev = NULL;
+	struct md_rdev *best_cost_rdev = NULL;
 	int do_balance;
-	int best_dist_slot, best_pending_slot;
+	int best_dist_slot, best_pending_slot, best_cost_slot = -1;
 	bool has_nonrot_disk = false;
 	unsigned int min_pending;
+	u64 min_cost = U64_MAX;
+	sector_t best_cost_dist = MaxSector;
+	bool by_latency = READ_ONCE(latency_read_balance);
 	struct geom *geo = &conf->geo;
 
 	raid10_find_phys(conf, r10_bio);
@@ -860,9 +866,25 @@ static struct md_rdev *read_balance(struct r10conf *conf,
 			best_dist_slot = slot;
 			best_dist_rdev = rdev;
 		}
+
+		if (by_latency) {
+			u64 cost = rdev_read_cost(rdev);
+
+			if (!best_cost_rdev ||
+			    read_cost_better(cost, new_distance,
+					     min_cost, best_cost_dist)) {
+				min_cost = cost;
+				best_cost_dist = new_distance;
+				best_cost_slot = slot;
+				best_cost_rdev = rdev;
+			}
+		}
 	}
 	if (slot >= conf->copies) {
-		if (has_nonrot_disk) {
+		if (best_cost_rdev) {
+			slot = best_cost_slot;
+			rdev = best_cost_rdev;
+		} else if (has_nonrot_disk) {
 			slot = best_pending_slot;
 			rdev = best_pending_rdev;
 		} else {
@@ -1258,6 +1280,7 @@ static void raid10_read_request(struct mddev *mddev, struct bio *bio,
 	    test_bit(R10BIO_FailFast, &r10_bio->state))
 	        read_bio->bi_opf |= MD_FAILFAST;
 	read_bio->bi_private = r10_bio;
+	r10_bio->read_start_ns = read_start_time();
 
 	if (mddev->gendisk)
 	        trace_block_bio_remap(read_bio, disk_devt(mddev->gendisk),
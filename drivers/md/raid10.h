@@ -132,6 +132,8 @@ struct r10bio {
 	 * if the IO is in READ direction, then this is where we read
 	 */
 	int			read_slot;
+	/* when the read was issued, or 0 if its latency isn't being sampled */
+	u64			read_start_ns;
 
 	struct list_head	retry_list;
 	/*
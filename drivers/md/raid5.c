@@ -248,13 +248,17 @@ static void do_release_stripe(struct r5conf *conf, struct stripe_head *sh,
 
 	if (test_bit(STRIPE_HANDLE, &sh->state)) {
 		if (test_bit(STRIPE_DELAYED, &sh->state) &&
-		    !test_bit(STRIPE_PREREAD_ACTIVE, &sh->state))
+		    !test_bit(STRIPE_PREREAD_ACTIVE, &sh->state)) {
+			if (!test_and_set_bit(STRIPE_GATHERING, &sh->state))
+				sh->gather_deadline = jiffies + msecs_to_jiffies(
+					READ_ONCE(conf->write_gather_msecs));
 			list_add_tail(&sh->lru, &conf->delayed_list);
-		else if (test_bit(STRIPE_BIT_DELAY, &sh->state) &&
+		} else if (test_bit(STRIPE_BIT_DELAY, &sh->state) &&
 			   sh->bm_seq - conf->seq_write > 0)
 			list_add_tail(&sh->lru, &conf->bitmap_list);
 		else {
 			clear_bit(STRIPE_DELAYED, &sh->state);
+			clear_bit(STRIPE_GATHERING, &sh->state);
 			clear_bit(STRIPE_BIT_DELAY, &sh->state);
 			if (conf->worker_cnt_per_group == 0) {
 				if (stripe_is_lowprio(sh))
@@ -271,6 +275,7 @@ static void do_release_stripe(struct r5conf *conf, struct stripe_head *sh,
 		md_wakeup_thread(conf->mddev->thread);
 	} else {
 		BUG_ON(stripe_operations_active(sh));
+		clear_bit(STRIPE_GATHERING, &sh->state);
 		if (test_and_clear_bit(STRIPE_PREREAD_ACTIVE, &sh->state))
 			if (atomic_dec_return(&conf->preread_active_stripes)
 			    < IO_THRESHOLD)
@@ -5382,6 +5387,32 @@ static void handle_stripe(struct stripe_head *sh)
 	clear_bit_unlock(STRIPE_ACTIVE, &sh->state);
 }
 
+/*
+ * A stripe that needs a read-modify-write or reconstruct-write is kept on
+ * the delayed_list for up to write_gather_msecs, so that a sequential
+ * writer gets the chance to fill it and have it written as a full stripe
+ * instead.  Stripes are added in order, so stop at the first one that is
+ * still inside its window and let the timer bring raid5d back for it.
+ */
+static bool raid5_stripe_gathering(struct r5conf *conf, struct stripe_head *sh)
+{
+	if (!READ_ONCE(conf->write_gather_msecs) || conf->quiesce ||
+	    test_bit(R5_INACTIVE_BLOCKED, &conf->cache_state) ||
+	    !test_bit(STRIPE_GATHERING, &sh->state) ||
+	    time_after_eq(jiffies, sh->gather_deadline))
+		return false;
+
+	mod_timer(&conf->gather_timer, sh->gather_deadline);
+	return true;
+}
+
+static void raid5_gather_timeout(struct timer_list *t)
+{
+	struct r5conf *conf = from_timer(conf, t, gather_timer);
+
+	md_wakeup_thread(conf->mddev->thread);
+}
+
 static void raid5_activate_delayed(struct r5conf *conf)
 	__must_hold(&conf->device_lock)
 {
@@ -5390,8 +5421,11 @@ static void raid5_activate_delayed(struct r5conf *conf)
 			struct list_head *l = conf->delayed_list.next;
 			struct stripe_head *sh;
 			sh = list_entry(l, struct stripe_head, lru);
+			if (raid5_stripe_gathering(conf, sh))
+				break;
 			list_del_init(l);
 			clear_bit(STRIPE_DELAYED, &sh->state);
+			clear_bit(STRIPE_GATHERING, &sh->state);
 			if (!test_and_set_bit(STRIPE_PREREAD_ACTIVE, &sh->state))
 				atomic_inc(&conf->preread_active_stripes);
 			list_add_tail(&sh->lru, &conf->hold_list);
@@ -7134,6 +7168,56 @@ raid5_preread_bypass_threshold = __ATTR(preread_bypass_threshold,
 					raid5_show_preread_threshold,
 					raid5_store_preread_threshold);
 
+#define WRITE_GATHER_MAX_MSECS 1000
+
+static ssize_t
+raid5_show_write_gather_msecs(struct mddev *mddev, char *page)
+{
+	struct r5conf *conf;
+	int ret = 0;
+	spin_lock(&mddev->lock);
+	conf = mddev->private;
+	if (conf)
+		ret = sprintf(page, "%u\n", conf->write_gather_msecs);
+	spin_unlock(&mddev->lock);
+	return ret;
+}
+
+static ssize_t
+raid5_store_write_gather_msecs(struct mddev *mddev, const char *page, size_t len)
+{
+	struct r5conf *conf;
+	unsigned int new;
+	int err;
+
+	if (len >= PAGE_SIZE)
+		return -EINVAL;
+	if (kstrtouint(page, 10, &new))
+		return -EINVAL;
+	if (new > WRITE_GATHER_MAX_MSECS)
+		return -EINVAL;
+
+	err = mddev_lock(mddev);
+	if (err)
+		return err;
+	conf = mddev->private;
+	if (!conf)
+		err = -ENODEV;
+	else {
+		WRITE_ONCE(conf->write_gather_msecs, new);
+		/* let anything already held go out under the new window */
+		md_wakeup_thread(mddev->thread);
+	}
+	mddev_unlock(mddev);
+	return err ?: len;
+}
+
+static struct md_sysfs_entry
+raid5_write_gather_msecs = __ATTR(write_gather_msecs,
+				  S_IRUGO | S_IWUSR,
+				  raid5_show_write_gather_msecs,
+				  raid5_store_write_gather_msecs);
+
 static ssize_t
 raid5_show_skip_copy(struct mddev *mddev, char *page)
 {
@@ -7273,6 +7357,7 @@ static struct attribute *raid5_attrs[] =  {
 	&raid5_stripecache_size.attr,
 	&raid5_stripecache_active.attr,
 	&raid5_preread_bypass_threshold.attr,
+	&raid5_write_gather_msecs.attr,
 	&raid5_group_thread_cnt.attr,
 	&raid5_skip_copy.attr,
 	&raid5_rmw_level.attr,
@@ -7408,6 +7493,7 @@ static void free_conf(struct r5conf *conf)
 
 	log_exit(conf);
 
+	timer_shutdown_sync(&conf->gather_timer);
 	unregister_shrinker(&conf->shrinker);
 	free_thread_groups(conf);
 	shrink_stripes(conf);
@@ -7531,6 +7617,7 @@ static struct r5conf *setup_conf(struct mddev *mddev)
 	conf = kzalloc(sizeof(struct r5conf), GFP_KERNEL);
 	if (conf == NULL)
 		goto abort;
+	timer_setup(&conf->gather_timer, raid5_gather_timeout, 0);
 
 #if PAGE_SIZE != DEFAULT_STRIPE_SIZE
 	conf->stripe_size = DEFAULT_STRIPE_SIZE;
@@ -212,6 +212,7 @@ struct stripe_head {
 	unsigned long		state;		/* state flags */
 	atomic_t		count;	      /* nr of active thread/requests */
 	int			bm_seq;	/* sequence number for bitmap flushes */
+	unsigned long		gather_deadline; /* jiffies, see STRIPE_GATHERING */
 	int			disks;		/* disks in stripe */
 	int			overwrite_disks; /* total overwrite disks in stripe,
 						  * this is only checked when stripe
@@ -399,6 +400,9 @@ enum {
 				 * in conf->r5c_full_stripe_list)
 				 */
 	STRIPE_R5C_PREFLUSH,	/* need to flush journal device */
+	STRIPE_GATHERING,	/* held on delayed_list until gather_deadline
+				 * in the hope that it becomes a full write
+				 */
 };
 
 #define STRIPE_EXPAND_SYNC_FLAGS \
@@ -625,6 +629,8 @@ struct r5conf {
 	atomic_t		pending_full_writes; /* full write backlog */
 	int			bypass_count; /* bypassed prereads */
 	int			bypass_threshold; /* preread nice */
+	unsigned int		write_gather_msecs; /* hold partial writes this long */
+	struct timer_list	gather_timer; /* kicks raid5d when a hold expires */
 	int			skip_copy; /* Don't copy data from bio to stripe cache */
 	struct list_head	*last_hold; /* detect hold_list promotions */
 
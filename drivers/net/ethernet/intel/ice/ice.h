@@ -340,6 +340,9 @@ struct ice_vsi {
 	u32 tx_busy;
 	u32 rx_buf_failed;
 	u32 rx_page_failed;
+	u64 rx_xsk_alloc_batches;
+	u64 rx_xsk_alloc_bufs;
+	u64 rx_xsk_alloc_short;
 	u16 num_q_vectors;
 	/* tell if only dynamic irq allocation is allowed */
 	bool irq_dyn_alloc;
@@ -61,6 +61,9 @@ static const struct ice_stats ice_gstrings_vsi_stats[] = {
 	ICE_VSI_STAT("rx_unknown_protocol", eth_stats.rx_unknown_protocol),
 	ICE_VSI_STAT("rx_alloc_fail", rx_buf_failed),
 	ICE_VSI_STAT("rx_pg_alloc_fail", rx_page_failed),
+	ICE_VSI_STAT("rx_xsk_alloc_batches", rx_xsk_alloc_batches),
+	ICE_VSI_STAT("rx_xsk_alloc_bufs", rx_xsk_alloc_bufs),
+	ICE_VSI_STAT("rx_xsk_alloc_short", rx_xsk_alloc_short),
 	ICE_VSI_STAT("tx_errors", eth_stats.tx_errors),
 	ICE_VSI_STAT("tx_linearize", tx_linearize),
 	ICE_VSI_STAT("tx_busy", tx_busy),
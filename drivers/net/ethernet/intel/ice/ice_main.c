@@ -6571,6 +6571,9 @@ static void ice_update_vsi_ring_stats(struct ice_vsi *vsi)
 	vsi->tx_linearize = 0;
 	vsi->rx_buf_failed = 0;
 	vsi->rx_page_failed = 0;
+	vsi->rx_xsk_alloc_batches = 0;
+	vsi->rx_xsk_alloc_bufs = 0;
+	vsi->rx_xsk_alloc_short = 0;
 
 	rcu_read_lock();
 
@@ -6591,6 +6594,9 @@ static void ice_update_vsi_ring_stats(struct ice_vsi *vsi)
 		vsi_stats->rx_bytes += bytes;
 		vsi->rx_buf_failed += ring_stats->rx_stats.alloc_buf_failed;
 		vsi->rx_page_failed += ring_stats->rx_stats.alloc_page_failed;
+		vsi->rx_xsk_alloc_batches += ring_stats->rx_stats.xsk_alloc_batches;
+		vsi->rx_xsk_alloc_bufs += ring_stats->rx_stats.xsk_alloc_bufs;
+		vsi->rx_xsk_alloc_short += ring_stats->rx_stats.xsk_alloc_short;
 	}
 
 	/* update XDP Tx rings counters */
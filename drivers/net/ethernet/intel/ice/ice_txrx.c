@@ -218,6 +218,8 @@ static bool ice_clean_tx_irq(struct ice_tx_ring *tx_ring, int napi_budget)
 {
 	unsigned int total_bytes = 0, total_pkts = 0;
 	unsigned int budget = ICE_DFLT_IRQ_WORK;
+	struct sk_buff *done[ICE_TX_CLEAN_BULK];
+	unsigned int nr_done = 0;
 	struct ice_vsi *vsi = tx_ring->vsi;
 	s16 i = tx_ring->next_to_clean;
 	struct ice_tx_desc *tx_desc;
@@ -257,15 +259,19 @@ static bool ice_clean_tx_irq(struct ice_tx_ring *tx_ring, int napi_budget)
 		total_bytes += tx_buf->bytecount;
 		total_pkts += tx_buf->gso_segs;
 
-		/* free the skb */
-		napi_consume_skb(tx_buf->skb, napi_budget);
-
 		/* unmap skb header data */
 		dma_unmap_single(tx_ring->dev,
 				 dma_unmap_addr(tx_buf, dma),
 				 dma_unmap_len(tx_buf, len),
 				 DMA_TO_DEVICE);
 
+		/* free the skb, a batch at a time */
+		done[nr_done++] = tx_buf->skb;
+		if (nr_done == ICE_TX_CLEAN_BULK) {
+			napi_consume_skb_bulk(done, nr_done, napi_budget);
+			nr_done = 0;
+		}
+
 		/* clear tx_buf data */
 		tx_buf->type = ICE_TX_BUF_EMPTY;
 		dma_unmap_len_set(tx_buf, len, 0);
@@ -309,6 +315,9 @@ static bool ice_clean_tx_irq(struct ice_tx_ring *tx_ring, int napi_budget)
 		budget--;
 	} while (likely(budget));
 
+	if (nr_done)
+		napi_consume_skb_bulk(done, nr_done, napi_budget);
+
 	i += tx_ring->count;
 	tx_ring->next_to_clean = i;
 
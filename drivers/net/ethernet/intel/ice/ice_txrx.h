@@ -7,6 +7,7 @@
 #include "ice_type.h"
 
 #define ICE_DFLT_IRQ_WORK	256
+#define ICE_TX_CLEAN_BULK	16
 #define ICE_RXBUF_3072		3072
 #define ICE_RXBUF_2048		2048
 #define ICE_RXBUF_1664		1664
@@ -221,6 +222,10 @@ struct ice_rxq_stats {
 	u64 non_eop_descs;
 	u64 alloc_page_failed;
 	u64 alloc_buf_failed;
+	/* AF_XDP zero-copy refill: batches, buffers placed, short batches */
+	u64 xsk_alloc_batches;
+	u64 xsk_alloc_bufs;
+	u64 xsk_alloc_short;
 };
 
 struct ice_ring_stats {
@@ -481,16 +481,24 @@ static u16 ice_fill_rx_descs(struct xsk_buff_pool *pool, struct xdp_buff **xdp,
  * for case where space from next_to_use up to the end of ring is less
  * than @count. Finally do a tail bump.
  *
+ * Each call is accounted as one refill batch; a batch is short when the
+ * XSK pool could not provide all @count buffers, i.e. the fill queue ran
+ * dry. xsk_alloc_bufs / xsk_alloc_batches gives the average batch size.
+ *
  * Returns true if all allocations were successful, false if any fail.
  */
 static bool __ice_alloc_rx_bufs_zc(struct ice_rx_ring *rx_ring, u16 count)
 {
+	struct ice_rxq_stats *rx_stats = &rx_ring->ring_stats->rx_stats;
 	u32 nb_buffs_extra = 0, nb_buffs = 0;
 	union ice_32b_rx_flex_desc *rx_desc;
 	u16 ntu = rx_ring->next_to_use;
 	u16 total_count = count;
 	struct xdp_buff **xdp;
 
+	if (!count)
+		return true;
+
 	rx_desc = ICE_RX_DESC(rx_ring, ntu);
 	xdp = ice_xdp_buf(rx_ring, ntu);
 
@@ -519,7 +527,14 @@ static bool __ice_alloc_rx_bufs_zc(struct ice_rx_ring *rx_ring, u16 count)
 	if (rx_ring->next_to_use != ntu)
 		ice_release_rx_desc(rx_ring, ntu);
 
-	return total_count == (nb_buffs_extra + nb_buffs);
+	rx_stats->xsk_alloc_batches++;
+	rx_stats->xsk_alloc_bufs += nb_buffs_extra + nb_buffs;
+	if (total_count != nb_buffs_extra + nb_buffs) {
+		rx_stats->xsk_alloc_short++;
+		return false;
+	}
+
+	return true;
 }
 
 /**
@@ -344,6 +344,12 @@ static void set_sock_opts(struct socket *sock)
 	sock->sk->sk_allocation = GFP_ATOMIC;
 	sock->sk->sk_sndbuf = INT_MAX;
 	sk_set_memalloc(sock->sk);
+	/* Let the outer UDP layer aggregate consecutive datagrams from the
+	 * same endpoint. We do not accept GSO skbs, so the aggregate is split
+	 * again right before it reaches wg_receive(), but the batch only walks
+	 * the IP and UDP receive paths once.
+	 */
+	udp_set_bit(GRO_ENABLED, sock->sk);
 }
 
 int wg_socket_init(struct wg_device *wg, u16 port)
@@ -17,6 +17,7 @@ MODULE_PARM_DESC(multipath,
 static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
+	[NVME_IOPOLICY_ST]	= "service-time",
 };
 
 static int iopolicy = NVME_IOPOLICY_NUMA;
@@ -29,6 +30,8 @@ static int nvme_set_iopolicy(const char *val, const struct kernel_param *kp)
 		iopolicy = NVME_IOPOLICY_NUMA;
 	else if (!strncmp(val, "round-robin", 11))
 		iopolicy = NVME_IOPOLICY_RR;
+	else if (!strncmp(val, "service-time", 12))
+		iopolicy = NVME_IOPOLICY_ST;
 	else
 		return -EINVAL;
 
@@ -43,7 +46,18 @@ static int nvme_get_iopolicy(char *buf, const struct kernel_param *kp)
 module_param_call(iopolicy, nvme_set_iopolicy, nvme_get_iopolicy,
 	&iopolicy, 0644);
 MODULE_PARM_DESC(iopolicy,
-	"Default multipath I/O policy; 'numa' (default) or 'round-robin'");
+	"Default multipath I/O policy; 'numa' (default), 'round-robin' or 'service-time'");
+
+/*
+ * The service-time policy keeps an EWMA of the completion latency of each
+ * path and sends I/O to the path with the lowest expected service time, i.e.
+ * (in-flight requests + 1) * average latency.  Completions may run on any
+ * CPU, so the average is shared by all CPUs rather than kept per CPU.
+ * Samples older than NVME_ST_DECAY_NS are halved for every period elapsed so
+ * that a path which got slow once is probed again after it has gone idle.
+ */
+#define NVME_ST_EWMA_SHIFT	3
+#define NVME_ST_DECAY_NS	(100 * NSEC_PER_MSEC)
 
 void nvme_mpath_default_iopolicy(struct nvme_subsystem *subsys)
 {
@@ -80,6 +94,29 @@ void nvme_mpath_start_freeze(struct nvme_subsystem *subsys)
 			blk_freeze_queue_start(h->disk->queue);
 }
 
+static void nvme_mpath_end_active(struct request *rq, bool sample)
+{
+	struct nvme_ns *ns = rq->q->queuedata;
+	s64 old, new;
+	u64 now, lat;
+
+	nvme_req(rq)->flags &= ~NVME_MPATH_CNT_ACTIVE;
+	atomic_dec_if_positive(&ns->nr_active);
+	if (!sample)
+		return;
+
+	now = ktime_get_ns();
+	lat = now - nvme_req(rq)->st_start_ns;
+	old = atomic64_read(&ns->st_lat_ns);
+	do {
+		new = lat;
+		if (old)
+			new = old - (old >> NVME_ST_EWMA_SHIFT) +
+				(lat >> NVME_ST_EWMA_SHIFT);
+	} while (!atomic64_try_cmpxchg(&ns->st_lat_ns, &old, new));
+	atomic64_set(&ns->st_stamp_ns, now);
+}
+
 void nvme_failover_req(struct request *req)
 {
 	struct nvme_ns *ns = req->q->queuedata;
@@ -118,6 +155,8 @@ void nvme_failover_req(struct request *req)
 	blk_steal_bios(&ns->head->requeue_list, req);
 	spin_unlock_irqrestore(&ns->head->requeue_lock, flags);
 
+	if (nvme_req(req)->flags & NVME_MPATH_CNT_ACTIVE)
+		nvme_mpath_end_active(req, false);
 	blk_mq_end_request(req, 0);
 	kblockd_schedule_work(&ns->head->requeue_work);
 }
@@ -127,7 +166,19 @@ void nvme_mpath_start_request(struct request *rq)
 	struct nvme_ns *ns = rq->q->queuedata;
 	struct gendisk *disk = ns->head->disk;
 
-	if (!blk_queue_io_stat(disk->queue) || blk_rq_is_passthrough(rq))
+	if (blk_rq_is_passthrough(rq))
+		return;
+
+	if (READ_ONCE(ns->head->subsys->iopolicy) == NVME_IOPOLICY_ST) {
+		/* a requeued request is still accounted from its first issue */
+		if (!(nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE)) {
+			atomic_inc(&ns->nr_active);
+			nvme_req(rq)->flags |= NVME_MPATH_CNT_ACTIVE;
+		}
+		nvme_req(rq)->st_start_ns = ktime_get_ns();
+	}
+
+	if (!blk_queue_io_stat(disk->queue))
 		return;
 
 	nvme_req(rq)->flags |= NVME_MPATH_IO_STATS;
@@ -140,6 +191,8 @@ void nvme_mpath_end_request(struct request *rq)
 {
 	struct nvme_ns *ns = rq->q->queuedata;
 
+	if (nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE)
+		nvme_mpath_end_active(rq, !nvme_req(rq)->status);
 	if (!(nvme_req(rq)->flags & NVME_MPATH_IO_STATS))
 		return;
 	bdev_end_io_acct(ns->head->disk->part0, req_op(rq),
@@ -329,6 +382,49 @@ static struct nvme_ns *nvme_round_robin_path(struct nvme_ns_head *head,
 	return found;
 }
 
+static u64 nvme_service_time_cost(struct nvme_ns *ns, u64 now)
+{
+	u64 lat = atomic64_read(&ns->st_lat_ns);
+	/* another CPU may have stamped a sample after @now was read */
+	s64 age = now - atomic64_read(&ns->st_stamp_ns);
+
+	if (age > NVME_ST_DECAY_NS)
+		lat >>= min_t(u64, div64_u64(age, NVME_ST_DECAY_NS), 63);
+	return (atomic_read(&ns->nr_active) + 1) * max_t(u64, lat, 1);
+}
+
+static struct nvme_ns *nvme_service_time_path(struct nvme_ns_head *head)
+{
+	struct nvme_ns *best_opt = NULL, *best_nonopt = NULL, *ns;
+	u64 min_opt = U64_MAX, min_nonopt = U64_MAX, cost;
+	u64 now = ktime_get_ns();
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		cost = nvme_service_time_cost(ns, now);
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (cost < min_opt) {
+				min_opt = cost;
+				best_opt = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (cost < min_nonopt) {
+				min_nonopt = cost;
+				best_nonopt = ns;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return best_opt ? best_opt : best_nonopt;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return ns->ctrl->state == NVME_CTRL_LIVE &&
@@ -340,6 +436,9 @@ inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 	int node = numa_node_id();
 	struct nvme_ns *ns;
 
+	if (READ_ONCE(head->subsys->iopolicy) == NVME_IOPOLICY_ST)
+		return nvme_service_time_path(head);
+
 	ns = srcu_dereference(head->current_path[node], &head->srcu);
 	if (unlikely(!ns))
 		return __nvme_find_path(head, node);
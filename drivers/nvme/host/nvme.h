@@ -176,6 +176,7 @@ struct nvme_request {
 	u16			status;
 #ifdef CONFIG_NVME_MULTIPATH
 	unsigned long		start_time;
+	u64			st_start_ns;
 #endif
 	struct nvme_ctrl	*ctrl;
 };
@@ -189,6 +190,7 @@ enum {
 	NVME_REQ_CANCELLED		= (1 << 0),
 	NVME_REQ_USERCMD		= (1 << 1),
 	NVME_MPATH_IO_STATS		= (1 << 2),
+	NVME_MPATH_CNT_ACTIVE		= (1 << 3),
 };
 
 static inline struct nvme_request *nvme_req(struct request *req)
@@ -400,6 +402,7 @@ static inline enum nvme_ctrl_state nvme_ctrl_state(struct nvme_ctrl *ctrl)
 enum nvme_iopolicy {
 	NVME_IOPOLICY_NUMA,
 	NVME_IOPOLICY_RR,
+	NVME_IOPOLICY_ST,
 };
 
 struct nvme_subsystem {
@@ -492,6 +495,10 @@ struct nvme_ns {
 #ifdef CONFIG_NVME_MULTIPATH
 	enum nvme_ana_state ana_state;
 	u32 ana_grpid;
+	/* service-time iopolicy state */
+	atomic_t nr_active;
+	atomic64_t st_lat_ns;
+	atomic64_t st_stamp_ns;
 #endif
 	struct list_head siblings;
 	struct kref kref;
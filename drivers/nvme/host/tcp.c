@@ -8,6 +8,8 @@
 #include <linux/init.h>
 #include <linux/slab.h>
 #include <linux/err.h>
+#include <linux/kthread.h>
+#include <linux/sched/clock.h>
 #include <linux/nvme-tcp.h>
 #include <net/sock.h>
 #include <net/tcp.h>
@@ -31,6 +33,22 @@ static int so_priority;
 module_param(so_priority, int, 0644);
 MODULE_PARM_DESC(so_priority, "nvme tcp socket optimize priority");
 
+/*
+ * By default socket callbacks kick io_work on the queue's io_cpu. In polling
+ * mode every default and read queue gets a kthread bound to that CPU, which
+ * busy-polls the socket for io_poll_budget microseconds after the last bit of
+ * progress before going back to sleep. Poll queues keep using io_work, as
+ * blk-mq polling already reaps their completions inline.
+ */
+static bool io_poll;
+module_param(io_poll, bool, 0444);
+MODULE_PARM_DESC(io_poll, "use per-queue busy-polling threads instead of io_work");
+
+static unsigned int io_poll_budget = 50;
+module_param(io_poll_budget, uint, 0644);
+MODULE_PARM_DESC(io_poll_budget,
+		 "microseconds a polling thread spins without progress before sleeping");
+
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 /* lockdep can detect a circular dependency of the form
  *   sk_lock -> mmap_lock (page fault) -> fs locks -> sk_lock
@@ -104,6 +122,7 @@ enum nvme_tcp_queue_flags {
 	NVME_TCP_Q_ALLOCATED	= 0,
 	NVME_TCP_Q_LIVE		= 1,
 	NVME_TCP_Q_POLLING	= 2,
+	NVME_TCP_Q_KICKED	= 3,
 };
 
 enum nvme_tcp_recv_state {
@@ -116,6 +135,7 @@ struct nvme_tcp_ctrl;
 struct nvme_tcp_queue {
 	struct socket		*sock;
 	struct work_struct	io_work;
+	struct task_struct __rcu *poll_thread;
 	int			io_cpu;
 
 	struct mutex		queue_lock;
@@ -189,6 +209,44 @@ static inline int nvme_tcp_queue_id(struct nvme_tcp_queue *queue)
 	return queue - queue->ctrl->queues;
 }
 
+static bool nvme_tcp_admin_queue(struct nvme_tcp_queue *queue)
+{
+	return nvme_tcp_queue_id(queue) == 0;
+}
+
+static bool nvme_tcp_default_queue(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
+	int qid = nvme_tcp_queue_id(queue);
+
+	return !nvme_tcp_admin_queue(queue) &&
+		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT];
+}
+
+static bool nvme_tcp_read_queue(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
+	int qid = nvme_tcp_queue_id(queue);
+
+	return !nvme_tcp_admin_queue(queue) &&
+		!nvme_tcp_default_queue(queue) &&
+		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT] +
+			  ctrl->io_queues[HCTX_TYPE_READ];
+}
+
+static bool nvme_tcp_poll_queue(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
+	int qid = nvme_tcp_queue_id(queue);
+
+	return !nvme_tcp_admin_queue(queue) &&
+		!nvme_tcp_default_queue(queue) &&
+		!nvme_tcp_read_queue(queue) &&
+		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT] +
+			  ctrl->io_queues[HCTX_TYPE_READ] +
+			  ctrl->io_queues[HCTX_TYPE_POLL];
+}
+
 static inline struct blk_mq_tags *nvme_tcp_tagset(struct nvme_tcp_queue *queue)
 {
 	u32 queue_idx = nvme_tcp_queue_id(queue);
@@ -334,6 +392,22 @@ static inline bool nvme_tcp_queue_more(struct nvme_tcp_queue *queue)
 		!llist_empty(&queue->req_list);
 }
 
+static inline void nvme_tcp_kick_io(struct nvme_tcp_queue *queue)
+{
+	struct task_struct *thread;
+
+	rcu_read_lock();
+	thread = rcu_dereference(queue->poll_thread);
+	if (thread) {
+		if (!test_and_set_bit(NVME_TCP_Q_KICKED, &queue->flags))
+			wake_up_process(thread);
+		rcu_read_unlock();
+		return;
+	}
+	rcu_read_unlock();
+	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+}
+
 static inline void nvme_tcp_queue_request(struct nvme_tcp_request *req,
 		bool sync, bool last)
 {
@@ -355,7 +429,7 @@ static inline void nvme_tcp_queue_request(struct nvme_tcp_request *req,
 	}
 
 	if (last && nvme_tcp_queue_more(queue))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 }
 
 static void nvme_tcp_process_req_list(struct nvme_tcp_queue *queue)
@@ -927,7 +1001,7 @@ static void nvme_tcp_data_ready(struct sock *sk)
 	queue = sk->sk_user_data;
 	if (likely(queue && queue->rd_enabled) &&
 	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 	read_unlock_bh(&sk->sk_callback_lock);
 }
 
@@ -939,7 +1013,7 @@ static void nvme_tcp_write_space(struct sock *sk)
 	queue = sk->sk_user_data;
 	if (likely(queue && sk_stream_is_writeable(sk))) {
 		clear_bit(SOCK_NOSPACE, &sk->sk_socket->flags);
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
@@ -1260,6 +1334,102 @@ static void nvme_tcp_io_work(struct work_struct *w)
 	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
 }
 
+static int nvme_tcp_poll_thread(void *data)
+{
+	struct nvme_tcp_queue *queue = data;
+	struct sock *sk = queue->sock->sk;
+
+	while (!kthread_should_stop()) {
+		u64 deadline;
+
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!test_and_clear_bit(NVME_TCP_Q_KICKED, &queue->flags) &&
+		    !kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		deadline = local_clock() + io_poll_budget * NSEC_PER_USEC;
+		while (!kthread_should_stop()) {
+			bool pending = false;
+			int result;
+
+			clear_bit(NVME_TCP_Q_KICKED, &queue->flags);
+
+			if (mutex_trylock(&queue->send_mutex)) {
+				result = nvme_tcp_try_send(queue);
+				mutex_unlock(&queue->send_mutex);
+				if (result > 0)
+					pending = true;
+			}
+
+			if (sk_can_busy_loop(sk) &&
+			    skb_queue_empty_lockless(&sk->sk_receive_queue))
+				sk_busy_loop(sk, true);
+
+			result = nvme_tcp_try_recv(queue);
+			if (result > 0)
+				pending = true;
+			else if (unlikely(result < 0) || !queue->rd_enabled)
+				break;
+
+			if (pending)
+				deadline = local_clock() +
+					   io_poll_budget * NSEC_PER_USEC;
+			else if (local_clock() > deadline)
+				break;
+
+			cond_resched();
+		}
+	}
+
+	return 0;
+}
+
+static void nvme_tcp_start_poll_thread(struct nvme_tcp_queue *queue)
+{
+	struct task_struct *thread;
+
+	if (!io_poll || nvme_tcp_admin_queue(queue) ||
+	    nvme_tcp_poll_queue(queue))
+		return;
+
+	thread = kthread_create_on_node(nvme_tcp_poll_thread, queue,
+					cpu_to_node(queue->io_cpu),
+					"nvme_tcp_%d/%d",
+					queue->ctrl->ctrl.instance,
+					nvme_tcp_queue_id(queue));
+	if (IS_ERR(thread)) {
+		dev_warn(queue->ctrl->ctrl.device,
+			 "queue %d: failed to start polling thread, using io_work\n",
+			 nvme_tcp_queue_id(queue));
+		return;
+	}
+
+	kthread_bind(thread, queue->io_cpu);
+	clear_bit(NVME_TCP_Q_KICKED, &queue->flags);
+	rcu_assign_pointer(queue->poll_thread, thread);
+	wake_up_process(thread);
+}
+
+static void nvme_tcp_stop_poll_thread(struct nvme_tcp_queue *queue)
+{
+	struct task_struct *thread = rcu_dereference_protected(queue->poll_thread, 1);
+
+	if (!thread)
+		return;
+
+	/*
+	 * Send further kicks to io_work. No grace period is needed before
+	 * stopping the thread: a task_struct is only freed after an RCU grace
+	 * period following its exit, so an nvme_tcp_kick_io() that still sees
+	 * the old pointer at worst wakes an exited task. Kicks lost that way
+	 * need no handling, the queue is being torn down and its io_work is
+	 * cancelled right after.
+	 */
+	RCU_INIT_POINTER(queue->poll_thread, NULL);
+	kthread_stop(thread);
+}
+
 static void nvme_tcp_free_crypto(struct nvme_tcp_queue *queue)
 {
 	struct crypto_ahash *tfm = crypto_ahash_reqtfm(queue->rcv_hash);
@@ -1453,44 +1623,6 @@ static int nvme_tcp_init_connection(struct nvme_tcp_queue *queue)
 	return ret;
 }
 
-static bool nvme_tcp_admin_queue(struct nvme_tcp_queue *queue)
-{
-	return nvme_tcp_queue_id(queue) == 0;
-}
-
-static bool nvme_tcp_default_queue(struct nvme_tcp_queue *queue)
-{
-	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
-	int qid = nvme_tcp_queue_id(queue);
-
-	return !nvme_tcp_admin_queue(queue) &&
-		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT];
-}
-
-static bool nvme_tcp_read_queue(struct nvme_tcp_queue *queue)
-{
-	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
-	int qid = nvme_tcp_queue_id(queue);
-
-	return !nvme_tcp_admin_queue(queue) &&
-		!nvme_tcp_default_queue(queue) &&
-		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT] +
-			  ctrl->io_queues[HCTX_TYPE_READ];
-}
-
-static bool nvme_tcp_poll_queue(struct nvme_tcp_queue *queue)
-{
-	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
-	int qid = nvme_tcp_queue_id(queue);
-
-	return !nvme_tcp_admin_queue(queue) &&
-		!nvme_tcp_default_queue(queue) &&
-		!nvme_tcp_read_queue(queue) &&
-		qid < 1 + ctrl->io_queues[HCTX_TYPE_DEFAULT] +
-			  ctrl->io_queues[HCTX_TYPE_READ] +
-			  ctrl->io_queues[HCTX_TYPE_POLL];
-}
-
 static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 {
 	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
@@ -1664,6 +1796,7 @@ static void __nvme_tcp_stop_queue(struct nvme_tcp_queue *queue)
 {
 	kernel_sock_shutdown(queue->sock, SHUT_RDWR);
 	nvme_tcp_restore_sock_ops(queue);
+	nvme_tcp_stop_poll_thread(queue);
 	cancel_work_sync(&queue->io_work);
 }
 
@@ -1705,6 +1838,7 @@ static int nvme_tcp_start_queue(struct nvme_ctrl *nctrl, int idx)
 
 	queue->rd_enabled = true;
 	nvme_tcp_init_recv_ctx(queue);
+	nvme_tcp_start_poll_thread(queue);
 	nvme_tcp_setup_sock_ops(queue);
 
 	if (idx)
@@ -2386,7 +2520,7 @@ static void nvme_tcp_commit_rqs(struct blk_mq_hw_ctx *hctx)
 	struct nvme_tcp_queue *queue = hctx->driver_data;
 
 	if (!llist_empty(&queue->req_list))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 }
 
 static blk_status_t nvme_tcp_queue_rq(struct blk_mq_hw_ctx *hctx,
@@ -254,6 +254,41 @@ static ssize_t nvmet_param_inline_data_size_store(struct config_item *item,
 
 CONFIGFS_ATTR(nvmet_, param_inline_data_size);
 
+static ssize_t nvmet_param_queue_cpus_show(struct config_item *item,
+		char *page)
+{
+	struct nvmet_port *port = to_nvmet_port(item);
+
+	return snprintf(page, PAGE_SIZE, "%*pbl\n",
+			cpumask_pr_args(port->queue_cpus));
+}
+
+static ssize_t nvmet_param_queue_cpus_store(struct config_item *item,
+		const char *page, size_t count)
+{
+	struct nvmet_port *port = to_nvmet_port(item);
+	cpumask_var_t mask;
+	int ret;
+
+	if (nvmet_is_port_enabled(port, __func__))
+		return -EACCES;
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+	ret = cpulist_parse(page, mask);
+	if (ret || (!cpumask_empty(mask) &&
+		    !cpumask_intersects(mask, cpu_online_mask))) {
+		pr_err("Invalid value '%s' for queue_cpus\n", page);
+		free_cpumask_var(mask);
+		return -EINVAL;
+	}
+	cpumask_copy(port->queue_cpus, mask);
+	free_cpumask_var(mask);
+	return count;
+}
+
+CONFIGFS_ATTR(nvmet_, param_queue_cpus);
+
 #ifdef CONFIG_BLK_DEV_INTEGRITY
 static ssize_t nvmet_param_pi_enable_show(struct config_item *item,
 		char *page)
@@ -1734,6 +1769,7 @@ static void nvmet_port_release(struct config_item *item)
 	flush_workqueue(nvmet_wq);
 	list_del(&port->global_entry);
 
+	free_cpumask_var(port->queue_cpus);
 	kfree(port->ana_state);
 	kfree(port);
 }
@@ -1745,6 +1781,7 @@ static struct configfs_attribute *nvmet_port_attrs[] = {
 	&nvmet_attr_addr_trsvcid,
 	&nvmet_attr_addr_trtype,
 	&nvmet_attr_param_inline_data_size,
+	&nvmet_attr_param_queue_cpus,
 #ifdef CONFIG_BLK_DEV_INTEGRITY
 	&nvmet_attr_param_pi_enable,
 #endif
@@ -1782,6 +1819,12 @@ static struct config_group *nvmet_ports_make(struct config_group *group,
 		return ERR_PTR(-ENOMEM);
 	}
 
+	if (!zalloc_cpumask_var(&port->queue_cpus, GFP_KERNEL)) {
+		kfree(port->ana_state);
+		kfree(port);
+		return ERR_PTR(-ENOMEM);
+	}
+
 	for (i = 1; i <= NVMET_MAX_ANAGRPS; i++) {
 		if (i == NVMET_DEFAULT_ANA_GRPID)
 			port->ana_state[1] = NVME_ANA_OPTIMIZED;
@@ -163,6 +163,8 @@ struct nvmet_port {
 	int				inline_data_size;
 	const struct nvmet_fabrics_ops	*tr_ops;
 	bool				pi_enable;
+	/* CPUs the transport spreads queue processing over, empty for any */
+	cpumask_var_t			queue_cpus;
 };
 
 static inline struct nvmet_port *to_nvmet_port(struct config_item *item)
@@ -8,6 +8,7 @@
 #include <linux/init.h>
 #include <linux/slab.h>
 #include <linux/err.h>
+#include <linux/blkdev.h>
 #include <linux/nvme-tcp.h>
 #include <net/sock.h>
 #include <net/tcp.h>
@@ -131,6 +132,7 @@ struct nvmet_tcp_queue {
 	struct socket		*sock;
 	struct nvmet_tcp_port	*port;
 	struct work_struct	io_work;
+	int			cpu;
 	struct nvmet_cq		nvme_cq;
 	struct nvmet_sq		nvme_sq;
 
@@ -183,6 +185,7 @@ struct nvmet_tcp_port {
 	struct nvmet_port	*nport;
 	struct sockaddr_storage addr;
 	void (*data_ready)(struct sock *);
+	int			last_cpu;
 };
 
 static DEFINE_IDA(nvmet_tcp_queue_ida);
@@ -258,6 +261,8 @@ static inline void nvmet_tcp_put_cmd(struct nvmet_tcp_cmd *cmd)
 
 static inline int queue_cpu(struct nvmet_tcp_queue *queue)
 {
+	if (queue->cpu >= 0)
+		return queue->cpu;
 	return queue->sock->sk->sk_incoming_cpu;
 }
 
@@ -1325,9 +1330,15 @@ static void nvmet_tcp_io_work(struct work_struct *w)
 {
 	struct nvmet_tcp_queue *queue =
 		container_of(w, struct nvmet_tcp_queue, io_work);
+	struct blk_plug plug;
 	bool pending;
 	int ret, ops = 0;
 
+	/*
+	 * Plug across the whole pass so that the backend I/O of all commands
+	 * received in one go is submitted to the device as a batch.
+	 */
+	blk_start_plug(&plug);
 	do {
 		pending = false;
 
@@ -1335,15 +1346,19 @@ static void nvmet_tcp_io_work(struct work_struct *w)
 		if (ret > 0)
 			pending = true;
 		else if (ret < 0)
-			return;
+			break;
 
 		ret = nvmet_tcp_try_send(queue, NVMET_TCP_SEND_BUDGET, &ops);
 		if (ret > 0)
 			pending = true;
 		else if (ret < 0)
-			return;
+			break;
 
 	} while (pending && ops < NVMET_TCP_IO_WORK_BUDGET);
+	blk_finish_plug(&plug);
+
+	if (ret < 0)
+		return;
 
 	/*
 	 * Requeue the worker if idle deadline period is in progress or any
@@ -1632,6 +1647,28 @@ static int nvmet_tcp_set_queue_sock(struct nvmet_tcp_queue *queue)
 	return ret;
 }
 
+/*
+ * Spread queues round-robin over the port's queue_cpus, if configured.
+ * Otherwise io_work follows the CPU the socket receives on.  Only called
+ * from the port's accept_work, which serializes updates to last_cpu.
+ */
+static int nvmet_tcp_pick_queue_cpu(struct nvmet_tcp_port *port)
+{
+	const struct cpumask *mask = port->nport->queue_cpus;
+	int cpu;
+
+	if (cpumask_empty(mask))
+		return -1;
+
+	cpu = cpumask_next_and(port->last_cpu, mask, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = cpumask_first_and(mask, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		return -1;
+	port->last_cpu = cpu;
+	return cpu;
+}
+
 static int nvmet_tcp_alloc_queue(struct nvmet_tcp_port *port,
 		struct socket *newsock)
 {
@@ -1646,6 +1683,7 @@ static int nvmet_tcp_alloc_queue(struct nvmet_tcp_port *port,
 	INIT_WORK(&queue->io_work, nvmet_tcp_io_work);
 	queue->sock = newsock;
 	queue->port = port;
+	queue->cpu = nvmet_tcp_pick_queue_cpu(port);
 	queue->nr_cmds = 0;
 	spin_lock_init(&queue->state_lock);
 	queue->state = NVMET_TCP_Q_CONNECTING;
@@ -1764,6 +1802,7 @@ static int nvmet_tcp_add_port(struct nvmet_port *nport)
 	}
 
 	port->nport = nport;
+	port->last_cpu = -1;
 	INIT_WORK(&port->accept_work, nvmet_tcp_accept_work);
 	if (port->nport->inline_data_size < 0)
 		port->nport->inline_data_size = NVMET_TCP_DEF_INLINE_DATA_SIZE;
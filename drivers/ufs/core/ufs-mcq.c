@@ -29,6 +29,11 @@
 #define MCQ_ENTRY_SIZE_IN_DWORD	8
 #define CQE_UCD_BA GENMASK_ULL(63, 7)
 
+/* MCQ Interrupt Aggregation Control Register, in the CQIS operation region */
+#define REG_CQ_IACR		0x8
+#define MCQ_INTR_AGGR_MAX_CNT	0x1F
+#define MCQ_INTR_AGGR_MAX_TMO	0xFF
+
 /* Max mcq register polling time in microseconds */
 #define MCQ_POLL_US 500000
 
@@ -80,6 +85,38 @@ module_param_cb(poll_queues, &poll_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues,
 		 "Number of poll queues used for r/w. Default value is 1");
 
+static int intr_aggr_cnt_set(const char *val, const struct kernel_param *kp)
+{
+	return param_set_uint_minmax(val, kp, 0, MCQ_INTR_AGGR_MAX_CNT);
+}
+
+static const struct kernel_param_ops intr_aggr_cnt_ops = {
+	.set = intr_aggr_cnt_set,
+	.get = param_get_uint,
+};
+
+static unsigned int intr_aggr_cnt;
+module_param_cb(intr_aggr_cnt, &intr_aggr_cnt_ops, &intr_aggr_cnt, 0444);
+MODULE_PARM_DESC(intr_aggr_cnt,
+		 "Completions per interrupt on interrupt driven queues. Default value is 0 (aggregation disabled)");
+
+static int intr_aggr_timeout_set(const char *val,
+				 const struct kernel_param *kp)
+{
+	return param_set_uint_minmax(val, kp, 1, MCQ_INTR_AGGR_MAX_TMO);
+}
+
+static const struct kernel_param_ops intr_aggr_timeout_ops = {
+	.set = intr_aggr_timeout_set,
+	.get = param_get_uint,
+};
+
+static unsigned int intr_aggr_timeout = 2;
+module_param_cb(intr_aggr_timeout, &intr_aggr_timeout_ops,
+		&intr_aggr_timeout, 0444);
+MODULE_PARM_DESC(intr_aggr_timeout,
+		 "Interrupt aggregation timeout in 40us units. Default value is 2");
+
 /**
  * ufshcd_mcq_config_mac - Set the #Max Activ Cmds.
  * @hba: per adapter instance
@@ -305,6 +342,33 @@ void ufshcd_mcq_compl_all_cqes_lock(struct ufs_hba *hba,
 	spin_unlock_irqrestore(&hwq->cq_lock, flags);
 }
 
+static bool ufshcd_mcq_intr_aggr_enabled(struct ufs_hba *hba,
+					 struct ufs_hw_queue *hwq)
+{
+	return intr_aggr_cnt &&
+	       hwq->id < hba->nr_hw_queues - hba->nr_queues[HCTX_TYPE_POLL];
+}
+
+static void ufshcd_mcq_config_intr_aggr(struct ufs_hba *hba,
+					struct ufs_hw_queue *hwq)
+{
+	if (!ufshcd_mcq_intr_aggr_enabled(hba, hwq))
+		return;
+
+	writel(INT_AGGR_ENABLE | INT_AGGR_PARAM_WRITE |
+	       INT_AGGR_COUNTER_AND_TIMER_RESET |
+	       INT_AGGR_COUNTER_THLD_VAL(intr_aggr_cnt) |
+	       INT_AGGR_TIMEOUT_VAL(intr_aggr_timeout),
+	       mcq_opr_base(hba, OPR_CQIS, hwq->id) + REG_CQ_IACR);
+}
+
+static void ufshcd_mcq_reset_intr_aggr(struct ufs_hba *hba,
+				       struct ufs_hw_queue *hwq)
+{
+	writel(INT_AGGR_ENABLE | INT_AGGR_COUNTER_AND_TIMER_RESET,
+	       mcq_opr_base(hba, OPR_CQIS, hwq->id) + REG_CQ_IACR);
+}
+
 unsigned long ufshcd_mcq_poll_cqe_lock(struct ufs_hba *hba,
 				       struct ufs_hw_queue *hwq)
 {
@@ -319,8 +383,12 @@ unsigned long ufshcd_mcq_poll_cqe_lock(struct ufs_hba *hba,
 		completed_reqs++;
 	}
 
-	if (completed_reqs)
+	if (completed_reqs) {
 		ufshcd_mcq_update_cq_head(hwq);
+		/* Restart the aggregation counter and timer for the next batch */
+		if (ufshcd_mcq_intr_aggr_enabled(hba, hwq))
+			ufshcd_mcq_reset_intr_aggr(hba, hwq);
+	}
 	spin_unlock_irqrestore(&hwq->cq_lock, flags);
 
 	return completed_reqs;
@@ -374,8 +442,10 @@ void ufshcd_mcq_make_queues_operational(struct ufs_hba *hba)
 		hwq->sq_tail_slot = hwq->cq_tail_slot = hwq->cq_head_slot = 0;
 
 		/* Enable Tail Entry Push Status interrupt only for non-poll queues */
-		if (i < hba->nr_hw_queues - hba->nr_queues[HCTX_TYPE_POLL])
+		if (i < hba->nr_hw_queues - hba->nr_queues[HCTX_TYPE_POLL]) {
 			writel(1, mcq_opr_base(hba, OPR_CQIS, i) + REG_CQIE);
+			ufshcd_mcq_config_intr_aggr(hba, hwq);
+		}
 
 		/* Completion Queue Enable|Size to Completion Queue Attribute */
 		ufsmcq_writel(hba, (1 << QUEUE_EN_OFFSET) | qsize,
@@ -110,6 +110,49 @@ static bool is_mcq_supported(struct ufs_hba *hba)
 module_param(use_mcq_mode, bool, 0644);
 MODULE_PARM_DESC(use_mcq_mode, "Control MCQ mode for controllers starting from UFSHCI 4.0. 1 - enable MCQ, 0 - disable MCQ. MCQ is enabled by default");
 
+/*
+ * Clock scaling boost. Devfreq only looks at busy time once per polling
+ * window, so a burst of requests arriving at low gear waits up to a full
+ * window before the clocks ramp up. When the number of outstanding requests
+ * reaches clkscale_boost_depth, or a request completes slower than
+ * clkscale_boost_lat_us while others are queued behind it, re-evaluate devfreq
+ * right away and report full load for clkscale_boost_hold_ms so the governor
+ * doesn't scale back down on the next quiet window.
+ */
+static unsigned int clkscale_boost_depth;
+module_param(clkscale_boost_depth, uint, 0644);
+MODULE_PARM_DESC(clkscale_boost_depth, "Outstanding requests that trigger an immediate clock scale up. 0 (default) disables");
+
+static unsigned int clkscale_boost_lat_us;
+module_param(clkscale_boost_lat_us, uint, 0644);
+MODULE_PARM_DESC(clkscale_boost_lat_us, "Completion latency in microseconds that triggers an immediate clock scale up. 0 (default) disables");
+
+static unsigned int clkscale_boost_hold_ms = 100;
+module_param(clkscale_boost_hold_ms, uint, 0644);
+MODULE_PARM_DESC(clkscale_boost_hold_ms, "Minimum time in milliseconds clocks stay scaled up after a boost. Default is 100");
+
+enum {
+	UFS_CLK_BOOST_PENDING,
+};
+
+struct ufs_clk_boost {
+	struct ufs_hba		*hba;
+	struct work_struct	work;
+	unsigned long		flags;
+	unsigned long		hold_until;
+};
+
+/* SCSI host private data, as returned by shost_priv() */
+struct ufs_hba_priv {
+	struct ufs_hba		hba;
+	struct ufs_clk_boost	clk_boost;
+};
+
+static inline struct ufs_clk_boost *ufshcd_clk_boost(struct ufs_hba *hba)
+{
+	return &container_of(hba, struct ufs_hba_priv, hba)->clk_boost;
+}
+
 #define ufshcd_toggle_vreg(_dev, _vreg, _on)				\
 	({                                                              \
 		int _ret;                                               \
@@ -1495,6 +1538,47 @@ static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 	devfreq_resume_device(hba->devfreq);
 }
 
+static bool ufshcd_clk_scaling_at_max(struct ufs_hba *hba)
+{
+	struct ufs_clk_info *clki;
+
+	if (list_empty(&hba->clk_list_head))
+		return true;
+	/* With OPPs the max is not known here, let devfreq figure it out */
+	if (hba->use_pm_opp)
+		return false;
+
+	clki = list_first_entry(&hba->clk_list_head, struct ufs_clk_info, list);
+	return clki->curr_freq == clki->max_freq;
+}
+
+static void ufshcd_clk_boost_kick(struct ufs_hba *hba)
+{
+	struct ufs_clk_boost *boost = ufshcd_clk_boost(hba);
+
+	if (!hba->clk_scaling.is_enabled || ufshcd_clk_scaling_at_max(hba))
+		return;
+
+	if (!test_and_set_bit(UFS_CLK_BOOST_PENDING, &boost->flags))
+		queue_work(hba->clk_scaling.workq, &boost->work);
+}
+
+static void ufshcd_clk_boost_work(struct work_struct *work)
+{
+	struct ufs_clk_boost *boost = container_of(work, struct ufs_clk_boost,
+						   work);
+	struct ufs_hba *hba = boost->hba;
+	struct devfreq *devfreq = hba->devfreq;
+
+	/* resume_work runs first on the same ordered workqueue */
+	if (devfreq && !hba->clk_scaling.is_suspended) {
+		mutex_lock(&devfreq->lock);
+		update_devfreq(devfreq);
+		mutex_unlock(&devfreq->lock);
+	}
+	clear_bit(UFS_CLK_BOOST_PENDING, &boost->flags);
+}
+
 static int ufshcd_devfreq_target(struct device *dev,
 				unsigned long *freq, u32 flags)
 {
@@ -1578,6 +1662,7 @@ static int ufshcd_devfreq_get_dev_status(struct device *dev,
 {
 	struct ufs_hba *hba = dev_get_drvdata(dev);
 	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	struct ufs_clk_boost *boost;
 	unsigned long flags;
 	ktime_t curr_t;
 
@@ -1611,6 +1696,15 @@ static int ufshcd_devfreq_get_dev_status(struct device *dev,
 				scaling->busy_start_t);
 	stat->total_time = ktime_us_delta(curr_t, scaling->window_start_t);
 	stat->busy_time = scaling->tot_busy_t;
+
+	boost = ufshcd_clk_boost(hba);
+	if (test_bit(UFS_CLK_BOOST_PENDING, &boost->flags) ||
+	    (clkscale_boost_depth &&
+	     scaling->active_reqs >= clkscale_boost_depth))
+		boost->hold_until = jiffies +
+				    msecs_to_jiffies(clkscale_boost_hold_ms);
+	if (time_before(jiffies, boost->hold_until))
+		stat->busy_time = stat->total_time;
 start_window:
 	scaling->window_start_t = curr_t;
 	scaling->tot_busy_t = 0;
@@ -1701,6 +1795,8 @@ static void ufshcd_suspend_clkscaling(struct ufs_hba *hba)
 
 	cancel_work_sync(&hba->clk_scaling.suspend_work);
 	cancel_work_sync(&hba->clk_scaling.resume_work);
+	cancel_work_sync(&ufshcd_clk_boost(hba)->work);
+	clear_bit(UFS_CLK_BOOST_PENDING, &ufshcd_clk_boost(hba)->flags);
 
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	if (!hba->clk_scaling.is_suspended) {
@@ -1810,6 +1906,9 @@ static void ufshcd_init_clk_scaling(struct ufs_hba *hba)
 		  ufshcd_clk_scaling_suspend_work);
 	INIT_WORK(&hba->clk_scaling.resume_work,
 		  ufshcd_clk_scaling_resume_work);
+	ufshcd_clk_boost(hba)->hba = hba;
+	ufshcd_clk_boost(hba)->hold_until = jiffies;
+	INIT_WORK(&ufshcd_clk_boost(hba)->work, ufshcd_clk_boost_work);
 
 	snprintf(wq_name, sizeof(wq_name), "ufs_clkscaling_%d",
 		 hba->host->host_no);
@@ -2209,6 +2308,10 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 		hba->clk_scaling.busy_start_t = curr_t;
 		hba->clk_scaling.is_busy_started = true;
 	}
+
+	if (clkscale_boost_depth &&
+	    hba->clk_scaling.active_reqs == clkscale_boost_depth)
+		ufshcd_clk_boost_kick(hba);
 	spin_unlock_irqrestore(hba->host->host_lock, flags);
 }
 
@@ -5543,6 +5646,12 @@ void ufshcd_compl_one_cqe(struct ufs_hba *hba, int task_tag,
 	if (cmd) {
 		if (unlikely(ufshcd_should_inform_monitor(hba, lrbp)))
 			ufshcd_update_monitor(hba, lrbp);
+		if (clkscale_boost_lat_us &&
+		    ufshcd_is_clkscaling_supported(hba) &&
+		    READ_ONCE(hba->clk_scaling.active_reqs) > 1 &&
+		    ktime_us_delta(lrbp->compl_time_stamp,
+				   lrbp->issue_time_stamp) >= clkscale_boost_lat_us)
+			ufshcd_clk_boost_kick(hba);
 		ufshcd_add_command_trace(hba, task_tag, UFS_CMD_COMP);
 		cmd->result = ufshcd_transfer_rsp_status(hba, lrbp, cqe);
 		ufshcd_release_scsi_cmd(hba, lrbp);
@@ -10374,7 +10483,7 @@ int ufshcd_alloc_host(struct device *dev, struct ufs_hba **hba_handle)
 	}
 
 	host = scsi_host_alloc(&ufshcd_driver_template,
-				sizeof(struct ufs_hba));
+				sizeof(struct ufs_hba_priv));
 	if (!host) {
 		dev_err(dev, "scsi_host_alloc failed\n");
 		err = -ENOMEM;
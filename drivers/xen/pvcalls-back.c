@@ -789,7 +789,7 @@ static int pvcalls_back_poll(struct xenbus_device *dev,
 	mappass->reqcopy = *req;
 	icsk = inet_csk(mappass->sock->sk);
 	queue = &icsk->icsk_accept_queue;
-	data = READ_ONCE(queue->rskq_accept_head) != NULL;
+	data = !reqsk_queue_empty(queue);
 	if (data) {
 		mappass->reqcopy.cmd = 0;
 		ret = 0;
@@ -70,6 +70,8 @@ enum {
 };
 
 /* in memory btrfs inode */
+struct btrfs_csum_cache;
+
 struct btrfs_inode {
 	/* which subvolume this inode belongs to */
 	struct btrfs_root *root;
@@ -218,6 +220,16 @@ struct btrfs_inode {
 	 */
 	u64 csum_bytes;
 
+	/*
+	 * Checksums prefetched for sequential reads, the disk bytenr right
+	 * after the last read looked up and a sequence bumped whenever the
+	 * cache is dropped, see btrfs_lookup_bio_sums().
+	 * Protected by the lock above.
+	 */
+	struct btrfs_csum_cache *csum_cache;
+	u64 csum_next_bytenr;
+	u64 csum_cache_seq;
+
 	/* Backwards incompatible flags, lower half of inode_item::flags  */
 	u32 flags;
 	/* Read-only compatibility flags, upper half of inode_item::flags */
@@ -1904,6 +1904,114 @@ static struct extent_buffer *btrfs_search_slot_get_root(struct btrfs_root *root,
 	return b;
 }
 
+/*
+ * Optimistically step through the root node of a read-only search without
+ * locking it, as every search of a tree otherwise takes the root's lock and
+ * that becomes the point of contention with many concurrent readers.
+ *
+ * The slot in the root is picked without the lock and then validated with the
+ * root's lock_seq after read locking the child: if no writer locked the root
+ * meanwhile, neither the root nor its pointer to the child can have changed.
+ * Only children that are cached and uptodate are used. On success the root is
+ * left unlocked in the path and the read locked child is returned, otherwise
+ * NULL is returned and the caller falls back to the regular locked descent.
+ *
+ * As a writer may be changing the root under us, nothing read from it can be
+ * trusted before the lock_seq check: the header is sanity checked and the
+ * slot is found with a search bounded by the node capacity rather than with
+ * btrfs_bin_search(), which trusts nritems and the level.
+ */
+static struct extent_buffer *btrfs_search_slot_root_nolock(struct btrfs_root *root,
+							    struct btrfs_path *p,
+							    const struct btrfs_key *key,
+							    int *prev_cmp)
+{
+	struct btrfs_fs_info *fs_info = root->fs_info;
+	struct extent_buffer *b;
+	struct extent_buffer *child;
+	struct btrfs_key first_key;
+	unsigned int seq;
+	u64 blocknr;
+	u64 gen;
+	u32 low, high;
+	int level;
+	int slot;
+	int ret = 1;
+
+	b = btrfs_root_node(root);
+	seq = raw_read_seqcount(&b->lock_seq);
+	if (seq & 1)
+		goto out_free;
+
+	level = btrfs_header_level(b);
+	if (level == 0 || level >= BTRFS_MAX_LEVEL || !extent_buffer_uptodate(b))
+		goto out_free;
+	if (btrfs_header_bytenr(b) != b->start ||
+	    btrfs_header_owner(b) != btrfs_root_id(root))
+		goto out_free;
+
+	low = 0;
+	high = min_t(u32, btrfs_header_nritems(b),
+		     BTRFS_NODEPTRS_PER_BLOCK(fs_info));
+	if (high == 0)
+		goto out_free;
+
+	while (low < high) {
+		struct btrfs_disk_key disk_key;
+		u32 mid = (low + high) / 2;
+		int cmp;
+
+		btrfs_node_key(b, &disk_key, mid);
+		cmp = comp_keys(&disk_key, key);
+		if (cmp < 0) {
+			low = mid + 1;
+		} else if (cmp > 0) {
+			high = mid;
+		} else {
+			low = mid;
+			ret = 0;
+			break;
+		}
+	}
+	slot = low;
+	if (ret && slot > 0)
+		slot--;
+
+	blocknr = btrfs_node_blockptr(b, slot);
+	gen = btrfs_node_ptr_generation(b, slot);
+	btrfs_node_key_to_cpu(b, &first_key, slot);
+	if (read_seqcount_retry(&b->lock_seq, seq))
+		goto out_free;
+
+	child = find_extent_buffer(fs_info, blocknr);
+	if (!child)
+		goto out_free;
+	if (btrfs_buffer_uptodate(child, gen, 1) <= 0)
+		goto out_free_child;
+
+	btrfs_maybe_reset_lockdep_class(root, child);
+	btrfs_tree_read_lock(child);
+	if (read_seqcount_retry(&b->lock_seq, seq) ||
+	    rcu_access_pointer(root->node) != b ||
+	    btrfs_verify_level_key(child, level - 1, &first_key, gen)) {
+		btrfs_tree_read_unlock(child);
+		goto out_free_child;
+	}
+
+	p->nodes[level] = b;
+	p->slots[level] = slot;
+	p->nodes[level - 1] = child;
+	p->locks[level - 1] = BTRFS_READ_LOCK;
+	*prev_cmp = ret;
+	return child;
+
+out_free_child:
+	free_extent_buffer(child);
+out_free:
+	free_extent_buffer(b);
+	return NULL;
+}
+
 /*
  * Replace the extent buffer at the lowest level of the path with a cloned
  * version. The purpose is to be able to use it safely, after releasing the
@@ -2137,6 +2245,7 @@ int btrfs_search_slot(struct btrfs_trans_handle *trans, struct btrfs_root *root,
 	u8 lowest_level = 0;
 	int min_write_lock_level;
 	int prev_cmp;
+	bool nolock_root;
 
 	might_sleep();
 
@@ -2176,6 +2285,10 @@ int btrfs_search_slot(struct btrfs_trans_handle *trans, struct btrfs_root *root,
 
 	min_write_lock_level = write_lock_level;
 
+	/* plain lookups may step through the root node without locking it */
+	nolock_root = !cow && !lowest_level && !p->keep_locks &&
+		      !p->skip_locking && !p->nowait && !p->search_commit_root;
+
 	if (p->need_commit_sem) {
 		ASSERT(p->search_commit_root);
 		if (p->nowait) {
@@ -2188,7 +2301,14 @@ int btrfs_search_slot(struct btrfs_trans_handle *trans, struct btrfs_root *root,
 
 again:
 	prev_cmp = -1;
-	b = btrfs_search_slot_get_root(root, p, write_lock_level);
+	b = NULL;
+	if (nolock_root) {
+		/* only try once, retries take the locks from the start */
+		nolock_root = false;
+		b = btrfs_search_slot_root_nolock(root, p, key, &prev_cmp);
+	}
+	if (!b)
+		b = btrfs_search_slot_get_root(root, p, write_lock_level);
 	if (IS_ERR(b)) {
 		ret = PTR_ERR(b);
 		goto done;
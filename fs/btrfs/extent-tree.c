@@ -2145,6 +2145,7 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 	struct rb_node *node;
 	struct btrfs_delayed_ref_root *delayed_refs;
 	struct btrfs_delayed_ref_head *head;
+	u64 start_ns;
 	int ret;
 	int run_all = count == (unsigned long)-1;
 
@@ -2155,6 +2156,8 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 	if (test_bit(BTRFS_FS_CREATING_FREE_SPACE_TREE, &fs_info->flags))
 		return 0;
 
+	start_ns = ktime_get_ns();
+
 	delayed_refs = &trans->transaction->delayed_refs;
 	if (count == 0)
 		count = delayed_refs->num_heads_ready;
@@ -2192,6 +2195,8 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 		goto again;
 	}
 out:
+	if (trans->transaction->state == TRANS_STATE_COMMIT_DOING)
+		trans->transaction->delayed_refs_dur += ktime_get_ns() - start_ns;
 	return 0;
 }
 
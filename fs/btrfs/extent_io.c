@@ -3397,6 +3397,7 @@ __alloc_extent_buffer(struct btrfs_fs_info *fs_info, u64 start,
 	eb->len = len;
 	eb->fs_info = fs_info;
 	init_rwsem(&eb->lock);
+	seqcount_init(&eb->lock_seq);
 
 	btrfs_leak_debug_add_eb(eb);
 
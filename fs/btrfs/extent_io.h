@@ -5,6 +5,7 @@
 
 #include <linux/rbtree.h>
 #include <linux/refcount.h>
+#include <linux/seqlock.h>
 #include <linux/fiemap.h>
 #include <linux/btrfs_tree.h>
 #include "compression.h"
@@ -86,6 +87,11 @@ struct extent_buffer {
 	s8 log_index;
 
 	struct rw_semaphore lock;
+	/*
+	 * Odd while the eb is write locked, bumped on every write lock and
+	 * unlock. Lets readers validate content read without the lock.
+	 */
+	seqcount_t lock_seq;
 
 	struct page *pages[INLINE_EXTENT_BUFFER_PAGES];
 #ifdef CONFIG_BTRFS_DEBUG
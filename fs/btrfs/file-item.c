@@ -336,6 +336,130 @@ static int search_csum_tree(struct btrfs_fs_info *fs_info,
 	return ret;
 }
 
+/*
+ * Per inode cache of checksums read ahead of a sequential stream of reads, so
+ * that following bios don't each have to search the csum tree again.
+ *
+ * The checksum of a disk bytenr can only change after its extent was freed
+ * and reallocated, and the inode can only start reading the new extent after
+ * its file extent items were changed.  Every such change goes through
+ * btrfs_drop_extents() or relocation, which drop the cache, so the cache only
+ * has to be invalidated per inode.  The cache is also dropped when the stream
+ * ends or the file is released, so it does not linger on idle inodes.
+ */
+#define BTRFS_CSUM_CACHE_SIZE		PAGE_SIZE
+
+struct btrfs_csum_cache {
+	u64 start;
+	u32 nr_sectors;
+	u8 csums[];
+};
+
+void btrfs_free_csum_cache(struct btrfs_inode *inode)
+{
+	struct btrfs_csum_cache *cache;
+
+	spin_lock(&inode->lock);
+	cache = inode->csum_cache;
+	inode->csum_cache = NULL;
+	inode->csum_cache_seq++;
+	spin_unlock(&inode->lock);
+	kfree(cache);
+}
+
+/*
+ * Copy the checksums for [@disk_bytenr, @disk_bytenr + @len) from the csum
+ * cache of @inode, refilling the cache first if this read continues the
+ * previous one.
+ *
+ * Return true if all the checksums were copied to @dst, false if the caller
+ * has to search the csum tree.
+ */
+static bool lookup_csum_cache(struct btrfs_inode *inode, struct btrfs_path *path,
+			      u64 disk_bytenr, u32 len, u8 *dst)
+{
+	struct btrfs_fs_info *fs_info = inode->root->fs_info;
+	const u32 csum_size = fs_info->csum_size;
+	const u32 bits = fs_info->sectorsize_bits;
+	const u32 nblocks = len >> bits;
+	const u32 max_sectors = (BTRFS_CSUM_CACHE_SIZE -
+				 sizeof(struct btrfs_csum_cache)) / csum_size;
+	struct btrfs_csum_cache *cache;
+	struct btrfs_csum_cache *old = NULL;
+	int orig_reada = path->reada;
+	u32 filled = 0;
+	bool sequential;
+	bool found;
+	u64 seq;
+
+	/* Reads that big get their own csum tree readahead anyway. */
+	if (nblocks > max_sectors)
+		return false;
+
+	spin_lock(&inode->lock);
+	sequential = (inode->csum_next_bytenr == disk_bytenr);
+	inode->csum_next_bytenr = disk_bytenr + len;
+	/* Sampled before searching, catches an invalidation racing the fill. */
+	seq = inode->csum_cache_seq;
+	cache = inode->csum_cache;
+	found = cache && disk_bytenr >= cache->start &&
+		disk_bytenr + len <= cache->start + ((u64)cache->nr_sectors << bits);
+	if (found) {
+		memcpy(dst, cache->csums +
+		       ((disk_bytenr - cache->start) >> bits) * csum_size,
+		       nblocks * csum_size);
+	} else if (!sequential) {
+		/* The stream ended, don't keep its checksums around. */
+		old = cache;
+		inode->csum_cache = NULL;
+	}
+	spin_unlock(&inode->lock);
+	kfree(old);
+
+	if (found || !sequential)
+		return found;
+
+	cache = kmalloc(BTRFS_CSUM_CACHE_SIZE, GFP_NOFS);
+	if (!cache)
+		return false;
+	cache->start = disk_bytenr;
+
+	path->reada = READA_FORWARD;
+	while (filled < max_sectors) {
+		int count;
+
+		count = search_csum_tree(fs_info, path,
+					 disk_bytenr + ((u64)filled << bits),
+					 (u64)(max_sectors - filled) << bits,
+					 cache->csums + filled * csum_size);
+		if (count <= 0)
+			break;
+		filled += count;
+	}
+	btrfs_release_path(path);
+	path->reada = orig_reada;
+
+	/* Leave holes and errors to the regular lookup, it reports them. */
+	if (filled < nblocks) {
+		kfree(cache);
+		return false;
+	}
+	cache->nr_sectors = filled;
+	memcpy(dst, cache->csums, nblocks * csum_size);
+
+	spin_lock(&inode->lock);
+	if (inode->csum_cache_seq == seq) {
+		old = inode->csum_cache;
+		inode->csum_cache = cache;
+		cache = NULL;
+	}
+	spin_unlock(&inode->lock);
+	kfree(old);
+	kfree(cache);
+
+	return true;
+}
+
 /*
  * Lookup the checksum for the read bio in csum tree.
  *
@@ -402,6 +526,10 @@ blk_status_t btrfs_lookup_bio_sums(struct btrfs_bio *bbio)
 	if (btrfs_is_free_space_inode(inode)) {
 		path->search_commit_root = 1;
 		path->skip_locking = 1;
+	} else if (inode->root->root_key.objectid != BTRFS_DATA_RELOC_TREE_OBJECTID &&
+		   lookup_csum_cache(inode, path, orig_disk_bytenr, orig_len,
+				     bbio->csum)) {
+		bio_offset = orig_len;
 	}
 
 	while (bio_offset < orig_len) {
@@ -39,6 +39,7 @@ static inline u32 btrfs_file_extent_calc_inline_size(u32 datasize)
 int btrfs_del_csums(struct btrfs_trans_handle *trans,
 		    struct btrfs_root *root, u64 bytenr, u64 len);
 blk_status_t btrfs_lookup_bio_sums(struct btrfs_bio *bbio);
+void btrfs_free_csum_cache(struct btrfs_inode *inode);
 int btrfs_insert_hole_extent(struct btrfs_trans_handle *trans,
 			     struct btrfs_root *root, u64 objectid, u64 pos,
 			     u64 num_bytes);
@@ -227,6 +227,9 @@ int btrfs_drop_extents(struct btrfs_trans_handle *trans,
 	args->bytes_found = 0;
 	args->extent_inserted = false;
 
+	/* The range may get new disk extents, see btrfs_lookup_bio_sums(). */
+	btrfs_free_csum_cache(inode);
+
 	/* Must always have a path if ->replace_extent is true */
 	ASSERT(!(args->replace_extent && !args->path));
 
@@ -1711,6 +1714,8 @@ int btrfs_release_file(struct inode *inode, struct file *filp)
 		filp->private_data = NULL;
 	}
 
+	btrfs_free_csum_cache(BTRFS_I(inode));
+
 	/*
 	 * Set by setattr when we are about to truncate a file from a non-zero
 	 * size to a zero size.  This tries to flush down new bytes that may
@@ -1950,8 +1955,11 @@ int btrfs_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
 
 	/* We successfully logged the inode, attempt to sync the log. */
 	if (!ret) {
+		u64 start_ns = ktime_get_ns();
+
 		ret = btrfs_sync_log(trans, root, &ctx);
 		if (!ret) {
+			btrfs_update_log_sync_lat(fs_info, ktime_get_ns() - start_ns);
 			ret = btrfs_end_transaction(trans);
 			goto out;
 		}
@@ -356,6 +356,35 @@ struct btrfs_commit_stats {
 	u64 last_commit_dur;
 	/* The total commit duration in ns */
 	u64 total_commit_dur;
+	/*
+	 * Time spent running delayed refs in the critical section of the
+	 * commit, last, maximum and total in ns.
+	 */
+	u64 last_delayed_refs_dur;
+	u64 max_delayed_refs_dur;
+	u64 total_delayed_refs_dur;
+};
+
+/*
+ * Buckets of the fsync log sync latency histogram, bucket i counts syncs that
+ * took less than 64us << (2 * i), the last one everything slower.
+ */
+#define BTRFS_LOG_SYNC_LAT_BUCKETS	8
+
+/*
+ * Log commits of different roots and fsyncs run concurrently, so the counters
+ * are atomic. Only avg_commit_dur is updated under fs_info->tree_log_mutex.
+ */
+struct btrfs_log_stats {
+	/* Number of log commits that wrote the super block */
+	atomic64_t commit_count;
+	/* Number of fsyncs completed by those commits */
+	atomic64_t fsync_count;
+	/* The largest number of fsyncs completed by a single log commit */
+	atomic64_t max_batch;
+	/* Running average of the log commit duration in ns */
+	u64 avg_commit_dur;
+	atomic64_t sync_lat[BTRFS_LOG_SYNC_LAT_BUCKETS];
 };
 
 struct btrfs_fs_info {
@@ -780,6 +809,7 @@ struct btrfs_fs_info {
 
 	/* Updates are not protected by any lock */
 	struct btrfs_commit_stats commit_stats;
+	struct btrfs_log_stats log_stats;
 
 	/*
 	 * Last generation where we dropped a non-relocation root.
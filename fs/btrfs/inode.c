@@ -8521,6 +8521,9 @@ struct inode *btrfs_alloc_inode(struct super_block *sb)
 	ei->flags = 0;
 	ei->ro_flags = 0;
 	ei->csum_bytes = 0;
+	ei->csum_cache = NULL;
+	ei->csum_next_bytenr = 0;
+	ei->csum_cache_seq = 0;
 	ei->index_cnt = (u64)-1;
 	ei->dir_index = 0;
 	ei->last_unlink_trans = 0;
@@ -8624,6 +8627,7 @@ void btrfs_destroy_inode(struct inode *vfs_inode)
 	inode_tree_del(inode);
 	btrfs_drop_extent_map_range(inode, 0, (u64)-1, false);
 	btrfs_inode_clear_file_extent_range(inode, 0, (u64)-1);
+	btrfs_free_csum_cache(inode);
 	btrfs_put_root(inode->root);
 }
 
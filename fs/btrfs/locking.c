@@ -165,6 +165,7 @@ int btrfs_try_tree_write_lock(struct extent_buffer *eb)
 {
 	if (down_write_trylock(&eb->lock)) {
 		eb->lock_owner = current->pid;
+		raw_write_seqcount_begin(&eb->lock_seq);
 		trace_btrfs_try_tree_write_lock(eb);
 		return 1;
 	}
@@ -197,6 +198,7 @@ void __btrfs_tree_lock(struct extent_buffer *eb, enum btrfs_lock_nesting nest)
 
 	down_write_nested(&eb->lock, nest);
 	eb->lock_owner = current->pid;
+	raw_write_seqcount_begin(&eb->lock_seq);
 	trace_btrfs_tree_lock(eb, start_ns);
 }
 
@@ -212,6 +214,7 @@ void btrfs_tree_unlock(struct extent_buffer *eb)
 {
 	trace_btrfs_tree_unlock(eb);
 	eb->lock_owner = 0;
+	raw_write_seqcount_end(&eb->lock_seq);
 	up_write(&eb->lock);
 }
 
@@ -1139,6 +1139,7 @@ int replace_file_extents(struct btrfs_trans_handle *trans,
 
 				btrfs_drop_extent_map_range(BTRFS_I(inode),
 							    key.offset, end, true);
+				btrfs_free_csum_cache(BTRFS_I(inode));
 				unlock_extent(&BTRFS_I(inode)->io_tree,
 					      key.offset, end, &cached_state);
 			}
@@ -1583,6 +1584,7 @@ static int invalidate_extent_cache(struct btrfs_root *root,
 		/* the lock_extent waits for read_folio to complete */
 		lock_extent(&BTRFS_I(inode)->io_tree, start, end, &cached_state);
 		btrfs_drop_extent_map_range(BTRFS_I(inode), start, end, true);
+		btrfs_free_csum_cache(BTRFS_I(inode));
 		unlock_extent(&BTRFS_I(inode)->io_tree, start, end, &cached_state);
 	}
 	return 0;
@@ -1046,11 +1046,17 @@ static ssize_t btrfs_commit_stats_show(struct kobject *kobj,
 		"commits %llu\n"
 		"last_commit_ms %llu\n"
 		"max_commit_ms %llu\n"
-		"total_commit_ms %llu\n",
+		"total_commit_ms %llu\n"
+		"last_delayed_refs_ms %llu\n"
+		"max_delayed_refs_ms %llu\n"
+		"total_delayed_refs_ms %llu\n",
 		fs_info->commit_stats.commit_count,
 		div_u64(fs_info->commit_stats.last_commit_dur, NSEC_PER_MSEC),
 		div_u64(fs_info->commit_stats.max_commit_dur, NSEC_PER_MSEC),
-		div_u64(fs_info->commit_stats.total_commit_dur, NSEC_PER_MSEC));
+		div_u64(fs_info->commit_stats.total_commit_dur, NSEC_PER_MSEC),
+		div_u64(fs_info->commit_stats.last_delayed_refs_dur, NSEC_PER_MSEC),
+		div_u64(fs_info->commit_stats.max_delayed_refs_dur, NSEC_PER_MSEC),
+		div_u64(fs_info->commit_stats.total_delayed_refs_dur, NSEC_PER_MSEC));
 }
 
 static ssize_t btrfs_commit_stats_store(struct kobject *kobj,
@@ -1074,11 +1080,66 @@ static ssize_t btrfs_commit_stats_store(struct kobject *kobj,
 		return -EINVAL;
 
 	WRITE_ONCE(fs_info->commit_stats.max_commit_dur, 0);
+	WRITE_ONCE(fs_info->commit_stats.max_delayed_refs_dur, 0);
 
 	return len;
 }
 BTRFS_ATTR_RW(, commit_stats, btrfs_commit_stats_show, btrfs_commit_stats_store);
 
+static ssize_t btrfs_log_stats_show(struct kobject *kobj,
+				    struct kobj_attribute *a, char *buf)
+{
+	struct btrfs_fs_info *fs_info = to_fs_info(kobj);
+	struct btrfs_log_stats *stats = &fs_info->log_stats;
+	ssize_t ret;
+	int i;
+
+	ret = sysfs_emit(buf,
+			 "log_commits %llu\n"
+			 "log_fsyncs %llu\n"
+			 "max_batch %llu\n"
+			 "avg_log_commit_us %llu\n",
+			 atomic64_read(&stats->commit_count),
+			 atomic64_read(&stats->fsync_count),
+			 atomic64_read(&stats->max_batch),
+			 div_u64(READ_ONCE(stats->avg_commit_dur), NSEC_PER_USEC));
+
+	for (i = 0; i < BTRFS_LOG_SYNC_LAT_BUCKETS - 1; i++)
+		ret += sysfs_emit_at(buf, ret, "sync_lat_lt_%uus %llu\n",
+				     64U << (2 * i),
+				     atomic64_read(&stats->sync_lat[i]));
+	ret += sysfs_emit_at(buf, ret, "sync_lat_ge_%uus %llu\n",
+			     64U << (2 * i), atomic64_read(&stats->sync_lat[i]));
+
+	return ret;
+}
+
+static ssize_t btrfs_log_stats_store(struct kobject *kobj,
+				     struct kobj_attribute *a,
+				     const char *buf, size_t len)
+{
+	struct btrfs_fs_info *fs_info = to_fs_info(kobj);
+	unsigned long val;
+	int ret;
+
+	if (!fs_info)
+		return -EPERM;
+
+	if (!capable(CAP_SYS_RESOURCE))
+		return -EPERM;
+
+	ret = kstrtoul(buf, 10, &val);
+	if (ret)
+		return ret;
+	if (val)
+		return -EINVAL;
+
+	atomic64_set(&fs_info->log_stats.max_batch, 0);
+
+	return len;
+}
+BTRFS_ATTR_RW(, log_stats, btrfs_log_stats_show, btrfs_log_stats_store);
+
 static ssize_t btrfs_clone_alignment_show(struct kobject *kobj,
 				struct kobj_attribute *a, char *buf)
 {
@@ -1302,6 +1363,7 @@ static const struct attribute *btrfs_attrs[] = {
 	BTRFS_ATTR_PTR(, read_policy),
 	BTRFS_ATTR_PTR(, bg_reclaim_threshold),
 	BTRFS_ATTR_PTR(, commit_stats),
+	BTRFS_ATTR_PTR(, log_stats),
 	NULL,
 };
 
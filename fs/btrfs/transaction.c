@@ -349,6 +349,7 @@ static noinline int join_transaction(struct btrfs_fs_info *fs_info,
 	refcount_set(&cur_trans->use_count, 2);
 	cur_trans->flags = 0;
 	cur_trans->start_time = ktime_get_seconds();
+	cur_trans->delayed_refs_dur = 0;
 
 	memset(&cur_trans->delayed_refs, 0, sizeof(cur_trans->delayed_refs));
 
@@ -2137,13 +2138,19 @@ static void add_pending_snapshot(struct btrfs_trans_handle *trans)
 	list_add(&trans->pending_snapshot->list, &cur_trans->pending_snapshots);
 }
 
-static void update_commit_stats(struct btrfs_fs_info *fs_info, ktime_t interval)
+static void update_commit_stats(struct btrfs_fs_info *fs_info, ktime_t interval,
+				u64 delayed_refs_dur)
 {
 	fs_info->commit_stats.commit_count++;
 	fs_info->commit_stats.last_commit_dur = interval;
 	fs_info->commit_stats.max_commit_dur =
 			max_t(u64, fs_info->commit_stats.max_commit_dur, interval);
 	fs_info->commit_stats.total_commit_dur += interval;
+	fs_info->commit_stats.last_delayed_refs_dur = delayed_refs_dur;
+	fs_info->commit_stats.max_delayed_refs_dur =
+			max_t(u64, fs_info->commit_stats.max_delayed_refs_dur,
+			      delayed_refs_dur);
+	fs_info->commit_stats.total_delayed_refs_dur += delayed_refs_dur;
 }
 
 int btrfs_commit_transaction(struct btrfs_trans_handle *trans)
@@ -2154,6 +2161,7 @@ int btrfs_commit_transaction(struct btrfs_trans_handle *trans)
 	int ret;
 	ktime_t start_time;
 	ktime_t interval;
+	u64 delayed_refs_dur;
 
 	ASSERT(refcount_read(&trans->use_count) == 1);
 	btrfs_trans_state_lockdep_acquire(fs_info, BTRFS_LOCKDEP_TRANS_COMMIT_PREP);
@@ -2546,6 +2554,7 @@ int btrfs_commit_transaction(struct btrfs_trans_handle *trans)
 	list_del_init(&cur_trans->list);
 	spin_unlock(&fs_info->trans_lock);
 
+	delayed_refs_dur = cur_trans->delayed_refs_dur;
 	btrfs_put_transaction(cur_trans);
 	btrfs_put_transaction(cur_trans);
 
@@ -2563,7 +2572,7 @@ int btrfs_commit_transaction(struct btrfs_trans_handle *trans)
 
 	kmem_cache_free(btrfs_trans_handle_cachep, trans);
 
-	update_commit_stats(fs_info, interval);
+	update_commit_stats(fs_info, interval, delayed_refs_dur);
 
 	return ret;
 
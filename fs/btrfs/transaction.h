@@ -53,6 +53,11 @@ struct btrfs_transaction {
 	struct list_head list;
 	struct extent_io_tree dirty_pages;
 	time64_t start_time;
+	/*
+	 * Time in ns spent running delayed refs in the critical section of
+	 * the commit (TRANS_STATE_COMMIT_DOING), only updated by the committer.
+	 */
+	u64 delayed_refs_dur;
 	wait_queue_head_t writer_wait;
 	wait_queue_head_t commit_wait;
 	struct list_head pending_snapshots;
@@ -2835,16 +2835,92 @@ static inline void btrfs_remove_log_ctx(struct btrfs_root *root,
  * Invoked in log mutex context, or be sure there is no other task which
  * can access the list.
  */
-static inline void btrfs_remove_all_log_ctxs(struct btrfs_root *root,
-					     int index, int error)
+static inline int btrfs_remove_all_log_ctxs(struct btrfs_root *root,
+					    int index, int error)
 {
 	struct btrfs_log_ctx *ctx;
 	struct btrfs_log_ctx *safe;
+	int count = 0;
 
 	list_for_each_entry_safe(ctx, safe, &root->log_ctxs[index], list) {
 		list_del_init(&ctx->list);
 		ctx->log_ret = error;
+		count++;
 	}
+
+	return count;
+}
+
+/*
+ * Upper bound of the time a log commit waits for more fsyncs to join it on
+ * non-rotational devices.
+ */
+#define BTRFS_LOG_BATCH_MAX_WAIT_NS	(NSEC_PER_MSEC)
+
+/*
+ * Give the other tasks logging to the same root a chance to join the log
+ * commit we are about to start, so that one super block write and flush
+ * serves all of them.
+ *
+ * On rotating disks the commit is expensive enough that waiting a tick is
+ * always worth it. On SSDs wait for as long as a log commit takes on average,
+ * like jbd2 does: waiting longer than the commit itself costs more latency
+ * than it saves.
+ */
+static void btrfs_log_batch_wait(struct btrfs_fs_info *fs_info)
+{
+	ktime_t expires;
+	u64 wait;
+
+	if (!btrfs_test_opt(fs_info, SSD)) {
+		schedule_timeout_uninterruptible(1);
+		return;
+	}
+
+	wait = min_t(u64, READ_ONCE(fs_info->log_stats.avg_commit_dur),
+		     BTRFS_LOG_BATCH_MAX_WAIT_NS);
+	if (!wait)
+		return;
+
+	expires = ktime_add_ns(ktime_get(), wait);
+	set_current_state(TASK_UNINTERRUPTIBLE);
+	schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
+}
+
+static void btrfs_update_log_commit_stats(struct btrfs_fs_info *fs_info,
+					  u64 start_ns)
+{
+	struct btrfs_log_stats *stats = &fs_info->log_stats;
+	u64 dur = ktime_get_ns() - start_ns;
+
+	lockdep_assert_held(&fs_info->tree_log_mutex);
+
+	atomic64_inc(&stats->commit_count);
+	WRITE_ONCE(stats->avg_commit_dur, (dur + 3 * stats->avg_commit_dur) / 4);
+}
+
+static void btrfs_update_log_batch_stats(struct btrfs_fs_info *fs_info,
+					 int batch_size)
+{
+	struct btrfs_log_stats *stats = &fs_info->log_stats;
+	s64 max = atomic64_read(&stats->max_batch);
+
+	atomic64_add(batch_size, &stats->fsync_count);
+	do {
+		if (batch_size <= max)
+			break;
+	} while (!atomic64_try_cmpxchg(&stats->max_batch, &max, batch_size));
+}
+
+void btrfs_update_log_sync_lat(struct btrfs_fs_info *fs_info, u64 dur_ns)
+{
+	u64 us = div_u64(dur_ns, NSEC_PER_USEC);
+	int bucket = 0;
+
+	if (us >= 64)
+		bucket = min((ilog2(us) - 6) / 2 + 1,
+			     BTRFS_LOG_SYNC_LAT_BUCKETS - 1);
+	atomic64_inc(&fs_info->log_stats.sync_lat[bucket]);
 }
 
 /*
@@ -2875,6 +2951,8 @@ int btrfs_sync_log(struct btrfs_trans_handle *trans,
 	struct blk_plug plug;
 	u64 log_root_start;
 	u64 log_root_level;
+	u64 start_ns;
+	int batch_size;
 
 	mutex_lock(&root->log_mutex);
 	log_transid = ctx->log_transid;
@@ -2898,17 +2976,16 @@ int btrfs_sync_log(struct btrfs_trans_handle *trans,
 
 	while (1) {
 		int batch = atomic_read(&root->log_batch);
-		/* when we're on an ssd, just kick the log commit out */
-		if (!btrfs_test_opt(fs_info, SSD) &&
-		    test_bit(BTRFS_ROOT_MULTI_LOG_TASKS, &root->state)) {
+		if (test_bit(BTRFS_ROOT_MULTI_LOG_TASKS, &root->state)) {
 			mutex_unlock(&root->log_mutex);
-			schedule_timeout_uninterruptible(1);
+			btrfs_log_batch_wait(fs_info);
 			mutex_lock(&root->log_mutex);
 		}
 		wait_for_writer(root);
 		if (batch == atomic_read(&root->log_batch))
 			break;
 	}
+	start_ns = ktime_get_ns();
 
 	/* bail out if we need to do a full commit */
 	if (btrfs_need_log_full_commit(trans)) {
@@ -3121,6 +3198,8 @@ int btrfs_sync_log(struct btrfs_trans_handle *trans,
 	btrfs_set_super_log_root(fs_info->super_for_commit, log_root_start);
 	btrfs_set_super_log_root_level(fs_info->super_for_commit, log_root_level);
 	ret = write_all_supers(fs_info, 1);
+	if (!ret)
+		btrfs_update_log_commit_stats(fs_info, start_ns);
 	mutex_unlock(&fs_info->tree_log_mutex);
 	if (ret) {
 		btrfs_set_log_full_commit(trans);
@@ -3155,7 +3234,9 @@ int btrfs_sync_log(struct btrfs_trans_handle *trans,
 	cond_wake_up(&log_root_tree->log_commit_wait[index2]);
 out:
 	mutex_lock(&root->log_mutex);
-	btrfs_remove_all_log_ctxs(root, index1, ret);
+	batch_size = btrfs_remove_all_log_ctxs(root, index1, ret);
+	if (!ret)
+		btrfs_update_log_batch_stats(fs_info, batch_size);
 	root->log_transid_committed++;
 	atomic_set(&root->log_commit[index1], 0);
 	mutex_unlock(&root->log_mutex);
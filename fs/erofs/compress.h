@@ -8,6 +8,10 @@
 
 #include "internal.h"
 
+#ifndef LZ4_DECOMPRESS_INPLACE_MARGIN
+#define LZ4_DECOMPRESS_INPLACE_MARGIN(srcsize)  (((srcsize) >> 8) + 32)
+#endif
+
 struct z_erofs_decompress_req {
 	struct super_block *sb;
 	struct page **in, **out;
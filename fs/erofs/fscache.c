@@ -197,6 +197,33 @@ static int erofs_fscache_meta_read_folio(struct file *data, struct folio *folio)
 	return ret;
 }
 
+/*
+ * Extend a read of @count bytes at @pos, which lies in the extent @map, over
+ * the following extents as long as they are stored right behind it on the
+ * same device, so that e.g. consecutive chunks of a readahead window end up
+ * in a single cachefiles read (and on-demand request) instead of one each.
+ */
+static size_t erofs_fscache_coalesce_extents(struct erofs_fscache_request *primary,
+		struct erofs_map_blocks *map, loff_t pos, size_t count)
+{
+	struct inode *inode = primary->mapping->host;
+	struct erofs_map_blocks next;
+	size_t left = primary->len - primary->submitted;
+
+	while (count < left) {
+		next.m_la = pos + count;
+		if (erofs_map_blocks(inode, &next))
+			break;
+		if ((next.m_flags & (EROFS_MAP_MAPPED | EROFS_MAP_META)) !=
+		    EROFS_MAP_MAPPED || next.m_la != pos + count ||
+		    next.m_deviceid != map->m_deviceid ||
+		    next.m_pa != map->m_pa + (pos - map->m_la) + count)
+			break;
+		count += min_t(size_t, next.m_llen, left - count);
+	}
+	return count;
+}
+
 static int erofs_fscache_data_read_slice(struct erofs_fscache_request *primary)
 {
 	struct address_space *mapping = primary->mapping;
@@ -251,6 +278,7 @@ static int erofs_fscache_data_read_slice(struct erofs_fscache_request *primary)
 
 	count = min_t(size_t, map.m_llen - (pos - map.m_la), count);
 	DBG_BUGON(!count || count % PAGE_SIZE);
+	count = erofs_fscache_coalesce_extents(primary, &map, pos, count);
 
 	mdev = (struct erofs_map_dev) {
 		.m_deviceid = map.m_deviceid,
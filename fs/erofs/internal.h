@@ -129,6 +129,12 @@ struct erofs_sb_info {
 
 	/* managed XArray arranged in physical block number */
 	struct xarray managed_pslots;
+#ifdef CONFIG_EROFS_FS_ZIP_DCACHE
+	/* decompressed pcluster cache, indexed like managed_pslots */
+	struct xarray dcache;
+	struct list_head dcache_lru;	/* protected by the dcache xa_lock */
+	unsigned long dcache_pages;
+#endif
 
 	unsigned int shrinker_run_no;
 	u16 available_compr_algs;
@@ -477,6 +483,20 @@ void __init erofs_pcpubuf_init(void);
 void erofs_pcpubuf_exit(void);
 int erofs_init_managed_cache(struct super_block *sb);
 int z_erofs_parse_cfgs(struct super_block *sb, struct erofs_super_block *dsb);
+#ifdef CONFIG_EROFS_FS_ZIP_DCACHE
+void z_erofs_dcache_destroy(struct super_block *sb);
+unsigned long z_erofs_dcache_count(void);
+unsigned long z_erofs_dcache_shrink(struct erofs_sb_info *sbi,
+				    unsigned long nr_shrink);
+#else
+static inline void z_erofs_dcache_destroy(struct super_block *sb) {}
+static inline unsigned long z_erofs_dcache_count(void) { return 0; }
+static inline unsigned long z_erofs_dcache_shrink(struct erofs_sb_info *sbi,
+						  unsigned long nr_shrink)
+{
+	return 0;
+}
+#endif
 #else
 static inline void erofs_shrinker_register(struct super_block *sb) {}
 static inline void erofs_shrinker_unregister(struct super_block *sb) {}
@@ -487,6 +507,7 @@ static inline void z_erofs_exit_zip_subsystem(void) {}
 static inline void erofs_pcpubuf_init(void) {}
 static inline void erofs_pcpubuf_exit(void) {}
 static inline int erofs_init_managed_cache(struct super_block *sb) { return 0; }
+static inline void z_erofs_dcache_destroy(struct super_block *sb) {}
 #endif	/* !CONFIG_EROFS_FS_ZIP */
 
 #ifdef CONFIG_EROFS_FS_ZIP_LZMA
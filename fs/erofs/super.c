@@ -659,6 +659,10 @@ static int erofs_fc_fill_super(struct super_block *sb, struct fs_context *fc)
 
 #ifdef CONFIG_EROFS_FS_ZIP
 	xa_init(&sbi->managed_pslots);
+#ifdef CONFIG_EROFS_FS_ZIP_DCACHE
+	xa_init(&sbi->dcache);
+	INIT_LIST_HEAD(&sbi->dcache_lru);
+#endif
 #endif
 
 	inode = erofs_iget(sb, ROOT_NID(sbi));
@@ -824,6 +828,7 @@ static void erofs_put_super(struct super_block *sb)
 
 	erofs_unregister_sysfs(sb);
 	erofs_shrinker_unregister(sb);
+	z_erofs_dcache_destroy(sb);
 	erofs_xattr_prefixes_cleanup(sb);
 #ifdef CONFIG_EROFS_FS_ZIP
 	iput(sbi->managed_cache);
@@ -206,7 +206,8 @@ void erofs_shrinker_unregister(struct super_block *sb)
 static unsigned long erofs_shrink_count(struct shrinker *shrink,
 					struct shrink_control *sc)
 {
-	return atomic_long_read(&erofs_global_shrink_cnt);
+	return atomic_long_read(&erofs_global_shrink_cnt) +
+		z_erofs_dcache_count();
 }
 
 static unsigned long erofs_shrink_scan(struct shrinker *shrink,
@@ -244,7 +245,10 @@ static unsigned long erofs_shrink_scan(struct shrinker *shrink,
 		spin_unlock(&erofs_sb_list_lock);
 		sbi->shrinker_run_no = run_no;
 
-		freed += erofs_shrink_workstation(sbi, nr - freed);
+		/* the dcache only holds copies of file data, drop it first */
+		freed += z_erofs_dcache_shrink(sbi, nr - freed);
+		if (freed < nr)
+			freed += erofs_shrink_workstation(sbi, nr - freed);
 
 		spin_lock(&erofs_sb_list_lock);
 		/* Get the next list element before we move this one */
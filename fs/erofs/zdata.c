@@ -721,6 +721,29 @@ int erofs_init_managed_cache(struct super_block *sb)
 	return 0;
 }
 
+/*
+ * LZ4 can only decompress in place if the decompressed data leaves enough
+ * slack at the end of its last page (see z_erofs_lz4_handle_overlap()).
+ * Otherwise file pages used for inplace I/O would just get their compressed
+ * data bounced into the per-CPU buffer again before decompression, so read
+ * such pclusters into pages of their own and decompress straight from those.
+ */
+static bool z_erofs_may_inplace_io(struct super_block *sb,
+				   struct erofs_map_blocks *map)
+{
+	unsigned int omargin;
+
+	if (map->m_algorithmformat != Z_EROFS_COMPRESSION_LZ4)
+		return true;
+	/* LZ4 decompression inplace is only safe if zero_padding is enabled */
+	if (!erofs_sb_has_zero_padding(EROFS_SB(sb)))
+		return false;
+	omargin = -(map->m_la + map->m_llen) & ~PAGE_MASK;
+	/* zero padding is less than a block, so this is a lower bound */
+	return omargin >= LZ4_DECOMPRESS_INPLACE_MARGIN(map->m_plen -
+							sb->s_blocksize);
+}
+
 static bool z_erofs_try_inplace_io(struct z_erofs_decompress_frontend *fe,
 				   struct z_erofs_bvec *bvec)
 {
@@ -896,7 +919,8 @@ static int z_erofs_pcluster_begin(struct z_erofs_decompress_frontend *fe)
 		fe->mode = Z_EROFS_PCLUSTER_FOLLOWED_NOINPLACE;
 	}
 	/* file-backed inplace I/O pages are traversed in reverse order */
-	fe->icur = z_erofs_pclusterpages(fe->pcl);
+	fe->icur = z_erofs_may_inplace_io(sb, map) ?
+			z_erofs_pclusterpages(fe->pcl) : 0;
 	return 0;
 }
 
@@ -967,6 +991,135 @@ static int z_erofs_read_fragment(struct super_block *sb, struct page *page,
 	return 0;
 }
 
+#ifdef CONFIG_EROFS_FS_ZIP_DCACHE
+/*
+ * Decompressed pcluster cache: the output of fully decoded pclusters is
+ * kept, up to a per-filesystem budget, so that reads of the same physical
+ * pcluster (deduplicated extents of other files, or pages reclaimed in the
+ * meantime) can be served by a copy instead of another decompression.  The
+ * data of a read-only filesystem never changes, so entries are never
+ * invalidated, only evicted in LRU order, by the shrinker or on unmount.
+ * Everything is protected by the xa_lock of sbi->dcache.
+ */
+struct z_erofs_dcache_entry {
+	struct list_head lru;
+	pgoff_t index;
+	refcount_t ref;
+	unsigned int length;	/* decompressed bytes from the extent start */
+	unsigned int nr_pages;
+	struct page *pages[];
+};
+
+#define Z_EROFS_DCACHE_BUDGET_PAGES	\
+	((unsigned long)CONFIG_EROFS_FS_ZIP_DCACHE_KB >> (PAGE_SHIFT - 10))
+/* bigger outputs would flush too much of the cache at once */
+#define Z_EROFS_DCACHE_MAX_ENTRY	min_t(unsigned long,		\
+	(Z_EROFS_DCACHE_BUDGET_PAGES << PAGE_SHIFT) / 16,		\
+	Z_EROFS_PCLUSTER_MAX_SIZE)
+
+/* cached entries of all mounted instances, for the shrinker */
+static atomic_long_t z_erofs_dcache_cnt;
+
+static void z_erofs_dcache_free(struct z_erofs_dcache_entry *e)
+{
+	unsigned int i;
+
+	for (i = 0; i < e->nr_pages; ++i)
+		if (e->pages[i])
+			__free_page(e->pages[i]);
+	kfree(e);
+}
+
+static void z_erofs_dcache_put(struct z_erofs_dcache_entry *e)
+{
+	if (refcount_dec_and_test(&e->ref))
+		z_erofs_dcache_free(e);
+}
+
+/* must be called with the xa_lock of sbi->dcache held */
+static void z_erofs_dcache_unlink(struct erofs_sb_info *sbi,
+				  struct z_erofs_dcache_entry *e)
+{
+	list_del(&e->lru);
+	sbi->dcache_pages -= e->nr_pages;
+	atomic_long_dec(&z_erofs_dcache_cnt);
+	z_erofs_dcache_put(e);
+}
+
+/* fill [cur, end) of @page from the cache if the current extent is cached */
+static bool z_erofs_dcache_read(struct z_erofs_decompress_frontend *fe,
+				struct page *page, unsigned int cur,
+				unsigned int end)
+{
+	struct erofs_sb_info *const sbi = EROFS_I_SB(fe->inode);
+	struct erofs_map_blocks *const map = &fe->map;
+	erofs_off_t pos = page_offset(page) + cur - map->m_la;
+	struct z_erofs_dcache_entry *e;
+	unsigned int cnt;
+
+	if ((map->m_flags & EROFS_MAP_META) || xa_empty(&sbi->dcache))
+		return false;
+
+	xa_lock(&sbi->dcache);
+	e = xa_load(&sbi->dcache, map->m_pa >> PAGE_SHIFT);
+	if (!e || e->length < pos + end - cur) {
+		xa_unlock(&sbi->dcache);
+		return false;
+	}
+	refcount_inc(&e->ref);
+	list_move(&e->lru, &sbi->dcache_lru);
+	xa_unlock(&sbi->dcache);
+
+	for (; cur < end; cur += cnt, pos += cnt) {
+		cnt = min_t(unsigned int, end - cur,
+			    PAGE_SIZE - (pos & ~PAGE_MASK));
+		memcpy_page(page, cur, e->pages[pos >> PAGE_SHIFT],
+			    pos & ~PAGE_MASK, cnt);
+	}
+	z_erofs_dcache_put(e);
+	return true;
+}
+
+unsigned long z_erofs_dcache_count(void)
+{
+	return atomic_long_read(&z_erofs_dcache_cnt);
+}
+
+/* evict up to @nr_shrink least recently used entries */
+unsigned long z_erofs_dcache_shrink(struct erofs_sb_info *sbi,
+				    unsigned long nr_shrink)
+{
+	struct z_erofs_dcache_entry *e;
+	unsigned long freed = 0;
+
+	xa_lock(&sbi->dcache);
+	while (freed < nr_shrink && !list_empty(&sbi->dcache_lru)) {
+		e = list_last_entry(&sbi->dcache_lru,
+				    struct z_erofs_dcache_entry, lru);
+		__xa_erase(&sbi->dcache, e->index);
+		z_erofs_dcache_unlink(sbi, e);
+		++freed;
+	}
+	xa_unlock(&sbi->dcache);
+	return freed;
+}
+
+void z_erofs_dcache_destroy(struct super_block *sb)
+{
+	struct erofs_sb_info *const sbi = EROFS_SB(sb);
+
+	z_erofs_dcache_shrink(sbi, ULONG_MAX);
+	xa_destroy(&sbi->dcache);
+}
+#else
+static bool z_erofs_dcache_read(struct z_erofs_decompress_frontend *fe,
+				struct page *page, unsigned int cur,
+				unsigned int end)
+{
+	return false;
+}
+#endif
+
 static int z_erofs_do_read_page(struct z_erofs_decompress_frontend *fe,
 				struct page *page)
 {
@@ -1014,6 +1167,11 @@ static int z_erofs_do_read_page(struct z_erofs_decompress_frontend *fe,
 		goto next_part;
 	}
 
+	if (z_erofs_dcache_read(fe, page, cur, end)) {
+		tight = false;
+		goto next_part;
+	}
+
 	if (!fe->pcl) {
 		err = z_erofs_pcluster_begin(fe);
 		if (err)
@@ -1236,6 +1394,85 @@ static int z_erofs_parse_in_bvecs(struct z_erofs_decompress_backend *be,
 	return 0;
 }
 
+#ifdef CONFIG_EROFS_FS_ZIP_DCACHE
+static void z_erofs_dcache_store(struct z_erofs_decompress_backend *be)
+{
+	const gfp_t gfp = GFP_NOIO | __GFP_NORETRY | __GFP_NOWARN;
+	struct erofs_sb_info *const sbi = EROFS_SB(be->sb);
+	struct z_erofs_pcluster *pcl = be->pcl;
+	unsigned int length = pcl->length, nr_pages, pos, cnt, i;
+	struct z_erofs_dcache_entry *e, *old;
+
+	/* only cache complete outputs which can serve any later read */
+	if (pcl->partial || pcl->multibases ||
+	    z_erofs_is_inline_pcluster(pcl) ||
+	    pcl->algorithmformat >= Z_EROFS_COMPRESSION_MAX ||
+	    length > Z_EROFS_DCACHE_MAX_ENTRY)
+		return;
+
+	xa_lock(&sbi->dcache);
+	e = xa_load(&sbi->dcache, pcl->obj.index);
+	if (e && e->length >= length) {
+		list_move(&e->lru, &sbi->dcache_lru);
+		xa_unlock(&sbi->dcache);
+		return;
+	}
+	xa_unlock(&sbi->dcache);
+
+	nr_pages = DIV_ROUND_UP(length, PAGE_SIZE);
+	e = kzalloc(struct_size(e, pages, nr_pages), gfp);
+	if (!e)
+		return;
+	e->nr_pages = nr_pages;
+	for (i = 0; i < nr_pages; ++i) {
+		e->pages[i] = alloc_page(gfp);
+		if (!e->pages[i])
+			goto free;
+	}
+
+	for (pos = 0; pos < length; pos += cnt) {
+		unsigned int off = pcl->pageofs_out + pos;
+		struct page *page = be->decompressed_pages[off >> PAGE_SHIFT];
+
+		if (!page)
+			goto free;
+		cnt = min_t(unsigned int, length - pos,
+			    PAGE_SIZE - (off & ~PAGE_MASK));
+		cnt = min_t(unsigned int, cnt, PAGE_SIZE - (pos & ~PAGE_MASK));
+		memcpy_page(e->pages[pos >> PAGE_SHIFT], pos & ~PAGE_MASK,
+			    page, off & ~PAGE_MASK, cnt);
+	}
+
+	e->index = pcl->obj.index;
+	e->length = length;
+	refcount_set(&e->ref, 1);
+
+	xa_lock(&sbi->dcache);
+	old = __xa_store(&sbi->dcache, e->index, e, GFP_NOWAIT);
+	if (xa_is_err(old)) {
+		xa_unlock(&sbi->dcache);
+		goto free;
+	}
+	if (old)
+		z_erofs_dcache_unlink(sbi, old);
+	list_add(&e->lru, &sbi->dcache_lru);
+	sbi->dcache_pages += nr_pages;
+	atomic_long_inc(&z_erofs_dcache_cnt);
+	while (sbi->dcache_pages > Z_EROFS_DCACHE_BUDGET_PAGES) {
+		old = list_last_entry(&sbi->dcache_lru,
+				      struct z_erofs_dcache_entry, lru);
+		__xa_erase(&sbi->dcache, old->index);
+		z_erofs_dcache_unlink(sbi, old);
+	}
+	xa_unlock(&sbi->dcache);
+	return;
+free:
+	z_erofs_dcache_free(e);
+}
+#else
+static void z_erofs_dcache_store(struct z_erofs_decompress_backend *be) {}
+#endif
+
 static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 				       int err)
 {
@@ -1300,6 +1537,8 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 					.partial_decoding = pcl->partial,
 					.fillgaps = pcl->multibases,
 				 }, be->pagepool);
+	if (!err)
+		z_erofs_dcache_store(be);
 
 out:
 	/* must handle all compressed pages before actual file pages */
@@ -1376,6 +1615,54 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 	}
 }
 
+/* don't split a decompression queue into parts shorter than this */
+#define Z_EROFS_SPLIT_MIN_PCLUSTERS	4
+
+static void z_erofs_decompressqueue_work(struct work_struct *work);
+
+/*
+ * Large readahead can queue dozens of pclusters, which would otherwise all be
+ * decompressed one after another by a single worker.  Hand the second half of
+ * a long queue to another worker of the (unbound) erofs workqueue; that one
+ * may split its part again, so the pclusters spread over several CPUs.
+ * Folios spanning pclusters of both halves are fine since their completion
+ * is counted in z_erofs_onlinepage_endio().
+ */
+static void z_erofs_split_queue(struct z_erofs_decompressqueue *q)
+{
+	z_erofs_next_pcluster_t owned = q->head;
+	struct z_erofs_decompressqueue *nq;
+	struct z_erofs_pcluster *pcl;
+	unsigned int nr = 0;
+
+	while (owned != Z_EROFS_PCLUSTER_TAIL) {
+		owned = READ_ONCE(container_of(owned, struct z_erofs_pcluster,
+					       next)->next);
+		++nr;
+	}
+	if (nr < 2 * Z_EROFS_SPLIT_MIN_PCLUSTERS)
+		return;
+
+	nq = kvzalloc(sizeof(*nq), GFP_NOIO | __GFP_NOWARN);
+	if (!nq)
+		return;
+
+	/* find the last pcluster of the first half */
+	pcl = container_of(q->head, struct z_erofs_pcluster, next);
+	for (nr = nr / 2; nr > 1; --nr)
+		pcl = container_of(READ_ONCE(pcl->next),
+				   struct z_erofs_pcluster, next);
+
+	nq->sb = q->sb;
+	nq->eio = q->eio;
+	nq->head = READ_ONCE(pcl->next);
+	/* the pcluster is still owned by this queue, so it stays non-NIL */
+	WRITE_ONCE(pcl->next, Z_EROFS_PCLUSTER_TAIL);
+
+	INIT_WORK(&nq->u.work, z_erofs_decompressqueue_work);
+	queue_work(z_erofs_workqueue, &nq->u.work);
+}
+
 static void z_erofs_decompressqueue_work(struct work_struct *work)
 {
 	struct z_erofs_decompressqueue *bgq =
@@ -1383,6 +1670,7 @@ static void z_erofs_decompressqueue_work(struct work_struct *work)
 	struct page *pagepool = NULL;
 
 	DBG_BUGON(bgq->head == Z_EROFS_PCLUSTER_TAIL);
+	z_erofs_split_queue(bgq);
 	z_erofs_decompress_queue(bgq, &pagepool);
 	erofs_release_pages(&pagepool);
 	kvfree(bgq);
@@ -247,6 +247,9 @@ struct ep_pqueue {
 /* Maximum number of epoll watched descriptors, per user */
 static long max_user_watches __read_mostly;
 
+/* Prefer waking a waiter that last ran on the CPU delivering the event */
+static int epoll_local_wakeup __read_mostly;
+
 /* Used for cycles detection */
 static DEFINE_MUTEX(epnested_mutex);
 
@@ -322,6 +325,15 @@ static struct ctl_table epoll_table[] = {
 		.extra1		= &long_zero,
 		.extra2		= &long_max,
 	},
+	{
+		.procname	= "local_wakeup",
+		.data		= &epoll_local_wakeup,
+		.maxlen		= sizeof(epoll_local_wakeup),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 	{ }
 };
 
@@ -1146,6 +1158,47 @@ static inline bool chain_epi_lockless(struct epitem *epi)
 	return true;
 }
 
+/*
+ * Number of ep->wq waiters looked at when searching for one that last ran on
+ * the local CPU.
+ */
+#define EP_LOCAL_WAKE_SCAN	16
+
+/*
+ * Wake one ep_poll() waiter, preferring a task that last ran on this CPU so
+ * that the event is harvested where its source data is still cache hot.
+ * Only the first EP_LOCAL_WAKE_SCAN waiters are examined; if none of them
+ * matches, this behaves exactly like wake_up().
+ *
+ * Called with ep->lock held for reading, which keeps ep_poll() from adding
+ * or removing its wait entry under us; ep->wq.lock serializes us against
+ * concurrent wakeups removing entries.
+ */
+static void ep_wake_up_local(struct eventpoll *ep)
+{
+	wait_queue_entry_t *curr, *target = NULL;
+	int cpu = raw_smp_processor_id();
+	int scanned = 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ep->wq.lock, flags);
+	list_for_each_entry(curr, &ep->wq.head, entry) {
+		struct task_struct *p = curr->private;
+
+		if (++scanned > EP_LOCAL_WAKE_SCAN)
+			break;
+		if (p && task_cpu(p) == cpu) {
+			target = curr;
+			break;
+		}
+	}
+	/* All ep_poll() waiters are exclusive: the head one gets woken. */
+	if (target)
+		list_move(&target->entry, &ep->wq.head);
+	wake_up_locked(&ep->wq);
+	spin_unlock_irqrestore(&ep->wq.lock, flags);
+}
+
 /*
  * This is the callback that is passed to the wait queue wakeup
  * mechanism. It is called by the stored file descriptors when they
@@ -1231,7 +1284,10 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 				break;
 			}
 		}
-		wake_up(&ep->wq);
+		if (READ_ONCE(epoll_local_wakeup))
+			ep_wake_up_local(ep);
+		else
+			wake_up(&ep->wq);
 	}
 	if (waitqueue_active(&ep->poll_wait))
 		pwake++;
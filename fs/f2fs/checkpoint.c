@@ -1212,6 +1212,25 @@ static int block_operations(struct f2fs_sb_info *sbi)
 	 */
 	f2fs_flush_inline_data(sbi);
 
+	/*
+	 * Start writeback of the dirty node pages before blocking operations,
+	 * so that only the ones dirtied meanwhile are left to be written with
+	 * cp_rwsem held. This keeps the window in which all filesystem
+	 * operations are stalled short when many nodes were dirtied.
+	 */
+	if (get_pages(sbi, F2FS_DIRTY_NODES)) {
+		struct writeback_control nowait_wbc = {
+			.sync_mode = WB_SYNC_NONE,
+			.nr_to_write = LONG_MAX,
+			.for_reclaim = 0,
+		};
+		struct blk_plug plug;
+
+		blk_start_plug(&plug);
+		f2fs_sync_node_pages(sbi, &nowait_wbc, false, FS_CP_NODE_IO);
+		blk_finish_plug(&plug);
+	}
+
 retry_flush_quotas:
 	f2fs_lock_all(sbi);
 	if (__need_flush_quota(sbi)) {
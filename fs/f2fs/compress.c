@@ -176,8 +176,9 @@ void f2fs_compress_ctx_add_page(struct compress_ctx *cc, struct page *page)
 #ifdef CONFIG_F2FS_FS_LZO
 static int lzo_init_compress_ctx(struct compress_ctx *cc)
 {
-	cc->private = f2fs_kvmalloc(F2FS_I_SB(cc->inode),
-				LZO1X_MEM_COMPRESS, GFP_NOFS);
+	if (!cc->private)
+		cc->private = f2fs_kvmalloc(F2FS_I_SB(cc->inode),
+					LZO1X_MEM_COMPRESS, GFP_NOFS);
 	if (!cc->private)
 		return -ENOMEM;
 
@@ -246,7 +247,9 @@ static int lz4_init_compress_ctx(struct compress_ctx *cc)
 		size = LZ4HC_MEM_COMPRESS;
 #endif
 
-	cc->private = f2fs_kvmalloc(F2FS_I_SB(cc->inode), size, GFP_NOFS);
+	if (!cc->private)
+		cc->private = f2fs_kvmalloc(F2FS_I_SB(cc->inode), size,
+								GFP_NOFS);
 	if (!cc->private)
 		return -ENOMEM;
 
@@ -343,7 +346,10 @@ static int zstd_init_compress_ctx(struct compress_ctx *cc)
 	params = zstd_get_params(level, cc->rlen);
 	workspace_size = zstd_cstream_workspace_bound(&params.cParams);
 
-	workspace = f2fs_kvmalloc(F2FS_I_SB(cc->inode),
+	/* a workspace kept from a previous cluster is reset by init_cstream */
+	workspace = cc->private;
+	if (!workspace)
+		workspace = f2fs_kvmalloc(F2FS_I_SB(cc->inode),
 					workspace_size, GFP_NOFS);
 	if (!workspace)
 		return -ENOMEM;
@@ -354,6 +360,8 @@ static int zstd_init_compress_ctx(struct compress_ctx *cc)
 				KERN_ERR, F2FS_I_SB(cc->inode)->sb->s_id,
 				__func__);
 		kvfree(workspace);
+		cc->private = NULL;
+		cc->private2 = NULL;
 		return -EIO;
 	}
 
@@ -621,6 +629,19 @@ static void *f2fs_vmap(struct page **pages, unsigned int count)
 	return buf;
 }
 
+/*
+ * The compression workspace is kept in @cc across the clusters written back
+ * in one pass, instead of being set up again for every cluster; free it once
+ * the pass is done.
+ */
+void f2fs_free_compress_workspace(struct compress_ctx *cc)
+{
+	const struct f2fs_compress_ops *cops = f2fs_cops[cc->private_alg];
+
+	if (cc->private && cops->destroy_compress_ctx)
+		cops->destroy_compress_ctx(cc);
+}
+
 static int f2fs_compress_pages(struct compress_ctx *cc)
 {
 	struct f2fs_inode_info *fi = F2FS_I(cc->inode);
@@ -633,10 +654,17 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	trace_f2fs_compress_pages_start(cc->inode, cc->cluster_idx,
 				cc->cluster_size, fi->i_compress_algorithm);
 
+	/* the compress option may have been changed since the last cluster */
+	if (cc->private && (cc->private_alg != fi->i_compress_algorithm ||
+			cc->private_level != fi->i_compress_level))
+		f2fs_free_compress_workspace(cc);
+
 	if (cops->init_compress_ctx) {
 		ret = cops->init_compress_ctx(cc);
 		if (ret)
 			goto out;
+		cc->private_alg = fi->i_compress_algorithm;
+		cc->private_level = fi->i_compress_level;
 	}
 
 	max_len = COMPRESS_HEADER_SIZE + cc->clen;
@@ -646,7 +674,7 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	cc->cpages = page_array_alloc(cc->inode, cc->nr_cpages);
 	if (!cc->cpages) {
 		ret = -ENOMEM;
-		goto destroy_compress_ctx;
+		goto out;
 	}
 
 	for (i = 0; i < cc->nr_cpages; i++)
@@ -700,9 +728,6 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 		cc->cpages[i] = NULL;
 	}
 
-	if (cops->destroy_compress_ctx)
-		cops->destroy_compress_ctx(cc);
-
 	cc->valid_nr_cpages = new_nr_cpages;
 
 	trace_f2fs_compress_pages_end(cc->inode, cc->cluster_idx,
@@ -720,9 +745,6 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	}
 	page_array_free(cc->inode, cc->cpages, cc->nr_cpages);
 	cc->cpages = NULL;
-destroy_compress_ctx:
-	if (cops->destroy_compress_ctx)
-		cops->destroy_compress_ctx(cc);
 out:
 	trace_f2fs_compress_pages_end(cc->inode, cc->cluster_idx,
 							cc->clen, ret);
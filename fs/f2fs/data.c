@@ -3266,6 +3266,7 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 	}
 	if (f2fs_compressed_file(inode))
 		f2fs_destroy_compress_ctx(&cc, false);
+	f2fs_free_compress_workspace(&cc);
 #endif
 	if (retry) {
 		index = 0;
@@ -127,6 +127,13 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 		si->nr_discard_cmd =
 			atomic_read(&SM_I(sbi)->dcc_info->discard_cmd_cnt);
 		si->undiscard_blks = SM_I(sbi)->dcc_info->undiscard_blks;
+		si->avg_discard_lat = SM_I(sbi)->dcc_info->nr_discard_lat ?
+			div_u64(div64_u64(SM_I(sbi)->dcc_info->sum_discard_lat,
+					  SM_I(sbi)->dcc_info->nr_discard_lat),
+				NSEC_PER_USEC) : 0;
+		si->peak_discard_lat = div_u64(
+				SM_I(sbi)->dcc_info->peak_discard_lat,
+				NSEC_PER_USEC);
 	}
 	si->nr_issued_ckpt = atomic_read(&sbi->cprc_info.issued_ckpt);
 	si->nr_total_ckpt = atomic_read(&sbi->cprc_info.total_ckpt);
@@ -592,6 +599,8 @@ static int stat_show(struct seq_file *s, void *v)
 		seq_printf(s, "Discard: (%4d %4d)) cmd: %4d undiscard:%4u\n",
 			   si->nr_discarding, si->nr_discarded,
 			   si->nr_discard_cmd, si->undiscard_blks);
+		seq_printf(s, "  - Discard latency (avg: %6u us, peak: %6u us)\n",
+			   si->avg_discard_lat, si->peak_discard_lat);
 		seq_printf(s, "  - atomic IO: %4d (Max. %4d)\n",
 			   si->aw_cnt, si->max_aw_cnt);
 		seq_printf(s, "  - compress: %4d, hit:%8d\n", si->compress_pages, si->compress_page_hit);
@@ -112,6 +112,22 @@ static bool __may_extent_tree(struct inode *inode, enum extent_type type)
 	return true;
 }
 
+/*
+ * Set (or drop, if @ei is NULL) the largest extent, with et->lock held for
+ * write.  The largest extent is also looked up without et->lock, see
+ * __lookup_largest_extent().
+ */
+static void __set_largest_extent(struct extent_tree *et,
+					struct extent_info *ei)
+{
+	write_seqcount_begin(&et->largest_seq);
+	if (ei)
+		et->largest = *ei;
+	else
+		et->largest.len = 0;
+	write_seqcount_end(&et->largest_seq);
+}
+
 static void __try_update_largest_extent(struct extent_tree *et,
 						struct extent_node *en)
 {
@@ -120,7 +136,7 @@ static void __try_update_largest_extent(struct extent_tree *et,
 	if (en->ei.len <= et->largest.len)
 		return;
 
-	et->largest = en->ei;
+	__set_largest_extent(et, &en->ei);
 	et->largest_updated = true;
 }
 
@@ -341,6 +357,7 @@ static struct extent_tree *__grab_extent_tree(struct inode *inode,
 		et->root = RB_ROOT_CACHED;
 		et->cached_en = NULL;
 		rwlock_init(&et->lock);
+		seqcount_rwlock_init(&et->largest_seq, &et->lock);
 		INIT_LIST_HEAD(&et->list);
 		atomic_set(&et->node_cnt, 0);
 		atomic_inc(&eti->total_ext_tree);
@@ -379,7 +396,7 @@ static void __drop_largest_extent(struct extent_tree *et,
 {
 	if (fofs < et->largest.fofs + et->largest.len &&
 			fofs + len > et->largest.fofs) {
-		et->largest.len = 0;
+		__set_largest_extent(et, NULL);
 		et->largest_updated = true;
 	}
 }
@@ -417,7 +434,7 @@ void f2fs_init_read_extent_tree(struct inode *inode, struct page *ipage)
 	en = __attach_extent_node(sbi, et, &ei, NULL,
 				&et->root.rb_root.rb_node, true);
 	if (en) {
-		et->largest = en->ei;
+		__set_largest_extent(et, &en->ei);
 		et->cached_en = en;
 
 		spin_lock(&eti->extent_lock);
@@ -449,6 +466,28 @@ void f2fs_init_extent_tree(struct inode *inode)
 		__grab_extent_tree(inode, EX_BLOCK_AGE);
 }
 
+/*
+ * Most lookups in large, rarely fragmented files hit the largest extent, so
+ * check it against a consistent snapshot first, without taking et->lock.
+ */
+static bool __lookup_largest_extent(struct extent_tree *et, pgoff_t pgofs,
+					struct extent_info *ei)
+{
+	struct extent_info largest;
+	unsigned int seq;
+
+	do {
+		seq = read_seqcount_begin(&et->largest_seq);
+		largest = et->largest;
+	} while (read_seqcount_retry(&et->largest_seq, seq));
+
+	if (largest.fofs > pgofs || largest.fofs + largest.len <= pgofs)
+		return false;
+
+	*ei = largest;
+	return true;
+}
+
 static bool __lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 			struct extent_info *ei, enum extent_type type)
 {
@@ -463,17 +502,15 @@ static bool __lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 
 	trace_f2fs_lookup_extent_tree_start(inode, pgofs, type);
 
-	read_lock(&et->lock);
-
-	if (type == EX_READ &&
-			et->largest.fofs <= pgofs &&
-			et->largest.fofs + et->largest.len > pgofs) {
-		*ei = et->largest;
+	if (type == EX_READ && __lookup_largest_extent(et, pgofs, ei)) {
 		ret = true;
 		stat_inc_largest_node_hit(sbi);
-		goto out;
+		stat_inc_total_hit(sbi, type);
+		goto out_trace;
 	}
 
+	read_lock(&et->lock);
+
 	en = __lookup_extent_node(&et->root, et->cached_en, pgofs);
 	if (!en)
 		goto out;
@@ -494,7 +531,7 @@ static bool __lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 out:
 	stat_inc_total_hit(sbi, type);
 	read_unlock(&et->lock);
-
+out_trace:
 	if (type == EX_READ)
 		trace_f2fs_lookup_read_extent_tree_end(inode, pgofs, ei);
 	else if (type == EX_BLOCK_AGE)
@@ -722,7 +759,7 @@ static void __update_extent_tree_range(struct inode *inode,
 		if (dei.len >= 1 &&
 				prev.len < F2FS_MIN_EXTENT_LEN &&
 				et->largest.len < F2FS_MIN_EXTENT_LEN) {
-			et->largest.len = 0;
+			__set_largest_extent(et, NULL);
 			et->largest_updated = true;
 			set_inode_flag(inode, FI_NO_EXTENT);
 		}
@@ -1091,7 +1128,7 @@ static void __drop_extent_tree(struct inode *inode, enum extent_type type)
 	if (type == EX_READ) {
 		set_inode_flag(inode, FI_NO_EXTENT);
 		if (et->largest.len) {
-			et->largest.len = 0;
+			__set_largest_extent(et, NULL);
 			updated = true;
 		}
 	}
@@ -369,6 +369,7 @@ struct discard_cmd {
 	int error;			/* bio error */
 	spinlock_t lock;		/* for state/bio_ref updating */
 	unsigned short bio_ref;		/* bio reference count */
+	ktime_t issue_time;		/* issue time, latency once done */
 };
 
 enum {
@@ -416,6 +417,9 @@ struct discard_cmd_control {
 	atomic_t issued_discard;		/* # of issued discard */
 	atomic_t queued_discard;		/* # of queued discard */
 	atomic_t discard_cmd_cnt;		/* # of cached cmd count */
+	u64 sum_discard_lat;			/* sum of discard latencies (ns) */
+	u64 nr_discard_lat;			/* # of completed discards */
+	u64 peak_discard_lat;			/* peak discard latency (ns) */
 	struct rb_root_cached root;		/* root of discard rb-tree */
 	bool rbtree_check;			/* config for consistence check */
 	bool discard_wake;			/* to wake up discard thread */
@@ -666,6 +670,7 @@ struct extent_tree {
 	atomic_t node_cnt;		/* # of extent node in rb-tree*/
 	bool largest_updated;		/* largest extent updated */
 	struct extent_info largest;	/* largest cached extent for EX_READ */
+	seqcount_rwlock_t largest_seq;	/* for lockless largest lookups */
 };
 
 struct extent_tree_info {
@@ -1472,6 +1477,8 @@ struct compress_ctx {
 	size_t clen;			/* valid data length in cbuf */
 	void *private;			/* payload buffer for specified compression algorithm */
 	void *private2;			/* extra payload buffer */
+	unsigned char private_alg;	/* algorithm of the payload buffers */
+	unsigned char private_level;	/* compress level of the payload buffers */
 };
 
 /* compress context for write IO path */
@@ -3921,6 +3928,7 @@ struct f2fs_stat_info {
 	int nr_discarding, nr_discarded;
 	int nr_discard_cmd;
 	unsigned int undiscard_blks;
+	unsigned int avg_discard_lat, peak_discard_lat;
 	int nr_issued_ckpt, nr_total_ckpt, nr_queued_ckpt;
 	unsigned int cur_ckpt_time, peak_ckpt_time;
 	int inline_xattr, inline_inode, inline_dir, append, update, orphans;
@@ -4293,6 +4301,7 @@ unsigned int f2fs_cluster_blocks_are_contiguous(struct dnode_of_data *dn,
 						unsigned int ofs_in_node);
 int f2fs_init_compress_ctx(struct compress_ctx *cc);
 void f2fs_destroy_compress_ctx(struct compress_ctx *cc, bool reuse);
+void f2fs_free_compress_workspace(struct compress_ctx *cc);
 void f2fs_init_compress_info(struct f2fs_sb_info *sbi);
 int f2fs_init_compress_inode(struct f2fs_sb_info *sbi);
 void f2fs_destroy_compress_inode(struct f2fs_sb_info *sbi);
@@ -34,7 +34,7 @@ static int gc_thread_func(void *data)
 	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
 	wait_queue_head_t *wq = &sbi->gc_thread->gc_wait_queue_head;
 	wait_queue_head_t *fggc_wq = &sbi->gc_thread->fggc_wq;
-	unsigned int wait_ms;
+	unsigned int wait_ms, i;
 	struct f2fs_gc_control gc_control = {
 		.victim_segno = NULL_SEGNO,
 		.should_migrate_blocks = false,
@@ -143,6 +143,22 @@ static int gc_thread_func(void *data)
 			/* reset wait_ms to default sleep time */
 			if (wait_ms == gc_th->no_gc_sleep_time)
 				wait_ms = gc_th->min_sleep_time;
+
+			/*
+			 * Free space is getting short: keep collecting victims
+			 * while the device stays idle, rather than leaving them
+			 * to foreground GC in f2fs_balance_fs().
+			 */
+			for (i = 1; !foreground && i < gc_th->boost_multiple &&
+			     !kthread_should_stop() &&
+			     has_enough_invalid_blocks(sbi) &&
+			     is_idle(sbi, GC_TIME); i++) {
+				if (!f2fs_down_write_trylock(&sbi->gc_lock))
+					break;
+				stat_inc_gc_call_count(sbi, BACKGROUND);
+				if (f2fs_gc(sbi, &gc_control))
+					break;
+			}
 		}
 
 		if (foreground)
@@ -182,6 +198,7 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->min_sleep_time = DEF_GC_THREAD_MIN_SLEEP_TIME;
 	gc_th->max_sleep_time = DEF_GC_THREAD_MAX_SLEEP_TIME;
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
+	gc_th->boost_multiple = DEF_GC_THREAD_BOOST_MULTIPLE;
 
 	gc_th->gc_wake = false;
 
@@ -9,6 +9,7 @@
 #include <linux/f2fs_fs.h>
 #include <linux/bio.h>
 #include <linux/blkdev.h>
+#include <linux/blk-mq.h>
 #include <linux/sched/mm.h>
 #include <linux/prefetch.h>
 #include <linux/kthread.h>
@@ -1099,6 +1100,15 @@ static void __remove_discard_cmd(struct f2fs_sb_info *sbi,
 
 	f2fs_bug_on(sbi, dc->ref);
 
+	if (dc->state == D_DONE) {
+		u64 lat = ktime_to_ns(dc->issue_time);
+
+		dcc->sum_discard_lat += lat;
+		dcc->nr_discard_lat++;
+		if (lat > dcc->peak_discard_lat)
+			dcc->peak_discard_lat = lat;
+	}
+
 	if (dc->error == -EOPNOTSUPP)
 		dc->error = 0;
 
@@ -1121,6 +1131,7 @@ static void f2fs_submit_discard_endio(struct bio *bio)
 	dc->bio_ref--;
 	if (!dc->bio_ref && dc->state == D_SUBMIT) {
 		dc->state = D_DONE;
+		dc->issue_time = ktime_sub(ktime_get(), dc->issue_time);
 		complete_all(&dc->wait);
 	}
 	spin_unlock_irqrestore(&dc->lock, flags);
@@ -1224,7 +1235,8 @@ static void __submit_zone_reset_cmd(struct f2fs_sb_info *sbi,
 		(*issued)++;
 
 	atomic_inc(&dcc->queued_discard);
-	dc->queued++;
+	if (!dc->queued++)
+		dc->issue_time = ktime_get();
 	list_move_tail(&dc->list, wait_list);
 
 	/* sanity check on discard range */
@@ -1333,7 +1345,8 @@ static int __submit_discard_cmd(struct f2fs_sb_info *sbi,
 		spin_unlock_irqrestore(&dc->lock, flags);
 
 		atomic_inc(&dcc->queued_discard);
-		dc->queued++;
+		if (!dc->queued++)
+			dc->issue_time = ktime_get();
 		list_move_tail(&dc->list, wait_list);
 
 		/* sanity check on discard range */
@@ -1873,6 +1886,37 @@ bool f2fs_issue_discard_timeout(struct f2fs_sb_info *sbi)
 	return !dropped;
 }
 
+static bool __is_bdev_idle(struct block_device *bdev)
+{
+	struct request_queue *q = bdev_get_queue(bdev);
+
+	if (!queue_is_mq(q))
+		return true;
+	/*
+	 * Check the whole tag set rather than just this queue: the LUs of a
+	 * UFS host have their own request queues but share the host tags.
+	 */
+	return !blk_mq_tagset_inflight(q->tag_set);
+}
+
+/*
+ * is_idle() only accounts for f2fs' own I/O, so also check that the devices
+ * have no requests in flight, e.g. from other partitions or from other
+ * logical units behind the same host.
+ */
+static bool f2fs_devices_idle(struct f2fs_sb_info *sbi)
+{
+	int i;
+
+	if (!f2fs_is_multi_device(sbi))
+		return __is_bdev_idle(sbi->sb->s_bdev);
+
+	for (i = 0; i < sbi->s_ndevs; i++)
+		if (!__is_bdev_idle(FDEV(i).bdev))
+			return false;
+	return true;
+}
+
 static int issue_discard_thread(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -1917,6 +1961,13 @@ static int issue_discard_thread(void *data)
 			continue;
 		}
 
+		/* our own discards were waited for above */
+		if (dpolicy.io_aware && sbi->gc_mode != GC_URGENT_HIGH &&
+		    !f2fs_devices_idle(sbi)) {
+			wait_ms = dpolicy.mid_interval;
+			continue;
+		}
+
 		sb_start_intwrite(sbi->sb);
 
 		issued = __issue_discard_cmd(sbi, &dpolicy);
@@ -2259,9 +2310,26 @@ int f2fs_start_discard_thread(struct f2fs_sb_info *sbi)
 	return err;
 }
 
+/* The coarsest discard granularity of the devices, in blocks */
+static unsigned int f2fs_devices_discard_granularity(struct f2fs_sb_info *sbi)
+{
+	unsigned int gran = 0;
+	int i;
+
+	if (!f2fs_is_multi_device(sbi))
+		return bdev_discard_granularity(sbi->sb->s_bdev) >>
+							F2FS_BLKSIZE_BITS;
+
+	for (i = 0; i < sbi->s_ndevs; i++)
+		gran = max(gran, bdev_discard_granularity(FDEV(i).bdev) >>
+							F2FS_BLKSIZE_BITS);
+	return gran;
+}
+
 static int create_discard_cmd_control(struct f2fs_sb_info *sbi)
 {
 	struct discard_cmd_control *dcc;
+	unsigned int gran;
 	int err = 0, i;
 
 	if (SM_I(sbi)->dcc_info) {
@@ -2276,6 +2344,11 @@ static int create_discard_cmd_control(struct f2fs_sb_info *sbi)
 	dcc->discard_io_aware_gran = MAX_PLIST_NUM;
 	dcc->discard_granularity = DEFAULT_DISCARD_GRANULARITY;
 	dcc->max_ordered_discard = DEFAULT_MAX_ORDERED_DISCARD_GRANULARITY;
+	/* don't issue background discards smaller than any device handles */
+	gran = f2fs_devices_discard_granularity(sbi);
+	if (gran > dcc->discard_granularity)
+		dcc->discard_granularity = min_t(unsigned int, gran,
+						 MAX_PLIST_NUM);
 	if (F2FS_OPTION(sbi).discard_unit == DISCARD_UNIT_SEGMENT)
 		dcc->discard_granularity = sbi->blocks_per_seg;
 	else if (F2FS_OPTION(sbi).discard_unit == DISCARD_UNIT_SECTION)
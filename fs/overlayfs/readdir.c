@@ -13,6 +13,8 @@
 #include <linux/security.h>
 #include <linux/cred.h>
 #include <linux/ratelimit.h>
+#include <linux/shrinker.h>
+#include <linux/module.h>
 #include "overlayfs.h"
 
 struct ovl_cache_entry {
@@ -33,8 +35,30 @@ struct ovl_dir_cache {
 	u64 version;
 	struct list_head entries;
 	struct rb_root root;
+	/* Merged dir cache kept on the inode while the dir is not open */
+	struct list_head lru;
+	struct inode *inode;
+	size_t size;
 };
 
+/*
+ * Merged directory caches are kept on their inode after the last close, so
+ * that the next open doesn't have to read and merge all layers again. They
+ * are validated by the inode version like caches of open directories.
+ * Unused caches sit on a global LRU, bounded by dir_cache_max_kb and trimmed
+ * by a shrinker. The LRU lock nests inside the inode lock; the other way
+ * around, inodes are only ever trylocked.
+ */
+static unsigned int ovl_dir_cache_max_kb = 16384;
+module_param_named(dir_cache_max_kb, ovl_dir_cache_max_kb, uint, 0644);
+MODULE_PARM_DESC(dir_cache_max_kb,
+		 "Memory limit in KiB for merged directory caches of directories that are not open, 0 to disable");
+
+static LIST_HEAD(ovl_dir_cache_lru);
+static DEFINE_SPINLOCK(ovl_dir_cache_lru_lock);
+static unsigned long ovl_dir_cache_lru_bytes;
+static unsigned long ovl_dir_cache_lru_nr;
+
 struct ovl_readdir_data {
 	struct dir_context ctx;
 	struct dentry *dentry;
@@ -225,9 +249,120 @@ void ovl_cache_free(struct list_head *list)
 	INIT_LIST_HEAD(list);
 }
 
+/* Called with ovl_dir_cache_lru_lock held */
+static void ovl_dir_cache_lru_del(struct ovl_dir_cache *cache)
+{
+	list_del_init(&cache->lru);
+	ovl_dir_cache_lru_bytes -= cache->size;
+	ovl_dir_cache_lru_nr--;
+}
+
+static void ovl_dir_cache_unpark(struct ovl_dir_cache *cache)
+{
+	spin_lock(&ovl_dir_cache_lru_lock);
+	if (!list_empty(&cache->lru))
+		ovl_dir_cache_lru_del(cache);
+	spin_unlock(&ovl_dir_cache_lru_lock);
+}
+
+/*
+ * Free up to @nr unused caches from the cold end of the LRU, stopping early
+ * once the LRU is down to @max_bytes.
+ */
+static unsigned long ovl_dir_cache_evict(unsigned long nr,
+					 unsigned long max_bytes)
+{
+	struct ovl_dir_cache *cache, *next;
+	unsigned long freed = 0;
+	LIST_HEAD(dispose);
+
+	spin_lock(&ovl_dir_cache_lru_lock);
+	list_for_each_entry_safe(cache, next, &ovl_dir_cache_lru, lru) {
+		struct inode *inode = cache->inode;
+
+		if (freed >= nr || ovl_dir_cache_lru_bytes <= max_bytes)
+			break;
+		/*
+		 * The inode can't go away under us, ovl_dir_cache_free() takes
+		 * the LRU lock. Holding the inode lock keeps ovl_cache_get()
+		 * from picking the cache up while we take it off the inode.
+		 */
+		if (!inode_trylock(inode))
+			continue;
+		ovl_dir_cache_lru_del(cache);
+		if (ovl_dir_cache(inode) == cache)
+			ovl_set_dir_cache(inode, NULL);
+		inode_unlock(inode);
+		list_add(&cache->lru, &dispose);
+		freed++;
+	}
+	spin_unlock(&ovl_dir_cache_lru_lock);
+
+	list_for_each_entry_safe(cache, next, &dispose, lru) {
+		ovl_cache_free(&cache->entries);
+		kfree(cache);
+	}
+	return freed;
+}
+
+/* Keep an unused merged dir cache on its inode, return false to free it */
+static bool ovl_dir_cache_park(struct ovl_dir_cache *cache)
+{
+	unsigned long max_bytes = READ_ONCE(ovl_dir_cache_max_kb) * 1024UL;
+	bool over;
+
+	if (cache->size > max_bytes)
+		return false;
+
+	spin_lock(&ovl_dir_cache_lru_lock);
+	list_add_tail(&cache->lru, &ovl_dir_cache_lru);
+	ovl_dir_cache_lru_bytes += cache->size;
+	ovl_dir_cache_lru_nr++;
+	over = ovl_dir_cache_lru_bytes > max_bytes;
+	spin_unlock(&ovl_dir_cache_lru_lock);
+
+	if (over)
+		ovl_dir_cache_evict(ULONG_MAX, max_bytes);
+	return true;
+}
+
+static unsigned long ovl_dir_cache_shrink_count(struct shrinker *shrink,
+						struct shrink_control *sc)
+{
+	return READ_ONCE(ovl_dir_cache_lru_nr);
+}
+
+static unsigned long ovl_dir_cache_shrink_scan(struct shrinker *shrink,
+					       struct shrink_control *sc)
+{
+	return ovl_dir_cache_evict(sc->nr_to_scan, 0);
+}
+
+static struct shrinker ovl_dir_cache_shrinker = {
+	.count_objects = ovl_dir_cache_shrink_count,
+	.scan_objects = ovl_dir_cache_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+int __init ovl_dir_cache_init(void)
+{
+	return register_shrinker(&ovl_dir_cache_shrinker, "overlayfs-dir-cache");
+}
+
+void ovl_dir_cache_exit(void)
+{
+	unregister_shrinker(&ovl_dir_cache_shrinker);
+}
+
 void ovl_dir_cache_free(struct inode *inode)
 {
-	struct ovl_dir_cache *cache = ovl_dir_cache(inode);
+	struct ovl_dir_cache *cache;
+
+	spin_lock(&ovl_dir_cache_lru_lock);
+	cache = ovl_dir_cache(inode);
+	if (cache && !list_empty(&cache->lru))
+		ovl_dir_cache_lru_del(cache);
+	spin_unlock(&ovl_dir_cache_lru_lock);
 
 	if (cache) {
 		ovl_cache_free(&cache->entries);
@@ -242,8 +377,12 @@ static void ovl_cache_put(struct ovl_dir_file *od, struct inode *inode)
 	WARN_ON(cache->refcount <= 0);
 	cache->refcount--;
 	if (!cache->refcount) {
-		if (ovl_dir_cache(inode) == cache)
+		if (ovl_dir_cache(inode) == cache) {
+			if (ovl_inode_version_get(inode) == cache->version &&
+			    ovl_dir_cache_park(cache))
+				return;
 			ovl_set_dir_cache(inode, NULL);
+		}
 
 		ovl_cache_free(&cache->entries);
 		kfree(cache);
@@ -394,14 +533,22 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 {
 	int res;
 	struct ovl_dir_cache *cache;
+	struct ovl_cache_entry *p;
 	struct inode *inode = d_inode(dentry);
 
 	cache = ovl_dir_cache(inode);
 	if (cache && ovl_inode_version_get(inode) == cache->version) {
-		WARN_ON(!cache->refcount);
+		/* An unused cache kept from a previous open */
+		if (!cache->refcount)
+			ovl_dir_cache_unpark(cache);
 		cache->refcount++;
 		return cache;
 	}
+	if (cache && !cache->refcount) {
+		ovl_dir_cache_unpark(cache);
+		ovl_cache_free(&cache->entries);
+		kfree(cache);
+	}
 	ovl_set_dir_cache(d_inode(dentry), NULL);
 
 	cache = kzalloc(sizeof(struct ovl_dir_cache), GFP_KERNEL);
@@ -410,6 +557,8 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 
 	cache->refcount = 1;
 	INIT_LIST_HEAD(&cache->entries);
+	INIT_LIST_HEAD(&cache->lru);
+	cache->inode = inode;
 	cache->root = RB_ROOT;
 
 	res = ovl_dir_read_merged(dentry, &cache->entries, &cache->root);
@@ -419,6 +568,9 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 		return ERR_PTR(res);
 	}
 
+	list_for_each_entry(p, &cache->entries, l_node)
+		cache->size += offsetof(struct ovl_cache_entry, name[p->len + 1]);
+	cache->size += sizeof(*cache);
 	cache->version = ovl_inode_version_get(inode);
 	ovl_set_dir_cache(inode, cache);
 
@@ -613,6 +765,8 @@ static struct ovl_dir_cache *ovl_cache_get_impure(const struct path *path)
 	cache = kzalloc(sizeof(struct ovl_dir_cache), GFP_KERNEL);
 	if (!cache)
 		return ERR_PTR(-ENOMEM);
+	INIT_LIST_HEAD(&cache->lru);
+	cache->inode = inode;
 
 	res = ovl_dir_read_impure(path, &cache->entries, &cache->root);
 	if (res) {
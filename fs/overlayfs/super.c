@@ -1540,6 +1540,10 @@ static int __init ovl_init(void)
 	if (ovl_inode_cachep == NULL)
 		return -ENOMEM;
 
+	err = ovl_dir_cache_init();
+	if (err)
+		goto out_inode_cache;
+
 	err = ovl_aio_request_cache_init();
 	if (!err) {
 		err = register_filesystem(&ovl_fs_type);
@@ -1548,6 +1552,8 @@ static int __init ovl_init(void)
 
 		ovl_aio_request_cache_destroy();
 	}
+	ovl_dir_cache_exit();
+out_inode_cache:
 	kmem_cache_destroy(ovl_inode_cachep);
 
 	return err;
@@ -1564,6 +1570,7 @@ static void __exit ovl_exit(void)
 	rcu_barrier();
 	kmem_cache_destroy(ovl_inode_cachep);
 	ovl_aio_request_cache_destroy();
+	ovl_dir_cache_exit();
 }
 
 module_init(ovl_init);
@@ -785,6 +785,23 @@ bool pipe_is_unprivileged_user(void)
 	return !capable(CAP_SYS_RESOURCE) && !capable(CAP_SYS_ADMIN);
 }
 
+/*
+ * Whether a pipe may be grown to @nr_slots, with @user_bufs then charged to
+ * its user, by a resize the user did not ask for.  Such growth is only an
+ * optimization, so it honours pipe_max_size and leaves at least half of the
+ * soft limit free for the user's own pipes, privileged or not.
+ */
+bool pipe_may_grow_implicitly(unsigned int nr_slots, unsigned long user_bufs)
+{
+	unsigned long soft_limit = READ_ONCE(pipe_user_pages_soft);
+
+	if ((unsigned long)nr_slots * PAGE_SIZE > READ_ONCE(pipe_max_size))
+		return false;
+	if (too_many_pipe_buffers_hard(user_bufs))
+		return false;
+	return !soft_limit || user_bufs <= soft_limit / 2;
+}
+
 struct pipe_inode_info *alloc_pipe_info(void)
 {
 	struct pipe_inode_info *pipe;
@@ -17,6 +17,7 @@
 #include <linux/cred.h>
 #include <linux/mm.h>
 #include <linux/printk.h>
+#include <linux/sched/signal.h>
 #include <linux/string_helpers.h>
 #include <linux/uio.h>
 
@@ -220,6 +221,7 @@ ssize_t seq_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 		if (m->count)	// hadn't managed to copy everything
 			goto Done;
 	}
+Again:
 	// get a non-empty record in the buffer
 	m->from = 0;
 	p = m->op->start(m, &m->index);
@@ -282,6 +284,13 @@ ssize_t seq_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 	copied += n;
 	m->count -= n;
 	m->from = n;
+	// the buffer was drained but the reader asked for more: refill it
+	// rather than returning a short read and having them come back
+	if (!m->count && p && !IS_ERR(p) && err >= 0 &&
+	    iov_iter_count(iter) && !fatal_signal_pending(current)) {
+		cond_resched();
+		goto Again;
+	}
 Done:
 	if (unlikely(!copied)) {
 		copied = m->count ? -EFAULT : err;
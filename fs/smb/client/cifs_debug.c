@@ -133,6 +133,20 @@ static void cifs_debug_tcon(struct seq_file *m, struct cifs_tcon *tcon)
 	seq_putc(m, '\n');
 }
 
+#ifdef CONFIG_CIFS_STATS2
+static void
+cifs_dump_channel_cmd(struct seq_file *m, const char *name,
+		      struct TCP_Server_Info *server, int cmd)
+{
+	int count = atomic_read(&server->num_cmds[cmd]);
+	u64 avg = count ? div_u64(server->time_per_cmd[cmd], count) : 0;
+
+	seq_printf(m, "\n\t\t%s: %d Avg rsp time: %u ms Slow: %d",
+		   name, count, jiffies_to_msecs(avg),
+		   atomic_read(&server->smb2slowcmd[cmd]));
+}
+#endif /* STATS2 */
+
 static void
 cifs_dump_channel(struct seq_file *m, int i, struct cifs_chan *chan)
 {
@@ -164,6 +178,10 @@ cifs_dump_channel(struct seq_file *m, int i, struct cifs_chan *chan)
 	if (server->net)
 		seq_printf(m, " Net namespace: %u ", server->net->ns.inum);
 #endif /* NET_NS */
+#ifdef CONFIG_CIFS_STATS2
+	cifs_dump_channel_cmd(m, "Reads", server, SMB2_READ_HE);
+	cifs_dump_channel_cmd(m, "Writes", server, SMB2_WRITE_HE);
+#endif /* STATS2 */
 
 }
 
@@ -806,6 +824,7 @@ PROC_FILE_DEFINE(smbd_max_fragmented_recv_size);
 PROC_FILE_DEFINE(smbd_max_send_size);
 PROC_FILE_DEFINE(smbd_send_credit_target);
 PROC_FILE_DEFINE(smbd_receive_credit_max);
+PROC_FILE_DEFINE(smbd_mr_pool_factor);
 #endif
 
 static struct proc_dir_entry *proc_fs_cifs;
@@ -862,6 +881,8 @@ cifs_proc_init(void)
 		&cifs_smbd_send_credit_target_proc_fops);
 	proc_create("smbd_receive_credit_max", 0644, proc_fs_cifs,
 		&cifs_smbd_receive_credit_max_proc_fops);
+	proc_create("smbd_mr_pool_factor", 0644, proc_fs_cifs,
+		&cifs_smbd_mr_pool_factor_proc_fops);
 #endif
 }
 
@@ -893,6 +914,7 @@ cifs_proc_clean(void)
 	remove_proc_entry("smbd_max_send_size", proc_fs_cifs);
 	remove_proc_entry("smbd_send_credit_target", proc_fs_cifs);
 	remove_proc_entry("smbd_receive_credit_max", proc_fs_cifs);
+	remove_proc_entry("smbd_mr_pool_factor", proc_fs_cifs);
 #endif
 	remove_proc_entry("fs/cifs", NULL);
 }
@@ -107,6 +107,13 @@ int smbd_keep_alive_interval = 120;
 /* Default maximum number of pages in a single RDMA write/read */
 int smbd_max_frmr_depth = 2048;
 
+/*
+ * Number of MRs allocated per hardware responder resource, i.e. how many
+ * RDMA read/write buffers can be registered at once before I/O has to wait
+ * for an MR to be recovered
+ */
+int smbd_mr_pool_factor = 2;
+
 /* If payload is less than this byte, use RDMA send/recv not read/write */
 int rdma_readwrite_threshold = 4096;
 
@@ -2122,7 +2129,7 @@ static void destroy_mr_list(struct smbd_connection *info)
  */
 static int allocate_mr_list(struct smbd_connection *info)
 {
-	int i;
+	int i, nr_mrs;
 	struct smbd_mr *smbdirect_mr, *tmp;
 
 	INIT_LIST_HEAD(&info->mr_list);
@@ -2132,8 +2139,10 @@ static int allocate_mr_list(struct smbd_connection *info)
 	atomic_set(&info->mr_used_count, 0);
 	init_waitqueue_head(&info->wait_for_mr_cleanup);
 	INIT_WORK(&info->mr_recovery_work, smbd_mr_recovery_work);
-	/* Allocate more MRs (2x) than hardware responder_resources */
-	for (i = 0; i < info->responder_resources * 2; i++) {
+	/* Allocate more MRs (2x by default) than hardware responder_resources */
+	nr_mrs = info->responder_resources * clamp(smbd_mr_pool_factor, 1, 16);
+	log_rdma_mr(INFO, "allocating %d MRs\n", nr_mrs);
+	for (i = 0; i < nr_mrs; i++) {
 		smbdirect_mr = kzalloc(sizeof(*smbdirect_mr), GFP_KERNEL);
 		if (!smbdirect_mr)
 			goto out;
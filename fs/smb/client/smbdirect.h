@@ -23,6 +23,7 @@ extern int smbd_max_fragmented_recv_size;
 extern int smbd_max_send_size;
 extern int smbd_send_credit_target;
 extern int smbd_receive_credit_max;
+extern int smbd_mr_pool_factor;
 
 enum keep_alive_status {
 	KEEP_ALIVE_NONE,
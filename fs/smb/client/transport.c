@@ -1021,6 +1021,7 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 {
 	uint index = 0;
 	unsigned int min_in_flight = UINT_MAX, max_in_flight = 0;
+	unsigned int best_credits = 0, min_credits = UINT_MAX, max_credits = 0;
 	struct TCP_Server_Info *server = NULL;
 	int i;
 
@@ -1042,18 +1043,27 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 		 * race while reading this data. The worst that can happen is
 		 * that we could use a channel that's not least loaded. Avoiding
 		 * taking the lock could help reduce wait time, which is
-		 * important for this function
+		 * important for this function. The same goes for
+		 * server->credits, which breaks ties between channels with
+		 * the same number of requests in flight: the one the server
+		 * has granted more credits can take a large read or write
+		 * without waiting.
 		 */
-		if (server->in_flight < min_in_flight) {
+		if (server->in_flight < min_in_flight ||
+		    (server->in_flight == min_in_flight &&
+		     server->credits > best_credits)) {
 			min_in_flight = server->in_flight;
+			best_credits = server->credits;
 			index = i;
 		}
 		if (server->in_flight > max_in_flight)
 			max_in_flight = server->in_flight;
+		min_credits = min(min_credits, server->credits);
+		max_credits = max(max_credits, server->credits);
 	}
 
 	/* if all channels are equally loaded, fall back to round-robin */
-	if (min_in_flight == max_in_flight) {
+	if (min_in_flight == max_in_flight && min_credits == max_credits) {
 		index = (uint)atomic_inc_return(&ses->chan_seq);
 		index %= ses->chan_count;
 	}
@@ -994,6 +994,45 @@ long vfs_splice_read(struct file *in, loff_t *ppos,
 }
 EXPORT_SYMBOL_GPL(vfs_splice_read);
 
+/*
+ * Upper bound on the number of slots the process-private pipe used by
+ * splice_direct_to_actor() is grown to.
+ */
+#define SPLICE_DIRECT_MAX_BUFFERS	(PIPE_DEF_BUFFERS * 16)
+
+/*
+ * Grow the (empty) internal pipe so that a large sendfile() moves up to
+ * SPLICE_DIRECT_MAX_BUFFERS pages per read/actor round trip instead of
+ * PIPE_DEF_BUFFERS.  The slots are accounted to the user like F_SETPIPE_SZ
+ * and stay so for the life of the pipe, so the pipe is only grown within
+ * pipe_max_size and while the user is well below its soft limit.
+ */
+static void splice_direct_grow_pipe(struct pipe_inode_info *pipe, size_t len)
+{
+	unsigned long user_bufs;
+	unsigned int nr_slots;
+
+	if (pipe->max_usage >= SPLICE_DIRECT_MAX_BUFFERS ||
+	    len <= ((size_t)pipe->max_usage << PAGE_SHIFT))
+		return;
+
+	nr_slots = min_t(size_t, DIV_ROUND_UP(len, PAGE_SIZE),
+			 SPLICE_DIRECT_MAX_BUFFERS);
+	nr_slots = roundup_pow_of_two(nr_slots);
+
+	user_bufs = account_pipe_buffers(pipe->user, pipe->nr_accounted,
+					 nr_slots);
+	if (!pipe_may_grow_implicitly(nr_slots, user_bufs))
+		goto out_revert_acct;
+
+	if (pipe_resize_ring(pipe, nr_slots) < 0)
+		goto out_revert_acct;
+	return;
+
+out_revert_acct:
+	(void) account_pipe_buffers(pipe->user, nr_slots, pipe->nr_accounted);
+}
+
 /**
  * splice_direct_to_actor - splices data directly between two non-pipes
  * @in:		file to splice from
@@ -1062,6 +1101,8 @@ ssize_t splice_direct_to_actor(struct file *in, struct splice_desc *sd,
 
 	WARN_ON_ONCE(!pipe_empty(pipe->head, pipe->tail));
 
+	splice_direct_grow_pipe(pipe, len);
+
 	while (len) {
 		size_t read_len;
 		loff_t pos = sd->pos, prev_pos = pos;
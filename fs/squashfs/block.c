@@ -186,8 +186,20 @@ static struct page *squashfs_get_cache_page(struct address_space *mapping,
 	return page;
 }
 
-static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
-			     struct bio **biop, int *block_offset)
+static void squashfs_bio_free(struct bio *bio)
+{
+	bio_free_pages(bio);
+	bio_uninit(bio);
+	kfree(bio);
+}
+
+/*
+ * Allocate a bio covering the device blocks holding [index, index + length),
+ * reusing any uptodate pages found in the cache mapping.  The bio is not
+ * submitted.
+ */
+static int squashfs_bio_alloc(struct super_block *sb, u64 index, int length,
+			      struct bio **biop, int *page_countp)
 {
 	struct squashfs_sb_info *msblk = sb->s_fs_info;
 	struct address_space *cache_mapping = msblk->cache_mapping;
@@ -198,7 +210,7 @@ static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
 	int offset = read_start - round_down(index, PAGE_SIZE);
 	int total_len = (block_end - block) << msblk->devblksize_log2;
 	const int page_count = DIV_ROUND_UP(total_len + offset, PAGE_SIZE);
-	int error, i;
+	int i;
 	struct bio *bio;
 
 	bio = bio_kmalloc(page_count, GFP_NOIO);
@@ -218,8 +230,8 @@ static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
 			page = alloc_page(GFP_NOIO);
 
 		if (!page) {
-			error = -ENOMEM;
-			goto out_free_bio;
+			squashfs_bio_free(bio);
+			return -ENOMEM;
 		}
 
 		/*
@@ -231,24 +243,61 @@ static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
 		total_len -= len;
 	}
 
+	*biop = bio;
+	*page_countp = page_count;
+	return 0;
+}
+
+static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
+			     struct bio **biop, int *block_offset)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	struct address_space *cache_mapping = msblk->cache_mapping;
+	const u64 read_start = round_down(index, msblk->devblksize);
+	const u64 read_end = round_up(index + length, msblk->devblksize);
+	int error, page_count;
+	struct bio *bio;
+
+	error = squashfs_bio_alloc(sb, index, length, &bio, &page_count);
+	if (error)
+		return error;
+
 	if (cache_mapping)
 		error = squashfs_bio_read_cached(bio, cache_mapping, index,
 						 length, read_start, read_end,
 						 page_count);
 	else
 		error = submit_bio_wait(bio);
-	if (error)
-		goto out_free_bio;
+	if (error) {
+		squashfs_bio_free(bio);
+		return error;
+	}
 
 	*biop = bio;
 	*block_offset = index & ((1 << msblk->devblksize_log2) - 1);
 	return 0;
+}
 
-out_free_bio:
-	bio_free_pages(bio);
-	bio_uninit(bio);
-	kfree(bio);
-	return error;
+static int squashfs_decompress_bio(struct squashfs_sb_info *msblk,
+				   struct bio *bio, int offset, int length,
+				   int compressed,
+				   struct squashfs_page_actor *output)
+{
+	if (!compressed)
+		return copy_bio_to_actor(bio, output, offset, length);
+
+	if (!msblk->stream)
+		return -EIO;
+
+	return msblk->thread_ops->decompress(msblk, bio, offset, length, output);
+}
+
+static void squashfs_read_error(struct squashfs_sb_info *msblk, u64 index,
+				int res)
+{
+	ERROR("Failed to read block 0x%llx: %d\n", index, res);
+	if (msblk->panic_on_errors)
+		panic("squashfs read failed");
 }
 
 /*
@@ -310,9 +359,7 @@ int squashfs_read_data(struct super_block *sb, u64 index, int length,
 			data = bvec_virt(bvec);
 			length |= data[0] << 8;
 		}
-		bio_free_pages(bio);
-		bio_uninit(bio);
-		kfree(bio);
+		squashfs_bio_free(bio);
 
 		compressed = SQUASHFS_COMPRESSED(length);
 		length = SQUASHFS_COMPRESSED_SIZE(length);
@@ -334,26 +381,111 @@ int squashfs_read_data(struct super_block *sb, u64 index, int length,
 	if (res)
 		goto out;
 
-	if (compressed) {
-		if (!msblk->stream) {
-			res = -EIO;
-			goto out_free_bio;
-		}
-		res = msblk->thread_ops->decompress(msblk, bio, offset, length, output);
-	} else {
-		res = copy_bio_to_actor(bio, output, offset, length);
-	}
+	res = squashfs_decompress_bio(msblk, bio, offset, length, compressed,
+				      output);
 
 out_free_bio:
-	bio_free_pages(bio);
-	bio_uninit(bio);
-	kfree(bio);
+	squashfs_bio_free(bio);
 out:
-	if (res < 0) {
-		ERROR("Failed to read block 0x%llx: %d\n", index, res);
-		if (msblk->panic_on_errors)
-			panic("squashfs read failed");
-	}
+	if (res < 0)
+		squashfs_read_error(msblk, index, res);
+
+	return res;
+}
+
+static void squashfs_prefetch_end_io(struct bio *bio)
+{
+	complete(bio->bi_private);
+}
+
+/*
+ * Start reading the datablock at index without waiting for the I/O, so that
+ * readahead can decompress one block while the device is transferring the
+ * next one.  Only the uncached bio path is pipelined: with a cache mapping
+ * the read may be split around cached pages and is left synchronous.
+ *
+ * On success the read must be completed with squashfs_read_prefetched() or
+ * dropped with squashfs_prefetch_release().
+ */
+int squashfs_prefetch_data(struct super_block *sb, u64 index, int length,
+			   struct squashfs_prefetch *pf)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	int size = SQUASHFS_COMPRESSED_SIZE_BLOCK(length);
+	int page_count, res;
+	struct bio *bio;
+
+	squashfs_prefetch_release(pf);
+
+	if (msblk->cache_mapping)
+		return -EOPNOTSUPP;
+
+	if (size <= 0 || size > msblk->block_size ||
+			(index + size) > msblk->bytes_used)
+		return -EIO;
+
+	res = squashfs_bio_alloc(sb, index, size, &bio, &page_count);
+	if (res)
+		return res;
+
+	init_completion(&pf->done);
+	bio->bi_private = &pf->done;
+	bio->bi_end_io = squashfs_prefetch_end_io;
+	submit_bio(bio);
+	/*
+	 * Readahead runs under a plug, which would hold the bio back until we
+	 * sleep waiting for it, i.e. until after the decompression it is
+	 * meant to overlap with: send it to the device now.
+	 */
+	blk_flush_plug(current->plug, false);
+
+	pf->bio = bio;
+	pf->index = index;
+	pf->length = length;
+	return 0;
+}
+
+void squashfs_prefetch_release(struct squashfs_prefetch *pf)
+{
+	if (!pf->bio)
+		return;
+
+	wait_for_completion_io(&pf->done);
+	squashfs_bio_free(pf->bio);
+	pf->bio = NULL;
+}
+
+/*
+ * Wait for a datablock started with squashfs_prefetch_data() and decompress
+ * it into output.  The prefetch is released in all cases.
+ */
+int squashfs_read_prefetched(struct super_block *sb,
+			     struct squashfs_prefetch *pf,
+			     struct squashfs_page_actor *output)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	struct bio *bio = pf->bio;
+	int compressed = SQUASHFS_COMPRESSED_BLOCK(pf->length);
+	int length = SQUASHFS_COMPRESSED_SIZE_BLOCK(pf->length);
+	int offset = pf->index & ((1 << msblk->devblksize_log2) - 1);
+	int res;
+
+	wait_for_completion_io(&pf->done);
+	pf->bio = NULL;
+
+	TRACE("Block @ 0x%llx, %scompressed size %d, src size %d (prefetched)\n",
+		pf->index, compressed ? "" : "un", length, output->length);
+
+	res = blk_status_to_errno(bio->bi_status);
+	if (!res && length > output->length)
+		res = -EIO;
+	if (!res)
+		res = squashfs_decompress_bio(msblk, bio, offset, length,
+					      compressed, output);
+
+	squashfs_bio_free(bio);
+	if (res < 0)
+		squashfs_read_error(msblk, pf->index, res);
 
 	return res;
 }
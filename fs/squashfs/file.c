@@ -546,6 +546,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	struct page **pages;
 	int i, file_end = i_size_read(inode) >> msblk->block_log;
 	unsigned int max_pages = 1UL << shift;
+	struct squashfs_prefetch pf[2] = {};
+	int cur = 0;
 
 	readahead_expand(ractl, start, (len | mask) + 1);
 
@@ -554,6 +556,7 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		return;
 
 	for (;;) {
+		struct squashfs_prefetch *this = &pf[cur], *next = &pf[cur ^ 1];
 		pgoff_t index;
 		int res, bsize;
 		u64 block = 0;
@@ -596,7 +599,32 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (!actor)
 			goto skip_pages;
 
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
+		if (this->bio && (this->index != block || this->length != bsize))
+			squashfs_prefetch_release(this);
+
+		/*
+		 * Get the I/O for the next datablock of this readahead window
+		 * going before decompressing the current one.
+		 */
+		if (readahead_count(ractl) &&
+		    ((loff_t)(index + 1) << msblk->block_log) < i_size_read(inode) &&
+		    (index + 1 < file_end || squashfs_i(inode)->fragment_block ==
+						SQUASHFS_INVALID_BLK)) {
+			u64 next_block;
+			int next_bsize = read_blocklist(inode, index + 1,
+							&next_block);
+
+			if (next_bsize > 0)
+				squashfs_prefetch_data(inode->i_sb, next_block,
+						       next_bsize, next);
+		}
+		cur ^= 1;
+
+		if (this->bio)
+			res = squashfs_read_prefetched(inode->i_sb, this, actor);
+		else
+			res = squashfs_read_data(inode->i_sb, block, bsize, NULL,
+						 actor);
 
 		last_page = squashfs_page_actor_free(actor);
 
@@ -621,6 +649,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		}
 	}
 
+	squashfs_prefetch_release(&pf[0]);
+	squashfs_prefetch_release(&pf[1]);
 	kfree(pages);
 	return;
 
@@ -629,6 +659,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		unlock_page(pages[i]);
 		put_page(pages[i]);
 	}
+	squashfs_prefetch_release(&pf[0]);
+	squashfs_prefetch_release(&pf[1]);
 	kfree(pages);
 }
 
@@ -15,8 +15,21 @@
 #define WARNING(s, args...)	pr_warn("SQUASHFS: "s, ## args)
 
 /* block.c */
+struct squashfs_prefetch {
+	struct bio		*bio;
+	struct completion	done;
+	u64			index;
+	int			length;
+};
+
 extern int squashfs_read_data(struct super_block *, u64, int, u64 *,
 				struct squashfs_page_actor *);
+extern int squashfs_prefetch_data(struct super_block *, u64, int,
+				struct squashfs_prefetch *);
+extern void squashfs_prefetch_release(struct squashfs_prefetch *);
+extern int squashfs_read_prefetched(struct super_block *,
+				struct squashfs_prefetch *,
+				struct squashfs_page_actor *);
 
 /* cache.c */
 extern struct squashfs_cache *squashfs_cache_init(char *, int, int);
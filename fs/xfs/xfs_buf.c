@@ -1001,6 +1001,7 @@ xfs_buf_rele(
 	struct xfs_perag	*pag = bp->b_pag;
 	bool			release;
 	bool			freebuf = false;
+	int			hold;
 
 	trace_xfs_buf_rele(bp, _RET_IP_);
 
@@ -1015,6 +1016,20 @@ xfs_buf_rele(
 
 	ASSERT(atomic_read(&bp->b_hold) > 0);
 
+	/*
+	 * Hot metadata buffers (AGF, AGI, btree roots) are held by many threads
+	 * at once. As long as at least two other references remain after ours
+	 * is dropped this cannot be the last or the second to last reference,
+	 * so none of the LRU and in-flight accounting below applies and we
+	 * don't touch the buffer after the decrement. Drop the reference
+	 * without bouncing b_lock between CPUs then.
+	 */
+	hold = atomic_read(&bp->b_hold);
+	while (hold > 2) {
+		if (atomic_try_cmpxchg(&bp->b_hold, &hold, hold - 1))
+			return;
+	}
+
 	/*
 	 * We grab the b_lock here first to serialise racing xfs_buf_rele()
 	 * calls. The pag_buf_lock being taken on the last reference only
@@ -23,6 +23,7 @@
 #include "xfs_reflink.h"
 #include "xfs_ialloc.h"
 #include "xfs_ag.h"
+#include "xfs_log.h"
 #include "xfs_log_priv.h"
 
 #include <linux/iversion.h>
@@ -1847,6 +1848,7 @@ xfs_inodegc_worker(
 	struct xfs_inode	*ip, *n;
 	struct xfs_mount	*mp = gc->mp;
 	unsigned int		nofs_flag;
+	unsigned int		items;
 
 	/*
 	 * Clear the cpu mask bit and ensure that we have seen the latest
@@ -1857,6 +1859,7 @@ xfs_inodegc_worker(
 	cpumask_clear_cpu(gc->cpu, &mp->m_inodegc_cpumask);
 	smp_mb__after_atomic();
 
+	items = READ_ONCE(gc->items);
 	WRITE_ONCE(gc->items, 0);
 
 	if (!node)
@@ -1870,7 +1873,7 @@ xfs_inodegc_worker(
 	nofs_flag = memalloc_nofs_save();
 
 	ip = llist_entry(node, struct xfs_inode, i_gclist);
-	trace_xfs_inodegc_worker(mp, READ_ONCE(gc->shrinker_hits));
+	trace_xfs_inodegc_worker(mp, items, READ_ONCE(gc->shrinker_hits));
 
 	WRITE_ONCE(gc->shrinker_hits, 0);
 	llist_for_each_entry_safe(ip, n, node, i_gclist) {
@@ -1885,6 +1888,19 @@ xfs_inodegc_worker(
 	memalloc_nofs_restore(nofs_flag);
 }
 
+/* Approximate number of inodes waiting for inactivation on all CPUs. */
+unsigned int
+xfs_inodegc_backlog(
+	struct xfs_mount	*mp)
+{
+	unsigned int		items = 0;
+	int			cpu;
+
+	for_each_cpu(cpu, &mp->m_inodegc_cpumask)
+		items += READ_ONCE(per_cpu_ptr(mp->m_inodegc, cpu)->items);
+	return items;
+}
+
 /*
  * Expedite all pending inodegc work to run immediately. This does not wait for
  * completion of the work.
@@ -2025,11 +2041,28 @@ xfs_inodegc_want_queue_work(
  */
 #define XFS_INODEGC_MAX_BACKLOG		(4 * XFS_INODES_PER_CHUNK)
 
+/*
+ * Size the percpu backlog by the free log space: every queued inactivation
+ * needs a log reservation, and once the log is short of space those wait for
+ * the tail to move.  A deep backlog then only turns into a long stall for the
+ * frontend that finally hits the limit, so throttle the frontend earlier and
+ * let unlinks proceed at the pace the log can absorb them.
+ */
+static inline unsigned int
+xfs_inodegc_max_backlog(
+	struct xfs_mount	*mp)
+{
+	if (xfs_log_space_low(mp))
+		return XFS_INODEGC_MAX_BACKLOG / 4;
+	return XFS_INODEGC_MAX_BACKLOG;
+}
+
 /*
  * Make the frontend wait for inactivations when:
  *
  *  - Memory shrinkers queued the inactivation worker and it hasn't finished.
- *  - The queue depth exceeds the maximum allowable percpu backlog.
+ *  - The queue depth exceeds the maximum allowable percpu backlog, which is
+ *    smaller while the log is short of space.
  *
  * Note: If the current thread is running a transaction, we don't ever want to
  * wait for other transactions because that could introduce a deadlock.
@@ -2046,7 +2079,8 @@ xfs_inodegc_want_flush_work(
 	if (shrinker_hits > 0)
 		return true;
 
-	if (items > XFS_INODEGC_MAX_BACKLOG)
+	if (items > XFS_INODEGC_MAX_BACKLOG / 4 &&
+	    items > xfs_inodegc_max_backlog(ip->i_mount))
 		return true;
 
 	return false;
@@ -373,6 +373,17 @@ xlog_grant_head_check(
 	return error;
 }
 
+/*
+ * Is the log short of space for new reservations, i.e. would a reservation
+ * have to push the tail of the log first?
+ */
+bool
+xfs_log_space_low(
+	struct xfs_mount	*mp)
+{
+	return xlog_grant_push_threshold(mp->m_log, 0) != NULLCOMMITLSN;
+}
+
 bool
 xfs_log_writable(
 	struct xfs_mount	*mp)
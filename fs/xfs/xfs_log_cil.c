@@ -1751,12 +1751,14 @@ xlog_cil_init(
 	if (!cil)
 		return -ENOMEM;
 	/*
-	 * Limit the CIL pipeline depth to 4 concurrent works to bound the
-	 * concurrency the log spinlocks will be exposed to.
+	 * Limit the CIL pipeline depth to bound the concurrency the log
+	 * spinlocks will be exposed to. Every checkpoint in flight occupies at
+	 * least one iclog, so allow as many concurrent pushes as there are
+	 * iclogs, but never fewer than 4.
 	 */
 	cil->xc_push_wq = alloc_workqueue("xfs-cil/%s",
 			XFS_WQFLAGS(WQ_FREEZABLE | WQ_MEM_RECLAIM | WQ_UNBOUND),
-			4, log->l_mp->m_super->s_id);
+			max(4, log->l_iclog_bufs), log->l_mp->m_super->s_id);
 	if (!cil->xc_push_wq)
 		goto out_destroy_cil;
 
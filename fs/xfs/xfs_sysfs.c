@@ -13,6 +13,7 @@
 #include "xfs_log.h"
 #include "xfs_log_priv.h"
 #include "xfs_mount.h"
+#include "xfs_icache.h"
 
 struct xfs_sysfs_attr {
 	struct attribute attr;
@@ -64,7 +65,25 @@ static const struct sysfs_ops xfs_sysfs_ops = {
 	.store = xfs_sysfs_object_store,
 };
 
+static inline struct xfs_mount *
+to_mp(struct kobject *kobject)
+{
+	struct xfs_kobj *kobj = to_kobj(kobject);
+
+	return container_of(kobj, struct xfs_mount, m_kobj);
+}
+
+STATIC ssize_t
+inodegc_backlog_show(
+	struct kobject	*kobject,
+	char		*buf)
+{
+	return sysfs_emit(buf, "%u\n", xfs_inodegc_backlog(to_mp(kobject)));
+}
+XFS_SYSFS_ATTR_RO(inodegc_backlog);
+
 static struct attribute *xfs_mp_attrs[] = {
+	ATTR_LIST(inodegc_backlog),
 	NULL,
 };
 ATTRIBUTE_GROUPS(xfs_mp);
@@ -202,18 +202,22 @@ DEFINE_PERAG_REF_EVENT(xfs_perag_set_inode_tag);
 DEFINE_PERAG_REF_EVENT(xfs_perag_clear_inode_tag);
 
 TRACE_EVENT(xfs_inodegc_worker,
-	TP_PROTO(struct xfs_mount *mp, unsigned int shrinker_hits),
-	TP_ARGS(mp, shrinker_hits),
+	TP_PROTO(struct xfs_mount *mp, unsigned int items,
+		 unsigned int shrinker_hits),
+	TP_ARGS(mp, items, shrinker_hits),
 	TP_STRUCT__entry(
 		__field(dev_t, dev)
+		__field(unsigned int, items)
 		__field(unsigned int, shrinker_hits)
 	),
 	TP_fast_assign(
 		__entry->dev = mp->m_super->s_dev;
+		__entry->items = items;
 		__entry->shrinker_hits = shrinker_hits;
 	),
-	TP_printk("dev %d:%d shrinker_hits %u",
+	TP_printk("dev %d:%d items %u shrinker_hits %u",
 		  MAJOR(__entry->dev), MINOR(__entry->dev),
+		  __entry->items,
 		  __entry->shrinker_hits)
 );
 
@@ -43,6 +43,8 @@ struct acomp_req {
  *
  * @compress:		Function performs a compress operation
  * @decompress:		Function performs a de-compress operation
+ * @compress_batch:	Optional, performs several compress operations
+ * @decompress_batch:	Optional, performs several de-compress operations
  * @dst_free:		Frees destination buffer if allocated inside the
  *			algorithm
  * @reqsize:		Context size for (de)compression requests
@@ -51,6 +53,10 @@ struct acomp_req {
 struct crypto_acomp {
 	int (*compress)(struct acomp_req *req);
 	int (*decompress)(struct acomp_req *req);
+	void (*compress_batch)(struct acomp_req *reqs[], int errs[],
+			       unsigned int nr);
+	void (*decompress_batch)(struct acomp_req *reqs[], int errs[],
+				 unsigned int nr);
 	void (*dst_free)(struct scatterlist *dst);
 	unsigned int reqsize;
 	struct crypto_tfm base;
@@ -328,4 +334,93 @@ static inline int crypto_acomp_decompress(struct acomp_req *req)
 	return crypto_comp_errstat(alg, tfm->decompress(req));
 }
 
+static inline int __crypto_acomp_batch(struct acomp_req *reqs[], int errs[],
+				       unsigned int nr, bool compress)
+{
+	struct crypto_acomp *tfm;
+	struct comp_alg_common *alg;
+	unsigned int i;
+	int ret = 0;
+
+	if (!nr)
+		return 0;
+
+	tfm = crypto_acomp_reqtfm(reqs[0]);
+	alg = crypto_comp_alg_common(tfm);
+
+	if (IS_ENABLED(CONFIG_CRYPTO_STATS)) {
+		struct crypto_istat_compress *istat = comp_get_stat(alg);
+
+		for (i = 0; i < nr; i++) {
+			if (compress) {
+				atomic64_inc(&istat->compress_cnt);
+				atomic64_add(reqs[i]->slen,
+					     &istat->compress_tlen);
+			} else {
+				atomic64_inc(&istat->decompress_cnt);
+				atomic64_add(reqs[i]->slen,
+					     &istat->decompress_tlen);
+			}
+		}
+	}
+
+	if (compress && tfm->compress_batch)
+		tfm->compress_batch(reqs, errs, nr);
+	else if (!compress && tfm->decompress_batch)
+		tfm->decompress_batch(reqs, errs, nr);
+	else
+		for (i = 0; i < nr; i++)
+			errs[i] = compress ? tfm->compress(reqs[i]) :
+					     tfm->decompress(reqs[i]);
+
+	for (i = 0; i < nr; i++) {
+		errs[i] = crypto_comp_errstat(alg, errs[i]);
+		if (errs[i] && !ret)
+			ret = errs[i];
+	}
+
+	return ret;
+}
+
+/**
+ * crypto_acomp_compress_batch() -- Invoke several compress operations
+ *
+ * Function submits a batch of independent compress requests in one call,
+ * letting the implementation amortize its per-request setup. All requests
+ * must have been allocated for the same tfm. The outcome of each request is
+ * stored in @errs and is what crypto_acomp_compress() would have returned
+ * for it; in particular, asynchronous implementations may report
+ * -EINPROGRESS and complete the request through its callback.
+ *
+ * @reqs:	array of asynchronous compress requests
+ * @errs:	array receiving the status of each request
+ * @nr:		number of requests in @reqs
+ *
+ * Return:	zero if every request completed successfully, otherwise the
+ *		first non-zero status in @errs
+ */
+static inline int crypto_acomp_compress_batch(struct acomp_req *reqs[],
+					      int errs[], unsigned int nr)
+{
+	return __crypto_acomp_batch(reqs, errs, nr, true);
+}
+
+/**
+ * crypto_acomp_decompress_batch() -- Invoke several decompress operations
+ *
+ * Decompress counterpart of crypto_acomp_compress_batch().
+ *
+ * @reqs:	array of asynchronous decompress requests
+ * @errs:	array receiving the status of each request
+ * @nr:		number of requests in @reqs
+ *
+ * Return:	zero if every request completed successfully, otherwise the
+ *		first non-zero status in @errs
+ */
+static inline int crypto_acomp_decompress_batch(struct acomp_req *reqs[],
+						int errs[], unsigned int nr)
+{
+	return __crypto_acomp_batch(reqs, errs, nr, false);
+}
+
 #endif
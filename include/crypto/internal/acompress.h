@@ -17,6 +17,11 @@
  *
  * @compress:	Function performs a compress operation
  * @decompress:	Function performs a de-compress operation
+ * @compress_batch:	Optional, performs several compress operations on
+ *		requests for the same tfm and stores each status in the
+ *		second array. Drivers that can queue many operations per
+ *		submission should implement it.
+ * @decompress_batch:	Optional, batched counterpart of @decompress
  * @dst_free:	Frees destination buffer if allocated inside the algorithm
  * @init:	Initialize the cryptographic transformation object.
  *		This function is used to initialize the cryptographic
@@ -38,6 +43,10 @@
 struct acomp_alg {
 	int (*compress)(struct acomp_req *req);
 	int (*decompress)(struct acomp_req *req);
+	void (*compress_batch)(struct acomp_req *reqs[], int errs[],
+			       unsigned int nr);
+	void (*decompress_batch)(struct acomp_req *reqs[], int errs[],
+				 unsigned int nr);
 	void (*dst_free)(struct scatterlist *dst);
 	int (*init)(struct crypto_acomp *tfm);
 	void (*exit)(struct crypto_acomp *tfm);
@@ -115,6 +115,9 @@ static inline void sha256_init(struct sha256_state *sctx)
 void sha256_update(struct sha256_state *sctx, const u8 *data, unsigned int len);
 void sha256_final(struct sha256_state *sctx, u8 *out);
 void sha256(const u8 *data, unsigned int len, u8 *out);
+void sha256_finup_2x(const struct sha256_state *sctx, const u8 *data1,
+		     const u8 *data2, unsigned int len,
+		     u8 out1[SHA256_DIGEST_SIZE], u8 out2[SHA256_DIGEST_SIZE]);
 
 static inline void sha224_init(struct sha256_state *sctx)
 {
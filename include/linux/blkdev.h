@@ -39,6 +39,7 @@ struct rq_qos;
 struct blk_queue_stats;
 struct blk_stat_callback;
 struct blk_crypto_profile;
+struct blk_zone_wplug;
 
 extern const struct device_type disk_type;
 extern const struct device_type part_type;
@@ -179,7 +180,9 @@ struct gendisk {
 	 * bits which indicates if a zone is conventional (bit set) or
 	 * sequential (bit clear). seq_zones_wlock is a bitmap of nr_zones
 	 * bits which indicates if a zone is write locked, that is, if a write
-	 * request targeting the zone was dispatched.
+	 * request targeting the zone was dispatched. zone_wplugs holds the
+	 * per-zone write plugs used to order writes to sequential zones at bio
+	 * level, for blk-mq devices.
 	 *
 	 * Reads of this information must be protected with blk_queue_enter() /
 	 * blk_queue_exit(). Modifying this information is only allowed while
@@ -191,6 +194,8 @@ struct gendisk {
 	unsigned int		max_active_zones;
 	unsigned long		*conv_zones_bitmap;
 	unsigned long		*seq_zones_wlock;
+	struct blk_zone_wplug	*zone_wplugs;
+	struct workqueue_struct	*zone_wplugs_wq;
 #endif /* CONFIG_BLK_DEV_ZONED */
 
 #if IS_ENABLED(CONFIG_CDROM)
@@ -452,6 +457,14 @@ struct request_queue {
 
 	unsigned int		rq_timeout;
 
+	/*
+	 * Adaptive plugging: completion latency target and the plug batch
+	 * size currently chosen to meet it. Zero means the fixed default.
+	 */
+	u64			plug_lat_target_nsec;
+	unsigned short		plug_batch;
+	struct blk_stat_callback *plug_cb;
+
 	struct timer_list	timeout;
 	struct work_struct	timeout_work;
 
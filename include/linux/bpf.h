@@ -1434,7 +1434,9 @@ struct bpf_prog_aux {
 	struct bpf_prog *prog;
 	struct user_struct *user;
 	u64 load_time; /* ns since boottime */
+	u64 verification_time; /* ns */
 	u32 verified_insns;
+	u32 verified_states;
 	int cgroup_atype; /* enum cgroup_bpf_attach_type */
 	struct bpf_map *cgroup_storage[MAX_BPF_CGROUP_STORAGE_TYPE];
 	char name[BPF_OBJ_NAME_LEN];
@@ -2244,6 +2246,8 @@ struct bpf_iter_aux_info {
 	struct {
 		enum bpf_iter_task_type	type;
 		u32 pid;
+		u32 tid_start;	/* BPF_TASK_ITER_ALL only */
+		u32 tid_end;
 	} task;
 };
 
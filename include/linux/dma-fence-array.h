@@ -41,6 +41,8 @@ struct dma_fence_array {
 	unsigned num_fences;
 	atomic_t num_pending;
 	struct dma_fence **fences;
+	bool signal_on_any;
+	unsigned int num_signaled;
 
 	struct irq_work work;
 };
@@ -20,6 +20,7 @@
  * @prev: previous fence of the chain
  * @prev_seqno: original previous seqno before garbage collection
  * @fence: encapsulated fence
+ * @pending: contained fence that last kept the chain from signaling
  * @lock: spinlock for fence handling
  */
 struct dma_fence_chain {
@@ -27,6 +28,7 @@ struct dma_fence_chain {
 	struct dma_fence __rcu *prev;
 	u64 prev_seqno;
 	struct dma_fence *fence;
+	struct dma_fence __rcu *pending;
 	union {
 		/**
 		 * @cb: callback for signaling
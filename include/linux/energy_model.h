@@ -188,20 +188,28 @@ static inline
 struct em_perf_state *em_pd_get_efficient_state(struct em_perf_domain *pd,
 						unsigned long freq)
 {
-	struct em_perf_state *ps;
-	int i;
+	int lo = 0, hi = pd->nr_perf_states - 1;
+
+	/*
+	 * The table is sorted by ascending frequency: bisect for the lowest
+	 * state meeting @freq, falling back to the highest state.
+	 */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (pd->table[mid].frequency >= freq)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
 
-	for (i = 0; i < pd->nr_perf_states; i++) {
-		ps = &pd->table[i];
-		if (ps->frequency >= freq) {
-			if (pd->flags & EM_PERF_DOMAIN_SKIP_INEFFICIENCIES &&
-			    ps->flags & EM_PERF_STATE_INEFFICIENT)
-				continue;
-			break;
-		}
+	if (pd->flags & EM_PERF_DOMAIN_SKIP_INEFFICIENCIES) {
+		while (lo < pd->nr_perf_states - 1 &&
+		       pd->table[lo].flags & EM_PERF_STATE_INEFFICIENT)
+			lo++;
 	}
 
-	return ps;
+	return &pd->table[lo];
 }
 
 /**
@@ -323,6 +323,9 @@ int mtree_alloc_rrange(struct maple_tree *mt, unsigned long *startp,
 
 int mtree_store_range(struct maple_tree *mt, unsigned long first,
 		      unsigned long last, void *entry, gfp_t gfp);
+int mtree_store_range_array(struct maple_tree *mt, const unsigned long *first,
+		const unsigned long *last, void **entries, unsigned long nr,
+		gfp_t gfp);
 int mtree_store(struct maple_tree *mt, unsigned long index,
 		void *entry, gfp_t gfp);
 void *mtree_erase(struct maple_tree *mt, unsigned long index);
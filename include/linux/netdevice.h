@@ -344,7 +344,11 @@ struct gro_list {
  * size of gro hash buckets, must less than bit number of
  * napi_struct::gro_bitmask
  */
+#ifdef CONFIG_GRO_WIDE_HASH
+#define GRO_HASH_BUCKETS	BITS_PER_LONG
+#else
 #define GRO_HASH_BUCKETS	8
+#endif
 
 /*
  * Structure for NAPI scheduling similar to tasklet but with weighting
@@ -3098,6 +3102,7 @@ u16 dev_pick_tx_cpu_id(struct net_device *dev, struct sk_buff *skb,
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
 int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+int __dev_direct_xmit_more(struct sk_buff *skb, u16 queue_id, bool more);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
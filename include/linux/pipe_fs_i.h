@@ -282,6 +282,7 @@ unsigned long account_pipe_buffers(struct user_struct *user,
 bool too_many_pipe_buffers_soft(unsigned long user_bufs);
 bool too_many_pipe_buffers_hard(unsigned long user_bufs);
 bool pipe_is_unprivileged_user(void);
+bool pipe_may_grow_implicitly(unsigned int nr_slots, unsigned long user_bufs);
 
 /* for F_SETPIPE_SZ and F_GETPIPE_SZ */
 int pipe_resize_ring(struct pipe_inode_info *pipe, unsigned int nr_slots);
@@ -1266,6 +1266,7 @@ struct sk_buff *build_skb_around(struct sk_buff *skb,
 void skb_attempt_defer_free(struct sk_buff *skb);
 
 struct sk_buff *napi_build_skb(void *data, unsigned int frag_size);
+u32 napi_skb_cache_get_bulk(void **skbs, u32 n);
 struct sk_buff *slab_build_skb(void *data);
 
 /**
@@ -3288,6 +3289,8 @@ static inline struct sk_buff *napi_alloc_skb(struct napi_struct *napi,
 	return __napi_alloc_skb(napi, length, GFP_ATOMIC);
 }
 void napi_consume_skb(struct sk_buff *skb, int budget);
+void napi_consume_skb_bulk(struct sk_buff **skbs, unsigned int count,
+			   int budget);
 
 void napi_skb_free_stolen_head(struct sk_buff *skb);
 void __napi_kfree_skb(struct sk_buff *skb, enum skb_drop_reason reason);
@@ -13,4 +13,12 @@ void sort(void *base, size_t num, size_t size,
 	  cmp_func_t cmp_func,
 	  swap_func_t swap_func);
 
+/* A 64-bit sort key and the caller's data (e.g. an index) it belongs to */
+struct sort_pair {
+	u64 key;
+	u64 val;
+};
+
+void sort_pairs(struct sort_pair *base, struct sort_pair *tmp, size_t num);
+
 #endif
@@ -140,27 +140,33 @@ struct neighbour {
 	struct neigh_parms	*parms;
 	unsigned long		confirmed;
 	unsigned long		updated;
+	unsigned long		used;
 	rwlock_t		lock;
 	refcount_t		refcnt;
 	unsigned int		arp_queue_len_bytes;
 	struct sk_buff_head	arp_queue;
 	struct timer_list	timer;
-	unsigned long		used;
 	atomic_t		probes;
+	u32			flags;
+
+	/* Read on every transmit, written only on state or address
+	 * changes: keep these off the cache line holding the timestamps,
+	 * refcount and lock above, which are dirtied from the fast path.
+	 */
+	int			(*output)(struct neighbour *, struct sk_buff *) ____cacheline_aligned_in_smp;
 	u8			nud_state;
 	u8			type;
 	u8			dead;
 	u8			protocol;
-	u32			flags;
 	seqlock_t		ha_lock;
 	unsigned char		ha[ALIGN(MAX_ADDR_LEN, sizeof(unsigned long))] __aligned(8);
 	struct hh_cache		hh;
-	int			(*output)(struct neighbour *, struct sk_buff *);
+	struct net_device	*dev;
+
 	const struct neigh_ops	*ops;
 	struct list_head	gc_list;
 	struct list_head	managed_list;
 	struct rcu_head		rcu;
-	struct net_device	*dev;
 	netdevice_tracker	dev_tracker;
 	u8			primary_key[];
 } __randomize_layout;
@@ -182,6 +182,7 @@ struct flow_offload {
 	unsigned long				flags;
 	u16					type;
 	u32					timeout;
+	u32					refresh_stamp;
 	struct rcu_head				rcu_head;
 };
 
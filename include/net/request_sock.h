@@ -169,6 +169,8 @@ struct fastopen_queue {
  *
  * @rskq_accept_head - FIFO head of established children
  * @rskq_accept_tail - FIFO tail of established children
+ * @rskq_accept_batch - children already taken off the FIFO by accept(),
+ *			owned by the listener socket lock holder
  * @rskq_defer_accept - User waits for some data after accept()
  *
  */
@@ -182,6 +184,7 @@ struct request_sock_queue {
 
 	struct request_sock	*rskq_accept_head;
 	struct request_sock	*rskq_accept_tail;
+	struct request_sock	*rskq_accept_batch;
 	struct fastopen_queue	fastopenq;  /* Check max_qlen != 0 to determine
 					     * if TFO is enabled.
 					     */
@@ -194,26 +197,75 @@ void reqsk_fastopen_remove(struct sock *sk, struct request_sock *req,
 
 static inline bool reqsk_queue_empty(const struct request_sock_queue *queue)
 {
-	return READ_ONCE(queue->rskq_accept_head) == NULL;
+	return READ_ONCE(queue->rskq_accept_head) == NULL &&
+	       READ_ONCE(queue->rskq_accept_batch) == NULL;
 }
 
+/* Must be called with the parent socket lock held.
+ *
+ * Up to net.ipv4.tcp_accept_batch children are moved off the shared FIFO
+ * per rskq_lock acquisition, so that a busy listener does not bounce the
+ * lock with the softirqs adding children for every single accept().
+ * Children parked in rskq_accept_batch are no longer accounted in
+ * sk_ack_backlog.
+ */
 static inline struct request_sock *reqsk_queue_remove(struct request_sock_queue *queue,
 						      struct sock *parent)
 {
-	struct request_sock *req;
+	struct request_sock *req, *last;
+	int batch, n;
+
+	req = queue->rskq_accept_batch;
+	if (req)
+		goto out;
+
+	batch = READ_ONCE(sock_net(parent)->ipv4.sysctl_tcp_accept_batch);
 
 	spin_lock_bh(&queue->rskq_lock);
 	req = queue->rskq_accept_head;
 	if (req) {
-		sk_acceptq_removed(parent);
-		WRITE_ONCE(queue->rskq_accept_head, req->dl_next);
+		for (last = req, n = 1; n < batch && last->dl_next; n++)
+			last = last->dl_next;
+		WRITE_ONCE(parent->sk_ack_backlog, parent->sk_ack_backlog - n);
+		WRITE_ONCE(queue->rskq_accept_head, last->dl_next);
 		if (queue->rskq_accept_head == NULL)
 			queue->rskq_accept_tail = NULL;
+		last->dl_next = NULL;
 	}
 	spin_unlock_bh(&queue->rskq_lock);
+	if (!req)
+		return NULL;
+out:
+	WRITE_ONCE(queue->rskq_accept_batch, req->dl_next);
 	return req;
 }
 
+/* Put the children taken by reqsk_queue_remove() but not yet accepted
+ * back at the head of the shared FIFO. Must be called with the parent
+ * socket lock held.
+ */
+static inline void reqsk_queue_unbatch(struct request_sock_queue *queue,
+				       struct sock *parent)
+{
+	struct request_sock *req = queue->rskq_accept_batch, *last;
+	int n = 1;
+
+	if (!req)
+		return;
+
+	for (last = req; last->dl_next; last = last->dl_next)
+		n++;
+
+	spin_lock_bh(&queue->rskq_lock);
+	last->dl_next = queue->rskq_accept_head;
+	if (!last->dl_next)
+		queue->rskq_accept_tail = last;
+	WRITE_ONCE(queue->rskq_accept_head, req);
+	WRITE_ONCE(queue->rskq_accept_batch, NULL);
+	WRITE_ONCE(parent->sk_ack_backlog, parent->sk_ack_backlog + n);
+	spin_unlock_bh(&queue->rskq_lock);
+}
+
 static inline void reqsk_queue_removed(struct request_sock_queue *queue,
 				       const struct request_sock *req)
 {
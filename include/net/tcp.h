@@ -293,13 +293,18 @@ static inline bool tcp_out_of_memory(struct sock *sk)
 	return false;
 }
 
-static inline void tcp_wmem_free_skb(struct sock *sk, struct sk_buff *skb)
+static inline void tcp_wmem_uncharge_skb(struct sock *sk, struct sk_buff *skb)
 {
 	sk_wmem_queued_add(sk, -skb->truesize);
 	if (!skb_zcopy_pure(skb))
 		sk_mem_uncharge(sk, skb->truesize);
 	else
 		sk_mem_uncharge(sk, SKB_TRUESIZE(skb_end_offset(skb)));
+}
+
+static inline void tcp_wmem_free_skb(struct sock *sk, struct sk_buff *skb)
+{
+	tcp_wmem_uncharge_skb(sk, skb);
 	__kfree_skb(skb);
 }
 
@@ -134,6 +134,10 @@ struct tls_sw_context_rx {
 	atomic_t decrypt_pending;
 	struct sk_buff_head async_hold;
 	struct wait_queue_head wq;
+
+	/* scratch for synchronous decryption, reused across records */
+	void *decrypt_mem;
+	size_t decrypt_mem_size;
 };
 
 struct tls_record_info {
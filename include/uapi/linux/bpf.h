@@ -116,6 +116,13 @@ union bpf_iter_link_info {
 		__u32	tid;
 		__u32	pid;
 		__u32	pid_fd;
+		/* When none of the above is set, only visit the tasks with
+		 * tid_start <= tid < tid_end (no upper bound if tid_end is
+		 * zero). Lets several iterators split the walk, or resume it
+		 * after the last tid seen.
+		 */
+		__u32	tid_start;
+		__u32	tid_end;
 	} task;
 };
 
@@ -1381,6 +1388,11 @@ union bpf_attr {
 		 * BPF_MAP_TYPE_BLOOM_FILTER - the lowest 4 bits indicate the
 		 * number of hash functions (if 0, the bloom filter will default
 		 * to using 5 hash functions).
+		 *
+		 * BPF_MAP_TYPE_HASH, BPF_MAP_TYPE_PERCPU_HASH - the number of
+		 * hash buckets of a BPF_F_NO_PREALLOC map, rounded up to a
+		 * power of 2 and capped at max_entries (if 0, one bucket per
+		 * entry is used).
 		 */
 		__u64	map_extra;
 	};
@@ -6441,6 +6453,8 @@ struct bpf_prog_info {
 	__u32 verified_insns;
 	__u32 attach_btf_obj_id;
 	__u32 attach_btf_id;
+	__u32 verified_states;
+	__u64 verification_time_ns;
 } __attribute__((aligned(8)));
 
 struct bpf_map_info {
@@ -6510,6 +6524,8 @@ struct bpf_link_info {
 				struct {
 					__u32 tid;
 					__u32 pid;
+					__u32 tid_start;
+					__u32 tid_end;
 				} task;
 			};
 		} iter;
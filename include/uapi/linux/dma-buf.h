@@ -167,6 +167,24 @@ struct dma_buf_import_sync_file {
 	__s32 fd;
 };
 
+/**
+ * struct dma_buf_sync_partial - Synchronize a byte range with CPU access.
+ *
+ * Like &struct dma_buf_sync, but limits cache maintenance to the range
+ * [offset, offset + len) of the buffer.  Exporters that cannot maintain
+ * partial ranges fall back to synchronizing the whole buffer, so the range
+ * is purely an optimization hint and the same START/END bracketing rules
+ * apply.
+ */
+struct dma_buf_sync_partial {
+	/** @flags: Set of access flags, as for &struct dma_buf_sync */
+	__u64 flags;
+	/** @offset: Offset in bytes of the range from the start of the buffer */
+	__u64 offset;
+	/** @len: Length in bytes of the range */
+	__u64 len;
+};
+
 #define DMA_BUF_BASE		'b'
 #define DMA_BUF_IOCTL_SYNC	_IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
 
@@ -178,5 +196,6 @@ struct dma_buf_import_sync_file {
 #define DMA_BUF_SET_NAME_B	_IOW(DMA_BUF_BASE, 1, __u64)
 #define DMA_BUF_IOCTL_EXPORT_SYNC_FILE	_IOWR(DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
 #define DMA_BUF_IOCTL_IMPORT_SYNC_FILE	_IOW(DMA_BUF_BASE, 3, struct dma_buf_import_sync_file)
+#define DMA_BUF_IOCTL_SYNC_PARTIAL	_IOW(DMA_BUF_BASE, 4, struct dma_buf_sync_partial)
 
 #endif
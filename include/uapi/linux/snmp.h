@@ -297,6 +297,8 @@ enum
 	LINUX_MIB_TCPMIGRATEREQSUCCESS,		/* TCPMigrateReqSuccess */
 	LINUX_MIB_TCPMIGRATEREQFAILURE,		/* TCPMigrateReqFailure */
 	LINUX_MIB_TCPPLBREHASH,			/* TCPPLBRehash */
+	LINUX_MIB_TCPZEROCOPYRECVMAPPED,	/* TCPZerocopyRecvMapped */
+	LINUX_MIB_TCPZEROCOPYRECVCOPIED,	/* TCPZerocopyRecvCopied */
 	__LINUX_MIB_MAX
 };
 
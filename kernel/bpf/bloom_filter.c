@@ -30,17 +30,33 @@ static u32 hash(struct bpf_bloom_filter *bloom, void *value,
 	else
 		h = jhash(value, value_size, bloom->hash_seed + index);
 
-	return h & bloom->bitset_mask;
+	return h;
+}
+
+/* Rather than running jhash over the value once per hash function, derive
+ * the bit positions as h1 + i * h2 from two hashes ("Less Hashing, Same
+ * Performance", Kirsch and Mitzenmacher), which has the same false
+ * positive rate. h2 is made odd so that, the bitset size being a power
+ * of two, the positions don't repeat.
+ */
+static void bloom_hashes(struct bpf_bloom_filter *bloom, void *value,
+			 u32 value_size, u32 *h1, u32 *h2)
+{
+	*h1 = hash(bloom, value, value_size, 0);
+	*h2 = bloom->nr_hash_funcs > 1 ?
+	      hash(bloom, value, value_size, 1) | 1 : 0;
 }
 
 static long bloom_map_peek_elem(struct bpf_map *map, void *value)
 {
 	struct bpf_bloom_filter *bloom =
 		container_of(map, struct bpf_bloom_filter, map);
-	u32 i, h;
+	u32 i, h, h1, h2;
+
+	bloom_hashes(bloom, value, map->value_size, &h1, &h2);
 
 	for (i = 0; i < bloom->nr_hash_funcs; i++) {
-		h = hash(bloom, value, map->value_size, i);
+		h = (h1 + i * h2) & bloom->bitset_mask;
 		if (!test_bit(h, bloom->bitset))
 			return -ENOENT;
 	}
@@ -52,14 +68,18 @@ static long bloom_map_push_elem(struct bpf_map *map, void *value, u64 flags)
 {
 	struct bpf_bloom_filter *bloom =
 		container_of(map, struct bpf_bloom_filter, map);
-	u32 i, h;
+	u32 i, h, h1, h2;
 
 	if (flags != BPF_ANY)
 		return -EINVAL;
 
+	bloom_hashes(bloom, value, map->value_size, &h1, &h2);
+
 	for (i = 0; i < bloom->nr_hash_funcs; i++) {
-		h = hash(bloom, value, map->value_size, i);
-		set_bit(h, bloom->bitset);
+		h = (h1 + i * h2) & bloom->bitset_mask;
+		/* Don't dirty the cacheline for bits that are already set */
+		if (!test_bit(h, bloom->bitset))
+			set_bit(h, bloom->bitset);
 	}
 
 	return 0;
@@ -320,14 +320,22 @@ static void bpf_lru_list_push_free(struct bpf_lru_list *l,
 	raw_spin_unlock_irqrestore(&l->lock, flags);
 }
 
-static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
-					   struct bpf_lru_locallist *loc_l)
+/* Refill the local free list from the global LRU list.  If !wait and
+ * another CPU is already working on the global list, give up and
+ * return false instead of spinning on its lock.
+ */
+static bool bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
+					   struct bpf_lru_locallist *loc_l,
+					   bool wait)
 {
 	struct bpf_lru_list *l = &lru->common_lru.lru_list;
 	struct bpf_lru_node *node, *tmp_node;
 	unsigned int nfree = 0;
 
-	raw_spin_lock(&l->lock);
+	if (wait)
+		raw_spin_lock(&l->lock);
+	else if (!raw_spin_trylock(&l->lock))
+		return false;
 
 	__local_list_flush(l, loc_l);
 
@@ -347,6 +355,8 @@ static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
 				      BPF_LRU_LOCAL_LIST_T_FREE);
 
 	raw_spin_unlock(&l->lock);
+
+	return true;
 }
 
 static void __local_list_add_pending(struct bpf_lru *lru,
@@ -433,6 +443,32 @@ static struct bpf_lru_node *bpf_percpu_lru_pop_free(struct bpf_lru *lru,
 	return node;
 }
 
+/* Take a node from the local free list of another CPU.  Those nodes
+ * have already been shrunk from the LRU list, so taking one does not
+ * cost anything in LRU ordering, unlike stealing a pending node.
+ */
+static struct bpf_lru_node *
+bpf_common_lru_steal_local_free(struct bpf_common_lru *clru, int cpu)
+{
+	struct bpf_lru_locallist *steal_loc_l;
+	struct bpf_lru_node *node = NULL;
+	unsigned long flags;
+	int steal;
+
+	for (steal = get_next_cpu(cpu); steal != cpu && !node;
+	     steal = get_next_cpu(steal)) {
+		steal_loc_l = per_cpu_ptr(clru->local_list, steal);
+		if (list_empty(local_free_list(steal_loc_l)))
+			continue;
+
+		raw_spin_lock_irqsave(&steal_loc_l->lock, flags);
+		node = __local_list_pop_free(steal_loc_l);
+		raw_spin_unlock_irqrestore(&steal_loc_l->lock, flags);
+	}
+
+	return node;
+}
+
 static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 						    u32 hash)
 {
@@ -442,6 +478,7 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 	int steal, first_steal;
 	unsigned long flags;
 	int cpu = raw_smp_processor_id();
+	bool contended = false;
 
 	loc_l = per_cpu_ptr(clru->local_list, cpu);
 
@@ -449,8 +486,10 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 
 	node = __local_list_pop_free(loc_l);
 	if (!node) {
-		bpf_lru_list_pop_free_to_local(lru, loc_l);
-		node = __local_list_pop_free(loc_l);
+		if (bpf_lru_list_pop_free_to_local(lru, loc_l, false))
+			node = __local_list_pop_free(loc_l);
+		else
+			contended = true;
 	}
 
 	if (node)
@@ -461,6 +500,27 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 	if (node)
 		return node;
 
+	/* Somebody else holds the global LRU list lock.  Under heavy
+	 * churn all CPUs tend to run out of local free nodes at the same
+	 * time and serialize on it, so first look for an already free
+	 * node on another CPU before queueing up on the lock.
+	 */
+	if (contended) {
+		node = bpf_common_lru_steal_local_free(clru, cpu);
+
+		raw_spin_lock_irqsave(&loc_l->lock, flags);
+		if (!node) {
+			bpf_lru_list_pop_free_to_local(lru, loc_l, true);
+			node = __local_list_pop_free(loc_l);
+		}
+		if (node)
+			__local_list_add_pending(lru, loc_l, cpu, node, hash);
+		raw_spin_unlock_irqrestore(&loc_l->lock, flags);
+
+		if (node)
+			return node;
+	}
+
 	/* No free nodes found from the local free list and
 	 * the global LRU list.
 	 *
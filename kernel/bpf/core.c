@@ -966,8 +966,7 @@ void bpf_prog_pack_free(struct bpf_binary_header *hdr)
 		  "bpf_prog_pack bug: missing bpf_arch_text_invalidate?\n");
 
 	bitmap_clear(pack->bitmap, pos, nbits);
-	if (bitmap_find_next_zero_area(pack->bitmap, BPF_PROG_CHUNK_COUNT, 0,
-				       BPF_PROG_CHUNK_COUNT, 0) == 0) {
+	if (bitmap_empty(pack->bitmap, BPF_PROG_CHUNK_COUNT)) {
 		list_del(&pack->list);
 		bpf_jit_free_exec(pack->ptr);
 		kfree(pack);
@@ -34,6 +34,7 @@
 
 #include <linux/netdevice.h>   /* netif_receive_skb_list */
 #include <linux/etherdevice.h> /* eth_type_trans */
+#include <net/gro.h>
 
 /* General idea: XDP packets getting XDP redirected to another CPU,
  * will maximum be stored/queued for one driver ->poll() call.  It is
@@ -70,6 +71,9 @@ struct bpf_cpu_map_entry {
 
 	struct completion kthread_running;
 	struct rcu_work free_work;
+
+	/* GRO context of the kthread, not registered with any device */
+	struct napi_struct napi;
 };
 
 struct bpf_cpu_map {
@@ -235,6 +239,22 @@ static int cpu_map_bpf_prog_run_xdp(struct bpf_cpu_map_entry *rcpu,
 
 #define CPUMAP_BATCH 8
 
+/* Hold packets in GRO for at most this many batches (a NAPI budget) */
+#define CPUMAP_GRO_BATCHES 8
+
+static void cpu_map_gro_init(struct napi_struct *napi)
+{
+	init_gro_hash(napi);
+	INIT_LIST_HEAD(&napi->rx_list);
+	napi->rx_count = 0;
+}
+
+static void cpu_map_gro_flush(struct napi_struct *napi)
+{
+	napi_gro_flush(napi, false);
+	gro_normal_list(napi);
+}
+
 static int cpu_map_bpf_prog_run(struct bpf_cpu_map_entry *rcpu, void **frames,
 				int xdp_n, struct xdp_cpumap_stats *stats,
 				struct list_head *list)
@@ -263,7 +283,9 @@ static int cpu_map_kthread_run(void *data)
 {
 	struct bpf_cpu_map_entry *rcpu = data;
 	unsigned long last_qs = jiffies;
+	unsigned int gro_batches = 0;
 
+	cpu_map_gro_init(&rcpu->napi);
 	complete(&rcpu->kthread_running);
 	set_current_state(TASK_INTERRUPTIBLE);
 
@@ -275,7 +297,6 @@ static int cpu_map_kthread_run(void *data)
 	while (!kthread_should_stop() || !__ptr_ring_empty(rcpu->queue)) {
 		struct xdp_cpumap_stats stats = {}; /* zero stats */
 		unsigned int kmem_alloc_drops = 0, sched = 0;
-		gfp_t gfp = __GFP_ZERO | GFP_ATOMIC;
 		int i, n, m, nframes, xdp_n;
 		void *frames[CPUMAP_BATCH];
 		void *skbs[CPUMAP_BATCH];
@@ -328,16 +349,15 @@ static int cpu_map_kthread_run(void *data)
 
 		/* Support running another XDP prog on this CPU */
 		nframes = cpu_map_bpf_prog_run(rcpu, frames, xdp_n, &stats, &list);
+
+		local_bh_disable();
 		if (nframes) {
-			m = kmem_cache_alloc_bulk(skbuff_cache, gfp, nframes, skbs);
-			if (unlikely(m == 0)) {
-				for (i = 0; i < nframes; i++)
-					skbs[i] = NULL; /* effect: xdp_return_frame */
-				kmem_alloc_drops += nframes;
-			}
+			m = napi_skb_cache_get_bulk(skbs, nframes);
+			for (i = m; i < nframes; i++)
+				skbs[i] = NULL; /* effect: xdp_return_frame */
+			kmem_alloc_drops += nframes - m;
 		}
 
-		local_bh_disable();
 		for (i = 0; i < nframes; i++) {
 			struct xdp_frame *xdpf = frames[i];
 			struct sk_buff *skb = skbs[i];
@@ -349,10 +369,20 @@ static int cpu_map_kthread_run(void *data)
 				continue;
 			}
 
-			list_add_tail(&skb->list, &list);
+			napi_gro_receive(&rcpu->napi, skb);
 		}
 		netif_receive_skb_list(&list);
 
+		/* Keep aggregating while more frames are queued, but don't
+		 * sit on packets once the queue runs dry or for longer than a
+		 * NAPI budget worth of frames.
+		 */
+		if (++gro_batches >= CPUMAP_GRO_BATCHES ||
+		    __ptr_ring_empty(rcpu->queue)) {
+			cpu_map_gro_flush(&rcpu->napi);
+			gro_batches = 0;
+		}
+
 		/* Feedback loop via tracepoint */
 		trace_xdp_cpumap_kthread(rcpu->map_id, n, kmem_alloc_drops,
 					 sched, &stats);
@@ -440,6 +440,12 @@ static int htab_map_alloc_check(union bpf_attr *attr)
 	if (lru && !prealloc)
 		return -ENOTSUPP;
 
+	/* map_extra is a bucket count hint, only meaningful when elements
+	 * are allocated on demand.
+	 */
+	if (attr->map_extra && (prealloc || attr->map_extra > 1UL << 31))
+		return -EINVAL;
+
 	if (numa_node != NUMA_NO_NODE && (percpu || percpu_lru))
 		return -EINVAL;
 
@@ -506,6 +512,12 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 		goto free_htab;
 
 	htab->n_buckets = roundup_pow_of_two(htab->map.max_entries);
+	/* For a map sized for the worst case, let user space trade longer
+	 * chains once the map fills up for a smaller bucket array.
+	 */
+	if (attr->map_extra)
+		htab->n_buckets = min_t(u32, htab->n_buckets,
+					roundup_pow_of_two(attr->map_extra));
 
 	htab->elem_size = sizeof(struct htab_elem) +
 			  round_up(htab->map.key_size, 8);
@@ -321,28 +321,27 @@ static long trie_update_elem(struct bpf_map *map,
 	if (key->prefixlen > trie->max_prefixlen)
 		return -EINVAL;
 
-	spin_lock_irqsave(&trie->lock, irq_flags);
+	/* Allocate and fill a new node. This does not depend on the trie, so
+	 * do it before taking the lock that serializes all the updaters.
+	 */
+	new_node = lpm_trie_node_alloc(trie, value);
+	if (!new_node)
+		return -ENOMEM;
+
+	new_node->prefixlen = key->prefixlen;
+	RCU_INIT_POINTER(new_node->child[0], NULL);
+	RCU_INIT_POINTER(new_node->child[1], NULL);
+	memcpy(new_node->data, key->data, trie->data_size);
 
-	/* Allocate and fill a new node */
+	spin_lock_irqsave(&trie->lock, irq_flags);
 
 	if (trie->n_entries == trie->map.max_entries) {
 		ret = -ENOSPC;
-		goto out;
-	}
-
-	new_node = lpm_trie_node_alloc(trie, value);
-	if (!new_node) {
-		ret = -ENOMEM;
-		goto out;
+		goto out_unlock;
 	}
 
 	trie->n_entries++;
 
-	new_node->prefixlen = key->prefixlen;
-	RCU_INIT_POINTER(new_node->child[0], NULL);
-	RCU_INIT_POINTER(new_node->child[1], NULL);
-	memcpy(new_node->data, key->data, trie->data_size);
-
 	/* Now find a slot to attach the new node. To do that, walk the tree
 	 * from the root and match as many bits as possible for each node until
 	 * we either find an empty slot or a slot that needs to be replaced by
@@ -420,16 +419,17 @@ static long trie_update_elem(struct bpf_map *map,
 	rcu_assign_pointer(*slot, im_node);
 
 out:
-	if (ret) {
-		if (new_node)
-			trie->n_entries--;
+	if (ret)
+		trie->n_entries--;
+
+out_unlock:
+	spin_unlock_irqrestore(&trie->lock, irq_flags);
 
+	if (ret) {
 		kfree(new_node);
 		kfree(im_node);
 	}
 
-	spin_unlock_irqrestore(&trie->lock, irq_flags);
-
 	return ret;
 }
 
@@ -97,6 +97,7 @@ struct bpf_mem_cache {
 	/* count of objects in free_llist */
 	int free_cnt;
 	int low_watermark, high_watermark, batch;
+	int high_watermark_max;
 	int percpu_size;
 	bool draining;
 	struct bpf_mem_cache *tgt;
@@ -422,6 +423,22 @@ static void check_free_by_rcu(struct bpf_mem_cache *c)
 	}
 }
 
+/* The cache ran dry before irq_work got to refill it, so allocations
+ * have been failing. Refill in bigger batches from now on, up to
+ * MEM_CACHE_WATERMARK_SCALE times the initial watermarks.
+ */
+#define MEM_CACHE_WATERMARK_SCALE	4
+
+static void bpf_mem_grow_watermarks(struct bpf_mem_cache *c)
+{
+	if (c->high_watermark >= c->high_watermark_max)
+		return;
+
+	c->low_watermark *= 2;
+	c->high_watermark *= 2;
+	c->batch = max((c->high_watermark - c->low_watermark) / 4 * 3, 1);
+}
+
 static void bpf_mem_refill(struct irq_work *work)
 {
 	struct bpf_mem_cache *c = container_of(work, struct bpf_mem_cache, refill_work);
@@ -429,6 +446,8 @@ static void bpf_mem_refill(struct irq_work *work)
 
 	/* Racy access to free_cnt. It doesn't need to be 100% accurate */
 	cnt = c->free_cnt;
+	if (!cnt)
+		bpf_mem_grow_watermarks(c);
 	if (cnt < c->low_watermark)
 		/* irq_work runs on this cpu and kmalloc will allocate
 		 * from the current numa node which is what we want here.
@@ -475,6 +494,7 @@ static void init_refill_work(struct bpf_mem_cache *c)
 		c->high_watermark = max(96 * 256 / c->unit_size, 3);
 	}
 	c->batch = max((c->high_watermark - c->low_watermark) / 4 * 3, 1);
+	c->high_watermark_max = c->high_watermark * MEM_CACHE_WATERMARK_SCALE;
 }
 
 static void prefill_mem_cache(struct bpf_mem_cache *c, int cpu)
@@ -417,6 +417,15 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 
 	cons_pos = smp_load_acquire(&rb->consumer_pos);
 
+	/* The producer position only moves forward, so if the ring is
+	 * already too full for this record against our snapshot of the
+	 * consumer position, it will still be once we get the lock. Bail
+	 * out without touching the lock: when the consumer falls behind,
+	 * every producer would otherwise serialize on it just to fail.
+	 */
+	if (READ_ONCE(rb->producer_pos) + len - cons_pos > rb->mask)
+		return NULL;
+
 	if (in_nmi()) {
 		if (!spin_trylock_irqsave(&rb->spinlock, flags))
 			return NULL;
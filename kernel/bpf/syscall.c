@@ -1143,6 +1143,8 @@ static int map_create(union bpf_attr *attr)
 	}
 
 	if (attr->map_type != BPF_MAP_TYPE_BLOOM_FILTER &&
+	    attr->map_type != BPF_MAP_TYPE_HASH &&
+	    attr->map_type != BPF_MAP_TYPE_PERCPU_HASH &&
 	    attr->map_extra != 0)
 		return -EINVAL;
 
@@ -4395,6 +4397,8 @@ static int bpf_prog_get_info_by_fd(struct file *file,
 	info.recursion_misses = stats.misses;
 
 	info.verified_insns = prog->aux->verified_insns;
+	info.verified_states = prog->aux->verified_states;
+	info.verification_time_ns = prog->aux->verification_time;
 
 	if (!bpf_capable()) {
 		info.jited_prog_len = 0;
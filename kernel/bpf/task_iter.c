@@ -21,6 +21,8 @@ struct bpf_iter_seq_task_common {
 	enum bpf_iter_task_type	type;
 	u32 pid;
 	u32 pid_visiting;
+	u32 tid_start;
+	u32 tid_end;
 };
 
 struct bpf_iter_seq_task_info {
@@ -135,11 +137,16 @@ static struct task_struct *task_seq_get_next(struct bpf_iter_seq_task_common *co
 		return task;
 	}
 
+	if (*tid < common->tid_start)
+		*tid = common->tid_start;
+
 	rcu_read_lock();
 retry:
 	pid = find_ge_pid(*tid, common->ns);
 	if (pid) {
 		*tid = pid_nr_ns(pid, common->ns);
+		if (common->tid_end && *tid >= common->tid_end)
+			goto out;
 		task = get_pid_task(pid, PIDTYPE_PID);
 		if (!task) {
 			++*tid;
@@ -152,6 +159,7 @@ static struct task_struct *task_seq_get_next(struct bpf_iter_seq_task_common *co
 			goto retry;
 		}
 	}
+out:
 	rcu_read_unlock();
 
 	return task;
@@ -234,7 +242,17 @@ static int bpf_iter_attach_task(struct bpf_prog *prog,
 	if ((!!linfo->task.tid + !!linfo->task.pid + !!linfo->task.pid_fd) > 1)
 		return -EINVAL;
 
+	if (linfo->task.tid_start || linfo->task.tid_end) {
+		if (linfo->task.tid || linfo->task.pid || linfo->task.pid_fd)
+			return -EINVAL;
+		if (linfo->task.tid_end &&
+		    linfo->task.tid_end <= linfo->task.tid_start)
+			return -EINVAL;
+	}
+
 	aux->task.type = BPF_TASK_ITER_ALL;
+	aux->task.tid_start = linfo->task.tid_start;
+	aux->task.tid_end = linfo->task.tid_end;
 	if (linfo->task.tid != 0) {
 		aux->task.type = BPF_TASK_ITER_TID;
 		aux->task.pid = linfo->task.tid;
@@ -414,6 +432,8 @@ static int init_seq_pidns(void *priv_data, struct bpf_iter_aux_info *aux)
 	common->ns = get_pid_ns(task_active_pid_ns(current));
 	common->type = aux->task.type;
 	common->pid = aux->task.pid;
+	common->tid_start = aux->task.tid_start;
+	common->tid_end = aux->task.tid_end;
 
 	return 0;
 }
@@ -703,6 +723,8 @@ static int bpf_iter_fill_link_info(const struct bpf_iter_aux_info *aux, struct b
 		info->iter.task.pid = aux->task.pid;
 		break;
 	default:
+		info->iter.task.tid_start = aux->task.tid_start;
+		info->iter.task.tid_end = aux->task.tid_end;
 		break;
 	}
 	return 0;
@@ -715,6 +737,9 @@ static void bpf_iter_task_show_fdinfo(const struct bpf_iter_aux_info *aux, struc
 		seq_printf(seq, "tid:\t%u\n", aux->task.pid);
 	else if (aux->task.type == BPF_TASK_ITER_TGID)
 		seq_printf(seq, "pid:\t%u\n", aux->task.pid);
+	else if (aux->task.tid_start || aux->task.tid_end)
+		seq_printf(seq, "tid_range:\t%u-%u\n",
+			   aux->task.tid_start, aux->task.tid_end);
 }
 
 static struct bpf_iter_reg task_reg_info = {
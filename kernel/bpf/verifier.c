@@ -16301,14 +16301,17 @@ static bool states_equal(struct bpf_verifier_env *env,
 		return false;
 
 	/* for states to be equal callsites have to be the same
-	 * and all frame states need to be equivalent
+	 * and all frame states need to be equivalent. Compare all the
+	 * callsites first, they are a lot cheaper to check than the frames.
 	 */
-	for (i = 0; i <= old->curframe; i++) {
+	for (i = 0; i <= old->curframe; i++)
 		if (old->frame[i]->callsite != cur->frame[i]->callsite)
 			return false;
+
+	for (i = 0; i <= old->curframe; i++)
 		if (!func_states_equal(env, old->frame[i], cur->frame[i], exact))
 			return false;
-	}
+
 	return true;
 }
 
@@ -20353,6 +20356,8 @@ int bpf_check(struct bpf_prog **prog, union bpf_attr *attr, bpfptr_t uattr, __u3
 	env->verification_time = ktime_get_ns() - start_time;
 	print_verification_stats(env);
 	env->prog->aux->verified_insns = env->insn_processed;
+	env->prog->aux->verified_states = env->total_states;
+	env->prog->aux->verification_time = env->verification_time;
 
 	/* preserve original error even if log finalization is successful */
 	err = bpf_vlog_finalize(&env->log, &log_true_size);
@@ -54,6 +54,7 @@ static const char * const lockevent_names[lockevent_num + 1] = {
  * Per-cpu counts
  */
 DEFINE_PER_CPU(unsigned long, lockevents[lockevent_num]);
+DEFINE_PER_CPU(unsigned int, lockevent_wait_seq);
 
 /*
  * The lockevent_read() function can be overridden.
@@ -16,6 +16,10 @@
 #ifndef __LOCKING_LOCK_EVENTS_H
 #define __LOCKING_LOCK_EVENTS_H
 
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/sched/clock.h>
+
 enum lock_events {
 
 #include "lock_events_list.h"
@@ -50,11 +54,50 @@ static inline void __lockevent_add(enum lock_events event, int inc)
 
 #define lockevent_add(ev, c)	__lockevent_add(LOCKEVENT_ ##ev, c)
 
+/*
+ * Contended acquisitions are timed 1 in LOCKEVENT_WAIT_SAMPLE times per
+ * CPU, so that the wait time histograms (LOCK_EVENT_WAIT_HIST) can stay
+ * enabled in production. lockevent_wait_begin() returns 0 for the
+ * acquisitions that are not sampled.
+ */
+#define LOCKEVENT_WAIT_SAMPLE	64
+#define LOCKEVENT_WAIT_BUCKETS	12
+
+DECLARE_PER_CPU(unsigned int, lockevent_wait_seq);
+
+static inline u64 lockevent_wait_begin(void)
+{
+	if (raw_cpu_inc_return(lockevent_wait_seq) % LOCKEVENT_WAIT_SAMPLE)
+		return 0;
+
+	return local_clock() | 1;
+}
+
+static inline void __lockevent_wait_end(enum lock_events hist, u64 start)
+{
+	u64 us;
+	int bucket = 0;
+
+	if (!start)
+		return;
+
+	us = div_u64(local_clock() - start, NSEC_PER_USEC);
+	if (us)
+		bucket = min_t(int, ilog2(us) + 1, LOCKEVENT_WAIT_BUCKETS - 1);
+
+	raw_cpu_inc(lockevents[hist + bucket]);
+}
+
+#define lockevent_wait_end(ev, start)	\
+	__lockevent_wait_end(LOCKEVENT_ ##ev ##_wait_lt1us, start)
+
 #else  /* CONFIG_LOCK_EVENT_COUNTS */
 
 #define lockevent_inc(ev)
 #define lockevent_add(ev, c)
 #define lockevent_cond_inc(ev, c)
+#define lockevent_wait_begin()		0
+#define lockevent_wait_end(ev, start)	do { (void)(start); } while (0)
 
 #endif /* CONFIG_LOCK_EVENT_COUNTS */
 
@@ -17,6 +17,25 @@
 #define LOCK_EVENT(name)	LOCKEVENT_ ## name,
 #endif
 
+/*
+ * Log2 histogram of sampled wait times, see lockevent_wait_begin().
+ * Bucket n > 0 counts waits of [2^(n-1), 2^n) us.
+ */
+#undef  LOCK_EVENT_WAIT_HIST
+#define LOCK_EVENT_WAIT_HIST(lock)					\
+	LOCK_EVENT(lock ## _wait_lt1us)					\
+	LOCK_EVENT(lock ## _wait_1us)					\
+	LOCK_EVENT(lock ## _wait_2us)					\
+	LOCK_EVENT(lock ## _wait_4us)					\
+	LOCK_EVENT(lock ## _wait_8us)					\
+	LOCK_EVENT(lock ## _wait_16us)					\
+	LOCK_EVENT(lock ## _wait_32us)					\
+	LOCK_EVENT(lock ## _wait_64us)					\
+	LOCK_EVENT(lock ## _wait_128us)					\
+	LOCK_EVENT(lock ## _wait_256us)					\
+	LOCK_EVENT(lock ## _wait_512us)					\
+	LOCK_EVENT(lock ## _wait_1ms_plus)
+
 #ifdef CONFIG_QUEUED_SPINLOCKS
 #ifdef CONFIG_PARAVIRT_SPINLOCKS
 /*
@@ -47,6 +66,9 @@ LOCK_EVENT(lock_use_node2)	/* # of locking ops that use 2nd percpu node */
 LOCK_EVENT(lock_use_node3)	/* # of locking ops that use 3rd percpu node */
 LOCK_EVENT(lock_use_node4)	/* # of locking ops that use 4th percpu node */
 LOCK_EVENT(lock_no_node)	/* # of locking ops w/o using percpu node    */
+LOCK_EVENT(lock_cna_intra)	/* # of NUMA-aware handoffs within a node    */
+LOCK_EVENT(lock_cna_flush)	/* # of secondary queue splices		     */
+LOCK_EVENT_WAIT_HIST(lock)	/* Sampled MCS queue wait times		     */
 #endif /* CONFIG_QUEUED_SPINLOCKS */
 
 /*
@@ -61,9 +83,12 @@ LOCK_EVENT(rwsem_opt_fail)	/* # of failed optspins			*/
 LOCK_EVENT(rwsem_opt_nospin)	/* # of disabled optspins		*/
 LOCK_EVENT(rwsem_rlock)		/* # of read locks acquired		*/
 LOCK_EVENT(rwsem_rlock_steal)	/* # of read locks by lock stealing	*/
+LOCK_EVENT(rwsem_rlock_spin)	/* # of read locks after writer spinning */
 LOCK_EVENT(rwsem_rlock_fast)	/* # of fast read locks acquired	*/
 LOCK_EVENT(rwsem_rlock_fail)	/* # of failed read lock acquisitions	*/
 LOCK_EVENT(rwsem_rlock_handoff)	/* # of read lock handoffs		*/
 LOCK_EVENT(rwsem_wlock)		/* # of write locks acquired		*/
 LOCK_EVENT(rwsem_wlock_fail)	/* # of failed write lock acquisitions	*/
 LOCK_EVENT(rwsem_wlock_handoff)	/* # of write lock handoffs		*/
+LOCK_EVENT_WAIT_HIST(rwsem_rlock)	/* Sampled read lock sleep times	*/
+LOCK_EVENT_WAIT_HIST(rwsem_wlock)	/* Sampled write lock sleep times	*/
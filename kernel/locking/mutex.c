@@ -512,6 +512,60 @@ mutex_optimistic_spin(struct mutex *lock, struct ww_acquire_ctx *ww_ctx,
 
 	return false;
 }
+
+/*
+ * Upper bound on how long the unlocker waits for an optimistic spinner to
+ * pick up the lock it just released.
+ */
+#define MUTEX_UNLOCK_SPIN_LOOPS	128
+
+/*
+ * How long the top waiter may be left asleep while spinners keep taking the
+ * lock. Only a woken waiter can set MUTEX_FLAG_HANDOFF, so past this point
+ * the wakeup is always issued.
+ */
+#define MUTEX_UNLOCK_SKIP_JIFFIES	1
+
+/*
+ * Called by the unlocker after releasing a lock that has waiters. If a
+ * spinner holds the OSQ it is running and will take the lock in a moment;
+ * waking the top waiter now would only have it find the lock taken and go
+ * back to sleep. Once somebody owns the lock again, MUTEX_FLAG_WAITERS is
+ * still set, so the new owner takes care of the wakeup when it unlocks.
+ *
+ * Returns true if the lock has been taken and the wakeup can be skipped.
+ */
+static bool mutex_unlock_spinner_took_lock(struct mutex *lock)
+{
+	struct mutex_waiter *waiter;
+	int loops = MUTEX_UNLOCK_SPIN_LOOPS;
+	bool skip;
+
+	if (!osq_is_locked(&lock->osq))
+		return false;
+
+	do {
+		if (__mutex_owner(lock))
+			goto taken;
+		cpu_relax();
+	} while (--loops && osq_is_locked(&lock->osq));
+
+	return false;
+
+taken:
+	/*
+	 * Don't let a stream of spinners starve the top waiter; once it has
+	 * been waiting long enough, wake it so it can request a handoff.
+	 */
+	raw_spin_lock(&lock->wait_lock);
+	waiter = list_first_entry_or_null(&lock->wait_list,
+					  struct mutex_waiter, list);
+	skip = !waiter ||
+	       time_before(jiffies, waiter->start + MUTEX_UNLOCK_SKIP_JIFFIES);
+	raw_spin_unlock(&lock->wait_lock);
+
+	return skip;
+}
 #else
 static __always_inline bool
 mutex_optimistic_spin(struct mutex *lock, struct ww_acquire_ctx *ww_ctx,
@@ -519,6 +573,11 @@ mutex_optimistic_spin(struct mutex *lock, struct ww_acquire_ctx *ww_ctx,
 {
 	return false;
 }
+
+static inline bool mutex_unlock_spinner_took_lock(struct mutex *lock)
+{
+	return false;
+}
 #endif
 
 static noinline void __sched __mutex_unlock_slowpath(struct mutex *lock, unsigned long ip);
@@ -629,6 +688,9 @@ __mutex_lock_common(struct mutex *lock, unsigned int state, unsigned int subclas
 	waiter.task = current;
 	if (use_ww_ctx)
 		waiter.ww_ctx = ww_ctx;
+#ifdef CONFIG_MUTEX_SPIN_ON_OWNER
+	waiter.start = jiffies;
+#endif
 
 	lock_contended(&lock->dep_map, ip);
 
@@ -922,7 +984,8 @@ static noinline void __sched __mutex_unlock_slowpath(struct mutex *lock, unsigne
 			break;
 
 		if (atomic_long_try_cmpxchg_release(&lock->owner, &owner, __owner_flags(owner))) {
-			if (owner & MUTEX_FLAG_WAITERS)
+			if ((owner & MUTEX_FLAG_WAITERS) &&
+			    !mutex_unlock_spinner_took_lock(lock))
 				break;
 
 			return;
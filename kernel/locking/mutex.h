@@ -15,6 +15,9 @@ struct mutex_waiter {
 	struct list_head	list;
 	struct task_struct	*task;
 	struct ww_acquire_ctx	*ww_ctx;
+#ifdef CONFIG_MUTEX_SPIN_ON_OWNER
+	unsigned long		start;
+#endif
 #ifdef CONFIG_DEBUG_MUTEXES
 	void			*magic;
 #endif
@@ -18,6 +18,7 @@
 #include <linux/cpumask.h>
 #include <linux/percpu.h>
 #include <linux/hardirq.h>
+#include <linux/jump_label.h>
 #include <linux/mutex.h>
 #include <linux/prefetch.h>
 #include <asm/byteorder.h>
@@ -77,11 +78,13 @@
  * two of them can fit in a cacheline in this case. That is OK as it is rare
  * to have more than 2 levels of slowpath nesting in actual use. We don't
  * want to penalize pvqspinlocks to optimize for a rare case in native
- * qspinlocks.
+ * qspinlocks. The NUMA-aware handoff (qspinlock_cna.h) uses the same space
+ * on 64-bit kernels.
  */
 struct qnode {
 	struct mcs_spinlock mcs;
-#ifdef CONFIG_PARAVIRT_SPINLOCKS
+#if defined(CONFIG_PARAVIRT_SPINLOCKS) || \
+    (defined(CONFIG_NUMA) && defined(CONFIG_64BIT))
 	long reserved[2];
 #endif
 };
@@ -139,6 +142,17 @@ struct mcs_spinlock *grab_mcs_node(struct mcs_spinlock *base, int idx)
 
 #define _Q_LOCKED_PENDING_MASK (_Q_LOCKED_MASK | _Q_PENDING_MASK)
 
+#if defined(CONFIG_NUMA) && defined(CONFIG_64BIT)
+#include "qspinlock_cna.h"
+#else
+static __always_inline void cna_init_node(struct mcs_spinlock *node, u32 tail) { }
+static __always_inline bool cna_active(u32 sec) { return false; }
+static __always_inline u32 cna_secondary_tail(u32 sec) { return 0; }
+static __always_inline void cna_splice_tail(u32 sec) { }
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next, u32 sec) { }
+#endif
+
 #if _Q_PENDING_BITS == 8
 /**
  * clear_pending - clear the pending bit.
@@ -316,7 +330,8 @@ static __always_inline u32  __pv_wait_head_or_lock(struct qspinlock *lock,
 void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 {
 	struct mcs_spinlock *prev, *next, *node;
-	u32 old, tail;
+	u32 old, tail, cna_sec = 1;
+	u64 wait_start;
 	int idx;
 
 	BUILD_BUG_ON(CONFIG_NR_CPUS >= (1U << _Q_TAIL_CPU_BITS));
@@ -403,6 +418,7 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	tail = encode_tail(smp_processor_id(), idx);
 
 	trace_contention_begin(lock, LCB_F_SPIN);
+	wait_start = lockevent_wait_begin();
 
 	/*
 	 * 4 nodes are allocated based on the assumption that there will
@@ -437,6 +453,8 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	node->locked = 0;
 	node->next = NULL;
 	pv_init_node(node);
+	if (!pv_enabled())
+		cna_init_node(node, tail);
 
 	/*
 	 * We touched a (possibly) cold cacheline in the per-cpu queue node;
@@ -476,6 +494,10 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 		pv_wait_node(node, prev);
 		arch_mcs_spin_lock_contended(&node->locked);
 
+		/* A NUMA-aware handoff may have passed us a secondary queue */
+		if (!pv_enabled())
+			cna_sec = node->locked;
+
 		/*
 		 * While waiting for the MCS lock, the next pointer may have
 		 * been set by another lock waiter. We optimistically load
@@ -536,8 +558,17 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	 *       PENDING will make the uncontended transition fail.
 	 */
 	if ((val & _Q_TAIL_MASK) == tail) {
-		if (atomic_try_cmpxchg_relaxed(&lock->val, &val, _Q_LOCKED_VAL))
+		u32 new = _Q_LOCKED_VAL;
+
+		/* Keep any secondary queue as the new main queue */
+		if (!pv_enabled())
+			new |= cna_secondary_tail(cna_sec);
+
+		if (atomic_try_cmpxchg_relaxed(&lock->val, &val, new)) {
+			if (!pv_enabled())
+				cna_splice_tail(cna_sec);
 			goto release; /* No contention */
+		}
 	}
 
 	/*
@@ -553,10 +584,14 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	if (!next)
 		next = smp_cond_load_relaxed(&node->next, (VAL));
 
-	arch_mcs_spin_unlock_contended(&next->locked);
+	if (!pv_enabled() && cna_active(cna_sec))
+		cna_pass_lock(node, next, cna_sec);
+	else
+		arch_mcs_spin_unlock_contended(&next->locked);
 	pv_kick_node(lock, next);
 
 release:
+	lockevent_wait_end(lock, wait_start);
 	trace_contention_end(lock, 0);
 
 	/*
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __LINUX_QSPINLOCK_CNA_H
+#define __LINUX_QSPINLOCK_CNA_H
+
+/*
+ * Compact NUMA-aware (CNA) handoff for the native queued spinlock slowpath.
+ *
+ * With the plain MCS queue the lock is handed to the next waiter in FIFO
+ * order, so under heavy contention from several sockets the lock and the
+ * data it protects bounce between nodes on almost every handoff. CNA keeps
+ * the MCS queue but, when passing the lock on, looks for the first waiter on
+ * the same NUMA node as the current holder. The waiters that are skipped are
+ * moved, in order, onto a secondary queue that travels with the lock:
+ *
+ *   main:      [holder] -> A(n1) -> B(n1) -> C(n0) -> D(n?) ...
+ *   handoff:   [C] -> D ...              secondary: A -> B
+ *
+ * The secondary queue is identified by the encoded tail of its first node,
+ * which is passed to the next holder through mcs_spinlock::locked in place of
+ * the usual 1 (an encoded tail is never 0 or 1). The head of the secondary
+ * queue records its last node and how many intra-node handoffs happened
+ * since it was formed. The secondary queue is spliced back in front of the
+ * main queue when no same-node waiter is found, when the handoff budget is
+ * exhausted, or when the main queue runs empty, so every waiter is served
+ * within a bounded number of handoffs.
+ *
+ * Only nodes whose ->next pointer is already set are ever moved, i.e. never
+ * the node that is the current MCS tail, so no other CPU can be writing to
+ * the links being rewritten.
+ *
+ * CNA is off by default and enabled with "numa_spinlock=on" on the kernel
+ * command line; it never applies to the paravirt slowpath. It is only built
+ * on 64-bit kernels: with 32-bit pointers struct cna_node does not fit in
+ * the two longs struct qnode reserves.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u16			handoffs;	/* secondary queue head only */
+	u32			encoded_tail;
+	struct mcs_spinlock	*sec_tail;	/* secondary queue head only */
+};
+
+/*
+ * Number of handoffs to same-node waiters before the secondary queue is
+ * forcibly spliced back and its (remote) waiters get served.
+ */
+#define CNA_HANDOFF_THRESHOLD	256
+
+static DEFINE_STATIC_KEY_FALSE(numa_spinlock_key);
+static bool numa_spinlock __initdata;
+
+static inline struct cna_node *to_cna_node(struct mcs_spinlock *node)
+{
+	return (struct cna_node *)node;
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node, u32 tail)
+{
+	struct cna_node *cn = to_cna_node(node);
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	cn->numa_node = numa_node_id();
+	cn->encoded_tail = tail;
+}
+
+/*
+ * The enabled check is only a hint: once CNA has been switched on, a holder
+ * may have been handed a secondary queue regardless of what it observed
+ * earlier, and it must pass that queue on.
+ */
+static __always_inline bool cna_active(u32 sec)
+{
+	return static_branch_unlikely(&numa_spinlock_key) || sec != 1;
+}
+
+/*
+ * Tail to leave in the lock word when the holder is the last node of the
+ * main queue: the secondary queue, if any, becomes the main queue.
+ */
+static __always_inline u32 cna_secondary_tail(u32 sec)
+{
+	if (sec == 1)
+		return 0;
+
+	return to_cna_node(to_cna_node(decode_tail(sec))->sec_tail)->encoded_tail;
+}
+
+/* Make the head of the (former) secondary queue the head of the main queue. */
+static __always_inline void cna_splice_tail(u32 sec)
+{
+	if (sec != 1) {
+		lockevent_inc(lock_cna_flush);
+		arch_mcs_spin_unlock_contended(&decode_tail(sec)->locked);
+	}
+}
+
+/*
+ * Pass the MCS lock from @node, which holds the spinlock, to a waiter; @next
+ * is the successor of @node in the main queue and @sec describes the
+ * secondary queue handed to @node.
+ */
+static void cna_pass_lock(struct mcs_spinlock *node, struct mcs_spinlock *next,
+			  u32 sec)
+{
+	struct mcs_spinlock *sec_head = sec != 1 ? decode_tail(sec) : NULL;
+	u16 numa_node = to_cna_node(node)->numa_node;
+	struct mcs_spinlock *cur, *last = NULL;
+
+	if (sec_head && ++to_cna_node(sec_head)->handoffs >= CNA_HANDOFF_THRESHOLD)
+		goto flush;
+
+	for (cur = next; cur; last = cur, cur = READ_ONCE(cur->next)) {
+		if (to_cna_node(cur)->numa_node == numa_node)
+			break;
+	}
+
+	if (!cur)
+		goto flush;
+
+	if (cur != next) {
+		/* Move [next, last] to the end of the secondary queue. */
+		WRITE_ONCE(last->next, NULL);
+		if (sec_head) {
+			WRITE_ONCE(to_cna_node(sec_head)->sec_tail->next, next);
+		} else {
+			sec_head = next;
+			sec = to_cna_node(next)->encoded_tail;
+			to_cna_node(next)->handoffs = 0;
+		}
+		to_cna_node(sec_head)->sec_tail = last;
+	}
+
+	lockevent_inc(lock_cna_intra);
+	smp_store_release(&cur->locked, sec);
+	return;
+
+flush:
+	if (sec_head) {
+		lockevent_inc(lock_cna_flush);
+		WRITE_ONCE(to_cna_node(sec_head)->sec_tail->next, next);
+		next = sec_head;
+	}
+	arch_mcs_spin_unlock_contended(&next->locked);
+}
+
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!str)
+		return -EINVAL;
+
+	return kstrtobool(str, &numa_spinlock);
+}
+early_param("numa_spinlock", numa_spinlock_setup);
+
+static int __init numa_spinlock_init(void)
+{
+	if (numa_spinlock && nr_node_ids > 1) {
+		static_branch_enable(&numa_spinlock_key);
+		pr_info("qspinlock: using NUMA-aware handoff\n");
+	}
+	return 0;
+}
+early_initcall(numa_spinlock_init);
+
+#endif /* __LINUX_QSPINLOCK_CNA_H */
@@ -934,6 +934,48 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return taken;
 }
 
+/*
+ * Let a reader that ran into a write-locked rwsem with nobody queued spin
+ * while the owning writer is running, rather than queue and sleep right
+ * away only to be woken again a moment later by up_write(). The reader's
+ * RWSEM_READER_BIAS is already in the count, so the read lock is ours as
+ * soon as the writer bit goes away. Stop as soon as anybody queues, so that
+ * a waiting writer can never be starved by spinning readers.
+ *
+ * Returns the last observed count.
+ */
+static long rwsem_reader_spin_on_writer(struct rw_semaphore *sem, long count)
+{
+	enum owner_state owner_state;
+
+	/* down_read*() run the slowpath with preemption disabled */
+	if (!rwsem_can_spin_on_owner(sem))
+		return count;
+
+	for (;;) {
+		owner_state = rwsem_spin_on_owner(sem);
+
+		count = atomic_long_read_acquire(&sem->count);
+		if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF))) {
+			lockevent_inc(rwsem_rlock_spin);
+			break;
+		}
+
+		if (!(owner_state & OWNER_SPINNABLE) ||
+		    (count & (RWSEM_FLAG_WAITERS | RWSEM_FLAG_HANDOFF)))
+			break;
+
+		/* See the RT and need_resched() notes in rwsem_optimistic_spin() */
+		if (owner_state != OWNER_WRITER &&
+		    (need_resched() || rt_task(current)))
+			break;
+
+		cpu_relax();
+	}
+
+	return count;
+}
+
 /*
  * Clear the owner's RWSEM_NONSPINNABLE bit if it is set. This should
  * only be called when the reader count reaches 0.
@@ -957,6 +999,12 @@ static inline bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 
 static inline void clear_nonspinnable(struct rw_semaphore *sem) { }
 
+static inline long rwsem_reader_spin_on_writer(struct rw_semaphore *sem,
+					       long count)
+{
+	return count;
+}
+
 static inline enum owner_state
 rwsem_spin_on_owner(struct rw_semaphore *sem)
 {
@@ -999,6 +1047,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	long rcnt = (count >> RWSEM_READER_SHIFT);
 	struct rwsem_waiter waiter;
 	DEFINE_WAKE_Q(wake_q);
+	u64 wait_start;
 
 	/*
 	 * To prevent a constant stream of readers from starving a sleeping
@@ -1009,6 +1058,12 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	    (rcnt > 1) && !(count & RWSEM_WRITER_LOCKED))
 		goto queue;
 
+	if ((count & RWSEM_WRITER_LOCKED) &&
+	    !(count & (RWSEM_FLAG_WAITERS | RWSEM_FLAG_HANDOFF))) {
+		count = rwsem_reader_spin_on_writer(sem, count);
+		rcnt = count >> RWSEM_READER_SHIFT;
+	}
+
 	/*
 	 * Reader optimistic lock stealing.
 	 */
@@ -1067,6 +1122,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 		wake_up_q(&wake_q);
 
 	trace_contention_begin(sem, LCB_F_READ);
+	wait_start = lockevent_wait_begin();
 
 	/* wait to be given the lock */
 	for (;;) {
@@ -1089,6 +1145,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 
 	__set_current_state(TASK_RUNNING);
 	lockevent_inc(rwsem_rlock);
+	lockevent_wait_end(rwsem_rlock, wait_start);
 	trace_contention_end(sem, 0);
 	return sem;
 
@@ -1108,6 +1165,7 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 {
 	struct rwsem_waiter waiter;
 	DEFINE_WAKE_Q(wake_q);
+	u64 wait_start;
 
 	/* do optimistic spinning and steal lock if possible */
 	if (rwsem_can_spin_on_owner(sem) && rwsem_optimistic_spin(sem)) {
@@ -1147,6 +1205,7 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	/* wait until we successfully acquire the lock */
 	set_current_state(state);
 	trace_contention_begin(sem, LCB_F_WRITE);
+	wait_start = lockevent_wait_begin();
 
 	for (;;) {
 		if (rwsem_try_write_lock(sem, &waiter)) {
@@ -1184,6 +1243,7 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	__set_current_state(TASK_RUNNING);
 	raw_spin_unlock_irq(&sem->wait_lock);
 	lockevent_inc(rwsem_wlock);
+	lockevent_wait_end(rwsem_wlock, wait_start);
 	trace_contention_end(sem, 0);
 	return sem;
 
@@ -204,6 +204,85 @@ static ssize_t module_xz_decompress(struct load_info *info,
 #define MODULE_COMPRESSION	zstd
 #define MODULE_DECOMPRESS_FN	module_zstd_decompress
 
+/*
+ * Largest decompressed size trusted from the frame header, as a multiple of
+ * the compressed size.  Modules compress a few times, so this is plenty for
+ * the single-pass path, while a bogus header can no longer make us allocate
+ * up to INT_MAX bytes before a single block has been decoded.
+ */
+#define MODULE_ZSTD_MAX_RATIO	16
+
+/*
+ * When the frame header records the decompressed size, decompress into a
+ * virtually contiguous buffer of that size in a single call.  This lets zstd
+ * take its single-pass path, decoding straight into the output instead of
+ * through the stream's window buffer one page at a time.  The buffer starts
+ * at the capped size and is grown and remapped if the frame turns out to be
+ * larger.
+ */
+static ssize_t module_zstd_decompress_single(struct load_info *info,
+					     ZSTD_DStream *dstream,
+					     ZSTD_inBuffer *zstd_buf,
+					     u64 content_size)
+{
+	size_t limit = min_t(size_t, INT_MAX,
+			     array_size(zstd_buf->size, MODULE_ZSTD_MAX_RATIO));
+	size_t out_size = min_t(u64, content_size, limit);
+	ZSTD_outBuffer zstd_dec = { .pos = 0 };
+	void *dst = NULL;
+	ssize_t retval;
+	size_t ret;
+	int err;
+
+	for (;;) {
+		while (info->used_pages < DIV_ROUND_UP(out_size, PAGE_SIZE)) {
+			struct page *page = module_get_next_page(info);
+
+			if (IS_ERR(page)) {
+				retval = PTR_ERR(page);
+				goto out;
+			}
+		}
+
+		if (dst)
+			vunmap(dst);
+		dst = vmap(info->pages, info->used_pages, VM_MAP, PAGE_KERNEL);
+		if (!dst) {
+			retval = -ENOMEM;
+			goto out;
+		}
+		zstd_dec.dst = dst;
+		zstd_dec.size = out_size;
+
+		ret = zstd_decompress_stream(dstream, &zstd_dec, zstd_buf);
+		err = zstd_get_error_code(ret);
+		if (err) {
+			pr_err("ZSTD-decompression failed with status %d\n", err);
+			retval = -EINVAL;
+			goto out;
+		}
+		if (ret == 0)
+			break;
+		if (zstd_dec.pos < zstd_dec.size) {
+			pr_err("ZSTD-compressed data is truncated\n");
+			retval = -EINVAL;
+			goto out;
+		}
+		if (out_size >= INT_MAX) {
+			pr_err("ZSTD-decompressed data is too large\n");
+			retval = -EFBIG;
+			goto out;
+		}
+		out_size = min_t(size_t, out_size * 2, INT_MAX);
+	}
+
+	retval = zstd_dec.pos;
+ out:
+	if (dst)
+		vunmap(dst);
+	return retval;
+}
+
 static ssize_t module_zstd_decompress(struct load_info *info,
 				    const void *buf, size_t size)
 {
@@ -254,6 +333,13 @@ static ssize_t module_zstd_decompress(struct load_info *info,
 		goto out;
 	}
 
+	if (header.frameContentSize != ZSTD_CONTENTSIZE_UNKNOWN &&
+	    header.frameContentSize) {
+		retval = module_zstd_decompress_single(info, dstream, &zstd_buf,
+						       header.frameContentSize);
+		goto out;
+	}
+
 	do {
 		struct page *page = module_get_next_page(info);
 
@@ -525,8 +525,29 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 			             LZO_HEADER, PAGE_SIZE)
 #define LZO_CMP_SIZE	(LZO_CMP_PAGES * PAGE_SIZE)
 
-/* Maximum number of threads for compression/decompression. */
+/* Default/maximum number of threads for compression/decompression. */
 #define LZO_THREADS	3
+#define LZO_MAX_THREADS	16
+
+/*
+ * Number of compression/decompression threads, settable with
+ * hibernate_compression_threads= on the kernel command line.  The image
+ * format does not depend on it: the image is a stream of independently
+ * compressed chunks that are handed to the threads in turn.
+ */
+static unsigned int hibernate_compression_threads = LZO_THREADS;
+
+static int __init compression_threads_setup(char *str)
+{
+	unsigned int n;
+
+	if (kstrtouint(str, 0, &n))
+		return 0;
+
+	hibernate_compression_threads = clamp_val(n, 1, LZO_MAX_THREADS);
+	return 1;
+}
+__setup("hibernate_compression_threads=", compression_threads_setup);
 
 /* Minimum/maximum number of pages for read buffering. */
 #define LZO_MIN_RD_PAGES	1024
@@ -592,8 +613,8 @@ struct crc_data {
 	wait_queue_head_t go;                     /* start crc update */
 	wait_queue_head_t done;                   /* crc update done */
 	u32 *crc32;                               /* points to handle's crc32 */
-	size_t *unc_len[LZO_THREADS];             /* uncompressed lengths */
-	unsigned char *unc[LZO_THREADS];          /* uncompressed data */
+	size_t *unc_len[LZO_MAX_THREADS];         /* uncompressed lengths */
+	unsigned char *unc[LZO_MAX_THREADS];      /* uncompressed data */
 };
 
 /*
@@ -698,7 +719,7 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	 * footprint.
 	 */
 	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = clamp_val(nr_threads, 1, hibernate_compression_threads);
 
 	page = (void *)__get_free_page(GFP_NOIO | __GFP_HIGH);
 	if (!page) {
@@ -1188,7 +1209,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	 * footprint.
 	 */
 	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = clamp_val(nr_threads, 1, hibernate_compression_threads);
 
 	page = vmalloc(array_size(LZO_MAX_RD_PAGES, sizeof(*page)));
 	if (!page) {
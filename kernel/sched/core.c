@@ -6299,6 +6299,16 @@ static bool try_steal_cookie(int this, int that)
 	unsigned long cookie;
 	bool success = false;
 
+	/*
+	 * sched_core_balance() walks every CPU of every domain, so filter out
+	 * the obvious misses before taking both runqueue locks. These are
+	 * only hints and everything is rechecked under the locks below; the
+	 * worst a stale read does is skip one steal attempt.
+	 */
+	if (!READ_ONCE(dst->core->core_cookie) ||
+	    RB_EMPTY_ROOT(&src->core_tree))
+		return false;
+
 	guard(irq)();
 	guard(double_rq_lock)(dst, src);
 
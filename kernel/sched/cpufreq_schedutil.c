@@ -7,6 +7,7 @@
  */
 
 #define IOWAIT_BOOST_MIN	(SCHED_CAPACITY_SCALE / 8)
+#define UTIL_EST_JUMP_MIN	(SCHED_CAPACITY_SCALE / 8)
 
 struct sugov_tunables {
 	struct gov_attr_set	attr_set;
@@ -48,6 +49,7 @@ struct sugov_cpu {
 
 	unsigned long		util;
 	unsigned long		bw_dl;
+	unsigned long		util_est;
 
 	/* The field below is for single-CPU policies only: */
 #ifdef CONFIG_NO_HZ_COMMON
@@ -310,6 +312,22 @@ static inline void ignore_dl_rate_limit(struct sugov_cpu *sg_cpu)
 		sg_cpu->sg_policy->limits_changed = true;
 }
 
+/*
+ * Likewise when a task with a large estimated utilization has just been
+ * enqueued: util_est already carries the history of its last activations, so
+ * raise the frequency now instead of after the next rate limit period.
+ */
+static inline void ignore_util_est_rate_limit(struct sugov_cpu *sg_cpu)
+{
+	unsigned long util_est;
+
+	util_est = READ_ONCE(cpu_rq(sg_cpu->cpu)->cfs.avg.util_est.enqueued);
+	if (util_est > sg_cpu->util_est + UTIL_EST_JUMP_MIN)
+		sg_cpu->sg_policy->limits_changed = true;
+
+	sg_cpu->util_est = util_est;
+}
+
 static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 					      u64 time, unsigned long max_cap,
 					      unsigned int flags)
@@ -318,6 +336,7 @@ static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 	sg_cpu->last_update = time;
 
 	ignore_dl_rate_limit(sg_cpu);
+	ignore_util_est_rate_limit(sg_cpu);
 
 	if (!sugov_should_update_freq(sg_cpu->sg_policy, time))
 		return false;
@@ -447,6 +466,7 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 	sg_cpu->last_update = time;
 
 	ignore_dl_rate_limit(sg_cpu);
+	ignore_util_est_rate_limit(sg_cpu);
 
 	if (sugov_should_update_freq(sg_policy, time)) {
 		next_f = sugov_next_freq_shared(sg_cpu, time);
@@ -150,7 +150,13 @@ int cpupri_find_fitness(struct cpupri *cp, struct task_struct *p,
 
 	WARN_ON_ONCE(task_pri >= CPUPRI_NR_PRIORITIES);
 
-	for (idx = 0; idx < task_pri; idx++) {
+	/*
+	 * Only visit the priority levels that currently have CPUs, rather
+	 * than touching the count of every vector below task_pri. A level
+	 * missed because of a racing cpupri_set() is the same race that
+	 * __cpupri_find() already tolerates on vec->count.
+	 */
+	for_each_set_bit(idx, cp->pri_active, task_pri) {
 
 		if (!__cpupri_find(cp, p, lowest_mask, idx))
 			continue;
@@ -236,7 +242,8 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * make sure the vector is visible when count is set.
 		 */
 		smp_mb__before_atomic();
-		atomic_inc(&(vec)->count);
+		if (atomic_inc_return(&(vec)->count) == 1)
+			set_bit(newpri, cp->pri_active);
 		do_mb = 1;
 	}
 	if (likely(oldpri != CPUPRI_INVALID)) {
@@ -261,7 +268,17 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * When removing from the vector, we decrement the counter first
 		 * do a memory barrier and then clear the mask.
 		 */
-		atomic_dec(&(vec)->count);
+		if (atomic_dec_return(&(vec)->count) == 0) {
+			clear_bit(oldpri, cp->pri_active);
+			/*
+			 * Another CPU may have moved onto this priority
+			 * and set the bit just before we cleared it; pairs
+			 * with the fully ordered atomic_inc_return() above.
+			 */
+			smp_mb__after_atomic();
+			if (atomic_read(&(vec)->count))
+				set_bit(oldpri, cp->pri_active);
+		}
 		smp_mb__after_atomic();
 		cpumask_clear_cpu(cpu, vec->mask);
 	}
@@ -286,6 +303,7 @@ int cpupri_init(struct cpupri *cp)
 		if (!zalloc_cpumask_var(&vec->mask, GFP_KERNEL))
 			goto cleanup;
 	}
+	bitmap_zero(cp->pri_active, CPUPRI_NR_PRIORITIES);
 
 	cp->cpu_to_pri = kcalloc(nr_cpu_ids, sizeof(int), GFP_KERNEL);
 	if (!cp->cpu_to_pri)
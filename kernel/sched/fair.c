@@ -2812,6 +2812,7 @@ static void task_numa_placement(struct task_struct *p)
 	u64 runtime, period;
 	spinlock_t *group_lock = NULL;
 	struct numa_group *ng;
+	bool tiering;
 
 	/*
 	 * The p->mm->numa_scan_seq field gets updated without
@@ -2823,6 +2824,7 @@ static void task_numa_placement(struct task_struct *p)
 		return;
 	p->numa_scan_seq = seq;
 	p->numa_scan_period_max = task_scan_max(p);
+	tiering = sysctl_numa_balancing_mode & NUMA_BALANCING_MEMORY_TIERING;
 
 	total_faults = p->numa_faults_locality[0] +
 		       p->numa_faults_locality[1];
@@ -2887,6 +2889,15 @@ static void task_numa_placement(struct task_struct *p)
 			}
 		}
 
+		/*
+		 * With memory tiering, the hot pages on a CPU-less node are
+		 * promoted to the fast tier where the task runs. Don't also
+		 * let them pull the task towards whichever CPU node happens
+		 * to be closest to the slow memory.
+		 */
+		if (tiering && !node_state(nid, N_CPU))
+			continue;
+
 		if (!ng) {
 			if (faults > max_faults) {
 				max_faults = faults;
@@ -5536,6 +5547,16 @@ static int assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(cfs_rq->tg);
 	int ret;
 
+	/*
+	 * Once the pool is drained every CPU running in the group hits this
+	 * at about the same time. Don't all pile onto cfs_b->lock just to find
+	 * out there is nothing left: failing here makes us resched, and
+	 * throttle_cfs_rq() rechecks under the lock (and starts the period
+	 * timer) before it actually throttles.
+	 */
+	if (READ_ONCE(cfs_b->quota) != RUNTIME_INF && !READ_ONCE(cfs_b->runtime))
+		return 0;
+
 	raw_spin_lock(&cfs_b->lock);
 	ret = __assign_cfs_rq_runtime(cfs_b, cfs_rq, sched_cfs_bandwidth_slice());
 	raw_spin_unlock(&cfs_b->lock);
@@ -6602,6 +6623,7 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	struct sched_entity *se = &p->se;
 	int idle_h_nr_running = task_has_idle_policy(p);
 	int task_new = !(flags & ENQUEUE_WAKEUP);
+	bool was_sched_idle = sched_idle_rq(rq);
 
 	/*
 	 * The code below (indirectly) updates schedutil which looks at
@@ -6659,6 +6681,9 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	/* At this point se is NULL and we are at root level*/
 	add_nr_running(rq, 1);
 
+	if (unlikely(was_sched_idle != sched_idle_rq(rq)))
+		update_idle_cpumask(rq, false);
+
 	/*
 	 * Since new tasks are assigned an initial util_avg equal to
 	 * half of the spare capacity of their CPU, tiny tasks have the
@@ -6751,8 +6776,10 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	sub_nr_running(rq, 1);
 
 	/* balance early to pull high priority tasks */
-	if (unlikely(!was_sched_idle && sched_idle_rq(rq)))
+	if (unlikely(!was_sched_idle && sched_idle_rq(rq))) {
 		rq->next_balance = jiffies;
+		update_idle_cpumask(rq, true);
+	}
 
 dequeue_throttle:
 	util_est_update(&rq->cfs, p, task_sleep);
@@ -6972,6 +6999,34 @@ wake_affine_weight(struct sched_domain *sd, struct task_struct *p,
 	return this_eff_load < prev_eff_load ? this_cpu : nr_cpumask_bits;
 }
 
+/*
+ * wake_affine_pair() - pull a wakee towards the waker's LLC when the two
+ *			tasks keep waking each other.
+ *
+ * record_wakee() leaves last_wakee pointing at the partner on both sides for
+ * a producer/consumer pair, which is the cheapest signal we have that the
+ * wakee is about to touch data the waker just produced. Only do this when the
+ * CPUs are on different LLCs, and only while the waking CPU still has room
+ * for the wakee so that a busy pair cannot pile up on one cache domain.
+ */
+static int
+wake_affine_pair(struct task_struct *p, int this_cpu, int prev_cpu)
+{
+	unsigned long util;
+
+	if (cpus_share_cache(this_cpu, prev_cpu))
+		return nr_cpumask_bits;
+
+	if (current->last_wakee != p || READ_ONCE(p->last_wakee) != current)
+		return nr_cpumask_bits;
+
+	util = cpu_util_cfs(this_cpu) + task_util_est(p);
+	if (!fits_capacity(util, capacity_of(this_cpu)))
+		return nr_cpumask_bits;
+
+	return this_cpu;
+}
+
 static int wake_affine(struct sched_domain *sd, struct task_struct *p,
 		       int this_cpu, int prev_cpu, int sync)
 {
@@ -6983,6 +7038,9 @@ static int wake_affine(struct sched_domain *sd, struct task_struct *p,
 	if (sched_feat(WA_WEIGHT) && target == nr_cpumask_bits)
 		target = wake_affine_weight(sd, p, this_cpu, prev_cpu, sync);
 
+	if (sched_feat(WA_PAIR) && target == nr_cpumask_bits)
+		target = wake_affine_pair(p, this_cpu, prev_cpu);
+
 	schedstat_inc(p->stats.nr_wakeups_affine_attempts);
 	if (target != this_cpu)
 		return prev_cpu;
@@ -7249,6 +7307,34 @@ static inline int select_idle_smt(struct task_struct *p, struct sched_domain *sd
 
 #endif /* CONFIG_SCHED_SMT */
 
+/*
+ * Maintain sd_llc_shared->idle_cpus_span. A CPU is in the mask while it runs
+ * its idle task (@idle) or only has SCHED_IDLE tasks, matching what
+ * __select_idle_cpu() accepts. Test before writing so that a CPU bouncing in
+ * and out of idle does not keep dirtying the shared line when its bit
+ * already has the right value.
+ */
+void update_idle_cpumask(struct rq *rq, bool idle)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+	struct cpumask *mask;
+
+	if (!idle)
+		idle = sched_idle_rq(rq);
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (!sds)
+		goto unlock;
+
+	mask = sds_idle_cpus(sds);
+	if (cpumask_test_cpu(cpu, mask) != idle)
+		assign_bit(cpu, cpumask_bits(mask), idle);
+unlock:
+	rcu_read_unlock();
+}
+
 /*
  * Scan the LLC domain for idle CPUs; this is dynamically regulated by
  * comparing the average scan cost (tracked in sd->avg_scan_cost) against the
@@ -7266,6 +7352,17 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
 
+	/*
+	 * A full core scan needs to see the busy siblings too, so only trim
+	 * the search to the idle CPUs when we are looking for any idle CPU.
+	 */
+	if (sched_feat(SIS_IDLE_MASK) && !has_idle_core) {
+		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
+		if (sd_share &&
+		    !cpumask_and(cpus, cpus, sds_idle_cpus(sd_share)))
+			return -1;
+	}
+
 	if (sched_feat(SIS_PROP) && !has_idle_core) {
 		u64 avg_cost, avg_idle, span_avg;
 		unsigned long now = jiffies;
@@ -7510,7 +7607,15 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 		}
 	}
 
-	i = select_idle_cpu(p, sd, has_idle_core, target);
+	if (schedstat_enabled()) {
+		u64 start = local_clock();
+
+		i = select_idle_cpu(p, sd, has_idle_core, target);
+		__schedstat_inc(this_rq()->sis_scan_count);
+		__schedstat_add(this_rq()->sis_scan_time, local_clock() - start);
+	} else {
+		i = select_idle_cpu(p, sd, has_idle_core, target);
+	}
 	if ((unsigned)i < nr_cpumask_bits)
 		return i;
 
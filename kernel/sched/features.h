@@ -51,6 +51,11 @@ SCHED_FEAT(TTWU_QUEUE, true)
  */
 SCHED_FEAT(SIS_PROP, false)
 SCHED_FEAT(SIS_UTIL, true)
+/*
+ * Only scan the CPUs of the LLC that were last seen idle or running only
+ * SCHED_IDLE tasks.
+ */
+SCHED_FEAT(SIS_IDLE_MASK, true)
 
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
@@ -79,6 +84,11 @@ SCHED_FEAT(ATTACH_AGE_LOAD, true)
 SCHED_FEAT(WA_IDLE, true)
 SCHED_FEAT(WA_WEIGHT, true)
 SCHED_FEAT(WA_BIAS, true)
+/*
+ * Keep tasks that wake each other on the waker's LLC, as long as the
+ * waking CPU has spare capacity for the wakee.
+ */
+SCHED_FEAT(WA_PAIR, false)
 
 /*
  * UtilEstimation. Use estimated CPU utilization.
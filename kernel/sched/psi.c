@@ -868,9 +868,18 @@ static void psi_group_change(struct psi_group *group, int cpu,
 	if (unlikely((state_mask & PSI_ONCPU) && cpu_curr(cpu)->in_memstall))
 		state_mask |= (1 << PSI_MEM_FULL);
 
-	record_times(groupc, now);
-
-	groupc->state_mask = state_mask;
+	/*
+	 * Most task changes only move the counts around without changing
+	 * the aggregate state, e.g. a wakeup into a group that already has
+	 * runnable tasks on this CPU. The time spent in an unchanged state
+	 * is still live in state_mask/state_start and is picked up from
+	 * there by get_recent_times(), so only conclude the state when it
+	 * actually changes.
+	 */
+	if (state_mask != groupc->state_mask) {
+		record_times(groupc, now);
+		groupc->state_mask = state_mask;
+	}
 
 	write_seqcount_end(&groupc->seq);
 
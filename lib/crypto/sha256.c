@@ -131,6 +131,78 @@ static void sha256_transform_blocks(struct sha256_state *sctx,
 	memzero_explicit(W, sizeof(W));
 }
 
+/*
+ * Two independent rounds, one on the x and one on the y state, so that the
+ * CPU has two dependency chains to schedule instead of one.
+ */
+#define SHA256_ROUND_2X(i, a, b, c, d, e, f, g, h) do {			\
+	u32 tx1, tx2, ty1, ty2;						\
+	tx1 = h##x + e1(e##x) + Ch(e##x, f##x, g##x) + SHA256_K[i] + Wx[i];\
+	ty1 = h##y + e1(e##y) + Ch(e##y, f##y, g##y) + SHA256_K[i] + Wy[i];\
+	tx2 = e0(a##x) + Maj(a##x, b##x, c##x);				\
+	ty2 = e0(a##y) + Maj(a##y, b##y, c##y);				\
+	d##x += tx1;							\
+	d##y += ty1;							\
+	h##x = tx1 + tx2;						\
+	h##y = ty1 + ty2;						\
+} while (0)
+
+static void sha256_transform_2x(u32 *sx, u32 *sy, const u8 *inx,
+				const u8 *iny, u32 *Wx, u32 *Wy)
+{
+	u32 ax, bx, cx, dx, ex, fx, gx, hx;
+	u32 ay, by, cy, dy, ey, fy, gy, hy;
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		LOAD_OP(i, Wx, inx);
+		LOAD_OP(i, Wy, iny);
+	}
+
+	for (i = 16; i < 64; i++) {
+		BLEND_OP(i, Wx);
+		BLEND_OP(i, Wy);
+	}
+
+	ax = sx[0];  bx = sx[1];  cx = sx[2];  dx = sx[3];
+	ex = sx[4];  fx = sx[5];  gx = sx[6];  hx = sx[7];
+	ay = sy[0];  by = sy[1];  cy = sy[2];  dy = sy[3];
+	ey = sy[4];  fy = sy[5];  gy = sy[6];  hy = sy[7];
+
+	for (i = 0; i < 64; i += 8) {
+		SHA256_ROUND_2X(i + 0, a, b, c, d, e, f, g, h);
+		SHA256_ROUND_2X(i + 1, h, a, b, c, d, e, f, g);
+		SHA256_ROUND_2X(i + 2, g, h, a, b, c, d, e, f);
+		SHA256_ROUND_2X(i + 3, f, g, h, a, b, c, d, e);
+		SHA256_ROUND_2X(i + 4, e, f, g, h, a, b, c, d);
+		SHA256_ROUND_2X(i + 5, d, e, f, g, h, a, b, c);
+		SHA256_ROUND_2X(i + 6, c, d, e, f, g, h, a, b);
+		SHA256_ROUND_2X(i + 7, b, c, d, e, f, g, h, a);
+	}
+
+	sx[0] += ax; sx[1] += bx; sx[2] += cx; sx[3] += dx;
+	sx[4] += ex; sx[5] += fx; sx[6] += gx; sx[7] += hx;
+	sy[0] += ay; sy[1] += by; sy[2] += cy; sy[3] += dy;
+	sy[4] += ey; sy[5] += fy; sy[6] += gy; sy[7] += hy;
+}
+
+static void sha256_transform_blocks_2x(struct sha256_state *sx,
+				       struct sha256_state *sy,
+				       const u8 *inx, const u8 *iny,
+				       unsigned int blocks)
+{
+	u32 Wx[64], Wy[64];
+
+	do {
+		sha256_transform_2x(sx->state, sy->state, inx, iny, Wx, Wy);
+		inx += SHA256_BLOCK_SIZE;
+		iny += SHA256_BLOCK_SIZE;
+	} while (--blocks);
+
+	memzero_explicit(Wx, sizeof(Wx));
+	memzero_explicit(Wy, sizeof(Wy));
+}
+
 void sha256_update(struct sha256_state *sctx, const u8 *data, unsigned int len)
 {
 	lib_sha256_base_do_update(sctx, data, len, sha256_transform_blocks);
@@ -165,4 +237,54 @@ void sha256(const u8 *data, unsigned int len, u8 *out)
 }
 EXPORT_SYMBOL(sha256);
 
+/**
+ * sha256_finup_2x() - hash two equal-length messages at once
+ * @sctx: state to start both messages from, e.g. after hashing a salt
+ * @data1: the first message
+ * @data2: the second message
+ * @len: length of each message in bytes
+ * @out1: digest of @sctx followed by @data1
+ * @out2: digest of @sctx followed by @data2
+ *
+ * Gives the same result as two separate sha256_update() + sha256_final()
+ * sequences on copies of @sctx, but the full blocks of both messages go
+ * through the compression function together, which is noticeably faster
+ * on CPUs that can overlap two independent rounds.
+ */
+void sha256_finup_2x(const struct sha256_state *sctx, const u8 *data1,
+		     const u8 *data2, unsigned int len,
+		     u8 out1[SHA256_DIGEST_SIZE], u8 out2[SHA256_DIGEST_SIZE])
+{
+	unsigned int partial = sctx->count % SHA256_BLOCK_SIZE;
+	struct sha256_state s1 = *sctx, s2 = *sctx;
+	unsigned int blocks;
+
+	if (partial) {
+		unsigned int n = min(len, SHA256_BLOCK_SIZE - partial);
+
+		sha256_update(&s1, data1, n);
+		sha256_update(&s2, data2, n);
+		data1 += n;
+		data2 += n;
+		len -= n;
+	}
+
+	/* Both states are now at a block boundary, unless len is 0. */
+	blocks = len / SHA256_BLOCK_SIZE;
+	if (blocks) {
+		sha256_transform_blocks_2x(&s1, &s2, data1, data2, blocks);
+		s1.count += blocks * SHA256_BLOCK_SIZE;
+		s2.count += blocks * SHA256_BLOCK_SIZE;
+		data1 += blocks * SHA256_BLOCK_SIZE;
+		data2 += blocks * SHA256_BLOCK_SIZE;
+		len %= SHA256_BLOCK_SIZE;
+	}
+
+	sha256_update(&s1, data1, len);
+	sha256_update(&s2, data2, len);
+	sha256_final(&s1, out1);
+	sha256_final(&s2, out2);
+}
+EXPORT_SYMBOL(sha256_finup_2x);
+
 MODULE_LICENSE("GPL");
@@ -180,6 +180,34 @@ static FORCE_INLINE int LZ4_decompress_generic(
 				continue;
 			}
 
+			/*
+			 * Except for the ones whose period divides 8, which
+			 * are mostly runs of zeroes: the match is then its
+			 * first 8 bytes repeated, so replicate the pattern
+			 * into a word and store that instead of copying
+			 * byte by byte in the slow path.
+			 */
+			if ((length != ML_MASK) &&
+			    (offset == 1 || offset == 2 || offset == 4) &&
+			    (dict == withPrefix64k || match >= lowPrefix)) {
+				U64 v;
+
+				if (offset == 1)
+					v = 0x0101010101010101ULL * match[0];
+				else if (offset == 2)
+					v = 0x0001000100010001ULL *
+					    LZ4_read16(match);
+				else
+					v = 0x0000000100000001ULL *
+					    LZ4_read32(match);
+
+				LZ4_memcpy(op + 0, &v, 8);
+				LZ4_memcpy(op + 8, &v, 8);
+				LZ4_memcpy(op + 16, &v, 2);
+				op += length + MINMATCH;
+				continue;
+			}
+
 			/*
 			 * The second stage didn't work out, but the info
 			 * is ready. Propel it right to the point of match
@@ -5592,19 +5592,8 @@ void mas_destroy(struct ma_state *mas)
 }
 EXPORT_SYMBOL_GPL(mas_destroy);
 
-/*
- * mas_expected_entries() - Set the expected number of entries that will be inserted.
- * @mas: The maple state
- * @nr_entries: The number of expected entries.
- *
- * This will attempt to pre-allocate enough nodes to store the expected number
- * of entries.  The allocations will occur using the bulk allocator interface
- * for speed.  Please call mas_destroy() on the @mas after inserting the entries
- * to ensure any unused nodes are freed.
- *
- * Return: 0 on success, -ENOMEM if memory could not be allocated.
- */
-int mas_expected_entries(struct ma_state *mas, unsigned long nr_entries)
+static int __mas_expected_entries(struct ma_state *mas,
+		unsigned long nr_entries, gfp_t gfp)
 {
 	int nonleaf_cap = MAPLE_ARANGE64_SLOTS - 2;
 	struct maple_enode *enode = mas->node;
@@ -5638,7 +5627,7 @@ int mas_expected_entries(struct ma_state *mas, unsigned long nr_entries)
 	/* Internal nodes */
 	nr_nodes += DIV_ROUND_UP(nr_nodes, nonleaf_cap);
 	/* Add working room for split (2 nodes) + new parents */
-	mas_node_count_gfp(mas, nr_nodes + 3, GFP_KERNEL);
+	mas_node_count_gfp(mas, nr_nodes + 3, gfp);
 
 	/* Detect if allocations run out */
 	mas->mas_flags |= MA_STATE_PREALLOC;
@@ -5652,6 +5641,23 @@ int mas_expected_entries(struct ma_state *mas, unsigned long nr_entries)
 	return ret;
 
 }
+
+/*
+ * mas_expected_entries() - Set the expected number of entries that will be inserted.
+ * @mas: The maple state
+ * @nr_entries: The number of expected entries.
+ *
+ * This will attempt to pre-allocate enough nodes to store the expected number
+ * of entries.  The allocations will occur using the bulk allocator interface
+ * for speed.  Please call mas_destroy() on the @mas after inserting the entries
+ * to ensure any unused nodes are freed.
+ *
+ * Return: 0 on success, -ENOMEM if memory could not be allocated.
+ */
+int mas_expected_entries(struct ma_state *mas, unsigned long nr_entries)
+{
+	return __mas_expected_entries(mas, nr_entries, GFP_KERNEL);
+}
 EXPORT_SYMBOL_GPL(mas_expected_entries);
 
 static inline bool mas_next_setup(struct ma_state *mas, unsigned long max,
@@ -6305,6 +6311,74 @@ int mtree_store_range(struct maple_tree *mt, unsigned long index,
 }
 EXPORT_SYMBOL(mtree_store_range);
 
+/**
+ * mtree_store_range_array() - Store a sorted array of ranges.
+ * @mt: The maple tree
+ * @first: The starts of the ranges
+ * @last: The ends of the ranges
+ * @entries: The entries to store
+ * @nr: The number of ranges
+ * @gfp: The GFP_FLAGS to use for allocations
+ *
+ * Store @entries[i] at [@first[i], @last[i]] for each i, under a single
+ * acquisition of the tree lock.  The ranges must be in ascending order and
+ * must not overlap.  If the tree is empty, not in RCU mode and @gfp allows
+ * blocking, the nodes for all entries are bulk allocated up front and the
+ * tree is built in bulk insert mode, which packs the leaves as it goes
+ * instead of splitting them in half.
+ *
+ * On error, the ranges before the failing one have been stored.
+ *
+ * Return: 0 on success, -EINVAL on invalid request, -ENOMEM if memory could not
+ * be allocated.
+ */
+int mtree_store_range_array(struct maple_tree *mt, const unsigned long *first,
+		const unsigned long *last, void **entries, unsigned long nr,
+		gfp_t gfp)
+{
+	MA_STATE(mas, mt, 0, 0);
+	unsigned long i;
+	bool bulk;
+	int ret = 0;
+
+	for (i = 0; i < nr; i++) {
+		if (WARN_ON_ONCE(xa_is_advanced(entries[i])))
+			return -EINVAL;
+
+		if (first[i] > last[i] || (i && first[i] <= last[i - 1]))
+			return -EINVAL;
+	}
+
+	if (!nr)
+		return 0;
+
+	bulk = gfpflags_allow_blocking(gfp) && !mt_in_rcu(mt);
+	if (bulk) {
+		/* Allocations do not touch the tree, do them unlocked */
+		ret = __mas_expected_entries(&mas, nr, gfp);
+		if (ret)
+			return ret;
+	}
+
+	mtree_lock(mt);
+	if (bulk && !mtree_empty(mt)) {
+		/* Bulk insert mode is only valid when building a new tree */
+		mas.mas_flags &= ~(MA_STATE_BULK | MA_STATE_PREALLOC);
+	}
+
+	for (i = 0; i < nr; i++) {
+		mas_set_range(&mas, first[i], last[i]);
+		ret = mas_store_gfp(&mas, entries[i], gfp);
+		if (ret)
+			break;
+	}
+
+	mas_destroy(&mas);
+	mtree_unlock(mt);
+
+	return ret;
+}
+
 /**
  * mtree_store() - Store an entry at a given index.
  * @mt: The maple tree
@@ -407,6 +407,28 @@ static int rhashtable_shrink(struct rhashtable *ht)
 	return rhashtable_rehash_alloc(ht, old_tbl, size);
 }
 
+/* Size to expand @tbl to.  After an insertion burst the table can be well
+ * past 75% load by the time the worker runs; pick a size that brings it back
+ * under 75% right away instead of doubling once per rehash pass, as every
+ * pass walks and relinks the whole table.
+ */
+static unsigned int rhashtable_grow_size(struct rhashtable *ht,
+					 struct bucket_table *tbl)
+{
+	unsigned int nelems = atomic_read(&ht->nelems);
+	unsigned int size = tbl->size * 2;
+
+	while (nelems > size / 4 * 3 &&
+	       (!ht->p.max_size || size < ht->p.max_size) &&
+	       size < (1U << 31))
+		size *= 2;
+
+	if (ht->p.max_size && size > ht->p.max_size)
+		size = ht->p.max_size;
+
+	return size;
+}
+
 static void rht_deferred_worker(struct work_struct *work)
 {
 	struct rhashtable *ht;
@@ -419,9 +441,13 @@ static void rht_deferred_worker(struct work_struct *work)
 	tbl = rht_dereference(ht->tbl, ht);
 	tbl = rhashtable_last_table(ht, tbl);
 
-	if (rht_grow_above_75(ht, tbl))
-		err = rhashtable_rehash_alloc(ht, tbl, tbl->size * 2);
-	else if (ht->p.automatic_shrinking && rht_shrink_below_30(ht, tbl))
+	if (rht_grow_above_75(ht, tbl)) {
+		unsigned int size = rhashtable_grow_size(ht, tbl);
+
+		err = rhashtable_rehash_alloc(ht, tbl, size);
+		if (err == -ENOMEM && size > tbl->size * 2)
+			err = rhashtable_rehash_alloc(ht, tbl, tbl->size * 2);
+	} else if (ht->p.automatic_shrinking && rht_shrink_below_30(ht, tbl))
 		err = rhashtable_shrink(ht);
 	else if (tbl->nest)
 		err = rhashtable_rehash_alloc(ht, tbl, tbl->size);
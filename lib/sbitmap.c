@@ -9,6 +9,30 @@
 #include <linux/sbitmap.h>
 #include <linux/seq_file.h>
 
+/*
+ * Pick a random starting hint for a CPU on @node. On NUMA systems the map
+ * is split into one range of whole words per node, so that CPUs on
+ * different nodes start out allocating from different cachelines rather
+ * than bouncing the same words between nodes.
+ */
+static unsigned int random_alloc_hint(struct sbitmap *sb, unsigned int depth,
+				      int node)
+{
+	unsigned int start = 0, len = depth;
+
+	if (nr_node_ids > 1 && node != NUMA_NO_NODE) {
+		unsigned int node_len;
+
+		node_len = round_down(depth / nr_node_ids, 1U << sb->shift);
+		if (node_len) {
+			start = node * node_len;
+			len = node_len;
+		}
+	}
+
+	return start + get_random_u32_below(len);
+}
+
 static int init_alloc_hint(struct sbitmap *sb, gfp_t flags)
 {
 	unsigned depth = sb->depth;
@@ -21,7 +45,8 @@ static int init_alloc_hint(struct sbitmap *sb, gfp_t flags)
 		int i;
 
 		for_each_possible_cpu(i)
-			*per_cpu_ptr(sb->alloc_hint, i) = get_random_u32_below(depth);
+			*per_cpu_ptr(sb->alloc_hint, i) =
+				random_alloc_hint(sb, depth, cpu_to_node(i));
 	}
 	return 0;
 }
@@ -33,7 +58,7 @@ static inline unsigned update_alloc_hint_before_get(struct sbitmap *sb,
 
 	hint = this_cpu_read(*sb->alloc_hint);
 	if (unlikely(hint >= depth)) {
-		hint = depth ? get_random_u32_below(depth) : 0;
+		hint = depth ? random_alloc_hint(sb, depth, numa_node_id()) : 0;
 		this_cpu_write(*sb->alloc_hint, hint);
 	}
 
@@ -46,8 +71,12 @@ static inline void update_alloc_hint_after_get(struct sbitmap *sb,
 					       unsigned int nr)
 {
 	if (nr == -1) {
-		/* If the map is full, a hint won't do us much good. */
-		this_cpu_write(*sb->alloc_hint, 0);
+		/*
+		 * If the map is full, a hint won't do us much good. Make the
+		 * next allocation pick a new one in this node's range rather
+		 * than have every CPU restart from the first word.
+		 */
+		this_cpu_write(*sb->alloc_hint, sb->round_robin ? 0 : UINT_MAX);
 	} else if (nr == hint || unlikely(sb->round_robin)) {
 		/* Only update the hint if we used it. */
 		hint = nr + 1;
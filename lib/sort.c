@@ -12,9 +12,12 @@
 
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
+#include <linux/bug.h>
 #include <linux/types.h>
 #include <linux/export.h>
+#include <linux/minmax.h>
 #include <linux/sort.h>
+#include <linux/string.h>
 
 /**
  * is_aligned - is this pointer & size okay for word-wide copying?
@@ -290,3 +293,92 @@ void sort(void *base, size_t num, size_t size,
 	return sort_r(base, num, size, _CMP_WRAPPER, SWAP_WRAPPER, &w);
 }
 EXPORT_SYMBOL(sort);
+
+static int cmp_sort_pair(const void *a, const void *b)
+{
+	const struct sort_pair *l = a, *r = b;
+
+	if (l->key == r->key)
+		return 0;
+	return l->key < r->key ? -1 : 1;
+}
+
+/* Below this, the radix passes cost more than they save */
+#define SORT_PAIRS_RADIX_MIN	256
+
+/* Stable insertion sort for the arrays too short for the radix passes */
+static void sort_pairs_short(struct sort_pair *base, size_t num)
+{
+	size_t i, j;
+
+	for (i = 1; i < num; i++) {
+		struct sort_pair p = base[i];
+
+		for (j = i; j > 0 && base[j - 1].key > p.key; j--)
+			base[j] = base[j - 1];
+		base[j] = p;
+	}
+}
+
+/**
+ * sort_pairs - sort key/value pairs by key
+ * @base: pointer to the pairs to sort
+ * @tmp: scratch buffer with room for @num pairs
+ * @num: number of pairs
+ *
+ * This function does a stable LSD radix sort on the 64-bit keys, one byte
+ * per pass, moving the pairs between @base and @tmp; passes in which every
+ * key has the same byte are skipped, so small or clustered key ranges cost
+ * only their significant bytes. The sorted pairs end up in @base.
+ *
+ * Unlike sort(), the memory traffic is a few sequential sweeps over the
+ * array rather than O(n log n) scattered accesses, which makes it much
+ * faster for large arrays; the price is the @tmp buffer. Short arrays are
+ * insertion sorted in place, which is stable too. @num must not exceed
+ * UINT_MAX.
+ */
+void sort_pairs(struct sort_pair *base, struct sort_pair *tmp, size_t num)
+{
+	struct sort_pair *src = base, *dst = tmp;
+	unsigned int count[256];
+	unsigned int shift;
+	size_t i;
+
+	if (num < SORT_PAIRS_RADIX_MIN) {
+		sort_pairs_short(base, num);
+		return;
+	}
+
+	/* The bucket counters are 32-bit; sort() at least sorts, unstably. */
+	if (WARN_ON_ONCE(num > UINT_MAX)) {
+		sort(base, num, sizeof(*base), cmp_sort_pair, NULL);
+		return;
+	}
+
+	for (shift = 0; shift < 64; shift += 8) {
+		unsigned int sum = 0, c, d;
+
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < num; i++)
+			count[(src[i].key >> shift) & 0xff]++;
+
+		/* Every key has the same byte here: nothing would move. */
+		if (count[(src[0].key >> shift) & 0xff] == num)
+			continue;
+
+		for (d = 0; d < 256; d++) {
+			c = count[d];
+			count[d] = sum;
+			sum += c;
+		}
+
+		for (i = 0; i < num; i++)
+			dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+
+		swap(src, dst);
+	}
+
+	if (src != base)
+		memcpy(base, src, num * sizeof(*base));
+}
+EXPORT_SYMBOL(sort_pairs);
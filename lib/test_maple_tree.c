@@ -1944,6 +1944,88 @@ static noinline void __init check_iteration(struct maple_tree *mt)
 	mt_set_non_kernel(0);
 }
 
+static noinline void __init check_store_range_array(struct maple_tree *mt)
+{
+	static unsigned long first[300] __initdata;
+	static unsigned long last[300] __initdata;
+	static void *entries[300] __initdata;
+	unsigned long i, nr = ARRAY_SIZE(first);
+
+	/* mtree_store_range_array() is not exported to modules */
+	if (IS_MODULE(CONFIG_TEST_MAPLE_TREE))
+		return;
+
+	for (i = 0; i < nr; i++) {
+		first[i] = i * 10;
+		last[i] = i * 10 + 5;
+		entries[i] = xa_mk_value(i);
+	}
+
+	/* Nothing to do */
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, 0,
+					      GFP_KERNEL) != 0);
+	MT_BUG_ON(mt, !mtree_empty(mt));
+
+	/* Overlapping, unsorted and inverted ranges are rejected up front */
+	last[1] = first[2];
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_KERNEL) != -EINVAL);
+	last[1] = first[1] + 5;
+	first[4] = first[3];
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_KERNEL) != -EINVAL);
+	first[4] = 40;
+	first[5] = last[5] + 1;
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_KERNEL) != -EINVAL);
+	first[5] = 50;
+	MT_BUG_ON(mt, !mtree_empty(mt));
+
+	/* Empty tree: bulk insert mode */
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_KERNEL) != 0);
+	mt_validate(mt);
+	for (i = 0; i < nr; i++) {
+		MT_BUG_ON(mt, mtree_load(mt, first[i]) != xa_mk_value(i));
+		MT_BUG_ON(mt, mtree_load(mt, last[i]) != xa_mk_value(i));
+		MT_BUG_ON(mt, mtree_load(mt, last[i] + 1) != NULL);
+	}
+
+	/* Non-empty tree: regular stores over the existing ranges */
+	for (i = 0; i < nr; i++) {
+		first[i] = i * 20 + 3;
+		last[i] = i * 20 + 12;
+		entries[i] = xa_mk_value(i + nr);
+	}
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_KERNEL) != 0);
+	mt_validate(mt);
+	for (i = 0; i < nr; i++) {
+		MT_BUG_ON(mt, mtree_load(mt, first[i]) != xa_mk_value(i + nr));
+		MT_BUG_ON(mt, mtree_load(mt, last[i]) != xa_mk_value(i + nr));
+	}
+	mtree_destroy(mt);
+
+	/* A gfp mask that cannot block skips the bulk preallocation */
+	mt_init_flags(mt, MT_FLAGS_ALLOC_RANGE);
+	mt_set_non_kernel(99999);
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_NOWAIT) != 0);
+	mt_set_non_kernel(0);
+	mt_validate(mt);
+	for (i = 0; i < nr; i++)
+		MT_BUG_ON(mt, mtree_load(mt, first[i]) != xa_mk_value(i + nr));
+	mtree_destroy(mt);
+
+	/* Bulk mode preallocates with the caller's gfp mask */
+	mt_init_flags(mt, MT_FLAGS_ALLOC_RANGE);
+	MT_BUG_ON(mt, mtree_store_range_array(mt, first, last, entries, nr,
+					      GFP_NOFS) != 0);
+	mt_validate(mt);
+	for (i = 0; i < nr; i++)
+		MT_BUG_ON(mt, mtree_load(mt, last[i]) != xa_mk_value(i + nr));
+}
+
 static noinline void __init check_mas_store_gfp(struct maple_tree *mt)
 {
 
@@ -3658,6 +3740,10 @@ static int __init maple_tree_seed(void)
 	check_mas_store_gfp(&tree);
 	mtree_destroy(&tree);
 
+	mt_init_flags(&tree, MT_FLAGS_ALLOC_RANGE);
+	check_store_range_array(&tree);
+	mtree_destroy(&tree);
+
 	/* Test ranges (store and insert) */
 	mt_init_flags(&tree, 0);
 	check_ranges(&tree);
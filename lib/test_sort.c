@@ -5,6 +5,8 @@
 #include <linux/sort.h>
 #include <linux/slab.h>
 #include <linux/module.h>
+#include <linux/random.h>
+#include <linux/timekeeping.h>
 
 /* a simple boot-time regression test */
 
@@ -33,8 +35,89 @@ static void test_sort(struct kunit *test)
 		KUNIT_ASSERT_LE(test, a[i], a[i + 1]);
 }
 
+static void check_sort_pairs(struct kunit *test, int len)
+{
+	struct sort_pair *a, *tmp;
+	u64 r = 1;
+	int i;
+
+	a = kunit_kmalloc_array(test, len, sizeof(*a), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, a);
+	tmp = kunit_kmalloc_array(test, len, sizeof(*tmp), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, tmp);
+
+	/* Few distinct keys in the upper bytes, so stability is tested too */
+	for (i = 0; i < len; i++) {
+		r = (r * 725861) % 6599;
+		a[i].key = (r % 13) << 40 | (r & 0xff00);
+		a[i].val = i;
+	}
+
+	sort_pairs(a, tmp, len);
+
+	for (i = 0; i < len-1; i++) {
+		KUNIT_ASSERT_LE(test, a[i].key, a[i + 1].key);
+		if (a[i].key == a[i + 1].key)
+			KUNIT_ASSERT_LT(test, a[i].val, a[i + 1].val);
+	}
+}
+
+static void test_sort_pairs(struct kunit *test)
+{
+	check_sort_pairs(test, TEST_LEN);
+	/* Short enough for the insertion sort */
+	check_sort_pairs(test, 100);
+}
+
+#define BENCH_LEN (1 << 16)
+
+static int cmp_pair(const void *a, const void *b)
+{
+	const struct sort_pair *l = a, *r = b;
+
+	if (l->key == r->key)
+		return 0;
+	return l->key < r->key ? -1 : 1;
+}
+
+/* Not a pass/fail test: reports sort_pairs() against sort() */
+static void test_sort_pairs_bench(struct kunit *test)
+{
+	struct sort_pair *a, *b, *tmp;
+	u64 t0, t1, t2;
+	int i;
+
+	a = kunit_kmalloc_array(test, BENCH_LEN, sizeof(*a), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, a);
+	b = kunit_kmalloc_array(test, BENCH_LEN, sizeof(*b), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, b);
+	tmp = kunit_kmalloc_array(test, BENCH_LEN, sizeof(*tmp), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, tmp);
+
+	for (i = 0; i < BENCH_LEN; i++) {
+		a[i].key = get_random_u64();
+		a[i].val = i;
+	}
+	memcpy(b, a, BENCH_LEN * sizeof(*a));
+
+	t0 = ktime_get_ns();
+	sort(a, BENCH_LEN, sizeof(*a), cmp_pair, NULL);
+	t1 = ktime_get_ns();
+	sort_pairs(b, tmp, BENCH_LEN);
+	t2 = ktime_get_ns();
+
+	for (i = 0; i < BENCH_LEN; i++)
+		KUNIT_ASSERT_EQ(test, a[i].key, b[i].key);
+
+	kunit_info(test, "%d pairs: sort() %llu us, sort_pairs() %llu us\n",
+		   BENCH_LEN, (t1 - t0) / NSEC_PER_USEC,
+		   (t2 - t1) / NSEC_PER_USEC);
+}
+
 static struct kunit_case sort_test_cases[] = {
 	KUNIT_CASE(test_sort),
+	KUNIT_CASE(test_sort_pairs),
+	KUNIT_CASE_SLOW(test_sort_pairs_bench),
 	{}
 };
 
@@ -172,6 +172,59 @@ static noinline void check_xa_load(struct xarray *xa)
 	XA_BUG_ON(xa, !xa_empty(xa));
 }
 
+static noinline void check_xa_load_batch(struct xarray *xa)
+{
+	unsigned long indices[] = { 0, 1, 5, 63, 64, 65, 4096, 12345678 };
+	void *entries[ARRAY_SIZE(indices)];
+	unsigned int i;
+
+	/* xa_load_batch() is not exported to modules */
+	if (IS_MODULE(CONFIG_TEST_XARRAY))
+		return;
+
+	xa_store_index(xa, 1, GFP_KERNEL);
+	xa_store_index(xa, 64, GFP_KERNEL);
+	xa_store_index(xa, 4096, GFP_KERNEL);
+	xa_load_batch(xa, indices, entries, ARRAY_SIZE(indices));
+	for (i = 0; i < ARRAY_SIZE(indices); i++)
+		XA_BUG_ON(xa, entries[i] != xa_load(xa, indices[i]));
+
+	/* Reserved entries read as NULL, in the same leaf or not */
+	XA_BUG_ON(xa, xa_reserve(xa, 5, GFP_KERNEL) != 0);
+	XA_BUG_ON(xa, xa_reserve(xa, 12345678, GFP_KERNEL) != 0);
+	xa_load_batch(xa, indices, entries, ARRAY_SIZE(indices));
+	for (i = 0; i < ARRAY_SIZE(indices); i++)
+		XA_BUG_ON(xa, entries[i] != xa_load(xa, indices[i]));
+	XA_BUG_ON(xa, entries[1] != xa_mk_index(1));
+	XA_BUG_ON(xa, entries[2] != NULL);
+	XA_BUG_ON(xa, entries[7] != NULL);
+	xa_release(xa, 5);
+	xa_release(xa, 12345678);
+
+	xa_erase_index(xa, 1);
+	xa_erase_index(xa, 64);
+	xa_erase_index(xa, 4096);
+	XA_BUG_ON(xa, !xa_empty(xa));
+
+	/* Every index covered by a multi-index entry returns that entry */
+	if (IS_ENABLED(CONFIG_XARRAY_MULTI)) {
+		unsigned long multi[] = { 0, 3, 4, 7, 8, 64, 127, 128 };
+
+		xa_store_order(xa, 4, 2, xa_mk_index(4), GFP_KERNEL);
+		xa_store_order(xa, 64, 6, xa_mk_index(64), GFP_KERNEL);
+		xa_load_batch(xa, multi, entries, ARRAY_SIZE(multi));
+		for (i = 0; i < ARRAY_SIZE(multi); i++)
+			XA_BUG_ON(xa, entries[i] != xa_load(xa, multi[i]));
+		XA_BUG_ON(xa, entries[3] != xa_mk_index(4));
+		XA_BUG_ON(xa, entries[6] != xa_mk_index(64));
+		XA_BUG_ON(xa, entries[7] != NULL);
+
+		xa_erase_index(xa, 4);
+		xa_erase_index(xa, 64);
+		XA_BUG_ON(xa, !xa_empty(xa));
+	}
+}
+
 static noinline void check_xa_mark_1(struct xarray *xa, unsigned long index)
 {
 	unsigned int order;
@@ -1796,6 +1849,7 @@ static int xarray_checks(void)
 	check_xa_err(&array);
 	check_xas_retry(&array);
 	check_xa_load(&array);
+	check_xa_load_batch(&array);
 	check_xa_mark(&array);
 	check_xa_shrink(&array);
 	check_xas_erase(&array);
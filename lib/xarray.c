@@ -1468,6 +1468,55 @@ void *xa_load(struct xarray *xa, unsigned long index)
 }
 EXPORT_SYMBOL(xa_load);
 
+/**
+ * xa_load_batch() - Load the entries at several indices.
+ * @xa: XArray.
+ * @indices: The indices to look up.
+ * @entries: The entries found at @indices.
+ * @nr: The number of indices.
+ *
+ * Equivalent to calling xa_load() for each index, but walks the tree only
+ * once for indices that fall in the same leaf node as the previous one,
+ * and takes the RCU lock only once.  Sorting @indices makes the best use
+ * of this.
+ *
+ * Context: Any context.  Takes and releases the RCU lock.
+ */
+void xa_load_batch(struct xarray *xa, const unsigned long *indices,
+		void **entries, unsigned int nr)
+{
+	XA_STATE(xas, xa, 0);
+	unsigned int i;
+
+	rcu_read_lock();
+	for (i = 0; i < nr; i++) {
+		unsigned long index = indices[i];
+		void *entry;
+
+		if (xas_valid(&xas) && xas.xa_node && !xas.xa_node->shift &&
+		    (index >> XA_CHUNK_SHIFT) ==
+		    (xas.xa_index >> XA_CHUNK_SHIFT)) {
+			xas.xa_index = index;
+			xas.xa_offset = index & XA_CHUNK_MASK;
+			entry = xas_reload(&xas);
+		} else {
+			xas_set(&xas, index);
+			entry = xas_load(&xas);
+		}
+
+		for (;;) {
+			if (xa_is_zero(entry))
+				entry = NULL;
+			if (!xas_retry(&xas, entry))
+				break;
+			entry = xas_load(&xas);
+		}
+
+		entries[i] = entry;
+	}
+	rcu_read_unlock();
+}
+
 static void *xas_result(struct xa_state *xas, void *curr)
 {
 	if (xa_is_zero(curr))
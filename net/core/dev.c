@@ -4281,6 +4281,7 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 {
 	struct net_device *dev = skb->dev;
 	struct netdev_queue *txq = NULL;
+	bool pkt_len_set = false;
 	struct Qdisc *q;
 	int rc = -ENOMEM;
 	bool again = false;
@@ -4298,10 +4299,13 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 
 	skb_update_prio(skb);
 
-	qdisc_pkt_len_init(skb);
 	tcx_set_ingress(skb, false);
 #ifdef CONFIG_NET_EGRESS
 	if (static_branch_unlikely(&egress_needed_key)) {
+		/* tc and netfilter egress may look at qdisc_pkt_len() */
+		qdisc_pkt_len_init(skb);
+		pkt_len_set = true;
+
 		if (nf_hook_egress_active()) {
 			skb = nf_hook_egress(skb, &rc, dev);
 			if (!skb)
@@ -4335,6 +4339,11 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 
 	trace_net_dev_queue(skb);
 	if (q->enqueue) {
+		/* Only qdiscs and egress hooks use the wire length estimate,
+		 * so noqueue devices don't pay for the GSO header walk.
+		 */
+		if (!pkt_len_set)
+			qdisc_pkt_len_init(skb);
 		rc = __dev_xmit_skb(skb, q, dev, txq);
 		goto out;
 	}
@@ -4401,7 +4410,16 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 }
 EXPORT_SYMBOL(__dev_queue_xmit);
 
-int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
+/**
+ * __dev_direct_xmit_more - transmit a buffer on a given queue, bypassing qdiscs
+ * @skb: buffer to transmit
+ * @queue_id: tx queue to use
+ * @more: more buffers will follow on the same queue
+ *
+ * When @more is true the driver may defer kicking the hardware, so the caller
+ * must end each batch with a call that has @more set to false.
+ */
+int __dev_direct_xmit_more(struct sk_buff *skb, u16 queue_id, bool more)
 {
 	struct net_device *dev = skb->dev;
 	struct sk_buff *orig_skb = skb;
@@ -4425,7 +4443,7 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 	dev_xmit_recursion_inc();
 	HARD_TX_LOCK(dev, txq, smp_processor_id());
 	if (!netif_xmit_frozen_or_drv_stopped(txq))
-		ret = netdev_start_xmit(skb, dev, txq, false);
+		ret = netdev_start_xmit(skb, dev, txq, more);
 	HARD_TX_UNLOCK(dev, txq);
 	dev_xmit_recursion_dec();
 
@@ -4436,6 +4454,12 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 	kfree_skb_list(skb);
 	return NET_XMIT_DROP;
 }
+EXPORT_SYMBOL(__dev_direct_xmit_more);
+
+int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
+{
+	return __dev_direct_xmit_more(skb, queue_id, false);
+}
 EXPORT_SYMBOL(__dev_direct_xmit);
 
 /*************************************************************************
@@ -4788,48 +4812,118 @@ static bool skb_flow_limit(struct sk_buff *skb, unsigned int qlen)
  * enqueue_to_backlog is called to queue an skb to a per CPU backlog
  * queue (may be a remote CPU queue).
  */
-static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
-			      unsigned int *qtail)
+/*
+ * Queue @skb to the backlog of @sd, whose rps lock the caller holds.
+ * Returns SKB_NOT_DROPPED_YET on success, otherwise the reason the caller
+ * should drop it with.
+ */
+static enum skb_drop_reason __enqueue_to_backlog(struct softnet_data *sd,
+						 struct sk_buff *skb,
+						 unsigned int *qtail)
 {
-	enum skb_drop_reason reason;
-	struct softnet_data *sd;
-	unsigned long flags;
 	unsigned int qlen;
 
-	reason = SKB_DROP_REASON_NOT_SPECIFIED;
-	sd = &per_cpu(softnet_data, cpu);
-
-	rps_lock_irqsave(sd, &flags);
 	if (!netif_running(skb->dev))
 		goto drop;
 	qlen = skb_queue_len(&sd->input_pkt_queue);
-	if (qlen <= READ_ONCE(netdev_max_backlog) && !skb_flow_limit(skb, qlen)) {
-		if (qlen) {
-enqueue:
-			__skb_queue_tail(&sd->input_pkt_queue, skb);
-			input_queue_tail_incr_save(sd, qtail);
-			rps_unlock_irq_restore(sd, &flags);
-			return NET_RX_SUCCESS;
-		}
-
-		/* Schedule NAPI for backlog device
-		 * We can use non atomic operation since we own the queue lock
-		 */
-		if (!__test_and_set_bit(NAPI_STATE_SCHED, &sd->backlog.state))
-			napi_schedule_rps(sd);
-		goto enqueue;
+	if (qlen > READ_ONCE(netdev_max_backlog) || skb_flow_limit(skb, qlen)) {
+		sd->dropped++;
+		return SKB_DROP_REASON_CPU_BACKLOG;
 	}
-	reason = SKB_DROP_REASON_CPU_BACKLOG;
+
+	/* Schedule NAPI for backlog device
+	 * We can use non atomic operation since we own the queue lock
+	 */
+	if (!qlen && !__test_and_set_bit(NAPI_STATE_SCHED, &sd->backlog.state))
+		napi_schedule_rps(sd);
+
+	__skb_queue_tail(&sd->input_pkt_queue, skb);
+	input_queue_tail_incr_save(sd, qtail);
+	return SKB_NOT_DROPPED_YET;
 
 drop:
 	sd->dropped++;
+	return SKB_DROP_REASON_NOT_SPECIFIED;
+}
+
+static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
+			      unsigned int *qtail)
+{
+	enum skb_drop_reason reason;
+	struct softnet_data *sd;
+	unsigned long flags;
+
+	sd = &per_cpu(softnet_data, cpu);
+
+	rps_lock_irqsave(sd, &flags);
+	reason = __enqueue_to_backlog(sd, skb, qtail);
 	rps_unlock_irq_restore(sd, &flags);
 
+	if (likely(reason == SKB_NOT_DROPPED_YET))
+		return NET_RX_SUCCESS;
+
 	dev_core_stats_rx_dropped_inc(skb->dev);
 	kfree_skb_reason(skb, reason);
 	return NET_RX_DROP;
 }
 
+#ifdef CONFIG_RPS
+/*
+ * RPS steering of a received list: runs of hash-steered packets going to
+ * the same CPU are queued to its backlog under a single acquisition of the
+ * remote input_pkt_queue lock instead of one per packet.
+ */
+#define RPS_BACKLOG_BATCH	16
+
+struct rps_backlog_batch {
+	int			cpu;
+	unsigned int		count;
+	struct sk_buff		*skbs[RPS_BACKLOG_BATCH];
+	unsigned int		*qtails[RPS_BACKLOG_BATCH];
+};
+
+static void rps_backlog_batch_flush(struct rps_backlog_batch *batch)
+{
+	enum skb_drop_reason reasons[RPS_BACKLOG_BATCH];
+	struct softnet_data *sd;
+	unsigned long flags;
+	unsigned int i;
+
+	if (!batch->count)
+		return;
+
+	sd = &per_cpu(softnet_data, batch->cpu);
+
+	rps_lock_irqsave(sd, &flags);
+	for (i = 0; i < batch->count; i++)
+		reasons[i] = __enqueue_to_backlog(sd, batch->skbs[i],
+						  batch->qtails[i]);
+	rps_unlock_irq_restore(sd, &flags);
+
+	for (i = 0; i < batch->count; i++) {
+		if (likely(reasons[i] == SKB_NOT_DROPPED_YET))
+			continue;
+		dev_core_stats_rx_dropped_inc(batch->skbs[i]->dev);
+		kfree_skb_reason(batch->skbs[i], reasons[i]);
+	}
+	batch->count = 0;
+}
+
+static void rps_backlog_batch_add(struct rps_backlog_batch *batch,
+				  struct sk_buff *skb, int cpu,
+				  unsigned int *qtail)
+{
+	if (batch->count &&
+	    (batch->cpu != cpu || batch->count == RPS_BACKLOG_BATCH))
+		rps_backlog_batch_flush(batch);
+
+	batch->cpu = cpu;
+	batch->skbs[batch->count] = skb;
+	batch->qtails[batch->count] = qtail;
+	batch->count++;
+}
+#endif
+
 static struct netdev_rx_queue *netif_get_rxqueue(struct sk_buff *skb)
 {
 	struct net_device *dev = skb->dev;
@@ -5774,16 +5868,33 @@ void netif_receive_skb_list_internal(struct list_head *head)
 	rcu_read_lock();
 #ifdef CONFIG_RPS
 	if (static_branch_unlikely(&rps_needed)) {
+		struct rps_dev_flow voidflow;
+		struct rps_backlog_batch batch;
+
+		batch.count = 0;
 		list_for_each_entry_safe(skb, next, head, list) {
-			struct rps_dev_flow voidflow, *rflow = &voidflow;
+			struct rps_dev_flow *rflow = &voidflow;
 			int cpu = get_rps_cpu(skb->dev, skb, &rflow);
 
-			if (cpu >= 0) {
-				/* Will be handled, remove from list */
-				skb_list_del_init(skb);
-				enqueue_to_backlog(skb, cpu, &rflow->last_qtail);
+			if (cpu < 0)
+				continue;
+
+			/* Will be handled, remove from list */
+			skb_list_del_init(skb);
+			if (rflow == &voidflow) {
+				rps_backlog_batch_add(&batch, skb, cpu,
+						      &voidflow.last_qtail);
+				continue;
 			}
+
+			/* RFS decides when a flow may move by comparing its
+			 * last_qtail with the old CPU's queue head, so an
+			 * RFS steered packet must not be held back.
+			 */
+			rps_backlog_batch_flush(&batch);
+			enqueue_to_backlog(skb, cpu, &rflow->last_qtail);
 		}
+		rps_backlog_batch_flush(&batch);
 	}
 #endif
 	__netif_receive_skb_list(head);
@@ -6375,7 +6486,7 @@ static enum hrtimer_restart napi_watchdog(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
-static void init_gro_hash(struct napi_struct *napi)
+void init_gro_hash(struct napi_struct *napi)
 {
 	int i;
 
@@ -6682,15 +6793,126 @@ static void skb_defer_free_flush(struct softnet_data *sd)
 	}
 }
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+/*
+ * Keep polling a threaded NAPI that has just completed until no packet has
+ * shown up for @spin_ns, @limit_ns have passed in total, or someone else
+ * wants the CPU.  The IRQ was re-armed by the completion; one that fires
+ * while we spin finds the NAPI claimed and only sets NAPI_STATE_MISSED.
+ * Returns -1 if the NAPI could not be claimed (it was already rescheduled),
+ * 0 if nothing arrived and 1 if something did, in which case *gap_ns is set
+ * to how long the first packet took to show up.
+ */
+static int napi_threaded_spin(struct napi_struct *napi, u64 spin_ns,
+			      u64 limit_ns, u64 *gap_ns)
+{
+	int budget = READ_ONCE(napi->weight);
+	unsigned long last_qs = jiffies;
+	struct softnet_data *sd;
+	void *have_poll_lock;
+	u64 start, last, now;
+	unsigned long val;
+	int ret = 0;
+
+	val = READ_ONCE(napi->state);
+	if (val & (NAPIF_STATE_DISABLE | NAPIF_STATE_SCHED |
+		   NAPIF_STATE_IN_BUSY_POLL))
+		return -1;
+	if (cmpxchg(&napi->state, val,
+		    val | NAPIF_STATE_IN_BUSY_POLL | NAPIF_STATE_SCHED) != val)
+		return -1;
+
+	have_poll_lock = netpoll_poll_lock(napi);
+	start = last = local_clock();
+	for (;;) {
+		int work;
+
+		local_bh_disable();
+		work = napi->poll(napi, budget);
+		trace_napi_poll(napi, work, budget);
+		gro_normal_list(napi);
+		sd = this_cpu_ptr(&softnet_data);
+		skb_defer_free_flush(sd);
+		local_bh_enable();
+
+		now = local_clock();
+		if (work > 0) {
+			if (!ret)
+				*gap_ns = now - start;
+			ret = 1;
+			last = now;
+		}
+		if (now - last >= spin_ns || now - start >= limit_ns ||
+		    need_resched() || kthread_should_stop() ||
+		    test_bit(NAPI_STATE_DISABLE, &napi->state))
+			break;
+		rcu_softirq_qs_periodic(last_qs);
+		cpu_relax();
+	}
+	busy_poll_stop(napi, have_poll_lock, false, budget);
+	cond_resched();
+
+	return ret;
+}
+#else
+static int napi_threaded_spin(struct napi_struct *napi, u64 spin_ns,
+			      u64 limit_ns, u64 *gap_ns)
+{
+	return -1;
+}
+#endif /* CONFIG_NET_RX_BUSY_POLL */
+
+/* How long a threaded NAPI may keep polling after traffic stops, see
+ * napi_threaded_poll_spin().  Zero disables spinning.
+ */
+unsigned int sysctl_napi_threaded_spin_usecs __read_mostly;
+
+#define NAPI_SPIN_GAP_SHIFT	2
+
+static void napi_spin_gap_update(u64 *gap_ewma, u64 sample)
+{
+	*gap_ewma = *gap_ewma - (*gap_ewma >> NAPI_SPIN_GAP_SHIFT) +
+		    (sample >> NAPI_SPIN_GAP_SHIFT);
+}
+
+/*
+ * After a threaded NAPI completes, spin on it for about twice the typical
+ * gap between bursts, capped by the sysctl, so that the next burst is
+ * picked up without an interrupt and a wakeup.  If bursts are usually
+ * further apart than the cap, spinning would only burn the CPU, so don't.
+ */
+static void napi_threaded_poll_spin(struct napi_struct *napi, u64 *gap_ewma)
+{
+	u64 spin_max = (u64)READ_ONCE(sysctl_napi_threaded_spin_usecs) *
+		       NSEC_PER_USEC;
+	u64 spin, gap;
+	int ret;
+
+	if (!spin_max || *gap_ewma > spin_max)
+		return;
+
+	spin = *gap_ewma ? min(*gap_ewma * 2, spin_max) : spin_max;
+	ret = napi_threaded_spin(napi, spin, spin_max, &gap);
+	if (ret > 0)
+		napi_spin_gap_update(gap_ewma, gap);
+	else if (!ret)
+		napi_spin_gap_update(gap_ewma, spin);
+}
+
 static int napi_threaded_poll(void *data)
 {
 	struct napi_struct *napi = data;
 	struct softnet_data *sd;
+	u64 gap_ewma = 0, idle_since = 0;
 	void *have;
 
 	while (!napi_thread_wait(napi)) {
 		unsigned long last_qs = jiffies;
 
+		/* woken by an interrupt: that is one observed gap */
+		if (idle_since && READ_ONCE(sysctl_napi_threaded_spin_usecs))
+			napi_spin_gap_update(&gap_ewma, local_clock() - idle_since);
+
 		for (;;) {
 			bool repoll = false;
 
@@ -6718,6 +6940,9 @@ static int napi_threaded_poll(void *data)
 			rcu_softirq_qs_periodic(last_qs);
 			cond_resched();
 		}
+
+		napi_threaded_poll_spin(napi, &gap_ewma);
+		idle_since = local_clock();
 	}
 	return 0;
 }
@@ -41,6 +41,7 @@ void dev_addr_check(struct net_device *dev);
 extern int		netdev_budget;
 extern unsigned int	netdev_budget_usecs;
 extern unsigned int	sysctl_skb_defer_max;
+extern unsigned int	sysctl_napi_threaded_spin_usecs;
 extern int		netdev_tstamp_prequeue;
 extern int		netdev_unregister_timeout_secs;
 extern int		weight_p;
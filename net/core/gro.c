@@ -295,13 +295,11 @@ static void __napi_gro_flush_chain(struct napi_struct *napi, u32 index,
 void napi_gro_flush(struct napi_struct *napi, bool flush_old)
 {
 	unsigned long bitmask = napi->gro_bitmask;
-	unsigned int i, base = ~0U;
+	unsigned int i;
 
-	while ((i = ffs(bitmask)) != 0) {
-		bitmask >>= i;
-		base += i;
-		__napi_gro_flush_chain(napi, base, flush_old);
-	}
+	/* ffs() only sees the low 32 bits, which a wide table exceeds */
+	for_each_set_bit(i, &bitmask, GRO_HASH_BUCKETS)
+		__napi_gro_flush_chain(napi, i, flush_old);
 }
 EXPORT_SYMBOL(napi_gro_flush);
 
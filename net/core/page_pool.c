@@ -28,6 +28,27 @@
 
 #define BIAS_MAX	LONG_MAX
 
+/* Pages released outside the pool's own NAPI context are collected in a
+ * small per-CPU magazine and pushed into the pool's ptr_ring in one go, so
+ * the ring producer_lock is taken once per PP_MAGAZINE_SIZE pages instead
+ * of once per page.  A magazine only ever holds pages of a single pool;
+ * releasing a page of another pool flushes it first.  The lock is
+ * effectively CPU local and is only contended when a pool being destroyed
+ * drains the other CPUs' magazines.
+ */
+#define PP_MAGAZINE_SIZE	16
+
+struct page_pool_magazine {
+	spinlock_t		lock;
+	struct page_pool	*pool;
+	unsigned int		count;
+	struct page		*pages[PP_MAGAZINE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct page_pool_magazine, pp_magazines) = {
+	.lock = __SPIN_LOCK_UNLOCKED(pp_magazines.lock),
+};
+
 #ifdef CONFIG_PAGE_POOL_STATS
 /* alloc_stat_inc is intended to be used in softirq context */
 #define alloc_stat_inc(pool, __stat)	(pool->alloc_stats.__stat++)
@@ -265,6 +286,67 @@ EXPORT_SYMBOL(page_pool_create);
 
 static void page_pool_return_page(struct page_pool *pool, struct page *page);
 
+/* Caller must hold mag->lock with BH disabled */
+static void page_pool_magazine_flush(struct page_pool_magazine *mag)
+{
+	struct page_pool *pool = mag->pool;
+	unsigned int i;
+
+	if (!mag->count)
+		return;
+
+	spin_lock(&pool->ring.producer_lock);
+	for (i = 0; i < mag->count; i++) {
+		if (__ptr_ring_produce(&pool->ring, mag->pages[i])) {
+			/* ring full */
+			recycle_stat_inc(pool, ring_full);
+			break;
+		}
+	}
+	recycle_stat_add(pool, ring, i);
+	spin_unlock(&pool->ring.producer_lock);
+
+	for (; i < mag->count; i++)
+		page_pool_return_page(pool, mag->pages[i]);
+	mag->count = 0;
+}
+
+/* Used from the pool's NAPI context when the ring is empty: pages that were
+ * released on this CPU, but not directly, sit in the local magazine and can
+ * go straight back into the alloc cache.  Like the ring refill, stop at the
+ * first page from another NUMA node and hand it back to the page allocator.
+ */
+static struct page *page_pool_refill_from_magazine(struct page_pool *pool,
+						   int pref_nid)
+{
+	struct page_pool_magazine *mag;
+	struct page *page;
+
+	local_bh_disable();
+	mag = this_cpu_ptr(&pp_magazines);
+	if (READ_ONCE(mag->pool) == pool) {
+		spin_lock(&mag->lock);
+		while (mag->pool == pool && mag->count &&
+		       pool->alloc.count < PP_ALLOC_CACHE_REFILL) {
+			page = mag->pages[--mag->count];
+			if (unlikely(page_to_nid(page) != pref_nid)) {
+				page_pool_return_page(pool, page);
+				alloc_stat_inc(pool, waive);
+				break;
+			}
+			pool->alloc.cache[pool->alloc.count++] = page;
+		}
+		spin_unlock(&mag->lock);
+	}
+	local_bh_enable();
+
+	if (!pool->alloc.count)
+		return NULL;
+
+	alloc_stat_inc(pool, refill);
+	return pool->alloc.cache[--pool->alloc.count];
+}
+
 noinline
 static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 {
@@ -272,12 +354,6 @@ static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 	struct page *page;
 	int pref_nid; /* preferred NUMA node */
 
-	/* Quicker fallback, avoid locks when ring is empty */
-	if (__ptr_ring_empty(r)) {
-		alloc_stat_inc(pool, empty);
-		return NULL;
-	}
-
 	/* Softirq guarantee CPU and thus NUMA node is stable. This,
 	 * assumes CPU refilling driver RX-ring will also run RX-NAPI.
 	 */
@@ -288,6 +364,14 @@ static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 	pref_nid = numa_mem_id(); /* will be zero like page_to_nid() */
 #endif
 
+	/* Quicker fallback, avoid locks when ring is empty */
+	if (__ptr_ring_empty(r)) {
+		page = page_pool_refill_from_magazine(pool, pref_nid);
+		if (!page)
+			alloc_stat_inc(pool, empty);
+		return page;
+	}
+
 	/* Refill alloc array, but only if NUMA match */
 	do {
 		page = __ptr_ring_consume(r);
@@ -411,6 +495,34 @@ static struct page *__page_pool_alloc_page_order(struct page_pool *pool,
 	return page;
 }
 
+/* High-order pools back large buffers or PP_FLAG_PAGE_FRAG carving, where
+ * each page is DMA mapped once and shared by many frags.  Refill a few of
+ * them per slow path call, keeping the number of bytes per refill close to
+ * the order-0 bulk path, so the NAPI poll doesn't come back here for every
+ * page.  Only the first allocation may try hard; the others are
+ * opportunistic.
+ */
+static struct page *__page_pool_alloc_high_order(struct page_pool *pool,
+						 gfp_t gfp)
+{
+	unsigned int bulk = max(PP_ALLOC_CACHE_REFILL >> pool->p.order, 1);
+	struct page *page;
+
+	while (pool->alloc.count < bulk) {
+		page = __page_pool_alloc_page_order(pool, pool->alloc.count ?
+						    gfp | __GFP_NORETRY | __GFP_NOWARN :
+						    gfp);
+		if (!page)
+			break;
+		pool->alloc.cache[pool->alloc.count++] = page;
+	}
+
+	if (unlikely(!pool->alloc.count))
+		return NULL;
+
+	return pool->alloc.cache[--pool->alloc.count];
+}
+
 /* slow path */
 noinline
 static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
@@ -422,9 +534,9 @@ static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 	struct page *page;
 	int i, nr_pages;
 
-	/* Don't support bulk alloc for high-order pages */
+	/* No bulk page allocator for high-order pages */
 	if (unlikely(pp_order))
-		return __page_pool_alloc_page_order(pool, gfp);
+		return __page_pool_alloc_high_order(pool, gfp);
 
 	/* Unnecessary as alloc cache is empty, but guarantees zero count */
 	if (unlikely(pool->alloc.count > 0))
@@ -545,21 +657,40 @@ static void page_pool_return_page(struct page_pool *pool, struct page *page)
 	 */
 }
 
-static bool page_pool_recycle_in_ring(struct page_pool *pool, struct page *page)
+static void page_pool_recycle_in_magazine(struct page_pool *pool,
+					  struct page *page)
 {
-	int ret;
-	/* BH protection not needed if current is softirq */
-	if (in_softirq())
-		ret = ptr_ring_produce(&pool->ring, page);
-	else
-		ret = ptr_ring_produce_bh(&pool->ring, page);
-
-	if (!ret) {
-		recycle_stat_inc(pool, ring);
-		return true;
+	struct page_pool_magazine *mag;
+
+	local_bh_disable();
+	mag = this_cpu_ptr(&pp_magazines);
+	spin_lock(&mag->lock);
+	if (mag->pool != pool) {
+		page_pool_magazine_flush(mag);
+		WRITE_ONCE(mag->pool, pool);
 	}
+	mag->pages[mag->count++] = page;
+	if (mag->count == PP_MAGAZINE_SIZE)
+		page_pool_magazine_flush(mag);
+	spin_unlock(&mag->lock);
+	local_bh_enable();
+}
+
+static void page_pool_drain_magazines(struct page_pool *pool)
+{
+	int cpu;
 
-	return false;
+	for_each_possible_cpu(cpu) {
+		struct page_pool_magazine *mag = per_cpu_ptr(&pp_magazines, cpu);
+
+		if (READ_ONCE(mag->pool) != pool)
+			continue;
+
+		spin_lock_bh(&mag->lock);
+		if (mag->pool == pool)
+			page_pool_magazine_flush(mag);
+		spin_unlock_bh(&mag->lock);
+	}
 }
 
 /* Only allow direct recycling in special circumstances, into the
@@ -639,11 +770,8 @@ void page_pool_put_defragged_page(struct page_pool *pool, struct page *page,
 				  unsigned int dma_sync_size, bool allow_direct)
 {
 	page = __page_pool_put_page(pool, page, dma_sync_size, allow_direct);
-	if (page && !page_pool_recycle_in_ring(pool, page)) {
-		/* Cache full, fallback to free pages */
-		recycle_stat_inc(pool, ring_full);
-		page_pool_return_page(pool, page);
-	}
+	if (page)
+		page_pool_recycle_in_magazine(pool, page);
 }
 EXPORT_SYMBOL(page_pool_put_defragged_page);
 
@@ -843,6 +971,7 @@ static void page_pool_scrub(struct page_pool *pool)
 	/* No more consumers should exist, but producers could still
 	 * be in-flight.
 	 */
+	page_pool_drain_magazines(pool);
 	page_pool_empty_ring(pool);
 }
 
@@ -38,6 +38,7 @@ void reqsk_queue_alloc(struct request_sock_queue *queue)
 	queue->fastopenq.qlen = 0;
 
 	queue->rskq_accept_head = NULL;
+	queue->rskq_accept_batch = NULL;
 }
 
 /*
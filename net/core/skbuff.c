@@ -341,6 +341,67 @@ static struct sk_buff *napi_skb_cache_get(void)
 	return skb;
 }
 
+/**
+ * napi_skb_cache_get_bulk - obtain a number of skbs from the NAPI cache
+ * @skbs: array to fill with skb pointers
+ * @n: number of skbs to obtain
+ *
+ * Takes skbs from the per-CPU NAPI cache, refilling it from the slab only
+ * when it runs short, so that paths building skbs in batches (e.g. from
+ * XDP frames) recycle the heads released by napi_consume_skb() instead
+ * of hitting the slab for every batch. The returned skbs are cleared
+ * the same way __napi_build_skb() clears its head, ready to be passed to
+ * build_skb_around() or __xdp_build_skb_from_frame(). Must be called
+ * with BH disabled.
+ *
+ * Return: number of skbs placed in @skbs, which may be less than @n.
+ */
+u32 napi_skb_cache_get_bulk(void **skbs, u32 n)
+{
+	struct napi_alloc_cache *nc;
+	u32 base, i, total = n;
+
+	DEBUG_NET_WARN_ON_ONCE(!in_softirq());
+
+	nc = this_cpu_ptr(&napi_alloc_cache);
+	if (nc->skb_count >= n)
+		goto get;
+
+	/* Not enough cached skbs, try refilling the cache first */
+	nc->skb_count += kmem_cache_alloc_bulk(skbuff_cache,
+					       GFP_ATOMIC | __GFP_NOWARN,
+					       min_t(u32, NAPI_SKB_CACHE_BULK,
+						     NAPI_SKB_CACHE_SIZE -
+						     nc->skb_count),
+					       &nc->skb_cache[nc->skb_count]);
+	if (likely(nc->skb_count >= n))
+		goto get;
+
+	/* Still short, allocate the missing part straight into the output */
+	n -= kmem_cache_alloc_bulk(skbuff_cache, GFP_ATOMIC | __GFP_NOWARN,
+				   n - nc->skb_count, &skbs[nc->skb_count]);
+	if (likely(nc->skb_count >= n))
+		goto get;
+
+	/* The slab could not satisfy us either, limit the output */
+	total -= n - nc->skb_count;
+	n = nc->skb_count;
+
+get:
+	for (base = nc->skb_count - n, i = 0; i < n; i++) {
+		skbs[i] = nc->skb_cache[base + i];
+		kasan_unpoison_object_data(skbuff_cache, skbs[i]);
+	}
+
+	nc->skb_count -= n;
+
+	for (i = 0; i < total; i++)
+		memset(skbs[i], 0, offsetof(struct sk_buff, tail));
+
+	return total;
+}
+EXPORT_SYMBOL_GPL(napi_skb_cache_get_bulk);
+
 static inline void __finalize_skb_around(struct sk_buff *skb, void *data,
 					 unsigned int size)
 {
@@ -1108,16 +1169,39 @@ EXPORT_SYMBOL(kfree_skb_reason);
 
 struct skb_free_array {
 	unsigned int skb_count;
+	unsigned int fclone_count;
 	void *skb_array[KFREE_SKB_BULK_SIZE];
+	void *fclone_array[KFREE_SKB_BULK_SIZE];
 };
 
 static void kfree_skb_add_bulk(struct sk_buff *skb,
 			       struct skb_free_array *sa,
 			       enum skb_drop_reason reason)
 {
-	/* if SKB is a clone, don't handle this case */
+	struct sk_buff_fclones *fclones;
+
 	if (unlikely(skb->fclone != SKB_FCLONE_UNAVAILABLE)) {
-		__kfree_skb(skb);
+		fclones = container_of(skb, struct sk_buff_fclones, skb1);
+
+		/* An original whose clone is already gone (e.g. an acked TCP
+		 * skb after TX completion) owns the whole fclone object, see
+		 * kfree_skbmem(). Anything else takes the slow path.
+		 */
+		if (skb->fclone != SKB_FCLONE_ORIG ||
+		    refcount_read(&fclones->fclone_ref) != 1) {
+			__kfree_skb(skb);
+			return;
+		}
+
+		skb_release_all(skb, reason, false);
+		sa->fclone_array[sa->fclone_count++] = fclones;
+
+		if (unlikely(sa->fclone_count == KFREE_SKB_BULK_SIZE)) {
+			kmem_cache_free_bulk(skbuff_fclone_cache,
+					     KFREE_SKB_BULK_SIZE,
+					     sa->fclone_array);
+			sa->fclone_count = 0;
+		}
 		return;
 	}
 
@@ -1137,6 +1221,7 @@ kfree_skb_list_reason(struct sk_buff *segs, enum skb_drop_reason reason)
 	struct skb_free_array sa;
 
 	sa.skb_count = 0;
+	sa.fclone_count = 0;
 
 	while (segs) {
 		struct sk_buff *next = segs->next;
@@ -1151,6 +1236,9 @@ kfree_skb_list_reason(struct sk_buff *segs, enum skb_drop_reason reason)
 
 	if (sa.skb_count)
 		kmem_cache_free_bulk(skbuff_cache, sa.skb_count, sa.skb_array);
+	if (sa.fclone_count)
+		kmem_cache_free_bulk(skbuff_fclone_cache, sa.fclone_count,
+				     sa.fclone_array);
 }
 EXPORT_SYMBOL(kfree_skb_list_reason);
 
@@ -1299,9 +1387,9 @@ void __consume_stateless_skb(struct sk_buff *skb)
 	kfree_skbmem(skb);
 }
 
-static void napi_skb_cache_put(struct sk_buff *skb)
+static void __napi_skb_cache_put(struct napi_alloc_cache *nc,
+				 struct sk_buff *skb)
 {
-	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
 	u32 i;
 
 	kasan_poison_object_data(skbuff_cache, skb);
@@ -1318,6 +1406,11 @@ static void napi_skb_cache_put(struct sk_buff *skb)
 	}
 }
 
+static void napi_skb_cache_put(struct sk_buff *skb)
+{
+	__napi_skb_cache_put(this_cpu_ptr(&napi_alloc_cache), skb);
+}
+
 void __napi_kfree_skb(struct sk_buff *skb, enum skb_drop_reason reason)
 {
 	skb_release_all(skb, reason, true);
@@ -1363,6 +1456,55 @@ void napi_consume_skb(struct sk_buff *skb, int budget)
 }
 EXPORT_SYMBOL(napi_consume_skb);
 
+/**
+ * napi_consume_skb_bulk() - consume a batch of TX completed skbs
+ * @skbs: array of skbs, entries may be NULL
+ * @count: number of entries in @skbs
+ * @budget: NAPI budget, zero when not called from NAPI context
+ *
+ * Same as calling napi_consume_skb() on every entry, but looks up the
+ * per-CPU skb cache once for the whole batch and lets consecutive heads go
+ * back to it without re-entering the cache for each one.  Frags backed by
+ * page_pool are recycled directly, as in napi_consume_skb().
+ */
+void napi_consume_skb_bulk(struct sk_buff **skbs, unsigned int count,
+			   int budget)
+{
+	struct napi_alloc_cache *nc;
+	unsigned int i;
+
+	/* Zero budget indicate non-NAPI context called us, like netpoll */
+	if (unlikely(!budget)) {
+		for (i = 0; i < count; i++)
+			dev_consume_skb_any(skbs[i]);
+		return;
+	}
+
+	DEBUG_NET_WARN_ON_ONCE(!in_softirq());
+
+	nc = this_cpu_ptr(&napi_alloc_cache);
+	for (i = 0; i < count; i++) {
+		struct sk_buff *skb = skbs[i];
+
+		if (i + 1 < count)
+			prefetchw(skbs[i + 1]);
+
+		if (!skb_unref(skb))
+			continue;
+
+		trace_consume_skb(skb, __builtin_return_address(0));
+
+		if (skb->fclone != SKB_FCLONE_UNAVAILABLE) {
+			__kfree_skb(skb);
+			continue;
+		}
+
+		skb_release_all(skb, SKB_CONSUMED, true);
+		__napi_skb_cache_put(nc, skb);
+	}
+}
+EXPORT_SYMBOL(napi_consume_skb_bulk);
+
 /* Make sure a field is contained by headers group */
 #define CHECK_SKB_FIELD(field) \
 	BUILD_BUG_ON(offsetof(struct sk_buff, field) !=		\
@@ -511,7 +511,8 @@ static struct sk_msg *alloc_sk_msg(gfp_t gfp)
 }
 
 static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
-						  struct sk_buff *skb)
+						  struct sk_buff *skb,
+						  gfp_t gfp)
 {
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		return NULL;
@@ -519,7 +520,7 @@ static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
 	if (!sk_rmem_schedule(sk, skb, skb->truesize))
 		return NULL;
 
-	return alloc_sk_msg(GFP_KERNEL);
+	return alloc_sk_msg(gfp);
 }
 
 static int sk_psock_skb_ingress_enqueue(struct sk_buff *skb,
@@ -560,7 +561,7 @@ static int sk_psock_skb_ingress_self(struct sk_psock *psock, struct sk_buff *skb
 				     u32 off, u32 len);
 
 static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
-				u32 off, u32 len)
+				u32 off, u32 len, gfp_t gfp)
 {
 	struct sock *sk = psock->sk;
 	struct sk_msg *msg;
@@ -572,7 +573,7 @@ static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
 	 */
 	if (unlikely(skb->sk == sk))
 		return sk_psock_skb_ingress_self(psock, skb, off, len);
-	msg = sk_psock_create_ingress_msg(sk, skb);
+	msg = sk_psock_create_ingress_msg(sk, skb, gfp);
 	if (!msg)
 		return -EAGAIN;
 
@@ -620,7 +621,7 @@ static int sk_psock_handle_skb(struct sk_psock *psock, struct sk_buff *skb,
 		return skb_send_sock(psock->sk, skb, off, len);
 	}
 	skb_get(skb);
-	err = sk_psock_skb_ingress(psock, skb, off, len);
+	err = sk_psock_skb_ingress(psock, skb, off, len, GFP_KERNEL);
 	if (err < 0)
 		kfree_skb(skb);
 	return err;
@@ -900,10 +901,43 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* On failure the skb is left as it was, to be queued on the backlog. */
+static int sk_psock_skb_ingress_direct(struct sk_psock *psock,
+				       struct sk_buff *skb)
+{
+	unsigned long sk_redir = skb->_sk_redir;
+	struct sock *sk = psock->sk;
+	int ret = -EBUSY;
+
+	/* The peer charges and reads its ingress under its socket lock, so
+	 * only deliver directly if that lock is free right now. Spinning on
+	 * it could deadlock against a redirect in the opposite direction,
+	 * whose caller holds that socket's lock and wants ours.
+	 */
+	local_bh_disable();
+	if (!spin_trylock(&sk->sk_lock.slock))
+		goto out;
+	if (sock_owned_by_user(sk))
+		goto unlock;
+
+	skb_bpf_redirect_clear(skb);
+	ret = sk_psock_skb_ingress(psock, skb, 0, skb->len, GFP_ATOMIC);
+	if (ret < 0)
+		skb->_sk_redir = sk_redir;
+	else
+		ret = 0;
+unlock:
+	bh_unlock_sock(sk);
+out:
+	local_bh_enable();
+	return ret;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
 	struct sock *sk_other;
+	bool direct;
 
 	sk_other = skb_bpf_redirect_fetch(skb);
 	/* This error is a buggy BPF program, it returned a redirect
@@ -924,6 +958,8 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		sock_drop(from->sk, skb);
 		return -EIO;
 	}
+	direct = skb_bpf_ingress(skb) && !skb_bpf_strparser(skb);
+again:
 	spin_lock_bh(&psock_other->ingress_lock);
 	if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
 		spin_unlock_bh(&psock_other->ingress_lock);
@@ -932,6 +968,19 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		return -EIO;
 	}
 
+	/* Nothing queued ahead of this skb: deliver it to the peer right
+	 * away instead of bouncing through the backlog work, which costs a
+	 * workqueue round trip per redirected skb.
+	 */
+	if (direct && skb_queue_empty(&psock_other->ingress_skb) &&
+	    !psock_other->work_state.len) {
+		spin_unlock_bh(&psock_other->ingress_lock);
+		if (!sk_psock_skb_ingress_direct(psock_other, skb))
+			return 0;
+		direct = false;
+		goto again;
+	}
+
 	skb_queue_tail(&psock_other->ingress_skb, skb);
 	schedule_delayed_work(&psock_other->work, 0);
 	spin_unlock_bh(&psock_other->ingress_lock);
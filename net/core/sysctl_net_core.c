@@ -30,6 +30,9 @@ static int int_3600 = 3600;
 static int min_sndbuf = SOCK_MIN_SNDBUF;
 static int min_rcvbuf = SOCK_MIN_RCVBUF;
 static int max_skb_frags = MAX_SKB_FRAGS;
+#ifdef CONFIG_NET_RX_BUSY_POLL
+static int max_napi_threaded_spin_usecs = 10 * USEC_PER_MSEC;
+#endif
 
 static int net_msg_warn;	/* Unused, but still a sysctl */
 
@@ -563,6 +566,15 @@ static struct ctl_table net_core_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= SYSCTL_ZERO,
 	},
+	{
+		.procname	= "napi_threaded_spin_usecs",
+		.data		= &sysctl_napi_threaded_spin_usecs,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= &max_napi_threaded_spin_usecs,
+	},
 #endif
 #ifdef CONFIG_NET_SCHED
 	{
@@ -56,6 +56,7 @@
 #include <linux/netlink.h>
 #include <linux/init.h>
 #include <linux/list.h>
+#include <linux/moduleparam.h>
 #include <linux/slab.h>
 #include <linux/export.h>
 #include <linux/vmalloc.h>
@@ -288,8 +289,20 @@ static inline unsigned long get_index(t_key key, struct key_vector *kv)
 
 static const int halve_threshold = 25;
 static const int inflate_threshold = 50;
-static const int halve_threshold_root = 15;
-static const int inflate_threshold_root = 30;
+
+/* The root node is kept larger so that lookups in big tables start with a
+ * wide direct-indexed step. Routers carrying full tables can lower these
+ * to trade memory for fewer levels below the root; halve must stay below
+ * inflate or the root would flap between sizes.
+ */
+static int halve_threshold_root __read_mostly = 15;
+module_param(halve_threshold_root, int, 0444);
+MODULE_PARM_DESC(halve_threshold_root,
+		 "Fill percentage below which the root node is halved");
+static int inflate_threshold_root __read_mostly = 30;
+module_param(inflate_threshold_root, int, 0444);
+MODULE_PARM_DESC(inflate_threshold_root,
+		 "Fill percentage at which the root node is inflated");
 
 static void __alias_free_mem(struct rcu_head *head)
 {
@@ -2398,6 +2411,14 @@ int fib_table_dump(struct fib_table *tb, struct sk_buff *skb,
 
 void __init fib_trie_init(void)
 {
+	if (inflate_threshold_root < 1 || halve_threshold_root < 1 ||
+	    halve_threshold_root >= inflate_threshold_root) {
+		pr_warn("fib_trie: invalid root thresholds %d/%d, using 15/30\n",
+			halve_threshold_root, inflate_threshold_root);
+		halve_threshold_root = 15;
+		inflate_threshold_root = 30;
+	}
+
 	fn_alias_kmem = kmem_cache_create("ip_fib_alias",
 					  sizeof(struct fib_alias),
 					  0, SLAB_PANIC | SLAB_ACCOUNT, NULL);
@@ -562,6 +562,24 @@ static int __inet_check_established(struct inet_timewait_death_row *death_row,
 	const struct hlist_nulls_node *node;
 	struct inet_timewait_sock *tw = NULL;
 
+	/* When probing ephemeral ports from __inet_hash_connect(), most
+	 * candidates with many connections to the same peer are taken by
+	 * an established socket. Reject those without the bucket lock;
+	 * a miss here only means we fall through to the locked check.
+	 */
+	if (twp) {
+		rcu_read_lock();
+		sk_nulls_for_each_rcu(sk2, node, &head->chain) {
+			if (sk2->sk_hash == hash &&
+			    READ_ONCE(sk2->sk_state) != TCP_TIME_WAIT &&
+			    inet_match(net, sk2, acookie, ports, dif, sdif)) {
+				rcu_read_unlock();
+				return -EADDRNOTAVAIL;
+			}
+		}
+		rcu_read_unlock();
+	}
+
 	spin_lock(lock);
 
 	sk_nulls_for_each(sk2, node, &head->chain) {
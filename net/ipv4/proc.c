@@ -299,6 +299,8 @@ static const struct snmp_mib snmp4_net_list[] = {
 	SNMP_MIB_ITEM("TCPMigrateReqSuccess", LINUX_MIB_TCPMIGRATEREQSUCCESS),
 	SNMP_MIB_ITEM("TCPMigrateReqFailure", LINUX_MIB_TCPMIGRATEREQFAILURE),
 	SNMP_MIB_ITEM("TCPPLBRehash", LINUX_MIB_TCPPLBREHASH),
+	SNMP_MIB_ITEM("TCPZerocopyRecvMapped", LINUX_MIB_TCPZEROCOPYRECVMAPPED),
+	SNMP_MIB_ITEM("TCPZerocopyRecvCopied", LINUX_MIB_TCPZEROCOPYRECVCOPIED),
 	SNMP_MIB_SENTINEL
 };
 
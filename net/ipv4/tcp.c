@@ -1884,6 +1884,8 @@ static int receive_fallback_to_copy(struct sock *sk,
 		struct sk_buff *skb;
 		u32 offset;
 
+		NET_ADD_STATS(sock_net(sk), LINUX_MIB_TCPZEROCOPYRECVCOPIED,
+			      zc->copybuf_len);
 		skb = tcp_recv_skb(sk, tcp_sk(sk)->copied_seq, &offset);
 		if (skb)
 			tcp_zerocopy_set_hint_for_skb(sk, zc, skb, offset);
@@ -2203,6 +2205,13 @@ static int tcp_zerocopy_receive(struct sock *sk,
 		copylen = tcp_zc_handle_leftover(zc, sk, skb, &seq, copybuf_len, tss);
 
 	if (length + copylen) {
+		/* Bytes, so that the mapped/copied ratio can be watched */
+		if (length)
+			NET_ADD_STATS(sock_net(sk),
+				      LINUX_MIB_TCPZEROCOPYRECVMAPPED, length);
+		if (copylen)
+			NET_ADD_STATS(sock_net(sk),
+				      LINUX_MIB_TCPZEROCOPYRECVCOPIED, copylen);
 		WRITE_ONCE(tp->copied_seq, seq);
 		tcp_rcv_space_adjust(sk);
 
@@ -1789,11 +1789,29 @@ static struct sk_buff *tcp_sacktag_bsearch(struct sock *sk, u32 seq)
 	return NULL;
 }
 
+/* Number of skbs tcp_sacktag_skip() steps over before searching the tree */
+#define TCP_SACKTAG_SKIP_SCAN	4
+
 static struct sk_buff *tcp_sacktag_skip(struct sk_buff *skb, struct sock *sk,
 					u32 skip_to_seq)
 {
-	if (skb && after(TCP_SKB_CB(skb)->seq, skip_to_seq))
-		return skb;
+	int i;
+
+	if (skb) {
+		if (after(TCP_SKB_CB(skb)->seq, skip_to_seq))
+			return skb;
+
+		/* Blocks are walked in ascending order, and with reordering
+		 * the next one usually starts a few skbs past where the
+		 * previous walk stopped: look there before going back to
+		 * the root of the rtx queue.
+		 */
+		for (i = 0; i < TCP_SACKTAG_SKIP_SCAN && skb; i++) {
+			if (before(skip_to_seq, TCP_SKB_CB(skb)->end_seq))
+				return skb;
+			skb = skb_rb_next(skb);
+		}
+	}
 
 	return tcp_sacktag_bsearch(sk, skip_to_seq);
 }
@@ -3262,7 +3280,7 @@ static int tcp_clean_rtx_queue(struct sock *sk, const struct sk_buff *ack_skb,
 	struct tcp_sock *tp = tcp_sk(sk);
 	u32 prior_sacked = tp->sacked_out;
 	u32 reord = tp->snd_nxt; /* lowest acked un-retx un-sacked seq */
-	struct sk_buff *skb, *next;
+	struct sk_buff *skb, *next, *acked = NULL;
 	bool fully_acked = true;
 	long sack_rtt_us = -1L;
 	long seq_rtt_us = -1L;
@@ -3349,9 +3367,18 @@ static int tcp_clean_rtx_queue(struct sock *sk, const struct sk_buff *ack_skb,
 		if (unlikely(skb == tp->lost_skb_hint))
 			tp->lost_skb_hint = NULL;
 		tcp_highest_sack_replace(sk, skb, next);
-		tcp_rtx_queue_unlink_and_free(skb, sk);
+
+		/* Freed in bulk below, a stretch ACK can release many skbs */
+		list_del(&skb->tcp_tsorted_anchor);
+		tcp_rtx_queue_unlink(skb, sk);
+		tcp_wmem_uncharge_skb(sk, skb);
+		skb->next = acked;
+		acked = skb;
 	}
 
+	if (acked)
+		kfree_skb_list_reason(acked, SKB_CONSUMED);
+
 	if (!skb)
 		tcp_chrono_stop(sk, TCP_CHRONO_BUSY);
 
@@ -1458,31 +1458,6 @@ static void udp_skb_dtor_locked(struct sock *sk, struct sk_buff *skb)
 	udp_rmem_release(sk, udp_skb_truesize(skb), 1, true);
 }
 
-/* Idea of busylocks is to let producers grab an extra spinlock
- * to relieve pressure on the receive_queue spinlock shared by consumer.
- * Under flood, this means that only one producer can be in line
- * trying to acquire the receive_queue spinlock.
- * These busylock can be allocated on a per cpu manner, instead of a
- * per socket one (that would consume a cache line per socket)
- */
-static int udp_busylocks_log __read_mostly;
-static spinlock_t *udp_busylocks __read_mostly;
-
-static spinlock_t *busylock_acquire(void *ptr)
-{
-	spinlock_t *busy;
-
-	busy = udp_busylocks + hash_ptr(ptr, udp_busylocks_log);
-	spin_lock(busy);
-	return busy;
-}
-
-static void busylock_release(spinlock_t *busy)
-{
-	if (busy)
-		spin_unlock(busy);
-}
-
 static int udp_rmem_schedule(struct sock *sk, int size)
 {
 	int delta;
@@ -1494,11 +1469,26 @@ static int udp_rmem_schedule(struct sock *sk, int size)
 	return 0;
 }
 
+/* Called for datagrams queued by another producer that could not be
+ * charged to the socket; the caller has no way to see the error.
+ */
+static void udp_drop_unscheduled(struct sock *sk, struct sk_buff *skb)
+{
+	atomic_sub(skb->truesize, &sk->sk_rmem_alloc);
+	atomic_inc(&sk->sk_drops);
+	__UDPX_INC_STATS(sk, UDP_MIB_MEMERRORS);
+	__UDPX_INC_STATS(sk, UDP_MIB_INERRORS);
+	kfree_skb_reason(skb, SKB_DROP_REASON_PROTO_MEM);
+}
+
 int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 {
 	struct sk_buff_head *list = &sk->sk_receive_queue;
+	struct sk_buff *next, *to_drop = NULL;
+	struct udp_sock *up = udp_sk(sk);
+	struct llist_node *ll_list;
 	int rmem, err = -ENOMEM;
-	spinlock_t *busy = NULL;
+	bool queued = false;
 	int size;
 
 	/* try to avoid the costly atomic add/sub pair when the receive
@@ -1514,11 +1504,9 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 	 * - Less cache line misses at copyout() time
 	 * - Less work at consume_skb() (less alien page frag freeing)
 	 */
-	if (rmem > (sk->sk_rcvbuf >> 1)) {
+	if (rmem > (sk->sk_rcvbuf >> 1))
 		skb_condense(skb);
 
-		busy = busylock_acquire(sk);
-	}
 	size = skb->truesize;
 	udp_set_dev_scratch(skb);
 
@@ -1529,27 +1517,45 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 	if (rmem > (size + (unsigned int)sk->sk_rcvbuf))
 		goto uncharge_drop;
 
-	spin_lock(&list->lock);
-	err = udp_rmem_schedule(sk, size);
-	if (err) {
-		spin_unlock(&list->lock);
-		goto uncharge_drop;
-	}
-
-	sk_forward_alloc_add(sk, -size);
-
 	/* no need to setup a destructor, we will explicitly release the
 	 * forward allocated memory on dequeue
 	 */
 	sock_skb_set_dropcount(sk, skb);
 
-	__skb_queue_tail(list, skb);
+	/* Producers only add the skb to a lockless list. The one finding
+	 * the list empty moves everything queued meanwhile to the receive
+	 * queue, so that under flood the receive queue lock and the forward
+	 * allocation are taken once per batch instead of once per datagram,
+	 * and only one producer ever competes with udp_recvmsg() for them.
+	 */
+	if (!llist_add(&skb->ll_node, &up->enqueue_list))
+		return 0;
+
+	spin_lock(&list->lock);
+	ll_list = llist_reverse_order(llist_del_all(&up->enqueue_list));
+	llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+		size = udp_skb_truesize(skb);
+		if (udp_rmem_schedule(sk, size)) {
+			skb->next = to_drop;
+			to_drop = skb;
+			continue;
+		}
+
+		sk_forward_alloc_add(sk, -size);
+		__skb_queue_tail(list, skb);
+		queued = true;
+	}
 	spin_unlock(&list->lock);
 
-	if (!sock_flag(sk, SOCK_DEAD))
+	if (queued && !sock_flag(sk, SOCK_DEAD))
 		INDIRECT_CALL_1(sk->sk_data_ready, sock_def_readable, sk);
 
-	busylock_release(busy);
+	while (to_drop) {
+		skb = to_drop;
+		to_drop = skb->next;
+		skb_mark_not_on_list(skb);
+		udp_drop_unscheduled(sk, skb);
+	}
 	return 0;
 
 uncharge_drop:
@@ -1557,7 +1563,6 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 
 drop:
 	atomic_inc(&sk->sk_drops);
-	busylock_release(busy);
 	return err;
 }
 EXPORT_SYMBOL_GPL(__udp_enqueue_schedule_skb);
@@ -3614,7 +3619,6 @@ static void __init bpf_iter_register(void)
 void __init udp_init(void)
 {
 	unsigned long limit;
-	unsigned int i;
 
 	udp_table_init(&udp_table, "UDP");
 	limit = nr_free_buffer_pages() / 8;
@@ -3623,15 +3627,6 @@ void __init udp_init(void)
 	sysctl_udp_mem[1] = limit;
 	sysctl_udp_mem[2] = sysctl_udp_mem[0] * 2;
 
-	/* 16 spinlocks per cpu */
-	udp_busylocks_log = ilog2(nr_cpu_ids) + 4;
-	udp_busylocks = kmalloc(sizeof(spinlock_t) << udp_busylocks_log,
-				GFP_KERNEL);
-	if (!udp_busylocks)
-		panic("UDP: failed to alloc udp_busylocks\n");
-	for (i = 0; i < (1U << udp_busylocks_log); i++)
-		spin_lock_init(udp_busylocks + i);
-
 	if (register_pernet_subsys(&udp_sysctl_ops))
 		panic("UDP: failed to init sysctl parameters.\n");
 
@@ -24,6 +24,7 @@
 #include <linux/in6.h>
 #include <linux/init.h>
 #include <linux/list.h>
+#include <linux/prefetch.h>
 #include <linux/slab.h>
 
 #include <net/ip.h>
@@ -1562,6 +1563,14 @@ static struct fib6_node *fib6_node_lookup_1(struct fib6_node *root,
 	for (;;) {
 		struct fib6_node *next;
 
+		/* The backtrack below compares against the leaf key of
+		 * every route-carrying node on the way down; start pulling
+		 * those in now so the misses overlap with the descent.
+		 * prefetch() does not fault on a NULL leaf.
+		 */
+		if (fn->fn_flags & RTN_RTINFO)
+			prefetch((u8 *)rcu_dereference(fn->leaf) + args->offset);
+
 		dir = addr_bit_set(args->addr, fn->fn_bit);
 
 		next = dir ? rcu_dereference(fn->right) :
@@ -1399,8 +1399,12 @@ bool mptcp_subflow_active(struct mptcp_subflow_context *subflow)
 /* implement the mptcp packet scheduler;
  * returns the subflow that will transmit the next DSS
  * additionally updates the rtx timeout
+ *
+ * With @rtt_aware, half of the subflow srtt is added to the time needed
+ * to flush its queue, so that the choice approximates the time at which
+ * the data reaches the peer rather than the time it leaves the host.
  */
-struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+struct sock *__mptcp_subflow_get_send(struct mptcp_sock *msk, bool rtt_aware)
 {
 	struct subflow_send_info send_info[SSK_MODE_MAX];
 	struct mptcp_subflow_context *subflow;
@@ -1435,6 +1439,12 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 		}
 
 		linger_time = div_u64((u64)READ_ONCE(ssk->sk_wmem_queued) << 32, pace);
+		if (rtt_aware) {
+			/* srtt_us is stored << 3, we want srtt / 2 */
+			u64 owd = READ_ONCE(tcp_sk(ssk)->srtt_us) >> 4;
+
+			linger_time += div_u64(owd << 32, USEC_PER_SEC);
+		}
 		if (linger_time < send_info[subflow->backup].linger_time) {
 			send_info[subflow->backup].ssk = ssk;
 			send_info[subflow->backup].linger_time = linger_time;
@@ -1474,6 +1484,11 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 	return ssk;
 }
 
+struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+{
+	return __mptcp_subflow_get_send(msk, false);
+}
+
 static void mptcp_push_release(struct sock *ssk, struct mptcp_sendmsg_info *info)
 {
 	tcp_push(ssk, 0, info->mss_now, tcp_sk(ssk)->nonagle, info->size_goal);
@@ -36,6 +36,31 @@ static struct mptcp_sched_ops mptcp_sched_default = {
 	.owner		= THIS_MODULE,
 };
 
+/* Like the default scheduler, but accounts for the subflow path delay when
+ * estimating when queued data will be delivered. This keeps data off high
+ * latency subflows (e.g. cellular next to Wi-Fi) as long as the faster one
+ * can deliver it first, reducing reordering at the receiver.
+ */
+static int mptcp_sched_latency_get_subflow(struct mptcp_sock *msk,
+					   struct mptcp_sched_data *data)
+{
+	struct sock *ssk;
+
+	ssk = data->reinject ? mptcp_subflow_get_retrans(msk) :
+			       __mptcp_subflow_get_send(msk, true);
+	if (!ssk)
+		return -EINVAL;
+
+	mptcp_subflow_set_scheduled(mptcp_subflow_ctx(ssk), true);
+	return 0;
+}
+
+static struct mptcp_sched_ops mptcp_sched_latency = {
+	.get_subflow	= mptcp_sched_latency_get_subflow,
+	.name		= "latency",
+	.owner		= THIS_MODULE,
+};
+
 /* Must be called with rcu read lock held */
 struct mptcp_sched_ops *mptcp_sched_find(const char *name)
 {
@@ -81,6 +106,7 @@ void mptcp_unregister_scheduler(struct mptcp_sched_ops *sched)
 void mptcp_sched_init(void)
 {
 	mptcp_register_scheduler(&mptcp_sched_default);
+	mptcp_register_scheduler(&mptcp_sched_latency);
 }
 
 int mptcp_init_sched(struct mptcp_sock *msk,
@@ -1792,6 +1792,7 @@ void mptcp_subflow_queue_clean(struct sock *listener_sk, struct sock *listener_s
 	 * Splice the req list, so that accept() can not reach the pending ssk after
 	 * the listener socket is released below.
 	 */
+	reqsk_queue_unbatch(queue, listener_ssk);
 	spin_lock_bh(&queue->rskq_lock);
 	head = queue->rskq_accept_head;
 	tail = queue->rskq_accept_tail;
@@ -69,6 +69,7 @@ struct conntrack_gc_work {
 	u32			avg_timeout;
 	u32			count;
 	u32			start_time;
+	u32			shard;
 	bool			exiting;
 	bool			early_drop;
 };
@@ -99,7 +100,28 @@ static DEFINE_MUTEX(nf_conntrack_mutex);
 #define MIN_CHAINLEN	50u
 #define MAX_CHAINLEN	(80u - MIN_CHAINLEN)
 
-static struct conntrack_gc_work conntrack_gc_work;
+/* The table can be split into up to NF_CT_GC_WORKERS_MAX ranges of
+ * buckets, each scanned by its own worker on the unbound workqueue, so
+ * that GC keeps up with expiries on large tables under churn.
+ */
+#define NF_CT_GC_WORKERS_MAX	16
+
+static struct conntrack_gc_work conntrack_gc_work[NF_CT_GC_WORKERS_MAX];
+static unsigned int nf_ct_gc_workers __read_mostly = 1;
+module_param_named(gc_workers, nf_ct_gc_workers, uint, 0400);
+MODULE_PARM_DESC(gc_workers, "Number of parallel conntrack GC workers (1-16)");
+
+static struct workqueue_struct *nf_ct_gc_wq(void)
+{
+	return nf_ct_gc_workers > 1 ? system_unbound_wq :
+				      system_power_efficient_wq;
+}
+
+/* First bucket of @shard's range, also the end of the range before it */
+static unsigned int gc_shard_bucket(unsigned int hashsz, unsigned int shard)
+{
+	return (u64)hashsz * shard / nf_ct_gc_workers;
+}
 
 void nf_conntrack_lock(spinlock_t *lock) __acquires(lock)
 {
@@ -1454,9 +1476,10 @@ static bool gc_worker_can_early_drop(const struct nf_conn *ct)
 
 static void gc_worker(struct work_struct *work)
 {
-	unsigned int i, hashsz, nf_conntrack_max95 = 0;
+	unsigned int i, hashsz, stop, nf_conntrack_max95 = 0;
 	u32 end_time, start_time = nfct_time_stamp;
 	struct conntrack_gc_work *gc_work;
+	struct hlist_nulls_head *ct_hash;
 	unsigned int expired_count = 0;
 	unsigned long next_run;
 	s32 delta_time;
@@ -1472,6 +1495,11 @@ static void gc_worker(struct work_struct *work)
 		gc_work->avg_timeout = GC_SCAN_INTERVAL_INIT;
 		gc_work->count = GC_SCAN_INITIAL_COUNT;
 		gc_work->start_time = start_time;
+
+		rcu_read_lock();
+		nf_conntrack_get_ht(&ct_hash, &hashsz);
+		rcu_read_unlock();
+		i = gc_shard_bucket(hashsz, gc_work->shard);
 	}
 
 	next_run = gc_work->avg_timeout;
@@ -1481,14 +1509,14 @@ static void gc_worker(struct work_struct *work)
 
 	do {
 		struct nf_conntrack_tuple_hash *h;
-		struct hlist_nulls_head *ct_hash;
 		struct hlist_nulls_node *n;
 		struct nf_conn *tmp;
 
 		rcu_read_lock();
 
 		nf_conntrack_get_ht(&ct_hash, &hashsz);
-		if (i >= hashsz) {
+		stop = gc_shard_bucket(hashsz, gc_work->shard + 1);
+		if (i >= stop) {
 			rcu_read_unlock();
 			break;
 		}
@@ -1567,14 +1595,14 @@ static void gc_worker(struct work_struct *work)
 		i++;
 
 		delta_time = nfct_time_stamp - end_time;
-		if (delta_time > 0 && i < hashsz) {
+		if (delta_time > 0 && i < stop) {
 			gc_work->avg_timeout = next_run;
 			gc_work->count = count;
 			gc_work->next_bucket = i;
 			next_run = 0;
 			goto early_exit;
 		}
-	} while (i < hashsz);
+	} while (i < stop);
 
 	gc_work->next_bucket = 0;
 
@@ -1593,13 +1621,31 @@ static void gc_worker(struct work_struct *work)
 	if (next_run)
 		gc_work->early_drop = false;
 
-	queue_delayed_work(system_power_efficient_wq, &gc_work->dwork, next_run);
+	queue_delayed_work(nf_ct_gc_wq(), &gc_work->dwork, next_run);
+}
+
+static void conntrack_gc_work_init(void)
+{
+	unsigned int i;
+
+	nf_ct_gc_workers = clamp(nf_ct_gc_workers, 1u, NF_CT_GC_WORKERS_MAX);
+
+	for (i = 0; i < nf_ct_gc_workers; i++) {
+		struct conntrack_gc_work *gc_work = &conntrack_gc_work[i];
+
+		INIT_DELAYED_WORK(&gc_work->dwork, gc_worker);
+		gc_work->shard = i;
+		gc_work->exiting = false;
+		queue_delayed_work(nf_ct_gc_wq(), &gc_work->dwork, HZ);
+	}
 }
 
-static void conntrack_gc_work_init(struct conntrack_gc_work *gc_work)
+static void conntrack_gc_work_cancel(void)
 {
-	INIT_DELAYED_WORK(&gc_work->dwork, gc_worker);
-	gc_work->exiting = false;
+	unsigned int i;
+
+	for (i = 0; i < nf_ct_gc_workers; i++)
+		cancel_delayed_work_sync(&conntrack_gc_work[i].dwork);
 }
 
 static struct nf_conn *
@@ -1618,8 +1664,13 @@ __nf_conntrack_alloc(struct net *net,
 
 	if (nf_conntrack_max && unlikely(ct_count > nf_conntrack_max)) {
 		if (!early_drop(net, hash)) {
-			if (!conntrack_gc_work.early_drop)
-				conntrack_gc_work.early_drop = true;
+			unsigned int i;
+
+			/* the table is full everywhere, not just in one shard */
+			for (i = 0; i < nf_ct_gc_workers; i++) {
+				if (!conntrack_gc_work[i].early_drop)
+					conntrack_gc_work[i].early_drop = true;
+			}
 			atomic_dec(&cnet->count);
 			net_warn_ratelimited("nf_conntrack: table full, dropping packet\n");
 			return ERR_PTR(-ENOMEM);
@@ -2500,14 +2551,17 @@ static int kill_all(struct nf_conn *i, void *data)
 
 void nf_conntrack_cleanup_start(void)
 {
+	unsigned int i;
+
 	cleanup_nf_conntrack_bpf();
-	conntrack_gc_work.exiting = true;
+	for (i = 0; i < nf_ct_gc_workers; i++)
+		conntrack_gc_work[i].exiting = true;
 }
 
 void nf_conntrack_cleanup_end(void)
 {
 	RCU_INIT_POINTER(nf_ct_hook, NULL);
-	cancel_delayed_work_sync(&conntrack_gc_work.dwork);
+	conntrack_gc_work_cancel();
 	kvfree(nf_conntrack_hash);
 
 	nf_conntrack_proto_fini();
@@ -2726,8 +2780,7 @@ int nf_conntrack_init_start(void)
 	if (ret < 0)
 		goto err_proto;
 
-	conntrack_gc_work_init(&conntrack_gc_work);
-	queue_delayed_work(system_power_efficient_wq, &conntrack_gc_work.dwork, HZ);
+	conntrack_gc_work_init();
 
 	ret = register_nf_conntrack_bpf();
 	if (ret < 0)
@@ -2736,7 +2789,7 @@ int nf_conntrack_init_start(void)
 	return 0;
 
 err_kfunc:
-	cancel_delayed_work_sync(&conntrack_gc_work.dwork);
+	conntrack_gc_work_cancel();
 	nf_conntrack_proto_fini();
 err_proto:
 	nf_conntrack_helper_fini();
@@ -280,7 +280,8 @@ int flow_offload_add(struct nf_flowtable *flow_table, struct flow_offload *flow)
 {
 	int err;
 
-	flow->timeout = nf_flowtable_time_stamp + flow_offload_get_timeout(flow);
+	flow->refresh_stamp = nf_flowtable_time_stamp;
+	flow->timeout = flow->refresh_stamp + flow_offload_get_timeout(flow);
 
 	err = rhashtable_insert_fast(&flow_table->rhashtable,
 				     &flow->tuplehash[0].node,
@@ -312,9 +313,20 @@ EXPORT_SYMBOL_GPL(flow_offload_add);
 void flow_offload_refresh(struct nf_flowtable *flow_table,
 			  struct flow_offload *flow, bool force)
 {
+	u32 now = nf_flowtable_time_stamp;
 	u32 timeout;
 
-	timeout = nf_flowtable_time_stamp + flow_offload_get_timeout(flow);
+	/* This runs for every forwarded packet. The timeout is only pushed
+	 * forward once per second, so skip looking up the per-netns protocol
+	 * timeout until at least that much time has passed since the last
+	 * update.
+	 */
+	if (!force && now - READ_ONCE(flow->refresh_stamp) <= HZ)
+		return;
+
+	WRITE_ONCE(flow->refresh_stamp, now);
+
+	timeout = now + flow_offload_get_timeout(flow);
 	if (force || timeout - READ_ONCE(flow->timeout) > HZ)
 		WRITE_ONCE(flow->timeout, timeout);
 	else
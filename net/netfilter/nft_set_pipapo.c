@@ -436,17 +436,29 @@ bool nft_pipapo_lookup(const struct net *net, const struct nft_set *set,
 
 	nft_pipapo_for_each_field(f, i, m) {
 		bool last = i == m->field_count - 1;
+		bool any;
 		int b;
 
 		/* For each bit group: select lookup table bucket depending on
 		 * packet bytes value, then AND bucket value
 		 */
 		if (likely(f->bb == 8))
-			pipapo_and_field_buckets_8bit(f, res_map, rp);
+			any = pipapo_and_field_buckets_8bit(f, res_map, rp);
 		else
-			pipapo_and_field_buckets_4bit(f, res_map, rp);
+			any = pipapo_and_field_buckets_4bit(f, res_map, rp);
 		NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
 
+		/* Nothing left to match: fill_map is still clean, and res_map
+		 * is reinitialised by the next lookup, so we can bail out here
+		 * without walking it in pipapo_refill().
+		 */
+		if (!any) {
+			scratch->map_index = map_index;
+			local_bh_enable();
+
+			return false;
+		}
+
 		rp += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
 
 		/* Now populate the bitmap for the next field, unless this is
@@ -192,8 +192,14 @@ int pipapo_refill(unsigned long *map, int len, int rules, unsigned long *dst,
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Stop as soon as the intersection is empty: no further group can add bits
+ * back, and on large sets most lookups that miss become empty in the first
+ * few groups.
+ *
+ * Return: false if no rule in @dst matches anymore, true otherwise.
  */
-static inline void pipapo_and_field_buckets_4bit(struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_4bit(struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -204,15 +210,19 @@ static inline void pipapo_and_field_buckets_4bit(struct nft_pipapo_field *f,
 		u8 v;
 
 		v = *data >> 4;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 
 		v = *data & 0x0f;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 	}
+
+	return true;
 }
 
 /**
@@ -220,8 +230,10 @@ static inline void pipapo_and_field_buckets_4bit(struct nft_pipapo_field *f,
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Return: false if no rule in @dst matches anymore, true otherwise.
  */
-static inline void pipapo_and_field_buckets_8bit(struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_8bit(struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -229,10 +241,13 @@ static inline void pipapo_and_field_buckets_8bit(struct nft_pipapo_field *f,
 	int group;
 
 	for (group = 0; group < f->groups; group++, data++) {
-		__bitmap_and(dst, dst, lt + *data * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + *data * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(8);
 	}
+
+	return true;
 }
 
 /**
@@ -2365,7 +2365,8 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,
 		slot_id = po->rx_ring.head;
 		if (test_bit(slot_id, po->rx_ring.rx_owner_map))
 			goto drop_n_account;
-		__set_bit(slot_id, po->rx_ring.rx_owner_map);
+		/* atomic: the bit is cleared without the queue lock */
+		set_bit(slot_id, po->rx_ring.rx_owner_map);
 	}
 
 	if (vnet_hdr_sz &&
@@ -2483,10 +2484,14 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,
 #endif
 
 	if (po->tp_version <= TPACKET_V2) {
-		spin_lock(&sk->sk_receive_queue.lock);
+		/* No need to retake the queue lock: we own the slot until the
+		 * bit is cleared, and a producer finding it still set after
+		 * user space released the frame just drops, as it would have
+		 * while we held the lock.
+		 */
 		__packet_set_status(po, h.raw, status);
-		__clear_bit(slot_id, po->rx_ring.rx_owner_map);
-		spin_unlock(&sk->sk_receive_queue.lock);
+		smp_mb__before_atomic();
+		clear_bit(slot_id, po->rx_ring.rx_owner_map);
 		sk->sk_data_ready(sk);
 	} else if (po->tp_version == TPACKET_V3) {
 		prb_clear_blk_fill_status(&po->rx_ring);
@@ -310,6 +310,15 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+static bool fl_mask_reuse_dissection(const struct fl_flow_mask *dissected,
+				     const struct fl_flow_mask *mask)
+{
+	return dissected &&
+	       dissected->dissector.used_keys == mask->dissector.used_keys &&
+	       dissected->range.start <= mask->range.start &&
+	       dissected->range.end >= mask->range.end;
+}
+
 TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 				  const struct tcf_proto *tp,
 				  struct tcf_result *res)
@@ -317,11 +326,21 @@ TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
 	bool post_ct = tc_skb_cb(skb)->post_ct;
 	u16 zone = tc_skb_cb(skb)->zone;
+	struct fl_flow_mask *dissected = NULL;
 	struct fl_flow_key skb_key;
 	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
 
 	list_for_each_entry_rcu(mask, &head->masks, list) {
+		/* Masks often differ only in prefix lengths while using the
+		 * same set of dissector keys. The dissected key is then
+		 * identical, so reuse it as long as this mask's range lies
+		 * within the range that was cleared before dissecting.
+		 */
+		if (fl_mask_reuse_dissection(dissected, mask))
+			goto lookup;
+
+		dissected = mask;
 		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
 		fl_clear_masked_range(&skb_key, mask);
 
@@ -338,7 +357,7 @@ TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
 		skb_flow_dissect(skb, &mask->dissector, &skb_key,
 				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
-
+lookup:
 		f = fl_mask_lookup(mask, &skb_key);
 		if (f && !tc_skip_sw(f->flags)) {
 			*res = f->res;
@@ -33,6 +33,7 @@
 #include <linux/rbtree.h>
 #include <linux/workqueue.h>
 #include <linux/slab.h>
+#include <linux/jump_label.h>
 #include <net/netlink.h>
 #include <net/sch_generic.h>
 #include <net/pkt_sched.h>
@@ -58,8 +59,32 @@ static int htb_hysteresis __read_mostly = 0; /* whether to use mode hysteresis f
 #error "Mismatched sch_htb.c and pkt_sch.h"
 #endif
 
+/* htb_class_mode() runs for the leaf and every ancestor of each dequeued
+ * packet; keep the common no-hysteresis case free of the extra tests.
+ */
+static DEFINE_STATIC_KEY_FALSE(htb_hysteresis_key);
+
+static int htb_hysteresis_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_int(val, kp);
+
+	if (ret)
+		return ret;
+
+	if (htb_hysteresis)
+		static_branch_enable(&htb_hysteresis_key);
+	else
+		static_branch_disable(&htb_hysteresis_key);
+	return 0;
+}
+
+static const struct kernel_param_ops htb_hysteresis_ops = {
+	.set	= htb_hysteresis_set,
+	.get	= param_get_int,
+};
+
 /* Module parameter and sysfs export */
-module_param    (htb_hysteresis, int, 0640);
+module_param_cb(htb_hysteresis, &htb_hysteresis_ops, &htb_hysteresis, 0640);
 MODULE_PARM_DESC(htb_hysteresis, "Hysteresis mode, less CPU load, less accurate");
 
 static int htb_rate_est = 0; /* htb classes have a default rate estimator */
@@ -501,14 +526,14 @@ static void htb_deactivate_prios(struct htb_sched *q, struct htb_class *cl)
 
 static inline s64 htb_lowater(const struct htb_class *cl)
 {
-	if (htb_hysteresis)
+	if (static_branch_unlikely(&htb_hysteresis_key))
 		return cl->cmode != HTB_CANT_SEND ? -cl->cbuffer : 0;
 	else
 		return 0;
 }
 static inline s64 htb_hiwater(const struct htb_class *cl)
 {
-	if (htb_hysteresis)
+	if (static_branch_unlikely(&htb_hysteresis_key))
 		return cl->cmode == HTB_CAN_SEND ? -cl->buffer : 0;
 	else
 		return 0;
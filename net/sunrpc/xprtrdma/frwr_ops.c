@@ -363,7 +363,7 @@ static void frwr_wc_fastreg(struct ib_cq *cq, struct ib_wc *wc)
 	/* WARNING: Only wr_cqe and status are reliable at this point */
 	trace_xprtrdma_wc_fastreg(wc, &mr->mr_cid);
 
-	rpcrdma_flush_disconnect(cq->cq_context, wc);
+	rpcrdma_flush_disconnect(mr->mr_xprt, wc);
 }
 
 /**
@@ -459,7 +459,7 @@ static void frwr_wc_localinv(struct ib_cq *cq, struct ib_wc *wc)
 	trace_xprtrdma_wc_li(wc, &mr->mr_cid);
 	frwr_mr_done(wc, mr);
 
-	rpcrdma_flush_disconnect(cq->cq_context, wc);
+	rpcrdma_flush_disconnect(mr->mr_xprt, wc);
 }
 
 /**
@@ -479,7 +479,7 @@ static void frwr_wc_localinv_wake(struct ib_cq *cq, struct ib_wc *wc)
 	frwr_mr_done(wc, mr);
 	complete(&mr->mr_linv_done);
 
-	rpcrdma_flush_disconnect(cq->cq_context, wc);
+	rpcrdma_flush_disconnect(mr->mr_xprt, wc);
 }
 
 /**
@@ -582,7 +582,7 @@ static void frwr_wc_localinv_done(struct ib_cq *cq, struct ib_wc *wc)
 	if (wc->status != IB_WC_SUCCESS) {
 		if (rep)
 			rpcrdma_unpin_rqst(rep);
-		rpcrdma_flush_disconnect(cq->cq_context, wc);
+		rpcrdma_flush_disconnect(mr->mr_xprt, wc);
 		return;
 	}
 	frwr_mr_put(mr);
@@ -142,7 +142,7 @@ static void rpcrdma_wc_send(struct ib_cq *cq, struct ib_wc *wc)
 	struct ib_cqe *cqe = wc->wr_cqe;
 	struct rpcrdma_sendctx *sc =
 		container_of(cqe, struct rpcrdma_sendctx, sc_cqe);
-	struct rpcrdma_xprt *r_xprt = cq->cq_context;
+	struct rpcrdma_xprt *r_xprt = sc->sc_xprt;
 
 	/* WARNING: Only wr_cqe and status are reliable at this point */
 	trace_xprtrdma_wc_send(wc, &sc->sc_cid);
@@ -161,7 +161,7 @@ static void rpcrdma_wc_receive(struct ib_cq *cq, struct ib_wc *wc)
 	struct ib_cqe *cqe = wc->wr_cqe;
 	struct rpcrdma_rep *rep = container_of(cqe, struct rpcrdma_rep,
 					       rr_cqe);
-	struct rpcrdma_xprt *r_xprt = cq->cq_context;
+	struct rpcrdma_xprt *r_xprt = rep->rr_rxprt;
 
 	/* WARNING: Only wr_cqe and status are reliable at this point */
 	trace_xprtrdma_wc_receive(wc, &rep->rr_cid);
@@ -336,10 +336,10 @@ static void rpcrdma_ep_destroy(struct kref *kref)
 	}
 
 	if (ep->re_attr.recv_cq)
-		ib_free_cq(ep->re_attr.recv_cq);
+		ib_cq_pool_put(ep->re_attr.recv_cq, ep->re_recv_cqes);
 	ep->re_attr.recv_cq = NULL;
 	if (ep->re_attr.send_cq)
-		ib_free_cq(ep->re_attr.send_cq);
+		ib_cq_pool_put(ep->re_attr.send_cq, ep->re_send_cqes);
 	ep->re_attr.send_cq = NULL;
 
 	if (ep->re_pd)
@@ -407,18 +407,23 @@ static int rpcrdma_ep_create(struct rpcrdma_xprt *r_xprt)
 	ep->re_send_count = ep->re_send_batch;
 	init_waitqueue_head(&ep->re_connect_wait);
 
-	ep->re_attr.send_cq = ib_alloc_cq_any(device, r_xprt,
-					      ep->re_attr.cap.max_send_wr,
-					      IB_POLL_WORKQUEUE);
+	/* Completion handlers find their transport through the wr_cqe
+	 * container, so the CQs can come from the device's shared pool:
+	 * transports on the same completion vector then share one CQ
+	 * and one polling work item instead of each arming their own.
+	 */
+	ep->re_send_cqes = ep->re_attr.cap.max_send_wr;
+	ep->re_attr.send_cq = ib_cq_pool_get(device, ep->re_send_cqes, -1,
+					     IB_POLL_WORKQUEUE);
 	if (IS_ERR(ep->re_attr.send_cq)) {
 		rc = PTR_ERR(ep->re_attr.send_cq);
 		ep->re_attr.send_cq = NULL;
 		goto out_destroy;
 	}
 
-	ep->re_attr.recv_cq = ib_alloc_cq_any(device, r_xprt,
-					      ep->re_attr.cap.max_recv_wr,
-					      IB_POLL_WORKQUEUE);
+	ep->re_recv_cqes = ep->re_attr.cap.max_recv_wr;
+	ep->re_attr.recv_cq = ib_cq_pool_get(device, ep->re_recv_cqes, -1,
+					     IB_POLL_WORKQUEUE);
 	if (IS_ERR(ep->re_attr.recv_cq)) {
 		rc = PTR_ERR(ep->re_attr.recv_cq);
 		ep->re_attr.recv_cq = NULL;
@@ -637,6 +642,7 @@ static int rpcrdma_sendctxs_create(struct rpcrdma_xprt *r_xprt)
 		sc = rpcrdma_sendctx_create(r_xprt->rx_ep);
 		if (!sc)
 			return -ENOMEM;
+		sc->sc_xprt = r_xprt;
 
 		buf->rb_sc_ctxs[i] = sc;
 	}
@@ -1458,6 +1458,23 @@ tls_alloc_clrtxt_skb(struct sock *sk, struct sk_buff *skb,
  * NULL, then the decryption happens inside skb buffers itself, i.e.
  * zero-copy gets disabled and 'darg->zc' is updated.
  */
+/* Synchronous decryption is done under the reader lock and the request is
+ * gone by the time tls_decrypt_sg() returns, so keep its memory around
+ * instead of going through kmalloc() for every record.
+ */
+static void *tls_decrypt_mem_get(struct tls_sw_context_rx *ctx, size_t size,
+				 gfp_t gfp)
+{
+	if (ctx->decrypt_mem_size < size) {
+		size = kmalloc_size_roundup(size);
+		kfree(ctx->decrypt_mem);
+		ctx->decrypt_mem = kmalloc(size, gfp);
+		ctx->decrypt_mem_size = ctx->decrypt_mem ? size : 0;
+	}
+
+	return ctx->decrypt_mem;
+}
+
 static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 			  struct scatterlist *out_sg,
 			  struct tls_decrypt_arg *darg)
@@ -1477,6 +1494,7 @@ static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 	struct tls_decrypt_ctx *dctx;
 	struct sk_buff *clear_skb;
 	int iv_offset = 0;
+	size_t mem_size;
 	u8 *mem;
 
 	n_sgin = skb_nsg(skb, rxm->offset + prot->prepend_size,
@@ -1511,8 +1529,11 @@ static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 	 */
 	aead_size = sizeof(*aead_req) + crypto_aead_reqsize(ctx->aead_recv);
 	aead_size = ALIGN(aead_size, __alignof__(*dctx));
-	mem = kmalloc(aead_size + struct_size(dctx, sg, size_add(n_sgin, n_sgout)),
-		      sk->sk_allocation);
+	mem_size = aead_size + struct_size(dctx, sg, size_add(n_sgin, n_sgout));
+	if (darg->async)
+		mem = kmalloc(mem_size, sk->sk_allocation);
+	else
+		mem = tls_decrypt_mem_get(ctx, mem_size, sk->sk_allocation);
 	if (!mem) {
 		err = -ENOMEM;
 		goto exit_free_skb;
@@ -1624,7 +1645,8 @@ static int tls_decrypt_sg(struct sock *sk, struct iov_iter *out_iov,
 	for (; pages > 0; pages--)
 		put_page(sg_page(&sgout[pages]));
 exit_free:
-	kfree(mem);
+	if (mem != ctx->decrypt_mem)
+		kfree(mem);
 exit_free_skb:
 	consume_skb(clear_skb);
 	return err;
@@ -2507,6 +2529,7 @@ void tls_sw_release_resources_rx(struct sock *sk)
 	if (ctx->aead_recv) {
 		__skb_queue_purge(&ctx->rx_list);
 		crypto_free_aead(ctx->aead_recv);
+		kfree(ctx->decrypt_mem);
 		tls_strp_stop(&ctx->strp);
 		/* If tls_sw_strparser_arm() was not called (cleanup paths)
 		 * we still want to tls_strp_stop(), but sk->sk_data_ready was
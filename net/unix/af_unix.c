@@ -2162,6 +2162,18 @@ static int queue_oob(struct socket *sock, struct msghdr *msg, struct sock *other
 }
 #endif
 
+static struct sk_buff *unix_stream_alloc_skb(struct sock *sk,
+					     struct msghdr *msg, int size,
+					     int data_len, bool noblock,
+					     int *err)
+{
+	if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES))
+		return sock_alloc_send_pskb(sk, 0, 0, noblock, err, 0);
+
+	return sock_alloc_send_pskb(sk, size - data_len, data_len, noblock,
+				    err, get_order(UNIX_SKB_FRAGS_SZ));
+}
+
 static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
@@ -2172,6 +2184,8 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	int sent = 0;
 	struct scm_cookie scm;
 	bool fds_sent = false;
+	bool wake_other = false;
+	bool noblock;
 	int data_len;
 
 	wait_for_unix_gc();
@@ -2202,13 +2216,13 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (sk->sk_shutdown & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	noblock = msg->msg_flags & MSG_DONTWAIT;
+
 	while (sent < len) {
 		size = len - sent;
 
 		if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES)) {
-			skb = sock_alloc_send_pskb(sk, 0, 0,
-						   msg->msg_flags & MSG_DONTWAIT,
-						   &err, 0);
+			data_len = 0;
 		} else {
 			/* Keep two messages in the pipe so it schedules better */
 			size = min_t(int, size, (sk->sk_sndbuf >> 1) - 64);
@@ -2219,10 +2233,18 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
 
 			data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
+		}
 
-			skb = sock_alloc_send_pskb(sk, size - data_len, data_len,
-						   msg->msg_flags & MSG_DONTWAIT, &err,
-						   get_order(UNIX_SKB_FRAGS_SZ));
+		/* The reader is only woken up once per call for large writes,
+		 * so it must be woken before we wait for it to free space.
+		 */
+		skb = unix_stream_alloc_skb(sk, msg, size, data_len,
+					    noblock || wake_other, &err);
+		if (!skb && wake_other && !noblock && err == -EAGAIN) {
+			other->sk_data_ready(other);
+			wake_other = false;
+			skb = unix_stream_alloc_skb(sk, msg, size, data_len,
+						    false, &err);
 		}
 		if (!skb)
 			goto out_err;
@@ -2265,10 +2287,15 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		scm_stat_add(other, skb);
 		skb_queue_tail(&other->sk_receive_queue, skb);
 		unix_state_unlock(other);
-		other->sk_data_ready(other);
+		wake_other = true;
 		sent += size;
 	}
 
+	if (wake_other) {
+		other->sk_data_ready(other);
+		wake_other = false;
+	}
+
 #if IS_ENABLED(CONFIG_AF_UNIX_OOB)
 	if (msg->msg_flags & MSG_OOB) {
 		err = queue_oob(sock, msg, other, &scm, fds_sent);
@@ -2290,6 +2317,8 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		send_sig(SIGPIPE, current, 0);
 	err = -EPIPE;
 out_err:
+	if (wake_other)
+		other->sk_data_ready(other);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
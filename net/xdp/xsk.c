@@ -710,13 +710,46 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/* Transmit a complete frame. @next is the frame built after it, if any. Its
+ * descriptors were consumed right after those of @skb, so it is cancelled
+ * along with @skb when the driver is busy, and dropped if @skb was.
+ */
+static int xsk_generic_xmit_skb(struct xdp_sock *xs, struct sk_buff *skb,
+				struct sk_buff *next, bool more)
+{
+	u32 next_descs = next ? xsk_get_num_desc(next) : 0;
+	int err;
+
+	err = __dev_direct_xmit_more(skb, xs->queue_id, more);
+	if  (err == NETDEV_TX_BUSY) {
+		/* Tell user-space to retry the send */
+		xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb) + next_descs);
+		xsk_consume_skb(skb);
+		if (next)
+			xsk_consume_skb(next);
+		return -EAGAIN;
+	}
+
+	/* Ignore NET_XMIT_CN as packet might have been sent */
+	if (err == NET_XMIT_DROP) {
+		/* SKB completed but not sent */
+		if (next) {
+			xskq_cons_cancel_n(xs->tx, next_descs);
+			xsk_consume_skb(next);
+		}
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
+	struct sk_buff *skb, *pending = NULL;
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
-	struct sk_buff *skb;
 	int err = 0;
 
 	mutex_lock(&xs->mutex);
@@ -730,7 +763,28 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	for (;;) {
+		/* A built frame is held back until the next one is ready, so
+		 * that it can go out with xmit_more set. Only keep it while the
+		 * next descriptor can be read without publishing the consumer
+		 * index, as cancelling it on NETDEV_TX_BUSY relies on that.
+		 */
+		if (pending && !xskq_cons_has_entries(xs->tx, 1))
+			break;
+		if (!xskq_cons_peek_desc(xs->tx, &desc, xs->pool))
+			break;
+
+		/* Multi-buffer frames may be dropped half way through, which
+		 * consumes their descriptors: send the pending frame first.
+		 */
+		if (pending && xp_mb_desc(&desc)) {
+			err = xsk_generic_xmit_skb(xs, pending, NULL, false);
+			pending = NULL;
+			if (err)
+				goto out;
+			sent_frame = true;
+		}
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
 			goto out;
@@ -760,25 +814,23 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
+		xs->skb = NULL;
+		if (pending) {
+			err = xsk_generic_xmit_skb(xs, pending, skb, true);
+			pending = NULL;
+			if (err)
+				goto out;
+			sent_frame = true;
 		}
+		pending = skb;
+	}
 
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
+	if (pending) {
+		err = xsk_generic_xmit_skb(xs, pending, NULL, false);
+		pending = NULL;
+		if (err)
 			goto out;
-		}
-
 		sent_frame = true;
-		xs->skb = NULL;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -788,6 +840,15 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (pending) {
+		int ret = xsk_generic_xmit_skb(xs, pending, NULL, false);
+
+		if (ret)
+			err = ret;
+		else
+			sent_frame = true;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
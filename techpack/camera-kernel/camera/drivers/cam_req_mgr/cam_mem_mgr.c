@@ -737,6 +737,8 @@ static int cam_mem_mgr_get_dma_heaps(void)
 {
 	int rc = 0;
 
+	tbl.try_heap_failed = NULL;
+	tbl.try_heap_fail_len = 0;
 	tbl.system_heap = NULL;
 	tbl.system_movable_heap = NULL;
 	tbl.system_uncached_heap = NULL;
@@ -848,6 +850,26 @@ int cam_mem_mgr_check_for_supported_heaps(uint64_t *heap_mask)
 	return 0;
 }
 
+/*
+ * The camera heaps are a limited carveout. Once one of them fails an
+ * allocation, every further request of the same size or larger would fail
+ * again (often only after an expensive attempt) before falling back to the
+ * system heap, so such requests go to the fallback heap directly until a
+ * buffer is freed. Unlocked access is fine, a race only costs one extra or
+ * one skipped attempt on the camera heap.
+ */
+static bool cam_mem_util_try_heap_exhausted(struct dma_heap *heap, size_t len)
+{
+	return (READ_ONCE(tbl.try_heap_failed) == heap) &&
+		(len >= READ_ONCE(tbl.try_heap_fail_len));
+}
+
+static void cam_mem_util_set_try_heap_failed(struct dma_heap *heap, size_t len)
+{
+	WRITE_ONCE(tbl.try_heap_fail_len, len);
+	WRITE_ONCE(tbl.try_heap_failed, heap);
+}
+
 static int cam_mem_util_get_dma_buf(size_t len,
 	unsigned int cam_flags,
 	enum cam_mem_mgr_allocator alloc_type,
@@ -966,12 +988,19 @@ static int cam_mem_util_get_dma_buf(size_t len,
 		return -EINVAL;
 	}
 
+	if (try_heap && heap && cam_mem_util_try_heap_exhausted(try_heap, len)) {
+		CAM_DBG(CAM_MEM, "Skipping exhausted try heap=%pK, len=%zu",
+			try_heap, len);
+		try_heap = NULL;
+	}
+
 	if (try_heap) {
 		*buf = dma_heap_buffer_alloc(try_heap, len, O_RDWR, 0);
 		if (IS_ERR(*buf)) {
 			CAM_WARN(CAM_MEM,
 				"Failed in allocating from try heap, heap=%pK, len=%zu, err=%d",
 				try_heap, len, PTR_ERR(*buf));
+			cam_mem_util_set_try_heap_failed(try_heap, len);
 			*buf = NULL;
 		}
 	}
@@ -1822,6 +1851,12 @@ static void cam_mem_util_unmap(int32_t idx)
 	if (tbl.bufq[idx].dma_buf)
 		dma_buf_put(tbl.bufq[idx].dma_buf);
 
+#if IS_REACHABLE(CONFIG_DMABUF_HEAPS)
+	/* Freed memory may have come from a camera heap, retry it */
+	if (tbl.bufq[idx].dma_buf && !tbl.bufq[idx].is_imported)
+		WRITE_ONCE(tbl.try_heap_failed, NULL);
+#endif
+
 	tbl.bufq[idx].fd = -1;
 	tbl.bufq[idx].i_ino = 0;
 	tbl.bufq[idx].dma_buf = NULL;
@@ -141,6 +141,9 @@ struct cam_mem_buf_queue {
  * @secure_display_heap: Handle to secure display heap
  * @ubwc_p_heap: Handle to ubwc-p heap
  * @ubwc_p_movable_heap: Handle to ubwc-p movable heap
+ * @try_heap_failed: Preferred (camera) heap that last failed an allocation
+ * @try_heap_fail_len: Size of that failed allocation; requests of at least
+ *                     this size skip @try_heap_failed until a buffer is freed
  */
 struct cam_mem_table {
 	struct mutex m_lock;
@@ -162,6 +165,8 @@ struct cam_mem_table {
 	struct dma_heap *secure_display_heap;
 	struct dma_heap *ubwc_p_heap;
 	struct dma_heap *ubwc_p_movable_heap;
+	struct dma_heap *try_heap_failed;
+	size_t try_heap_fail_len;
 #endif
 
 };
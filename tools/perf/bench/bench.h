@@ -47,6 +47,15 @@ int bench_uprobe_baseline(int argc, const char **argv);
 int bench_uprobe_empty(int argc, const char **argv);
 int bench_uprobe_trace_printk(int argc, const char **argv);
 int bench_pmu_scan(int argc, const char **argv);
+int bench_io_pread(int argc, const char **argv);
+int bench_io_aio(int argc, const char **argv);
+int bench_io_uring(int argc, const char **argv);
+int bench_io_uring_poll(int argc, const char **argv);
+int bench_net_tcp_rr(int argc, const char **argv);
+int bench_net_tcp_stream(int argc, const char **argv);
+int bench_net_udp_rr(int argc, const char **argv);
+int bench_net_unix_stream(int argc, const char **argv);
+int bench_net_unix_dgram(int argc, const char **argv);
 
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
@@ -0,0 +1,685 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * io.c
+ *
+ * io: Benchmarks for block layer submission and completion overhead
+ *
+ * Each thread keeps random, fixed-size reads in flight against a block
+ * device (null_blk by default, so that the device itself costs next to
+ * nothing) using synchronous pread(), Linux AIO or io_uring, either
+ * interrupt driven or polled.  The summary reports IOPS, CPU time spent
+ * per I/O and completion latency percentiles, which makes it suitable for
+ * comparing block layer changes across kernels.
+ */
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "../util/cpumap.h"
+#include "../util/stat.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <linux/aio_abi.h>
+#include <linux/compiler.h>
+#include <linux/io_uring.h>
+#include <linux/kernel.h>
+#include <linux/time64.h>
+#include <linux/types.h>
+#include <asm/barrier.h>
+#include <perf/cpumap.h>
+
+static const char	*filename = "/dev/nullb0";
+static unsigned int	block_size = 4096;
+static unsigned int	queue_depth = 32;
+static unsigned int	batch = 8;
+static unsigned int	nthreads = 1;
+static unsigned int	runtime = 5;
+static bool		buffered;
+static bool		pin;
+static bool		silent;
+
+static const struct option options[] = {
+	OPT_STRING('f', "file", &filename, "path", "Block device or file to read from"),
+	OPT_UINTEGER('b', "block-size", &block_size, "Size of each read in bytes"),
+	OPT_UINTEGER('q', "queue-depth", &queue_depth, "Reads kept in flight per thread (aio, uring)"),
+	OPT_UINTEGER('B', "batch", &batch, "Completions reaped and resubmitted per system call (aio, uring)"),
+	OPT_UINTEGER('t', "threads", &nthreads, "Number of submitting threads"),
+	OPT_UINTEGER('r', "runtime", &runtime, "Runtime in seconds"),
+	OPT_BOOLEAN( 'p', "pin", &pin, "Pin thread N to the Nth online CPU; buffers are then node local"),
+	OPT_BOOLEAN( 'C', "buffered", &buffered, "Use buffered instead of O_DIRECT reads"),
+	OPT_BOOLEAN( 's', "silent", &silent, "Do not print per thread results"),
+	OPT_END()
+};
+
+static const char * const bench_io_usage[] = {
+	"perf bench io <pread|aio|uring|uring-poll> <options>",
+	NULL
+};
+
+/*
+ * Latency histogram: 8 linear sub-buckets per power of two, i.e. a
+ * relative error of at most 12.5%, covering the whole u64 range.
+ */
+#define LAT_SUB_BITS	3
+#define LAT_SUB_MASK	((1U << LAT_SUB_BITS) - 1)
+#define LAT_NR_BUCKETS	(64 << LAT_SUB_BITS)
+
+struct worker {
+	pthread_t		thread;
+	int			id;
+	int			fd;
+	int			err;
+	u64			seed;
+	u64			nr_ios;
+	void			*bufs;
+	u64			*issue_ns;
+	u64			lat[LAT_NR_BUCKETS];
+};
+
+static volatile bool	done;
+static u64		nr_blocks;
+static pthread_barrier_t start_barrier;
+static int		(*run_engine)(struct worker *w);
+
+static unsigned int lat_bucket(u64 ns)
+{
+	unsigned int msb;
+
+	if (ns <= LAT_SUB_MASK)
+		return ns;
+
+	msb = 63 - __builtin_clzll(ns);
+	return ((msb - LAT_SUB_BITS + 1) << LAT_SUB_BITS) |
+	       ((ns >> (msb - LAT_SUB_BITS)) & LAT_SUB_MASK);
+}
+
+static u64 lat_bucket_ns(unsigned int idx)
+{
+	unsigned int group = idx >> LAT_SUB_BITS;
+	unsigned int sub = idx & LAT_SUB_MASK;
+
+	if (!group)
+		return sub;
+
+	return (u64)((1U << LAT_SUB_BITS) | sub) << (group - 1);
+}
+
+static u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static u64 next_offset(struct worker *w)
+{
+	/* xorshift64 */
+	w->seed ^= w->seed << 13;
+	w->seed ^= w->seed >> 7;
+	w->seed ^= w->seed << 17;
+
+	return (w->seed % nr_blocks) * block_size;
+}
+
+static void *slot_buf(struct worker *w, unsigned int slot)
+{
+	return w->bufs + (size_t)slot * block_size;
+}
+
+static void account_io(struct worker *w, unsigned int slot)
+{
+	w->lat[lat_bucket(now_ns() - w->issue_ns[slot])]++;
+	w->nr_ios++;
+}
+
+static int run_pread(struct worker *w)
+{
+	while (!done) {
+		ssize_t ret;
+
+		w->issue_ns[0] = now_ns();
+		ret = pread(w->fd, slot_buf(w, 0), block_size, next_offset(w));
+		if (ret != (ssize_t)block_size)
+			return ret < 0 ? -errno : -EIO;
+		account_io(w, 0);
+	}
+	return 0;
+}
+
+static int aio_submit(aio_context_t ctx, struct iocb **list, unsigned int nr)
+{
+	while (nr) {
+		long ret = syscall(__NR_io_submit, ctx, nr, list);
+
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return -errno;
+		}
+		list += ret;
+		nr -= ret;
+	}
+	return 0;
+}
+
+static void aio_prep(struct worker *w, struct iocb *iocb, unsigned int slot)
+{
+	memset(iocb, 0, sizeof(*iocb));
+	iocb->aio_fildes = w->fd;
+	iocb->aio_lio_opcode = IOCB_CMD_PREAD;
+	iocb->aio_buf = (u64)(unsigned long)slot_buf(w, slot);
+	iocb->aio_nbytes = block_size;
+	iocb->aio_offset = next_offset(w);
+	iocb->aio_data = slot;
+	w->issue_ns[slot] = now_ns();
+}
+
+static int run_aio(struct worker *w)
+{
+	aio_context_t ctx = 0;
+	struct iocb *iocbs, **list;
+	struct io_event *events;
+	unsigned int i, inflight;
+	int ret;
+
+	iocbs = calloc(queue_depth, sizeof(*iocbs));
+	list = calloc(queue_depth, sizeof(*list));
+	events = calloc(queue_depth, sizeof(*events));
+	if (!iocbs || !list || !events) {
+		ret = -ENOMEM;
+		goto out_free;
+	}
+
+	if (syscall(__NR_io_setup, queue_depth, &ctx)) {
+		ret = -errno;
+		goto out_free;
+	}
+
+	for (i = 0; i < queue_depth; i++) {
+		aio_prep(w, &iocbs[i], i);
+		list[i] = &iocbs[i];
+	}
+	ret = aio_submit(ctx, list, queue_depth);
+	if (ret)
+		goto out_destroy;
+	inflight = queue_depth;
+
+	while (inflight) {
+		long nr = syscall(__NR_io_getevents, ctx,
+				  min(batch, inflight), inflight, events, NULL);
+
+		if (nr < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			break;
+		}
+
+		inflight -= nr;
+		for (i = 0; i < nr; i++) {
+			unsigned int slot = events[i].data;
+
+			if (events[i].res != block_size) {
+				ret = (long)events[i].res < 0 ? events[i].res : -EIO;
+				break;
+			}
+			account_io(w, slot);
+			aio_prep(w, &iocbs[slot], slot);
+			list[i] = &iocbs[slot];
+		}
+		if (ret)
+			break;
+
+		if (!done) {
+			ret = aio_submit(ctx, list, nr);
+			if (ret)
+				break;
+			inflight += nr;
+		}
+	}
+
+out_destroy:
+	/* io_destroy() waits for anything still in flight */
+	syscall(__NR_io_destroy, ctx);
+out_free:
+	free(events);
+	free(list);
+	free(iocbs);
+	return ret;
+}
+
+struct uring {
+	int			fd;
+	unsigned int		*sq_tail;
+	unsigned int		*sq_mask;
+	unsigned int		*sq_array;
+	unsigned int		*cq_head;
+	unsigned int		*cq_tail;
+	unsigned int		*cq_mask;
+	struct io_uring_sqe	*sqes;
+	struct io_uring_cqe	*cqes;
+	void			*sq_ptr;
+	void			*cq_ptr;
+	size_t			sq_len;
+	size_t			cq_len;
+	size_t			sqes_len;
+};
+
+static void uring_exit(struct uring *r)
+{
+	if (r->sqes != MAP_FAILED)
+		munmap(r->sqes, r->sqes_len);
+	if (r->cq_ptr != MAP_FAILED && r->cq_ptr != r->sq_ptr)
+		munmap(r->cq_ptr, r->cq_len);
+	if (r->sq_ptr != MAP_FAILED)
+		munmap(r->sq_ptr, r->sq_len);
+	close(r->fd);
+}
+
+static int uring_init(struct uring *r, unsigned int entries, unsigned int flags)
+{
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+	p.flags = flags;
+
+	r->sq_ptr = r->cq_ptr = r->sqes = MAP_FAILED;
+	r->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (r->fd < 0)
+		return -errno;
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_len = r->cq_len = max(r->sq_len, r->cq_len);
+
+	r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ptr == MAP_FAILED)
+		goto err;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_ptr = r->sq_ptr;
+	else
+		r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+				 MAP_SHARED | MAP_POPULATE, r->fd,
+				 IORING_OFF_CQ_RING);
+	if (r->cq_ptr == MAP_FAILED)
+		goto err;
+
+	r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED)
+		goto err;
+
+	r->sq_tail = r->sq_ptr + p.sq_off.tail;
+	r->sq_mask = r->sq_ptr + p.sq_off.ring_mask;
+	r->sq_array = r->sq_ptr + p.sq_off.array;
+	r->cq_head = r->cq_ptr + p.cq_off.head;
+	r->cq_tail = r->cq_ptr + p.cq_off.tail;
+	r->cq_mask = r->cq_ptr + p.cq_off.ring_mask;
+	r->cqes = r->cq_ptr + p.cq_off.cqes;
+	return 0;
+
+err:
+	uring_exit(r);
+	return -errno;
+}
+
+static void uring_prep(struct worker *w, struct uring *r, unsigned int slot)
+{
+	unsigned int tail = *r->sq_tail;
+	unsigned int idx = tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = w->fd;
+	sqe->addr = (u64)(unsigned long)slot_buf(w, slot);
+	sqe->len = block_size;
+	sqe->off = next_offset(w);
+	sqe->user_data = slot;
+	r->sq_array[idx] = idx;
+	w->issue_ns[slot] = now_ns();
+
+	smp_store_release(r->sq_tail, tail + 1);
+}
+
+/*
+ * Wait for the reads still in flight before the ring and the buffers they
+ * read into go away.
+ */
+static void uring_drain(struct uring *r, unsigned int inflight)
+{
+	while (inflight) {
+		unsigned int head, tail;
+
+		if (syscall(__NR_io_uring_enter, r->fd, 0, 1,
+			    IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+		    errno != EINTR && errno != EAGAIN)
+			break;
+
+		head = *r->cq_head;
+		tail = smp_load_acquire(r->cq_tail);
+		inflight -= tail - head;
+		smp_store_release(r->cq_head, tail);
+	}
+}
+
+static int __run_uring(struct worker *w, unsigned int flags)
+{
+	unsigned int i, to_submit, inflight = 0;
+	struct uring r;
+	int ret;
+
+	ret = uring_init(&r, queue_depth, flags);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < queue_depth; i++)
+		uring_prep(w, &r, i);
+	to_submit = queue_depth;
+
+	while (to_submit || inflight) {
+		unsigned int head, tail;
+		long nr;
+
+		nr = syscall(__NR_io_uring_enter, r.fd, to_submit,
+			     min(batch, inflight + to_submit),
+			     IORING_ENTER_GETEVENTS, NULL, 0);
+		if (nr < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			ret = -errno;
+			break;
+		}
+		to_submit -= nr;
+		inflight += nr;
+
+		head = *r.cq_head;
+		tail = smp_load_acquire(r.cq_tail);
+		for (; head != tail; head++) {
+			struct io_uring_cqe *cqe = &r.cqes[head & *r.cq_mask];
+			unsigned int slot = cqe->user_data;
+
+			inflight--;
+			if (cqe->res != (int)block_size) {
+				if (!ret)
+					ret = cqe->res < 0 ? cqe->res : -EIO;
+				continue;
+			}
+			account_io(w, slot);
+			if (!done && !ret) {
+				uring_prep(w, &r, slot);
+				to_submit++;
+			}
+		}
+		smp_store_release(r.cq_head, head);
+		if (ret)
+			break;
+	}
+
+	uring_drain(&r, inflight);
+	uring_exit(&r);
+	return ret;
+}
+
+static int run_uring(struct worker *w)
+{
+	return __run_uring(w, 0);
+}
+
+static int run_uring_poll(struct worker *w)
+{
+	return __run_uring(w, IORING_SETUP_IOPOLL);
+}
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = arg;
+	size_t len = (size_t)queue_depth * block_size;
+
+	/* Allocated here so that a pinned worker gets node local memory */
+	w->issue_ns = calloc(queue_depth, sizeof(*w->issue_ns));
+	if (!w->issue_ns || posix_memalign(&w->bufs, getpagesize(), len)) {
+		w->err = -ENOMEM;
+		pthread_barrier_wait(&start_barrier);
+		return NULL;
+	}
+	memset(w->bufs, 0, len);
+
+	w->fd = open(filename, O_RDONLY | (buffered ? 0 : O_DIRECT));
+	if (w->fd < 0)
+		w->err = -errno;
+
+	pthread_barrier_wait(&start_barrier);
+
+	if (!w->err)
+		w->err = run_engine(w);
+
+	if (w->fd >= 0)
+		close(w->fd);
+	free(w->bufs);
+	free(w->issue_ns);
+	return NULL;
+}
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	done = true;
+}
+
+static u64 lat_percentile(const u64 *lat, u64 total, double pct)
+{
+	u64 want = (u64)(total * pct / 100.0), seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < LAT_NR_BUCKETS; i++) {
+		seen += lat[i];
+		if (seen > want)
+			return lat_bucket_ns(i);
+	}
+	return lat_bucket_ns(LAT_NR_BUCKETS - 1);
+}
+
+static void print_summary(struct worker *workers, u64 runtime_us, u64 cpu_us,
+			  const char *engine)
+{
+	static const double pcts[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+	u64 lat[LAT_NR_BUCKETS] = { 0 };
+	struct stats iops_stats;
+	u64 total = 0, iops;
+	unsigned int i, j;
+
+	init_stats(&iops_stats);
+	for (i = 0; i < nthreads; i++) {
+		u64 t = workers[i].nr_ios * USEC_PER_SEC / runtime_us;
+
+		total += workers[i].nr_ios;
+		update_stats(&iops_stats, t);
+		for (j = 0; j < LAT_NR_BUCKETS; j++)
+			lat[j] += workers[i].lat[j];
+		if (!silent && bench_format == BENCH_FORMAT_DEFAULT)
+			printf("[thread %3d] %" PRIu64 " IOPS\n", i, t);
+	}
+	iops = total * USEC_PER_SEC / runtime_us;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# Executed %" PRIu64 " %u-byte reads in %d.%03d secs (%s, %u threads, qd %u, batch %u)\n\n",
+		       total, block_size, (int)(runtime_us / USEC_PER_SEC),
+		       (int)(runtime_us % USEC_PER_SEC / USEC_PER_MSEC),
+		       engine, nthreads, queue_depth, batch);
+		printf(" %14" PRIu64 " IOPS (+- %.2f%% between threads)\n",
+		       iops, rel_stddev_stats(stddev_stats(&iops_stats),
+					       avg_stats(&iops_stats)));
+		printf(" %14.2f MiB/s\n", (double)iops * block_size / (1024 * 1024));
+		if (total)
+			printf(" %14.1f ns CPU per I/O\n", (double)cpu_us * NSEC_PER_USEC / total);
+		printf("\n Completion latency percentiles (usec):\n");
+		for (i = 0; i < ARRAY_SIZE(pcts); i++)
+			printf(" %14.2fth: %.1f\n", pcts[i],
+			       lat_percentile(lat, total, pcts[i]) / 1000.0);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%" PRIu64 "\n", iops);
+		break;
+	default:
+		/* reaching here is something of a disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+}
+
+static int bench_io(int argc, const char **argv, const char *engine,
+		    int (*run)(struct worker *w))
+{
+	struct perf_cpu_map *cpus = NULL;
+	struct rusage ru_start, ru_end;
+	struct timeval start, end, diff;
+	struct worker *workers;
+	struct sigaction act;
+	u64 runtime_us, cpu_us;
+	off_t size;
+	unsigned int i;
+	int fd, ret = 0;
+
+	argc = parse_options(argc, argv, options, bench_io_usage, 0);
+	if (argc || !block_size || !queue_depth || !batch || !nthreads || !runtime) {
+		usage_with_options(bench_io_usage, options);
+		exit(EXIT_FAILURE);
+	}
+	if (run == run_pread)
+		queue_depth = batch = 1;
+	batch = min(batch, queue_depth);
+	if (run == run_uring_poll && buffered)
+		errx(EXIT_FAILURE, "polled I/O requires O_DIRECT");
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		err(EXIT_FAILURE, "open %s", filename);
+	size = lseek(fd, 0, SEEK_END);
+	close(fd);
+	if (size < (off_t)block_size)
+		errx(EXIT_FAILURE, "%s is smaller than one block", filename);
+	nr_blocks = size / block_size;
+
+	memset(&act, 0, sizeof(act));
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	sigaction(SIGINT, &act, NULL);
+
+	workers = calloc(nthreads, sizeof(*workers));
+	if (!workers)
+		err(EXIT_FAILURE, "calloc");
+
+	if (pin) {
+		cpus = perf_cpu_map__new(NULL);
+		if (!cpus)
+			err(EXIT_FAILURE, "perf_cpu_map__new");
+	}
+
+	run_engine = run;
+	pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_attr_t attr;
+
+		workers[i].id = i;
+		workers[i].fd = -1;
+		workers[i].seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+
+		pthread_attr_init(&attr);
+		if (cpus) {
+			/* the set is indexed by CPU number, not map index */
+			int max_cpu = cpu__max_cpu().cpu;
+			size_t setsize = CPU_ALLOC_SIZE(max_cpu);
+			cpu_set_t *cpuset = CPU_ALLOC(max_cpu);
+
+			BUG_ON(!cpuset);
+			CPU_ZERO_S(setsize, cpuset);
+			CPU_SET_S(perf_cpu_map__cpu(cpus, i % perf_cpu_map__nr(cpus)).cpu,
+				  setsize, cpuset);
+			ret = pthread_attr_setaffinity_np(&attr, setsize, cpuset);
+			CPU_FREE(cpuset);
+			if (ret)
+				err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+		}
+		ret = pthread_create(&workers[i].thread, &attr, workerfn, &workers[i]);
+		pthread_attr_destroy(&attr);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_create");
+	}
+
+	pthread_barrier_wait(&start_barrier);
+	getrusage(RUSAGE_SELF, &ru_start);
+	gettimeofday(&start, NULL);
+
+	sleep(runtime);
+	done = true;
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	gettimeofday(&end, NULL);
+	getrusage(RUSAGE_SELF, &ru_end);
+	pthread_barrier_destroy(&start_barrier);
+
+	for (i = 0; i < nthreads; i++) {
+		if (workers[i].err) {
+			warnx("thread %u: %s", i, strerror(-workers[i].err));
+			ret = -1;
+		}
+	}
+
+	timersub(&end, &start, &diff);
+	runtime_us = diff.tv_sec * USEC_PER_SEC + diff.tv_usec;
+
+	timersub(&ru_end.ru_utime, &ru_start.ru_utime, &diff);
+	cpu_us = diff.tv_sec * USEC_PER_SEC + diff.tv_usec;
+	timersub(&ru_end.ru_stime, &ru_start.ru_stime, &diff);
+	cpu_us += diff.tv_sec * USEC_PER_SEC + diff.tv_usec;
+
+	if (!ret && runtime_us)
+		print_summary(workers, runtime_us, cpu_us, engine);
+
+	perf_cpu_map__put(cpus);
+	free(workers);
+	return ret;
+}
+
+int bench_io_pread(int argc, const char **argv)
+{
+	return bench_io(argc, argv, "pread", run_pread);
+}
+
+int bench_io_aio(int argc, const char **argv)
+{
+	return bench_io(argc, argv, "aio", run_aio);
+}
+
+int bench_io_uring(int argc, const char **argv)
+{
+	return bench_io(argc, argv, "io_uring", run_uring);
+}
+
+int bench_io_uring_poll(int argc, const char **argv)
+{
+	return bench_io(argc, argv, "io_uring polled", run_uring_poll);
+}
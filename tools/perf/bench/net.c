@@ -0,0 +1,579 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * net.c
+ *
+ * net: Benchmarks for the socket fast paths
+ *
+ * Each pair of threads runs a netperf style test over a local socket:
+ * request/response ping-pong (TCP_RR, UDP_RR, AF_UNIX dgram) or a one way
+ * bulk transfer (TCP_STREAM, AF_UNIX stream).  Client and server run in the
+ * same network namespace, so TCP and UDP traffic always goes over loopback,
+ * whichever local address --host names.  The result is reported as CPU
+ * cycles spent per transaction and per byte, so that regressions in the
+ * protocol send/receive paths show up without an external netperf setup.
+ */
+#include <subcmd/parse-options.h>
+#include "bench.h"
+
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/perf_event.h>
+#include <linux/time64.h>
+#include <linux/types.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL		46
+#endif
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY		60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY		0x4000000
+#endif
+
+/* Receive/send timeout, so that blocked threads notice the end of the run */
+#define NET_IO_TIMEOUT_MS	100
+
+/* Sends between two reaps of the zerocopy completion queue */
+#define NET_ZC_REAP_INTERVAL	32
+
+static const char	*host = "127.0.0.1";
+static unsigned int	msg_size;
+static unsigned int	npairs = 1;
+static unsigned int	runtime = 5;
+static int		client_cpu = -1;
+static int		server_cpu = -1;
+static unsigned int	busy_poll;
+static bool		zerocopy;
+
+static const struct option options[] = {
+	OPT_STRING('H', "host", &host, "addr", "Local IPv4 address for TCP/UDP to bind to (default: 127.0.0.1)"),
+	OPT_UINTEGER('m', "msg-size", &msg_size, "Bytes per request/send (default: 1 for RR, 64K for stream)"),
+	OPT_UINTEGER('p', "pairs", &npairs, "Number of client/server thread pairs"),
+	OPT_UINTEGER('r', "runtime", &runtime, "Runtime in seconds"),
+	OPT_INTEGER( 'c', "client-cpu", &client_cpu, "Pin the client of pair N to CPU <n> + N"),
+	OPT_INTEGER( 'S', "server-cpu", &server_cpu, "Pin the server of pair N to CPU <n> + N"),
+	OPT_UINTEGER('b', "busy-poll", &busy_poll, "SO_BUSY_POLL budget in usecs"),
+	OPT_BOOLEAN( 'z', "zerocopy", &zerocopy, "Send with MSG_ZEROCOPY (TCP/UDP)"),
+	OPT_END()
+};
+
+static const char * const bench_net_usage[] = {
+	"perf bench net <tcp-rr|tcp-stream|udp-rr|unix-stream|unix-dgram> <options>",
+	NULL
+};
+
+enum net_mode {
+	NET_TCP_RR,
+	NET_TCP_STREAM,
+	NET_UDP_RR,
+	NET_UNIX_STREAM,
+	NET_UNIX_DGRAM,
+};
+
+struct pair {
+	pthread_t	client;
+	pthread_t	server;
+	int		id;
+	int		cfd;
+	int		sfd;
+	int		err;
+	u64		ops;
+	u64		bytes;
+	u64		zc_sends;
+};
+
+static volatile bool	done;
+static enum net_mode	mode;
+
+static bool mode_is_stream(void)
+{
+	return mode == NET_TCP_STREAM || mode == NET_UNIX_STREAM;
+}
+
+static bool mode_is_inet(void)
+{
+	return mode == NET_TCP_RR || mode == NET_TCP_STREAM || mode == NET_UDP_RR;
+}
+
+static bool mode_is_dgram(void)
+{
+	return mode == NET_UDP_RR || mode == NET_UNIX_DGRAM;
+}
+
+static bool io_retry(void)
+{
+	return !done && (errno == EAGAIN || errno == EINTR);
+}
+
+static int recv_full(int fd, char *buf, size_t len)
+{
+	size_t off = 0;
+
+	while (off < len) {
+		ssize_t ret = recv(fd, buf + off, len - off, 0);
+
+		if (ret > 0) {
+			/* a datagram is all or nothing */
+			if (mode_is_dgram())
+				return 0;
+			off += ret;
+		} else if (ret == 0 || done) {
+			return -ECONNRESET;
+		} else if (mode_is_dgram() && errno == EAGAIN) {
+			/* timed out, the datagram may have been dropped */
+			return -EAGAIN;
+		} else if (!io_retry()) {
+			return -errno;
+		}
+	}
+	return 0;
+}
+
+static void zc_reap(struct pair *p, int fd)
+{
+	char control[128];
+	struct msghdr msg = {
+		.msg_control	= control,
+		.msg_controllen	= sizeof(control),
+	};
+
+	/*
+	 * Only the notifications matter, so that the kernel can release the
+	 * pinned pages.  The send buffer is only rewritten once the peer has
+	 * answered or the request timed out, so not waiting for the
+	 * completion first is harmless here.
+	 */
+	while (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) != -1)
+		msg.msg_controllen = sizeof(control);
+	p->zc_sends = 0;
+}
+
+static int send_full(struct pair *p, int fd, const char *buf, size_t len)
+{
+	int flags = zerocopy && fd == p->cfd ? MSG_ZEROCOPY : 0;
+	size_t off = 0;
+
+	while (off < len) {
+		ssize_t ret = send(fd, buf + off, len - off, flags);
+
+		if (ret >= 0) {
+			off += ret;
+			if (flags && ++p->zc_sends >= NET_ZC_REAP_INTERVAL)
+				zc_reap(p, fd);
+		} else if (flags && errno == ENOBUFS) {
+			/* out of optmem: completions have to be reaped first */
+			zc_reap(p, fd);
+		} else if (done) {
+			return -ECONNRESET;
+		} else if (!io_retry()) {
+			return -errno;
+		}
+	}
+	return 0;
+}
+
+static void pin_self(int cpu)
+{
+	cpu_set_t set;
+
+	if (cpu < 0)
+		return;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+		warnx("could not pin to CPU %d", cpu);
+}
+
+static void *clientfn(void *arg)
+{
+	struct pair *p = arg;
+	char *buf = calloc(1, msg_size);
+	char *rbuf = calloc(1, msg_size);
+	unsigned char seq = 0;
+	int ret = 0;
+
+	if (!buf || !rbuf) {
+		p->err = -ENOMEM;
+		goto out;
+	}
+	pin_self(client_cpu < 0 ? -1 : client_cpu + p->id);
+
+	while (!done) {
+		/*
+		 * The server echoes the request, so tagging datagrams lets a
+		 * reply that arrives after its request timed out be told apart
+		 * from the reply to the request just sent.
+		 */
+		if (mode_is_dgram())
+			buf[0] = ++seq;
+
+		ret = send_full(p, p->cfd, buf, msg_size);
+		if (ret)
+			break;
+
+		if (mode_is_stream()) {
+			p->bytes += msg_size;
+			continue;
+		}
+
+		do {
+			ret = recv_full(p->cfd, rbuf, msg_size);
+		} while (!ret && mode_is_dgram() && rbuf[0] != buf[0]);
+		if (ret) {
+			/* a lost datagram only costs a retransmit */
+			if (ret == -EAGAIN)
+				continue;
+			break;
+		}
+		p->ops++;
+		p->bytes += 2 * msg_size;
+	}
+
+	if (!done)
+		p->err = ret;
+out:
+	free(rbuf);
+	free(buf);
+	return NULL;
+}
+
+static void *serverfn(void *arg)
+{
+	struct pair *p = arg;
+	char *buf = calloc(1, msg_size);
+	int ret = 0;
+
+	if (!buf) {
+		p->err = -ENOMEM;
+		return NULL;
+	}
+	pin_self(server_cpu < 0 ? -1 : server_cpu + p->id);
+
+	while (!done) {
+		if (mode_is_stream()) {
+			ssize_t len = recv(p->sfd, buf, msg_size, 0);
+
+			if (len > 0)
+				continue;
+			if (len < 0 && io_retry())
+				continue;
+			ret = len ? -errno : -ECONNRESET;
+			break;
+		}
+
+		ret = recv_full(p->sfd, buf, msg_size);
+		if (ret == -EAGAIN)
+			continue;
+		if (!ret)
+			ret = send_full(p, p->sfd, buf, msg_size);
+		if (ret)
+			break;
+	}
+
+	if (!done)
+		p->err = ret;
+	free(buf);
+	return NULL;
+}
+
+static void sock_setup(int fd)
+{
+	struct timeval tv = {
+		.tv_sec		= 0,
+		.tv_usec	= NET_IO_TIMEOUT_MS * USEC_PER_MSEC,
+	};
+	int one = 1;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) ||
+	    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)))
+		err(EXIT_FAILURE, "setsockopt(SO_RCVTIMEO/SO_SNDTIMEO)");
+
+	if (mode == NET_TCP_RR &&
+	    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)))
+		err(EXIT_FAILURE, "setsockopt(TCP_NODELAY)");
+
+	if (busy_poll &&
+	    setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)))
+		err(EXIT_FAILURE, "setsockopt(SO_BUSY_POLL)");
+
+	if (zerocopy && setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)))
+		err(EXIT_FAILURE, "setsockopt(SO_ZEROCOPY)");
+}
+
+static int inet_socket(int type, struct sockaddr_in *addr)
+{
+	socklen_t len = sizeof(*addr);
+	int fd = socket(AF_INET, type, 0);
+
+	if (fd < 0)
+		err(EXIT_FAILURE, "socket");
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	if (inet_pton(AF_INET, host, &addr->sin_addr) != 1)
+		errx(EXIT_FAILURE, "invalid address: %s", host);
+	if (bind(fd, (struct sockaddr *)addr, sizeof(*addr)) ||
+	    getsockname(fd, (struct sockaddr *)addr, &len))
+		err(EXIT_FAILURE, "bind %s", host);
+
+	return fd;
+}
+
+static void pair_connect(struct pair *p)
+{
+	struct sockaddr_in caddr, saddr;
+	int fds[2], lfd;
+
+	switch (mode) {
+	case NET_TCP_RR:
+	case NET_TCP_STREAM:
+		lfd = inet_socket(SOCK_STREAM, &saddr);
+		if (listen(lfd, 1))
+			err(EXIT_FAILURE, "listen");
+		p->cfd = socket(AF_INET, SOCK_STREAM, 0);
+		if (p->cfd < 0 ||
+		    connect(p->cfd, (struct sockaddr *)&saddr, sizeof(saddr)))
+			err(EXIT_FAILURE, "connect");
+		p->sfd = accept(lfd, NULL, NULL);
+		if (p->sfd < 0)
+			err(EXIT_FAILURE, "accept");
+		close(lfd);
+		break;
+	case NET_UDP_RR:
+		p->sfd = inet_socket(SOCK_DGRAM, &saddr);
+		p->cfd = inet_socket(SOCK_DGRAM, &caddr);
+		if (connect(p->cfd, (struct sockaddr *)&saddr, sizeof(saddr)) ||
+		    connect(p->sfd, (struct sockaddr *)&caddr, sizeof(caddr)))
+			err(EXIT_FAILURE, "connect");
+		break;
+	case NET_UNIX_STREAM:
+	case NET_UNIX_DGRAM:
+		if (socketpair(AF_UNIX, mode == NET_UNIX_STREAM ?
+			       SOCK_STREAM : SOCK_DGRAM, 0, fds))
+			err(EXIT_FAILURE, "socketpair");
+		p->cfd = fds[0];
+		p->sfd = fds[1];
+		break;
+	default:
+		BUG_ON(1);
+	}
+
+	sock_setup(p->cfd);
+	sock_setup(p->sfd);
+}
+
+/*
+ * Cycles of this process and every thread it creates afterwards, user and
+ * kernel.  Returns -1 if the counter is unavailable, e.g. in a VM without a
+ * PMU or with a restrictive perf_event_paranoid setting.
+ */
+static int cycles_open(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.inherit = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	done = true;
+}
+
+static void print_summary(struct pair *pairs, u64 runtime_us, u64 cycles,
+			  u64 cpu_ns, const char *name)
+{
+	u64 ops = 0, bytes = 0;
+	unsigned int i;
+	double per;
+
+	for (i = 0; i < npairs; i++) {
+		ops += pairs[i].ops;
+		bytes += pairs[i].bytes;
+	}
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %s: %u pair(s), %u-byte messages, %d.%03d secs%s%s\n\n",
+		       name, npairs, msg_size, (int)(runtime_us / USEC_PER_SEC),
+		       (int)(runtime_us % USEC_PER_SEC / USEC_PER_MSEC),
+		       zerocopy ? ", zerocopy" : "", busy_poll ? ", busy-poll" : "");
+		if (!mode_is_stream()) {
+			printf(" %14.0f transactions/sec\n",
+			       (double)ops * USEC_PER_SEC / runtime_us);
+			if (ops)
+				printf(" %14.3f usecs/transaction\n",
+				       (double)runtime_us * npairs / ops);
+		}
+		printf(" %14.2f MiB/s\n",
+		       (double)bytes * USEC_PER_SEC / runtime_us / (1024 * 1024));
+
+		if (cycles) {
+			if (ops)
+				printf(" %14.0f cycles/transaction\n", (double)cycles / ops);
+			if (bytes)
+				printf(" %14.3f cycles/byte\n", (double)cycles / bytes);
+		} else {
+			/* no PMU access, fall back to CPU time */
+			if (ops)
+				printf(" %14.0f CPU ns/transaction\n", (double)cpu_ns / ops);
+			if (bytes)
+				printf(" %14.3f CPU ns/byte\n", (double)cpu_ns / bytes);
+		}
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		per = cycles ? cycles : cpu_ns;
+		printf("%.3f\n", mode_is_stream() ?
+		       (bytes ? per / bytes : 0) : (ops ? per / ops : 0));
+		break;
+	default:
+		/* reaching here is something of a disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+}
+
+static u64 tv_us(const struct timeval *tv)
+{
+	return tv->tv_sec * USEC_PER_SEC + tv->tv_usec;
+}
+
+static int bench_net(int argc, const char **argv, enum net_mode m,
+		     const char *name)
+{
+	struct rusage ru_start, ru_end;
+	struct timeval start, end, diff;
+	u64 runtime_us, cycles = 0, cpu_ns;
+	struct sigaction act;
+	struct pair *pairs;
+	unsigned int i;
+	int cfd, ret = 0;
+
+	argc = parse_options(argc, argv, options, bench_net_usage, 0);
+	if (argc || !npairs || !runtime) {
+		usage_with_options(bench_net_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	mode = m;
+	if (!msg_size)
+		msg_size = mode_is_stream() ? 64 * 1024 : 1;
+	if (zerocopy && !mode_is_inet())
+		errx(EXIT_FAILURE, "--zerocopy needs a TCP or UDP test");
+
+	memset(&act, 0, sizeof(act));
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	sigaction(SIGINT, &act, NULL);
+	/* the peer may go away first at the end of the run */
+	signal(SIGPIPE, SIG_IGN);
+
+	pairs = calloc(npairs, sizeof(*pairs));
+	if (!pairs)
+		err(EXIT_FAILURE, "calloc");
+
+	for (i = 0; i < npairs; i++) {
+		pairs[i].id = i;
+		pair_connect(&pairs[i]);
+	}
+
+	cfd = cycles_open();
+	getrusage(RUSAGE_SELF, &ru_start);
+	gettimeofday(&start, NULL);
+
+	for (i = 0; i < npairs; i++) {
+		if (pthread_create(&pairs[i].server, NULL, serverfn, &pairs[i]) ||
+		    pthread_create(&pairs[i].client, NULL, clientfn, &pairs[i]))
+			err(EXIT_FAILURE, "pthread_create");
+	}
+
+	sleep(runtime);
+	done = true;
+
+	for (i = 0; i < npairs; i++) {
+		pthread_join(pairs[i].client, NULL);
+		pthread_join(pairs[i].server, NULL);
+	}
+
+	gettimeofday(&end, NULL);
+	getrusage(RUSAGE_SELF, &ru_end);
+
+	/* inherited counts are folded into the parent as the threads exit */
+	if (cfd >= 0) {
+		if (read(cfd, &cycles, sizeof(cycles)) != sizeof(cycles))
+			cycles = 0;
+		close(cfd);
+	}
+
+	timersub(&end, &start, &diff);
+	runtime_us = tv_us(&diff);
+	timersub(&ru_end.ru_utime, &ru_start.ru_utime, &diff);
+	cpu_ns = tv_us(&diff) * NSEC_PER_USEC;
+	timersub(&ru_end.ru_stime, &ru_start.ru_stime, &diff);
+	cpu_ns += tv_us(&diff) * NSEC_PER_USEC;
+
+	for (i = 0; i < npairs; i++) {
+		if (pairs[i].err) {
+			warnx("pair %u: %s", i, strerror(-pairs[i].err));
+			ret = -1;
+		}
+		close(pairs[i].cfd);
+		close(pairs[i].sfd);
+	}
+
+	if (!ret && runtime_us)
+		print_summary(pairs, runtime_us, cycles, cpu_ns, name);
+
+	free(pairs);
+	return ret;
+}
+
+int bench_net_tcp_rr(int argc, const char **argv)
+{
+	return bench_net(argc, argv, NET_TCP_RR, "TCP_RR");
+}
+
+int bench_net_tcp_stream(int argc, const char **argv)
+{
+	return bench_net(argc, argv, NET_TCP_STREAM, "TCP_STREAM");
+}
+
+int bench_net_udp_rr(int argc, const char **argv)
+{
+	return bench_net(argc, argv, NET_UDP_RR, "UDP_RR");
+}
+
+int bench_net_unix_stream(int argc, const char **argv)
+{
+	return bench_net(argc, argv, NET_UNIX_STREAM, "AF_UNIX stream");
+}
+
+int bench_net_unix_dgram(int argc, const char **argv)
+{
+	return bench_net(argc, argv, NET_UNIX_DGRAM, "AF_UNIX dgram RR");
+}
@@ -305,6 +305,72 @@ static void test_task_pidfd(void)
 	close(pidfd);
 }
 
+static void test_task_range(void)
+{
+	LIBBPF_OPTS(bpf_iter_attach_opts, opts);
+	union bpf_iter_link_info linfo;
+	struct bpf_link_info info = {};
+	int num_unknown_tid, num_known_tid;
+	struct bpf_iter_task *skel;
+	struct bpf_link *link;
+	__u32 info_len;
+	int err;
+
+	memset(&linfo, 0, sizeof(linfo));
+	opts.link_info = &linfo;
+	opts.link_info_len = sizeof(linfo);
+
+	/* Only the main thread, whose tid is the pid */
+	linfo.task.tid_start = getpid();
+	linfo.task.tid_end = getpid() + 1;
+	test_task_common(&opts, 0, 1);
+
+	/* Everything from the main thread on, without an upper bound */
+	linfo.task.tid_end = 0;
+	test_task_common_nocheck(&opts, &num_unknown_tid, &num_known_tid);
+	ASSERT_EQ(num_known_tid, 1, "check_num_known_tid");
+
+	/* Everything below the main thread */
+	linfo.task.tid_start = 0;
+	linfo.task.tid_end = getpid();
+	test_task_common_nocheck(&opts, &num_unknown_tid, &num_known_tid);
+	ASSERT_EQ(num_known_tid, 0, "check_num_known_tid");
+
+	skel = bpf_iter_task__open_and_load();
+	if (!ASSERT_OK_PTR(skel, "bpf_iter_task__open_and_load"))
+		return;
+
+	/* The range is reported back through the link info */
+	linfo.task.tid_start = 1;
+	linfo.task.tid_end = getpid() + 1;
+	link = bpf_program__attach_iter(skel->progs.dump_task, &opts);
+	if (ASSERT_OK_PTR(link, "attach_iter")) {
+		info_len = sizeof(info);
+		err = bpf_link_get_info_by_fd(bpf_link__fd(link), &info,
+					      &info_len);
+		ASSERT_OK(err, "bpf_link_get_info_by_fd");
+		ASSERT_EQ(info.iter.task.tid_start, 1, "check_tid_start");
+		ASSERT_EQ(info.iter.task.tid_end, getpid() + 1, "check_tid_end");
+		bpf_link__destroy(link);
+	}
+
+	/* An empty range is rejected */
+	linfo.task.tid_start = getpid();
+	linfo.task.tid_end = getpid();
+	link = bpf_program__attach_iter(skel->progs.dump_task, &opts);
+	if (!ASSERT_ERR_PTR(link, "attach_iter empty range"))
+		bpf_link__destroy(link);
+
+	/* A range can't be combined with a single task or process */
+	linfo.task.tid_end = 0;
+	linfo.task.tid = getpid();
+	link = bpf_program__attach_iter(skel->progs.dump_task, &opts);
+	if (!ASSERT_ERR_PTR(link, "attach_iter range and tid"))
+		bpf_link__destroy(link);
+
+	bpf_iter_task__destroy(skel);
+}
+
 static void test_task_sleepable(void)
 {
 	struct bpf_iter_task *skel;
@@ -1651,6 +1717,8 @@ void test_bpf_iter(void)
 		test_task_pid();
 	if (test__start_subtest("task_pidfd"))
 		test_task_pidfd();
+	if (test__start_subtest("task_range"))
+		test_task_range();
 	if (test__start_subtest("task_sleepable"))
 		test_task_sleepable();
 	if (test__start_subtest("task_stack"))
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include <test_progs.h>
+
+#define MAX_ENTRIES	1024
+
+static void test_fail_cases(void)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts);
+	int fd;
+
+	/* Preallocated maps don't take a bucket count hint */
+	opts.map_extra = 16;
+	fd = bpf_map_create(BPF_MAP_TYPE_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), MAX_ENTRIES, &opts);
+	if (!ASSERT_EQ(fd, -EINVAL, "bpf_map_create prealloc map_extra"))
+		close(fd);
+
+	/* Hint too large */
+	opts.map_flags = BPF_F_NO_PREALLOC;
+	opts.map_extra = (1ULL << 31) + 1;
+	fd = bpf_map_create(BPF_MAP_TYPE_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), MAX_ENTRIES, &opts);
+	if (!ASSERT_EQ(fd, -EINVAL, "bpf_map_create huge map_extra"))
+		close(fd);
+
+	/* Other map types still reject map_extra */
+	opts.map_extra = 16;
+	fd = bpf_map_create(BPF_MAP_TYPE_LRU_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), MAX_ENTRIES, &opts);
+	if (!ASSERT_LT(fd, 0, "bpf_map_create lru map_extra"))
+		close(fd);
+}
+
+/* Fill the map well past its bucket count and check every element */
+static void test_fill(enum bpf_map_type type, __u64 map_extra)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts);
+	int nr_cpus = libbpf_num_possible_cpus();
+	struct bpf_map_info info = {};
+	__u32 info_len = sizeof(info);
+	__u32 key, next_key, count;
+	__u64 *values;
+	int fd, err, i;
+	void *prev;
+
+	if (!ASSERT_GT(nr_cpus, 0, "libbpf_num_possible_cpus"))
+		return;
+	if (type != BPF_MAP_TYPE_PERCPU_HASH)
+		nr_cpus = 1;
+	values = calloc(nr_cpus, sizeof(*values));
+	if (!ASSERT_OK_PTR(values, "calloc values"))
+		return;
+
+	opts.map_flags = BPF_F_NO_PREALLOC;
+	opts.map_extra = map_extra;
+	fd = bpf_map_create(type, NULL, sizeof(key), sizeof(*values),
+			    MAX_ENTRIES, &opts);
+	if (!ASSERT_GE(fd, 0, "bpf_map_create"))
+		goto out;
+
+	err = bpf_map_get_info_by_fd(fd, &info, &info_len);
+	if (!ASSERT_OK(err, "bpf_map_get_info_by_fd"))
+		goto close;
+	ASSERT_EQ(info.map_extra, map_extra, "info.map_extra");
+	ASSERT_EQ(info.max_entries, MAX_ENTRIES, "info.max_entries");
+
+	for (key = 0; key < MAX_ENTRIES; key++) {
+		for (i = 0; i < nr_cpus; i++)
+			values[i] = key + i;
+		err = bpf_map_update_elem(fd, &key, values, BPF_NOEXIST);
+		if (!ASSERT_OK(err, "bpf_map_update_elem"))
+			goto close;
+	}
+
+	/* max_entries still bounds the map, not the bucket count */
+	err = bpf_map_update_elem(fd, &key, values, BPF_NOEXIST);
+	ASSERT_EQ(err, -E2BIG, "bpf_map_update_elem full");
+
+	for (key = 0; key < MAX_ENTRIES; key++) {
+		err = bpf_map_lookup_elem(fd, &key, values);
+		if (!ASSERT_OK(err, "bpf_map_lookup_elem"))
+			goto close;
+		for (i = 0; i < nr_cpus; i++)
+			if (!ASSERT_EQ(values[i], key + i, "value"))
+				goto close;
+	}
+
+	count = 0;
+	prev = NULL;
+	while (!bpf_map_get_next_key(fd, prev, &next_key)) {
+		key = next_key;
+		prev = &key;
+		count++;
+	}
+	ASSERT_EQ(count, MAX_ENTRIES, "get_next_key count");
+
+	for (key = 0; key < MAX_ENTRIES; key++) {
+		err = bpf_map_delete_elem(fd, &key);
+		if (!ASSERT_OK(err, "bpf_map_delete_elem"))
+			goto close;
+	}
+	ASSERT_EQ(bpf_map_get_next_key(fd, NULL, &next_key), -ENOENT,
+		  "map empty");
+close:
+	close(fd);
+out:
+	free(values);
+}
+
+void test_htab_map_extra(void)
+{
+	if (test__start_subtest("fail_cases"))
+		test_fail_cases();
+	if (test__start_subtest("hash"))
+		test_fill(BPF_MAP_TYPE_HASH, 16);
+	if (test__start_subtest("hash_single_bucket"))
+		test_fill(BPF_MAP_TYPE_HASH, 1);
+	if (test__start_subtest("hash_hint_above_max"))
+		test_fill(BPF_MAP_TYPE_HASH, 4 * MAX_ENTRIES);
+	if (test__start_subtest("percpu_hash"))
+		test_fill(BPF_MAP_TYPE_PERCPU_HASH, 16);
+}
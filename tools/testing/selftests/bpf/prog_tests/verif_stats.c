@@ -24,6 +24,42 @@ void test_verif_stats(void)
 	if (!ASSERT_GT(info.verified_insns, 0, "verified_insns"))
 		goto cleanup;
 
+	ASSERT_GT(info.verification_time_ns, 0, "verification_time_ns");
+
 cleanup:
 	trace_vprintk_lskel__destroy(skel);
 }
+
+void test_verif_stats_states(void)
+{
+	struct bpf_insn insns[] = {
+		BPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_1,
+			    offsetof(struct __sk_buff, len)),
+		BPF_MOV64_IMM(BPF_REG_0, 0),
+		BPF_JMP_IMM(BPF_JGT, BPF_REG_2, 10, 1),
+		BPF_MOV64_IMM(BPF_REG_0, 1),
+		BPF_EXIT_INSN(),
+	};
+	/* Checkpoint at every prune point, so the jump target gets a state */
+	LIBBPF_OPTS(bpf_prog_load_opts, opts,
+		    .prog_flags = BPF_F_TEST_STATE_FREQ,
+	);
+	__u32 len = sizeof(struct bpf_prog_info);
+	struct bpf_prog_info info = {};
+	int fd, err;
+
+	fd = bpf_prog_load(BPF_PROG_TYPE_SOCKET_FILTER, NULL, "GPL", insns,
+			   ARRAY_SIZE(insns), &opts);
+	if (!ASSERT_GE(fd, 0, "bpf_prog_load"))
+		return;
+
+	err = bpf_prog_get_info_by_fd(fd, &info, &len);
+	if (!ASSERT_OK(err, "bpf_prog_get_info_by_fd"))
+		goto close;
+
+	ASSERT_GT(info.verified_insns, 0, "verified_insns");
+	ASSERT_GT(info.verified_states, 0, "verified_states");
+	ASSERT_GT(info.verification_time_ns, 0, "verification_time_ns");
+close:
+	close(fd);
+}